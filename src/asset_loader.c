@@ -0,0 +1,468 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "asset_loader.h"
+#include "utils.h"
+
+#ifdef EMBED_TEXTURES
+#include "../texture_pieces_msdf.h"
+#include "../texture_titlebar_bc7.h"
+#include "../texture_titlebar_etc2.h"
+#endif /* EMBED_TEXTURES */
+
+#ifdef EMBED_MESHES
+#include "../mesh_pawn.h"
+#include "../mesh_knight.h"
+#include "../mesh_bishop.h"
+#include "../mesh_rook.h"
+#include "../mesh_queen.h"
+#include "../mesh_king.h"
+#endif /* EMBED_MESHES */
+
+#ifdef EMBED_FONTS
+#include "../font_roboto.h"
+#endif /* EMBED_FONTS */
+
+/* Textures are named <name>_<encoding>.ktx2 */
+static const char *assetFileNames[ASSET_COUNT] = {
+	"pieces",
+	"titlebar",
+	"pawn.mesh",
+	"knight.mesh",
+	"bishop.mesh",
+	"rook.mesh",
+	"queen.mesh",
+	"king.mesh",
+	"roboto.ttf"
+};
+
+static const char *textureEncodingNames[TEXTURE_ENCODING_COUNT] = {
+	"bc7",
+	"etc2",
+	"msdf"
+};
+
+static const uint32_t textureEncodingFormats[TEXTURE_ENCODING_COUNT] = {
+	TEXTURE_FORMAT_BC7_SRGB_BLOCK,
+	TEXTURE_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,
+	TEXTURE_FORMAT_R8G8B8A8_UNORM
+};
+
+typedef struct asset_job_t {
+	bool finished;
+	char *error;
+	CookedMesh mesh;
+	char *bytes;
+	size_t size;
+} AssetJob;
+
+/*
+ * Workers claim jobs in Asset order; each result stays here until it's taken.
+ * Textures aren't jobs, since which file to map depends on the device, and
+ * mapping one is all there is to do.
+ */
+struct asset_loader_t {
+	char *resourcePath;
+	pthread_t workers[ASSET_LOADER_WORKER_COUNT];
+	size_t workerCount;
+	pthread_mutex_t mutex;
+	pthread_cond_t jobFinished;
+	size_t nextJob;
+	AssetJob jobs[ASSET_COUNT];
+};
+
+static void *assetLoaderWorker(void *arg);
+static bool loadAsset(AssetLoader self, Asset asset, AssetJob *job, char **error);
+static bool readAsset(AssetLoader self, Asset asset, char **bytes, size_t *size, char **error);
+static bool mapCookedMesh(AssetLoader self, Asset asset, CookedMesh *mesh, char **error);
+static const unsigned char *findEmbeddedAsset(Asset asset, size_t *size);
+static const unsigned char *findEmbeddedTexture(Asset asset, TextureEncoding encoding, size_t *size);
+static AssetJob *waitForAsset(AssetLoader self, Asset asset, char **error);
+
+bool createAssetLoader(AssetLoader *assetLoader, const char *resourcePath, char **error)
+{
+	*assetLoader = malloc(sizeof(**assetLoader));
+
+	AssetLoader self = *assetLoader;
+
+	self->resourcePath = strdup(resourcePath);
+	self->nextJob = 0;
+	memset(self->jobs, 0, sizeof(self->jobs));
+	self->jobs[ASSET_PIECES_TEXTURE].finished = true;
+	self->jobs[ASSET_TITLEBAR_TEXTURE].finished = true;
+#ifndef ENABLE_IMGUI
+	self->jobs[ASSET_ROBOTO_FONT].finished = true;
+#endif /* ENABLE_IMGUI */
+	pthread_mutex_init(&self->mutex, NULL);
+	pthread_cond_init(&self->jobFinished, NULL);
+
+	for (self->workerCount = 0; self->workerCount < ASSET_LOADER_WORKER_COUNT; ++self->workerCount) {
+		if (pthread_create(&self->workers[self->workerCount], NULL, assetLoaderWorker, (void *) self) != 0) {
+			break;
+		}
+	}
+	if (self->workerCount == 0) {
+		asprintf(error, "Failed to start asset loading threads");
+		pthread_cond_destroy(&self->jobFinished);
+		pthread_mutex_destroy(&self->mutex);
+		free(self->resourcePath);
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/* Maps the texture cooked in the given encoding; the caller releases it with freeCookedTexture */
+bool assetLoaderTakeTexture(AssetLoader self, Asset asset, TextureEncoding encoding, CookedTexture *texture, char **error)
+{
+	size_t size;
+	const unsigned char *bytes = findEmbeddedTexture(asset, encoding, &size);
+	texture->mapping = NULL;
+	texture->mappingSize = 0;
+
+	char *fileName;
+	asprintf(&fileName, "%s_%s.ktx2", assetFileNames[asset], textureEncodingNames[encoding]);
+
+	if (!bytes) {
+		char *path;
+		asprintf(&path, "%s/%s", self->resourcePath, fileName);
+		texture->mapping = mapFile(path, &size);
+		free(path);
+		if (!texture->mapping) {
+			asprintf(error, "Failed to map %s.\n", fileName);
+			free(fileName);
+			return false;
+		}
+		texture->mappingSize = size;
+		bytes = texture->mapping;
+	}
+
+	Ktx2Header header;
+	if (size < sizeof(header)) {
+		asprintf(error, "%s is truncated.\n", fileName);
+		free(fileName);
+		freeCookedTexture(*texture);
+		return false;
+	}
+	memcpy(&header, bytes, sizeof(header));
+	if (memcmp(header.identifier, KTX2_IDENTIFIER, KTX2_IDENTIFIER_SIZE) != 0 || header.supercompressionScheme != 0
+		|| header.faceCount != 1 || header.levelCount < 1 || header.levelCount > TEXTURE_MAX_LEVELS
+		|| header.vkFormat != textureEncodingFormats[encoding]
+	) {
+		asprintf(error, "%s is not a cooked %s texture.\n", fileName, textureEncodingNames[encoding]);
+		free(fileName);
+		freeCookedTexture(*texture);
+		return false;
+	}
+	if (size < sizeof(header) + sizeof(Ktx2Level) * header.levelCount) {
+		asprintf(error, "%s is truncated.\n", fileName);
+		free(fileName);
+		freeCookedTexture(*texture);
+		return false;
+	}
+
+	texture->format = header.vkFormat;
+	texture->width = header.pixelWidth;
+	texture->height = header.pixelHeight;
+	texture->levelCount = header.levelCount;
+	uint32_t blockDimension = encoding == TEXTURE_ENCODING_MSDF ? 1 : TEXTURE_BLOCK_DIMENSION;
+	uint32_t blockSize = encoding == TEXTURE_ENCODING_MSDF ? TEXTURE_MSDF_TEXEL_SIZE : TEXTURE_BLOCK_SIZE;
+	for (uint32_t i = 0; i < header.levelCount; ++i) {
+		Ktx2Level level;
+		memcpy(&level, bytes + sizeof(header) + sizeof(level) * i, sizeof(level));
+
+		uint32_t blocksWide = ((header.pixelWidth >> i) + blockDimension - 1) / blockDimension;
+		uint32_t blocksHigh = ((header.pixelHeight >> i) + blockDimension - 1) / blockDimension;
+		if (level.byteOffset > size || level.byteLength > size - level.byteOffset
+			|| level.byteLength != (uint64_t) blocksWide * blocksHigh * blockSize
+		) {
+			asprintf(error, "%s has a level out of range.\n", fileName);
+			free(fileName);
+			freeCookedTexture(*texture);
+			return false;
+		}
+
+		texture->levels[i] = bytes + level.byteOffset;
+		texture->levelSizes[i] = level.byteLength;
+	}
+	free(fileName);
+
+	return true;
+}
+
+/* Blocks until the mesh is mapped; the caller releases it with freeCookedMesh */
+bool assetLoaderTakeMesh(AssetLoader self, Asset asset, CookedMesh *mesh, char **error)
+{
+	AssetJob *job;
+	if (!(job = waitForAsset(self, asset, error))) {
+		return false;
+	}
+
+	*mesh = job->mesh;
+	memset(&job->mesh, 0, sizeof(job->mesh));
+
+	return true;
+}
+
+/* Blocks until the asset is read; the caller frees the bytes */
+bool assetLoaderTakeFile(AssetLoader self, Asset asset, char **bytes, size_t *size, char **error)
+{
+	AssetJob *job;
+	if (!(job = waitForAsset(self, asset, error))) {
+		return false;
+	}
+
+	*bytes = job->bytes;
+	*size = job->size;
+	job->bytes = NULL;
+
+	return true;
+}
+
+void freeCookedTexture(CookedTexture texture)
+{
+	if (texture.mapping) {
+		unmapFile(texture.mapping, texture.mappingSize);
+	}
+}
+
+void freeCookedMesh(CookedMesh mesh)
+{
+	if (mesh.mapping) {
+		unmapFile(mesh.mapping, mesh.mappingSize);
+	}
+}
+
+/* Waits for any jobs still running and frees whatever wasn't taken */
+void destroyAssetLoader(AssetLoader self)
+{
+	for (size_t i = 0; i < self->workerCount; ++i) {
+		pthread_join(self->workers[i], NULL);
+	}
+
+	for (size_t i = 0; i < ASSET_COUNT; ++i) {
+		AssetJob *job = self->jobs + i;
+		free(job->error);
+		freeCookedMesh(job->mesh);
+		free(job->bytes);
+	}
+
+	pthread_cond_destroy(&self->jobFinished);
+	pthread_mutex_destroy(&self->mutex);
+	free(self->resourcePath);
+	free(self);
+}
+
+static void *assetLoaderWorker(void *arg)
+{
+	AssetLoader self = (AssetLoader) arg;
+
+	pthread_mutex_lock(&self->mutex);
+	while (self->nextJob < ASSET_COUNT) {
+		Asset asset = self->nextJob++;
+		AssetJob *job = self->jobs + asset;
+		if (job->finished) {
+			continue;
+		}
+		pthread_mutex_unlock(&self->mutex);
+
+		loadAsset(self, asset, job, &job->error);
+
+		pthread_mutex_lock(&self->mutex);
+		job->finished = true;
+		pthread_cond_broadcast(&self->jobFinished);
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return NULL;
+}
+
+static bool loadAsset(AssetLoader self, Asset asset, AssetJob *job, char **error)
+{
+	switch (asset) {
+	case ASSET_PAWN_MESH:
+	case ASSET_KNIGHT_MESH:
+	case ASSET_BISHOP_MESH:
+	case ASSET_ROOK_MESH:
+	case ASSET_QUEEN_MESH:
+	case ASSET_KING_MESH:
+		return mapCookedMesh(self, asset, &job->mesh, error);
+	default:
+		break;
+	}
+
+	if (!readAsset(self, asset, &job->bytes, &job->size, error)) {
+		return false;
+	}
+
+	return true;
+}
+
+/* Embedded assets are copied so that every result is freed the same way */
+static bool readAsset(AssetLoader self, Asset asset, char **bytes, size_t *size, char **error)
+{
+	size_t embeddedSize;
+	const unsigned char *embeddedBytes = findEmbeddedAsset(asset, &embeddedSize);
+
+	if (embeddedBytes) {
+		*bytes = malloc(embeddedSize);
+		memcpy(*bytes, embeddedBytes, embeddedSize);
+		*size = embeddedSize;
+		return true;
+	}
+
+	char *path;
+	asprintf(&path, "%s/%s", self->resourcePath, assetFileNames[asset]);
+	long fileSize = readFileToString(path, bytes);
+	free(path);
+	if (fileSize == -1) {
+		asprintf(error, "Failed to open %s for reading.\n", assetFileNames[asset]);
+		return false;
+	}
+	*size = fileSize;
+
+	return true;
+}
+
+/* Cooked meshes are used in place, either mapped from the file or from the embedded array */
+static bool mapCookedMesh(AssetLoader self, Asset asset, CookedMesh *mesh, char **error)
+{
+	size_t size;
+	const unsigned char *bytes = findEmbeddedAsset(asset, &size);
+	mesh->mapping = NULL;
+	mesh->mappingSize = 0;
+
+	if (!bytes) {
+		char *path;
+		asprintf(&path, "%s/%s", self->resourcePath, assetFileNames[asset]);
+		mesh->mapping = mapFile(path, &size);
+		free(path);
+		if (!mesh->mapping) {
+			asprintf(error, "Failed to map %s.\n", assetFileNames[asset]);
+			return false;
+		}
+		mesh->mappingSize = size;
+		bytes = mesh->mapping;
+	}
+
+	MeshHeader header;
+	if (size < sizeof(header)) {
+		asprintf(error, "%s is truncated.\n", assetFileNames[asset]);
+		freeCookedMesh(*mesh);
+		return false;
+	}
+	memcpy(&header, bytes, sizeof(header));
+	if (header.magic != MESH_MAGIC || header.version != MESH_VERSION) {
+		asprintf(error, "%s is not a version %d cooked mesh.\n", assetFileNames[asset], MESH_VERSION);
+		freeCookedMesh(*mesh);
+		return false;
+	}
+	if (size < sizeof(header) + sizeof(MeshVertex) * (size_t) header.vertexCount + sizeof(uint16_t) * (size_t) header.indexCount) {
+		asprintf(error, "%s is truncated.\n", assetFileNames[asset]);
+		freeCookedMesh(*mesh);
+		return false;
+	}
+	for (size_t i = 0; i < MESH_LOD_COUNT; ++i) {
+		MeshLod lod = header.lods[i];
+		if ((size_t) lod.vertexOffset + lod.vertexCount > header.vertexCount || (size_t) lod.indexOffset + lod.indexCount > header.indexCount) {
+			asprintf(error, "%s has a LOD out of range.\n", assetFileNames[asset]);
+			freeCookedMesh(*mesh);
+			return false;
+		}
+	}
+
+	mesh->vertices = bytes + sizeof(header);
+	mesh->vertexCount = header.vertexCount;
+	mesh->indices = bytes + sizeof(header) + sizeof(MeshVertex) * header.vertexCount;
+	mesh->indexCount = header.indexCount;
+	memcpy(mesh->scale, header.scale, sizeof(mesh->scale));
+	memcpy(mesh->bias, header.bias, sizeof(mesh->bias));
+	memcpy(mesh->lods, header.lods, sizeof(mesh->lods));
+
+	return true;
+}
+
+static const unsigned char *findEmbeddedAsset(Asset asset, size_t *size)
+{
+	switch (asset) {
+#ifdef EMBED_MESHES
+	case ASSET_PAWN_MESH:
+		*size = pawnMeshSize;
+		return pawnMeshBytes;
+	case ASSET_KNIGHT_MESH:
+		*size = knightMeshSize;
+		return knightMeshBytes;
+	case ASSET_BISHOP_MESH:
+		*size = bishopMeshSize;
+		return bishopMeshBytes;
+	case ASSET_ROOK_MESH:
+		*size = rookMeshSize;
+		return rookMeshBytes;
+	case ASSET_QUEEN_MESH:
+		*size = queenMeshSize;
+		return queenMeshBytes;
+	case ASSET_KING_MESH:
+		*size = kingMeshSize;
+		return kingMeshBytes;
+#endif /* EMBED_MESHES */
+#ifdef EMBED_FONTS
+	case ASSET_ROBOTO_FONT:
+		*size = robotoFontSize;
+		return robotoFontBytes;
+#endif /* EMBED_FONTS */
+	default:
+		break;
+	}
+
+	return NULL;
+}
+
+/* The pieces are only cooked as a distance field, and the titlebar only as images */
+static const unsigned char *findEmbeddedTexture(Asset asset, TextureEncoding encoding, size_t *size)
+{
+#ifdef EMBED_TEXTURES
+	switch (asset) {
+	case ASSET_PIECES_TEXTURE:
+		if (encoding == TEXTURE_ENCODING_MSDF) {
+			*size = piecesMsdfTextureSize;
+			return piecesMsdfTextureBytes;
+		}
+		break;
+	case ASSET_TITLEBAR_TEXTURE:
+		if (encoding == TEXTURE_ENCODING_BC7) {
+			*size = titlebarBc7TextureSize;
+			return titlebarBc7TextureBytes;
+		}
+		if (encoding == TEXTURE_ENCODING_ETC2) {
+			*size = titlebarEtc2TextureSize;
+			return titlebarEtc2TextureBytes;
+		}
+		break;
+	default:
+		break;
+	}
+#endif /* EMBED_TEXTURES */
+
+	return NULL;
+}
+
+static AssetJob *waitForAsset(AssetLoader self, Asset asset, char **error)
+{
+	AssetJob *job = self->jobs + asset;
+
+	pthread_mutex_lock(&self->mutex);
+	while (!job->finished) {
+		pthread_cond_wait(&self->jobFinished, &self->mutex);
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	if (job->error) {
+		*error = job->error;
+		job->error = NULL;
+		return NULL;
+	}
+
+	return job;
+}
@@ -0,0 +1,61 @@
+#ifndef MODELER_ASSET_LOADER_H
+#define MODELER_ASSET_LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mesh.h"
+#include "texture.h"
+
+#define ASSET_LOADER_WORKER_COUNT 4
+
+typedef enum asset_t {
+	ASSET_PIECES_TEXTURE,
+	ASSET_TITLEBAR_TEXTURE,
+	/* Same order as the piece meshes in chess_board.c */
+	ASSET_PAWN_MESH,
+	ASSET_KNIGHT_MESH,
+	ASSET_BISHOP_MESH,
+	ASSET_ROOK_MESH,
+	ASSET_QUEEN_MESH,
+	ASSET_KING_MESH,
+	ASSET_ROBOTO_FONT,
+	ASSET_COUNT
+} Asset;
+
+/* Like CookedMesh, each level points into the mapped or embedded KTX2 file */
+typedef struct cooked_texture_t {
+	uint32_t format; /* VkFormat */
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	const void *levels[TEXTURE_MAX_LEVELS];
+	size_t levelSizes[TEXTURE_MAX_LEVELS];
+	void *mapping;
+	size_t mappingSize;
+} CookedTexture;
+
+/* Points into the mapped or embedded blob, so it's unaligned and read-only */
+typedef struct cooked_mesh_t {
+	const void *vertices; /* MeshVertex */
+	uint32_t vertexCount;
+	const void *indices; /* uint16_t */
+	uint32_t indexCount;
+	float scale[3];
+	float bias[3];
+	MeshLod lods[MESH_LOD_COUNT];
+	void *mapping;
+	size_t mappingSize;
+} CookedMesh;
+
+typedef struct asset_loader_t *AssetLoader;
+
+bool createAssetLoader(AssetLoader *assetLoader, const char *resourcePath, char **error);
+bool assetLoaderTakeTexture(AssetLoader self, Asset asset, TextureEncoding encoding, CookedTexture *texture, char **error);
+bool assetLoaderTakeMesh(AssetLoader self, Asset asset, CookedMesh *mesh, char **error);
+bool assetLoaderTakeFile(AssetLoader self, Asset asset, char **bytes, size_t *size, char **error);
+void destroyAssetLoader(AssetLoader self);
+void freeCookedTexture(CookedTexture texture);
+void freeCookedMesh(CookedMesh mesh);
+
+#endif /* MODELER_ASSET_LOADER_H */
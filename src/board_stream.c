@@ -0,0 +1,322 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "utils.h"
+
+#include "board_stream.h"
+
+#define BOARD_STREAM_READ_SIZE 4096
+
+typedef struct board_stream_client_t {
+	int fd;
+	char line[BOARD_STREAM_LINE_LENGTH];
+	size_t lineLength;
+	bool discardingLine;
+} BoardStreamClient;
+
+struct board_stream_t {
+	char *path;
+	int listenFd;
+	int epollFd;
+	BoardStreamClient clients[BOARD_STREAM_MAX_CLIENTS];
+	size_t clientCount;
+};
+
+static bool removeStaleSocket(const struct sockaddr_un *address, char **error);
+static bool acceptClients(BoardStream self, char **error);
+static bool readClient(BoardStreamClient *client, BoardUpdateBatch **batch);
+static void removeClient(BoardStream self, BoardStreamClient *client);
+static void pushLine(BoardUpdateBatch **batch, const char *line, size_t length);
+
+bool createBoardStream(BoardStream *boardStream, const char *path, char **error)
+{
+	struct sockaddr_un address = {
+		.sun_family = AF_UNIX
+	};
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		asprintf(error, "Board stream socket path too long: %s", path);
+		return false;
+	}
+	strcpy(address.sun_path, path);
+
+	*boardStream = malloc(sizeof(**boardStream));
+	BoardStream self = *boardStream;
+	self->clientCount = 0;
+	self->path = strdup(path);
+
+	if ((self->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+		asprintf(error, "Failed to create board stream socket: %s", strerror(errno));
+		free(self->path);
+		free(self);
+		return false;
+	}
+
+	if (!removeStaleSocket(&address, error)) {
+		close(self->listenFd);
+		free(self->path);
+		free(self);
+		return false;
+	}
+	if (bind(self->listenFd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+		asprintf(error, "Failed to bind board stream socket %s: %s", path, strerror(errno));
+		close(self->listenFd);
+		free(self->path);
+		free(self);
+		return false;
+	}
+
+	if (listen(self->listenFd, BOARD_STREAM_MAX_CLIENTS) == -1) {
+		asprintf(error, "Failed to listen on board stream socket: %s", strerror(errno));
+		close(self->listenFd);
+		unlink(path);
+		free(self->path);
+		free(self);
+		return false;
+	}
+
+	/*
+	 * The listener and all clients live in a private epoll set, so the main
+	 * loop only has to watch a single descriptor for the whole stream.
+	 */
+	if ((self->epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		asprintf(error, "Failed to create board stream epoll instance: %s", strerror(errno));
+		close(self->listenFd);
+		unlink(path);
+		free(self->path);
+		free(self);
+		return false;
+	}
+	struct epoll_event epollConfigurationEvent = {
+		.events = EPOLLIN,
+		.data.fd = self->listenFd
+	};
+	epoll_ctl(self->epollFd, EPOLL_CTL_ADD, self->listenFd, &epollConfigurationEvent);
+
+	return true;
+}
+
+/*
+ * A socket left behind by a previous run would make bind fail, but only a
+ * socket nothing is listening on is removed: anything else at the path is
+ * either not ours or belongs to another running instance.
+ */
+static bool removeStaleSocket(const struct sockaddr_un *address, char **error)
+{
+	struct stat pathStat;
+	if (lstat(address->sun_path, &pathStat) == -1) {
+		if (errno == ENOENT) {
+			return true;
+		}
+		asprintf(error, "Failed to stat board stream socket %s: %s", address->sun_path, strerror(errno));
+		return false;
+	}
+
+	if (!S_ISSOCK(pathStat.st_mode)) {
+		asprintf(error, "Board stream socket path %s exists and isn't a socket", address->sun_path);
+		return false;
+	}
+
+	int testFd;
+	if ((testFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1) {
+		asprintf(error, "Failed to create board stream test socket: %s", strerror(errno));
+		return false;
+	}
+	int connectResult = connect(testFd, (const struct sockaddr *) address, sizeof(*address));
+	int connectError = errno;
+	close(testFd);
+
+	if (connectResult == 0) {
+		asprintf(error, "Board stream socket %s is in use by another instance", address->sun_path);
+		return false;
+	}
+	if (connectError != ECONNREFUSED) {
+		asprintf(error, "Failed to check board stream socket %s: %s", address->sun_path, strerror(connectError));
+		return false;
+	}
+
+	if (unlink(address->sun_path) == -1) {
+		asprintf(error, "Failed to remove stale board stream socket %s: %s", address->sun_path, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+int boardStreamGetFd(BoardStream self)
+{
+	return self->epollFd;
+}
+
+/*
+ * Service every ready client once, collecting all complete lines into a single
+ * batch. *batch is left NULL if no complete line arrived.
+ */
+bool boardStreamDispatch(BoardStream self, BoardUpdateBatch **batch, char **error)
+{
+	struct epoll_event epollEventBuffer[BOARD_STREAM_MAX_CLIENTS + 1];
+	int eventCount;
+
+	*batch = NULL;
+
+	if ((eventCount = epoll_wait(self->epollFd, epollEventBuffer, BOARD_STREAM_MAX_CLIENTS + 1, 0)) == -1) {
+		if (errno == EINTR) {
+			return true;
+		}
+		asprintf(error, "Failed to wait for board stream epoll: %s", strerror(errno));
+		return false;
+	}
+
+	for (int i = 0; i < eventCount; ++i) {
+		int fd = epollEventBuffer[i].data.fd;
+		if (fd == self->listenFd) {
+			if (!acceptClients(self, error)) {
+				return false;
+			}
+			continue;
+		}
+
+		for (size_t j = 0; j < self->clientCount; ++j) {
+			if (self->clients[j].fd == fd) {
+				if (!readClient(self->clients + j, batch)) {
+					removeClient(self, self->clients + j);
+				}
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+void destroyBoardStream(BoardStream self)
+{
+	while (self->clientCount > 0) {
+		removeClient(self, self->clients);
+	}
+	close(self->epollFd);
+	close(self->listenFd);
+	unlink(self->path);
+	free(self->path);
+	free(self);
+}
+
+char *getDefaultBoardStreamPath(void)
+{
+	char *path;
+	const char *overridePath = getenv("MODELER_SOCKET");
+	if (overridePath) {
+		return strdup(overridePath);
+	}
+
+	const char *runtimeDirectory = getenv("XDG_RUNTIME_DIR");
+	if (!runtimeDirectory) {
+		return NULL;
+	}
+
+	asprintf(&path, "%s/%s", runtimeDirectory, BOARD_STREAM_SOCKET_NAME);
+	return path;
+}
+
+static bool acceptClients(BoardStream self, char **error)
+{
+	for (;;) {
+		int fd = accept(self->listenFd, NULL, NULL);
+		if (fd == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+				return true;
+			}
+			asprintf(error, "Failed to accept board stream client: %s", strerror(errno));
+			return false;
+		}
+
+		if (self->clientCount == BOARD_STREAM_MAX_CLIENTS) {
+			fprintf(stderr, "Too many board stream clients, dropping connection\n");
+			close(fd);
+			continue;
+		}
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		BoardStreamClient *client = self->clients + self->clientCount++;
+		*client = (BoardStreamClient) {
+			.fd = fd,
+			.lineLength = 0,
+			.discardingLine = false
+		};
+		struct epoll_event epollConfigurationEvent = {
+			.events = EPOLLIN,
+			.data.fd = fd
+		};
+		epoll_ctl(self->epollFd, EPOLL_CTL_ADD, fd, &epollConfigurationEvent);
+	}
+}
+
+/*
+ * Read at most one chunk per dispatch. epoll is level-triggered, so a client
+ * with more pending data simply wakes the main loop again, and a flooding
+ * client cannot keep the Wayland connection from being serviced.
+ */
+static bool readClient(BoardStreamClient *client, BoardUpdateBatch **batch)
+{
+	char buffer[BOARD_STREAM_READ_SIZE];
+	ssize_t length = read(client->fd, buffer, sizeof(buffer));
+	if (length == 0) {
+		return false;
+	} else if (length == -1) {
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+
+	for (ssize_t i = 0; i < length; ++i) {
+		char c = buffer[i];
+		if (c == '\n') {
+			if (!client->discardingLine && client->lineLength > 0) {
+				pushLine(batch, client->line, client->lineLength);
+			}
+			client->lineLength = 0;
+			client->discardingLine = false;
+		} else if (c == '\r' || client->discardingLine) {
+			continue;
+		} else if (client->lineLength == BOARD_STREAM_LINE_LENGTH - 1) {
+			fprintf(stderr, "Board stream line too long, discarding\n");
+			client->discardingLine = true;
+		} else {
+			client->line[client->lineLength++] = c;
+		}
+	}
+
+	return true;
+}
+
+static void removeClient(BoardStream self, BoardStreamClient *client)
+{
+	epoll_ctl(self->epollFd, EPOLL_CTL_DEL, client->fd, NULL);
+	close(client->fd);
+	*client = self->clients[--self->clientCount];
+}
+
+static void pushLine(BoardUpdateBatch **batch, const char *line, size_t length)
+{
+	if (!*batch) {
+		*batch = malloc(sizeof(**batch));
+		**batch = (BoardUpdateBatch) {
+			.lines = NULL,
+			.lineCount = 0
+		};
+	}
+
+	BoardUpdateBatch *self = *batch;
+	self->lines = realloc(self->lines, sizeof(*self->lines) * (self->lineCount + 1));
+	char *copy = malloc(length + 1);
+	memcpy(copy, line, length);
+	copy[length] = '\0';
+	self->lines[self->lineCount++] = copy;
+}
@@ -0,0 +1,20 @@
+#ifndef MODELER_BOARD_STREAM_H
+#define MODELER_BOARD_STREAM_H
+
+#include <stdbool.h>
+
+#include "input_event.h"
+
+#define BOARD_STREAM_SOCKET_NAME "modeler.sock"
+#define BOARD_STREAM_MAX_CLIENTS 16
+#define BOARD_STREAM_LINE_LENGTH 256
+
+typedef struct board_stream_t *BoardStream;
+
+bool createBoardStream(BoardStream *boardStream, const char *path, char **error);
+int boardStreamGetFd(BoardStream self);
+bool boardStreamDispatch(BoardStream self, BoardUpdateBatch **batch, char **error);
+void destroyBoardStream(BoardStream self);
+char *getDefaultBoardStreamPath(void);
+
+#endif /* MODELER_BOARD_STREAM_H */
@@ -0,0 +1,117 @@
+#include <stdlib.h>
+
+#include "buffer_arena.h"
+
+#include "buffer.h"
+#include "utils.h"
+
+/* Every block can back any of the small device-local buffers, whatever they're used for */
+#define BUFFER_ARENA_USAGE (VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+
+/*
+ * Device-local buffers that live as long as the renderer, bumped linearly
+ * out of a few large blocks rather than each getting its own VkBuffer and
+ * allocation. Nothing is freed until the arena is destroyed. An allocation
+ * that doesn't fit in what's left of the newest block starts a new one, as
+ * large as the allocation if that's more than the block size.
+ */
+struct buffer_arena_t {
+	VkDevice device;
+	VmaAllocator allocator;
+	VkDeviceSize alignment; /* Suits uniform and storage descriptors, and vertex, index and indirect offsets */
+	VkDeviceSize blockSize;
+	VkBuffer blocks[BUFFER_ARENA_MAX_BLOCKS];
+	VmaAllocation blockAllocations[BUFFER_ARENA_MAX_BLOCKS];
+	VkDeviceSize blockSizes[BUFFER_ARENA_MAX_BLOCKS];
+	size_t blockCount;
+	VkDeviceSize head; /* Where the next allocation goes in the newest block */
+};
+
+static bool addBlock(BufferArena self, VkDeviceSize size, char **error);
+
+bool createBufferArena(BufferArena *bufferArena, VkDevice device, VmaAllocator allocator, const VkPhysicalDeviceLimits *limits, VkDeviceSize blockSize, char **error)
+{
+	*bufferArena = malloc(sizeof(**bufferArena));
+
+	BufferArena self = *bufferArena;
+
+	self->device = device;
+	self->allocator = allocator;
+	/* Both limits are powers of two, so the larger is a multiple of the smaller */
+	self->alignment = 4;
+	if (limits->minUniformBufferOffsetAlignment > self->alignment) {
+		self->alignment = limits->minUniformBufferOffsetAlignment;
+	}
+	if (limits->minStorageBufferOffsetAlignment > self->alignment) {
+		self->alignment = limits->minStorageBufferOffsetAlignment;
+	}
+	self->blockSize = blockSize;
+	self->blockCount = 0;
+
+	if (!addBlock(self, blockSize, error)) {
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+static bool addBlock(BufferArena self, VkDeviceSize size, char **error)
+{
+	if (self->blockCount == BUFFER_ARENA_MAX_BLOCKS) {
+		asprintf(error, "Buffer arena is out of blocks");
+		return false;
+	}
+
+	if (!createBuffer(self->device, self->allocator, size, BUFFER_ARENA_USAGE, VMA_MEMORY_USAGE_AUTO, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, self->blocks + self->blockCount, self->blockAllocations + self->blockCount, error)) {
+		return false;
+	}
+	self->blockSizes[self->blockCount] = size;
+	++self->blockCount;
+	self->head = 0;
+
+	return true;
+}
+
+bool bufferArenaAllocate(BufferArena self, VkDeviceSize size, BufferRange *range, char **error)
+{
+	VkDeviceSize start = (self->head + self->alignment - 1) / self->alignment * self->alignment;
+	if (start + size > self->blockSizes[self->blockCount - 1]) {
+		if (!addBlock(self, size > self->blockSize ? size : self->blockSize, error)) {
+			return false;
+		}
+		start = 0;
+	}
+
+	range->buffer = self->blocks[self->blockCount - 1];
+	range->offset = start;
+	range->size = size;
+	self->head = start + size;
+
+	return true;
+}
+
+/* Allocates and copies data in through the batch's staging memory */
+bool bufferArenaAllocateStatic(BufferArena self, UploadBatch uploadBatch, const void *data, VkDeviceSize size, BufferRange *range, char **error)
+{
+	VkBuffer stagingBuffer;
+	if (!uploadBatchStage(uploadBatch, data, size, &stagingBuffer, error)) {
+		return false;
+	}
+
+	if (!bufferArenaAllocate(self, size, range, error)) {
+		return false;
+	}
+
+	uploadBatchCopyBuffer(uploadBatch, stagingBuffer, range->buffer, range->offset, size);
+
+	return true;
+}
+
+void destroyBufferArena(BufferArena self)
+{
+	for (size_t i = 0; i < self->blockCount; ++i) {
+		destroyBuffer(self->allocator, self->blocks[i], self->blockAllocations[i]);
+	}
+	free(self);
+}
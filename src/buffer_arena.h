@@ -0,0 +1,27 @@
+#ifndef MODELER_BUFFER_ARENA_H
+#define MODELER_BUFFER_ARENA_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+#include "vk_mem_alloc.h"
+
+#include "upload.h"
+
+#define BUFFER_ARENA_DEFAULT_BLOCK_SIZE (4 * 1024 * 1024)
+#define BUFFER_ARENA_MAX_BLOCKS 16
+
+typedef struct buffer_arena_t *BufferArena;
+
+/* Where an allocation lives in one of the arena's buffers */
+typedef struct buffer_range_t {
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+} BufferRange;
+
+bool createBufferArena(BufferArena *bufferArena, VkDevice device, VmaAllocator allocator, const VkPhysicalDeviceLimits *limits, VkDeviceSize blockSize, char **error);
+bool bufferArenaAllocate(BufferArena self, VkDeviceSize size, BufferRange *range, char **error);
+bool bufferArenaAllocateStatic(BufferArena self, UploadBatch uploadBatch, const void *data, VkDeviceSize size, BufferRange *range, char **error);
+void destroyBufferArena(BufferArena self);
+
+#endif /* MODELER_BUFFER_ARENA_H */
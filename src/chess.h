@@ -38,4 +38,9 @@ typedef struct lastMove {
 	ChessSquare to;
 } LastMove;
 
+typedef struct board_arrow_t {
+	ChessSquare from;
+	ChessSquare to;
+} BoardArrow;
+
 #endif /* MODELER_CHESS_H */
\ No newline at end of file
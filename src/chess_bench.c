@@ -0,0 +1,272 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chess_position.h"
+
+/*
+ * Times each part of move generation separately over a corpus of positions and
+ * prints the results as JSON, one result per line, so runs from different
+ * commits can be diffed directly:
+ *
+ * 	chess_bench [iterations [fen-file]]
+ *
+ * The perft counts double as a correctness check; a mismatch fails the run.
+ */
+
+#define DEFAULT_ITERATIONS 2000
+#define MAX_CORPUS_SIZE 256
+#define FEN_LENGTH 128
+
+typedef struct corpus_entry_t {
+	char fen[FEN_LENGTH];
+	unsigned perftDepth;
+	uint64_t perftNodes; /* 0 if unknown */
+} CorpusEntry;
+
+typedef struct bench_result_t {
+	uint64_t operations;
+	uint64_t nanoseconds;
+} BenchResult;
+
+static const CorpusEntry defaultCorpus[] = {
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281},
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+	{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467},
+	{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379},
+	{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890},
+	{"rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4", 3, 0},
+	{"2r3k1/pp3pp1/4p2p/3qP3/3P4/P4Q1P/5PP1/2R3K1 b - - 0 28", 3, 0}
+};
+
+static const char *pieceTypeNames[CHESS_PIECE_TYPE_COUNT] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+static uint64_t checksum;
+
+static inline uint64_t now(void)
+{
+	struct timespec spec;
+	clock_gettime(CLOCK_MONOTONIC, &spec);
+	return (uint64_t) spec.tv_sec * 1000000000 + spec.tv_nsec;
+}
+
+static size_t loadCorpus(const char *path, CorpusEntry *corpus)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp) {
+		return 0;
+	}
+
+	size_t count = 0;
+	char line[FEN_LENGTH];
+	while (count < MAX_CORPUS_SIZE && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#') {
+			continue;
+		}
+		corpus[count] = (CorpusEntry) {
+			.perftDepth = 3,
+			.perftNodes = 0
+		};
+		strcpy(corpus[count++].fen, line);
+	}
+
+	fclose(fp);
+	return count;
+}
+
+static BenchResult benchPseudoLegal(ChessPosition *positions, size_t positionCount, unsigned iterations)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	BenchResult result = {0, 0};
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			checksum += chessPositionGeneratePseudoLegalMoves(positions + j, moves);
+		}
+	}
+	result.nanoseconds = now() - start;
+	result.operations = (uint64_t) iterations * positionCount;
+	return result;
+}
+
+static BenchResult benchPieceType(ChessPosition *positions, size_t positionCount, unsigned iterations, ChessPieceType type)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	BenchResult result = {0, 0};
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			checksum += chessPositionGeneratePieceMoves(positions + j, type, moves);
+		}
+	}
+	result.nanoseconds = now() - start;
+	result.operations = (uint64_t) iterations * positionCount;
+	return result;
+}
+
+static BenchResult benchLegal(ChessPosition *positions, size_t positionCount, unsigned iterations)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	BenchResult result = {0, 0};
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			checksum += chessPositionGenerateLegalMoves(positions + j, moves);
+		}
+	}
+	result.nanoseconds = now() - start;
+	result.operations = (uint64_t) iterations * positionCount;
+	return result;
+}
+
+/* One operation is a make followed by its unmake */
+static BenchResult benchMakeUnmake(ChessPosition *positions, size_t positionCount, unsigned iterations)
+{
+	static ChessMove moves[MAX_CORPUS_SIZE][CHESS_MAX_MOVES];
+	size_t moveCounts[MAX_CORPUS_SIZE];
+	BenchResult result = {0, 0};
+
+	for (size_t j = 0; j < positionCount; ++j) {
+		moveCounts[j] = chessPositionGeneratePseudoLegalMoves(positions + j, moves[j]);
+		result.operations += moveCounts[j];
+	}
+	result.operations *= iterations;
+
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			for (size_t k = 0; k < moveCounts[j]; ++k) {
+				ChessUndo undo;
+				chessPositionMakeMove(positions + j, moves[j][k], &undo);
+				checksum += positions[j].hash;
+				chessPositionUnmakeMove(positions + j, moves[j][k], &undo);
+			}
+		}
+	}
+	result.nanoseconds = now() - start;
+	return result;
+}
+
+/* One operation is a single square queried for one attacking color */
+static BenchResult benchAttackQuery(ChessPosition *positions, size_t positionCount, unsigned iterations)
+{
+	BenchResult result = {0, 0};
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			for (ChessSquare square = 0; square < CHESS_SQUARE_COUNT; ++square) {
+				checksum += chessPositionIsSquareAttacked(positions + j, square, WHITE);
+				checksum += chessPositionIsSquareAttacked(positions + j, square, BLACK);
+			}
+		}
+	}
+	result.nanoseconds = now() - start;
+	result.operations = (uint64_t) iterations * positionCount * CHESS_SQUARE_COUNT * 2;
+	return result;
+}
+
+/* Full recomputation; the incremental update is part of make/unmake */
+static BenchResult benchHash(ChessPosition *positions, size_t positionCount, unsigned iterations)
+{
+	BenchResult result = {0, 0};
+	uint64_t start = now();
+	for (unsigned i = 0; i < iterations; ++i) {
+		for (size_t j = 0; j < positionCount; ++j) {
+			checksum += chessPositionComputeHash(positions + j);
+		}
+	}
+	result.nanoseconds = now() - start;
+	result.operations = (uint64_t) iterations * positionCount;
+	return result;
+}
+
+static bool benchPerft(ChessPosition *positions, CorpusEntry *corpus, size_t positionCount, BenchResult *result)
+{
+	bool passed = true;
+
+	*result = (BenchResult) {0, 0};
+	for (size_t j = 0; j < positionCount; ++j) {
+		uint64_t start = now();
+		uint64_t nodes = chessPositionPerft(positions + j, corpus[j].perftDepth);
+		result->nanoseconds += now() - start;
+		result->operations += nodes;
+
+		if (corpus[j].perftNodes && nodes != corpus[j].perftNodes) {
+			fprintf(stderr, "Perft mismatch for %s at depth %u: expected %llu, got %llu\n", corpus[j].fen, corpus[j].perftDepth,
+				(unsigned long long) corpus[j].perftNodes, (unsigned long long) nodes);
+			passed = false;
+		}
+
+		if (positions[j].hash != chessPositionComputeHash(positions + j)) {
+			fprintf(stderr, "Hash not restored by unmake for %s\n", corpus[j].fen);
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+static void printResult(const char *name, BenchResult result, bool last)
+{
+	printf("\t\t\"%s\": {\"ops\": %llu, \"ns_per_op\": %.3f}%s\n", name, (unsigned long long) result.operations,
+		result.operations ? (double) result.nanoseconds / result.operations : 0.0, last ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+	static CorpusEntry corpus[MAX_CORPUS_SIZE];
+	static ChessPosition positions[MAX_CORPUS_SIZE];
+	unsigned iterations = DEFAULT_ITERATIONS;
+	size_t positionCount;
+
+	if (argc > 1 && (iterations = strtoul(argv[1], NULL, 10)) == 0) {
+		fprintf(stderr, "usage: %s [iterations [fen-file]]\n", argv[0]);
+		return 2;
+	}
+
+	if (argc > 2) {
+		if (!(positionCount = loadCorpus(argv[2], corpus))) {
+			fprintf(stderr, "Failed to load positions from %s\n", argv[2]);
+			return 2;
+		}
+	} else {
+		positionCount = sizeof(defaultCorpus) / sizeof(defaultCorpus[0]);
+		memcpy(corpus, defaultCorpus, sizeof(defaultCorpus));
+	}
+
+	for (size_t i = 0; i < positionCount; ++i) {
+		if (!chessPositionFromFen(positions + i, corpus[i].fen)) {
+			fprintf(stderr, "Invalid FEN: %s\n", corpus[i].fen);
+			return 2;
+		}
+	}
+
+	BenchResult perft;
+	bool passed = benchPerft(positions, corpus, positionCount, &perft);
+
+	printf("{\n");
+	printf("\t\"iterations\": %u,\n", iterations);
+	printf("\t\"positions\": %zu,\n", positionCount);
+	printf("\t\"results\": {\n");
+	printResult("pseudo_legal_movegen", benchPseudoLegal(positions, positionCount, iterations), false);
+	for (ChessPieceType type = PAWN; type < CHESS_PIECE_TYPE_COUNT; ++type) {
+		char name[32];
+		snprintf(name, sizeof(name), "pseudo_legal_movegen.%s", pieceTypeNames[type]);
+		printResult(name, benchPieceType(positions, positionCount, iterations, type), false);
+	}
+	printResult("legal_movegen", benchLegal(positions, positionCount, iterations), false);
+	printResult("make_unmake", benchMakeUnmake(positions, positionCount, iterations), false);
+	printResult("attack_query", benchAttackQuery(positions, positionCount, iterations), false);
+	printResult("hash", benchHash(positions, positionCount, iterations), false);
+	printResult("perft_node", perft, true);
+	printf("\t},\n");
+	printf("\t\"perft_passed\": %s,\n", passed ? "true" : "false");
+	printf("\t\"checksum\": %llu\n", (unsigned long long) checksum);
+	printf("}\n");
+
+	return passed ? 0 : 1;
+}
@@ -2,8 +2,6 @@
 #include <string.h>
 #include <math.h>
 
-#include "lodepng.h"
-
 #include "chess_board.h"
 #include "descriptor.h"
 #include "image.h"
@@ -13,51 +11,70 @@
 #include "synchronization.h"
 #include "utils.h"
 #include "matrix_utils.h"
-#include "tinyobj_loader_c.h"
+#include "mesh.h"
 
 #ifdef EMBED_SHADERS
 #include "../shader_chess_board.vert.h"
 #include "../shader_chess_board.frag.h"
 #include "../shader_phong.vert.h"
 #include "../shader_phong.frag.h"
+#include "../shader_piece_instances.comp.h"
 #endif /* EMBED_SHADERS */
 
-#ifdef EMBED_TEXTURES
-#include "../texture_pieces.h"
-#endif /* EMBED_TEXTURES */
-
-#ifdef EMBED_MESHES
-#include "../mesh_pawn.h"
-#include "../mesh_knight.h"
-#include "../mesh_bishop.h"
-#include "../mesh_rook.h"
-#include "../mesh_queen.h"
-#include "../mesh_king.h"
-#endif /* EMBED_MESHES */
-
 static const float VIEWPORT_WIDTH = 2.0f;
 static const float VIEWPORT_HEIGHT = 2.0f;
 
-typedef struct board_vertex_t {
-	float pos[3];
-	float color[3];
-	float texCoord[2];
-	float texCoord2[2];
-} BoardVertex;
-
-typedef struct mesh_vertex_t {
-	float pos[3];
-	float normal[3];
-} MeshVertex;
-
-#define CHESS_VERTEX_COUNT CHESS_SQUARE_COUNT * 4
-#define CHESS_INDEX_COUNT CHESS_SQUARE_COUNT * 6
-#define PIECES_TEXTURE_MIP_LEVELS 7
-
-typedef struct chess_piece_push_constants_t {
-	float diffuseColor[4];
-	float ambientColor[4];
-} ChessPiecePushConstants;
+/* Per tile: squares, board sides, then each arrow's shaft and head */
+#define BOARD_QUAD_COUNT (CHESS_SQUARE_COUNT + 8 + CHESS_BOARD_MAX_ARROWS * 2)
+#define PIECES_TEXTURE_MIP_LEVELS 4
+
+/* A bit per frame in flight, for tracking which ring regions are out of date */
+#define EVERY_FRAME ((1 << MAX_FRAMES_IN_FLIGHT) - 1)
+
+#define PIECE_MESH_COUNT 6
+/* Pixels across a piece below which the next coarser LOD is used, halved for each further LOD */
+#define PIECE_LOD_FULL_DETAIL_PIXELS 192.0f
+
+/*
+ * Per-instance vertex data, written by the piece_instances compute shader
+ * into a fixed range of CHESS_BOARD_MAX_TILES * CHESS_SQUARE_COUNT slots per
+ * mesh. transformIndex is tile * CHESS_SQUARE_COUNT + square.
+ */
+typedef struct piece_instance_t {
+	uint32_t transformIndex;
+	uint32_t meshIndex;
+	float diffuseColor[3];
+	float ambientColor[3];
+} PieceInstance;
+
+/* Constant inputs of the piece_instances compute shader, std140 */
+typedef struct piece_draw_parameters_t {
+	uint32_t meshes[PIECE_MESH_COUNT * MESH_LOD_COUNT][4]; /* indexCount, firstIndex, vertexOffset, unused; mesh * MESH_LOD_COUNT + LOD */
+	float diffuseColors[2][4]; /* Black, white */
+	float ambientColors[2][4];
+} PieceDrawParameters;
+
+/* Undoes each piece mesh's position quantization in phong.vert, std140 */
+typedef struct piece_mesh_bounds_t {
+	float scales[PIECE_MESH_COUNT][4];
+	float biases[PIECE_MESH_COUNT][4];
+} PieceMeshBounds;
+
+#define SQUARE_LAST_MOVE (1 << 16)
+#define SQUARE_SELECTED (1 << 17)
+
+/*
+ * Everything the board's quads are built from, std430. Each square is one
+ * word: the piece in the low byte, the move marker in the next, then the
+ * SQUARE_* flags. The piece_instances compute shader reads the same buffer.
+ */
+typedef struct board_state_t {
+	uint32_t enable3d;
+	uint32_t arrowCount;
+	uint32_t pieceLod;
+	uint32_t arrows[CHESS_BOARD_MAX_ARROWS]; /* from | to << 8 */
+	uint32_t squares[CHESS_BOARD_MAX_TILES * CHESS_SQUARE_COUNT];
+} BoardState;
 
 typedef struct transform_uniform_t {
 	float MV[16];
@@ -81,34 +98,14 @@ size_t pieceMeshIndexMap[13] = {
 	5
 };
 
-float pieceSpriteOriginMap[13][2] = {
-	{0.75f, 0.75f},
-	{0.25f, 0.75f},
-	{0.75f, 0.5f},
-	{0.5f, 0.5f},
-	{0.0f, 0.75f},
-	{0.25f, 0.5f},
-	{0.0f, 0.5f},
-	{0.25f, 0.25f},
-	{0.75f, 0.0f},
-	{0.5f, 0.0f},
-	{0.0f, 0.25f},
-	{0.25f, 0.0f},
-	{0.0f, 0.0f}
-};
-
-float iconSpriteOriginMap[3][2] = {
-	{0.75f, 0.75f},
-	{0.5f, 0.25f},
-	{0.75f, 0.25f}
-};
-
 struct chess_board_t {
 	VkDevice device;
 	VmaAllocator allocator;
-	VkCommandPool commandPool;
-	VkQueue queue;
+	UploadManager uploadManager;
+	UniformRing uniformRing;
+	BufferArena bufferArena;
 	VkRenderPass renderPass;
+	VkPipelineCache pipelineCache;
 	uint32_t subpass;
 	VkSampleCountFlagBits sampleCount;
 	const char *resourcePath;
@@ -117,20 +114,29 @@ struct chess_board_t {
 	Projection projection;
 	VkPipelineLayout boardPipelineLayout;
 	VkPipeline boardPipeline;
-	BoardVertex boardVertices[CHESS_VERTEX_COUNT + 32];
-	void *boardStagingVertexBufferMappedMemory;
-	VkBuffer boardStagingVertexBuffer;
-	VmaAllocation boardStagingVertexBufferAllocation;
-	VkBuffer boardVertexBuffer;
-	VmaAllocation boardVertexBufferAllocation;
-	VkBuffer boardIndexBuffer;
-	VmaAllocation boardIndexBufferAllocation;
-	size_t pieceVertexCounts[6];
-	size_t pieceVertexOffsets[6];
-	VkBuffer piecesVertexBuffer;
-	VmaAllocation piecesVertexBufferAllocation;
-	VkBuffer piecesIndexBuffer;
-	VmaAllocation piecesIndexBufferAllocation;
+	size_t pieceVertexOffsets[PIECE_MESH_COUNT];
+	size_t pieceIndexOffsets[PIECE_MESH_COUNT];
+	MeshLod pieceLods[PIECE_MESH_COUNT][MESH_LOD_COUNT];
+	/* Of the largest piece mesh's bounds, in model space */
+	float pieceRadius;
+	float viewportWidth;
+	float viewportHeight;
+	BufferRange piecesVertexBuffer;
+	BufferRange piecesIndexBuffer;
+	BufferRange piecesBoundsBuffer;
+	/* Only tile 0 has a selection, moves and arrows */
+	BoardState boardState;
+	uint64_t boardStateChangedSquares[CHESS_BOARD_MAX_TILES];
+	bool boardStateHeaderChanged;
+	BufferRange boardStateBuffer;
+	BufferRange piecesParametersBuffer;
+	BufferRange piecesInstanceBuffer;
+	BufferRange piecesIndirectBuffer;
+	VkDescriptorPool piecesComputeDescriptorPool;
+	VkDescriptorSet piecesComputeDescriptorSet;
+	VkDescriptorSetLayout piecesComputeDescriptorSetLayout;
+	VkPipelineLayout piecesComputePipelineLayout;
+	VkPipeline piecesComputePipeline;
 	VkPipelineLayout piecesPipelineLayout;
 	VkPipeline piecesPipeline;
 	VkImage textureImage;
@@ -138,22 +144,27 @@ struct chess_board_t {
 	VkImageView textureImageView;
 	VkSampler sampler;
 	VkDescriptorPool descriptorPool;
-	VkDescriptorSet boardDescriptorSets[MAX_FRAMES_IN_FLIGHT];
-	VkDescriptorSetLayout boardDescriptorSetLayouts[MAX_FRAMES_IN_FLIGHT];
-	VkDescriptorSet piecesDescriptorSets[MAX_FRAMES_IN_FLIGHT];
-	VkDescriptorSetLayout piecesDescriptorSetLayouts[MAX_FRAMES_IN_FLIGHT];
-	VkBuffer boardUniformBuffers[MAX_FRAMES_IN_FLIGHT];
-	VmaAllocation boardUniformBufferAllocations[MAX_FRAMES_IN_FLIGHT];
-	void *boardUniformBufferMappedMemories[MAX_FRAMES_IN_FLIGHT];
-	VkBuffer piecesUniformBuffers[MAX_FRAMES_IN_FLIGHT];
-	VmaAllocation piecesUniformBufferAllocations[MAX_FRAMES_IN_FLIGHT];
-	void *piecesUniformBufferMappedMemories[MAX_FRAMES_IN_FLIGHT];
+	VkDescriptorSet boardDescriptorSet;
+	VkDescriptorSetLayout boardDescriptorSetLayout;
+	VkDescriptorSet piecesDescriptorSet;
+	VkDescriptorSetLayout piecesDescriptorSetLayout;
+	/* Offsets of each uniform within every frame's region of the ring */
+	VkDeviceSize boardUniformOffset;
+	VkDeviceSize piecesUniformOffset;
+	VkDeviceSize tilesUniformOffset;
+	/* Frames whose copies predate the last change, written when they're next drawn */
+	uint32_t staleTransformFrames;
+	uint32_t staleTilesFrames;
 	TransformUniform boardUniform;
 	TransformUniform piecesUniforms[CHESS_SQUARE_COUNT];
-	Board8x8 board;
+	size_t tileCount;
+	float tiles[CHESS_BOARD_MAX_TILES][4]; /* Clip-space scale and offset */
+	Board8x8 boards[CHESS_BOARD_MAX_TILES];
 	MoveBoard8x8 move;
 	ChessSquare selected;
-	LastMove lastMove;
+	LastMove lastMoves[CHESS_BOARD_MAX_TILES];
+	BoardArrow arrows[CHESS_BOARD_MAX_ARROWS];
+	size_t arrowCount;
 	NormalizedPointerPosition pointerPosition;
 	ChessEngine engine;
 	float inverseViewProjection[mat4N * mat4N];
@@ -162,29 +173,31 @@ struct chess_board_t {
 static void initializePieces(ChessBoard self);
 static void initializeMove(ChessBoard self);
 static void updateUniformBuffers(ChessBoard self);
-static void readObjFromFile(void* ctx, const char* filename, const int is_mtl, const char* obj_filename, char** data, size_t* len);
-static void readEmbeddedObj(void* ctx, const char* filename, const int is_mtl, const char* obj_filename, char** data, size_t* len);
-static bool createBoardTexture(ChessBoard self, char **error);
+static bool createBoardTexture(ChessBoard self, AssetLoader assetLoader, UploadBatch uploadBatch, char **error);
 static bool createBoardTextureSampler(ChessBoard self, char **error);
 static bool createDescriptors(ChessBoard self, char **error);
-static bool createBoardVertexBuffer(ChessBoard self, char **error);
-static bool createBoardIndexBuffer(ChessBoard self, char **error);
-static bool createBoardPipeline(ChessBoard self, char **error);
-static bool createPiecesPipeline(ChessBoard self, char **error);
-static bool loadPieceMeshes(ChessBoard self, char **error);
-static bool createBoardUniformBuffer(ChessBoard self, char **error);
-static bool createPiecesUniformBuffer(ChessBoard self, char **error);
-static void updateBoardUniformBuffer(ChessBoard self);
-static void updatePiecesUniformBuffer(ChessBoard self);
-static void updateBoardMesh(ChessBoard self);
+static bool createBoardStateBuffer(ChessBoard self, UploadBatch uploadBatch, char **error);
+static bool createPiecesComputeBuffers(ChessBoard self, UploadBatch uploadBatch, char **error);
+static bool createPiecesComputeDescriptors(ChessBoard self, char **error);
+static bool createPiecesComputePipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error);
+static bool createBoardPipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error);
+static bool createPiecesPipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error);
+static bool loadPieceMeshes(ChessBoard self, AssetLoader assetLoader, UploadBatch uploadBatch, char **error);
+static bool uploadPieceMeshes(ChessBoard self, CookedMesh *meshes, UploadBatch uploadBatch, char **error);
+static bool reserveUniforms(ChessBoard self, char **error);
+static void writeStaleUniforms(ChessBoard self, uint32_t frame);
+static void updateTiles(ChessBoard self);
+static void updateSquareState(ChessBoard self, size_t tile, ChessSquare square);
+static void updateTileState(ChessBoard self, size_t tile);
+static void updateBoardStateHeader(ChessBoard self);
+static void updatePieceLod(ChessBoard self);
 static ChessSquare squareFromPointerPosition(ChessBoard self);
 static void screenPositionFromPointerPosition(NormalizedPointerPosition pointerPosition, float screenPosition[mat2N]);
 static float getRotationRadians(ChessBoard self);
-static void parseTinyobjIntoBuffers(tinyobj_attrib_t attrib, size_t vertexOffset, size_t vertexCount, MeshVertex *vertices, uint16_t *indices);
 static void basicSetMove(ChessBoard self, MoveBoard8x8 move);
 static void basicSetBoard(ChessBoard self, Board8x8 board);
 
-bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderPass, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, Orientation orientation, bool enable3d, Projection projection, char **error)
+bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice device, VmaAllocator allocator, AssetLoader assetLoader, UploadBatch uploadBatch, UploadManager uploadManager, UniformRing uniformRing, BufferArena bufferArena, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, Orientation orientation, bool enable3d, Projection projection, char **error)
 {
 	*chessBoard = malloc(sizeof(**chessBoard));
 
@@ -193,9 +206,11 @@ bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice devic
 	self->engine = engine;
 	self->device = device;
 	self->allocator = allocator;
-	self->commandPool = commandPool;
-	self->queue = queue;
+	self->uploadManager = uploadManager;
+	self->uniformRing = uniformRing;
+	self->bufferArena = bufferArena;
 	self->renderPass = renderPass;
+	self->pipelineCache = pipelineCache;
 	self->subpass = subpass;
 	self->sampleCount = sampleCount;
 	self->resourcePath = resourcePath;
@@ -204,52 +219,68 @@ bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice devic
 	self->projection = projection;
 
 	self->selected = CHESS_SQUARE_COUNT;
-	self->lastMove = (LastMove) {
-		.from = CHESS_SQUARE_COUNT,
-		.to = CHESS_SQUARE_COUNT
-	};
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		self->lastMoves[i] = (LastMove) {
+			.from = CHESS_SQUARE_COUNT,
+			.to = CHESS_SQUARE_COUNT
+		};
+	}
+	self->arrowCount = 0;
+	self->tileCount = 1;
+	self->pieceRadius = 0.0f;
+	self->viewportWidth = 0.0f;
+	self->viewportHeight = 0.0f;
+	updateTiles(self);
 	initializePieces(self);
 	initializeMove(self);
-	updateBoardMesh(self);
+	memset(&self->boardState, 0, sizeof(self->boardState));
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		updateTileState(self, i);
+	}
+	updateBoardStateHeader(self);
 	updateUniformBuffers(self);
 
-	if (!createBoardVertexBuffer(self, error)) {
+	if (!createBoardTexture(self, assetLoader, uploadBatch, error)) {
 		return false;
 	}
 
-	if (!createBoardIndexBuffer(self, error)) {
+	if (!createBoardTextureSampler(self, error)) {
 		return false;
 	}
 
-	if (!createBoardTexture(self, error)) {
+	if (!reserveUniforms(self, error)) {
 		return false;
 	}
 
-	if (!createBoardTextureSampler(self, error)) {
+	if (!createBoardStateBuffer(self, uploadBatch, error)) {
 		return false;
 	}
 
-	if (!createBoardUniformBuffer(self, error)) {
+	if (!loadPieceMeshes(self, assetLoader, uploadBatch, error)) {
 		return false;
 	}
 
-	if (!createPiecesUniformBuffer(self, error)) {
+	if (!createDescriptors(self, error)) {
 		return false;
 	}
 
-	if (!createDescriptors(self, error)) {
+	if (!createBoardPipeline(self, pipelineBuilder, error)) {
 		return false;
 	}
 
-	if (!createBoardPipeline(self, error)) {
+	if (!createPiecesComputeBuffers(self, uploadBatch, error)) {
 		return false;
 	}
 
-	if (!loadPieceMeshes(self, error)) {
+	if (!createPiecesComputeDescriptors(self, error)) {
 		return false;
 	}
 
-	if (!createPiecesPipeline(self, error)) {
+	if (!createPiecesComputePipeline(self, pipelineBuilder, error)) {
+		return false;
+	}
+
+	if (!createPiecesPipeline(self, pipelineBuilder, error)) {
 		return false;
 	}
 
@@ -347,6 +378,8 @@ static void updateUniformBuffers(ChessBoard self)
 		mat4Copy(projection, self->piecesUniforms[i].P);
 		mat4Copy(normalMatrix, self->piecesUniforms[i].normalMatrix);
 	}
+
+	self->staleTransformFrames = EVERY_FRAME;
 }
 
 static void initializePieces(ChessBoard self)
@@ -362,6 +395,9 @@ static void initializePieces(ChessBoard self)
 		WHITE_ROOK, WHITE_KNIGHT, WHITE_BISHOP, WHITE_QUEEN, WHITE_KING, WHITE_BISHOP, WHITE_KNIGHT, WHITE_ROOK
 	};
 
+	for (size_t i = 1; i < CHESS_BOARD_MAX_TILES; ++i) {
+		memcpy(self->boards[i], initialSetup, sizeof(initialSetup));
+	}
 	basicSetBoard(self, initialSetup);
 }
 
@@ -381,75 +417,41 @@ static void initializeMove(ChessBoard self)
 	basicSetMove(self, initialSetup);
 }
 
-static bool createBoardTexture(ChessBoard self, char **error)
+static bool createBoardTexture(ChessBoard self, AssetLoader assetLoader, UploadBatch uploadBatch, char **error)
 {
-#ifndef EMBED_TEXTURES
-	char *piecesTexturePath;
-	asprintf(&piecesTexturePath, "%s/%s", self->resourcePath, "pieces.png");
-	char *piecesTextureBytes;
-	uint32_t piecesTextureSize = 0;
-
-	if ((piecesTextureSize = readFileToString(piecesTexturePath, &piecesTextureBytes)) == -1) {
-		asprintf(error, "Failed to open texture for reading.\n");
+	CookedTexture texture;
+	if (!assetLoaderTakeTexture(assetLoader, ASSET_PIECES_TEXTURE, TEXTURE_ENCODING_MSDF, &texture, error)) {
 		return false;
 	}
-#endif /* EMBED_TEXTURES */
-
-	unsigned lodepngResult;
-	unsigned char *piecesTextureDecodedBytes;
-	unsigned piecesTextureDecodedWidth;
-	unsigned piecesTextureDecodedHeight;
-
-	if (lodepngResult = lodepng_decode32(&piecesTextureDecodedBytes, &piecesTextureDecodedWidth, &piecesTextureDecodedHeight, piecesTextureBytes, piecesTextureSize)) {
-		asprintf(error, "Failed to decode PNG: %s\n", lodepng_error_text(lodepngResult));
+	if (texture.levelCount != PIECES_TEXTURE_MIP_LEVELS) {
+		asprintf(error, "Pieces texture has %u levels, not %d.\n", texture.levelCount, PIECES_TEXTURE_MIP_LEVELS);
+		freeCookedTexture(texture);
 		return false;
 	}
 
 	VkExtent2D textureExtent = {
-		.width = piecesTextureDecodedHeight,
-		.height = piecesTextureDecodedHeight
+		.width = texture.width,
+		.height = texture.height
 	};
-	unsigned piecesTextureDecodedSize = (piecesTextureDecodedWidth * piecesTextureDecodedHeight) * (32 / sizeof(piecesTextureDecodedBytes));
-
-#ifndef EMBED_TEXTURES
-	free(piecesTextureBytes);
-#endif /* EMBED_TEXTURES */
+	VkFormat format = (VkFormat) texture.format;
 
 	VkBuffer stagingBuffer;
-	VmaAllocation stagingBufferAllocation;
-	if (!createBuffer(self->device, self->allocator, piecesTextureDecodedSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, 0, &stagingBuffer, &stagingBufferAllocation, error)) {
+	VkDeviceSize levelOffsets[TEXTURE_MAX_LEVELS];
+	bool staged = uploadBatchStageLevels(uploadBatch, texture.levels, texture.levelSizes, texture.levelCount, &stagingBuffer, levelOffsets, error);
+	freeCookedTexture(texture);
+	if (!staged) {
 		return false;
 	}
 
-	VkResult result;
-	void *data;
-	if ((result = vmaMapMemory(self->allocator, stagingBufferAllocation, &data)) != VK_SUCCESS) {
-		asprintf(error, "Failed to map memory: %s", string_VkResult(result));
+	if (!createImage(self->device, self->allocator, textureExtent, format, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, PIECES_TEXTURE_MIP_LEVELS, VK_SAMPLE_COUNT_1_BIT, &self->textureImage, &self->textureImageAllocation, error)) {
 		return false;
 	}
-	memcpy(data, piecesTextureDecodedBytes, piecesTextureDecodedSize);
-	free(piecesTextureDecodedBytes);
-	vmaUnmapMemory(self->allocator, stagingBufferAllocation);
 
-	if (!createImage(self->device, self->allocator, textureExtent, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, PIECES_TEXTURE_MIP_LEVELS, VK_SAMPLE_COUNT_1_BIT, &self->textureImage, &self->textureImageAllocation, error)) {
+	if (!uploadBatchCopyImage(uploadBatch, stagingBuffer, self->textureImage, format, texture.width, texture.height, PIECES_TEXTURE_MIP_LEVELS, levelOffsets, error)) {
 		return false;
 	}
 
-	if (!transitionImageLayout(self->device, self->commandPool, self->queue, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, PIECES_TEXTURE_MIP_LEVELS, error)) {
-		return false;
-	}
-
-	if (!copyBufferToImage(self->device, self->commandPool, self->queue, stagingBuffer, self->textureImage, piecesTextureDecodedWidth, piecesTextureDecodedHeight, PIECES_TEXTURE_MIP_LEVELS, error)) {
-		return false;
-	}
-
-	if (!transitionImageLayout(self->device, self->commandPool, self->queue, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, PIECES_TEXTURE_MIP_LEVELS, error)) {
-		return false;
-	}
-
-	destroyBuffer(self->allocator, stagingBuffer, stagingBufferAllocation);
-
-	if (!createImageView(self->device, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, PIECES_TEXTURE_MIP_LEVELS, &self->textureImageView, error)) {
+	if (!createImageView(self->device, self->textureImage, format, VK_IMAGE_ASPECT_COLOR_BIT, PIECES_TEXTURE_MIP_LEVELS, &self->textureImageView, error)) {
 		return false;
 	}
 
@@ -467,16 +469,35 @@ static bool createBoardTextureSampler(ChessBoard self, char **error)
 
 static bool createDescriptors(ChessBoard self, char **error)
 {
+	/* The ring's uniforms are bound with each frame's dynamic offsets */
 	VkDescriptorBufferInfo boardBufferDescriptorInfo = {
-		.buffer = self->boardUniformBuffers[0],
+		.buffer = uniformRingGetBuffer(self->uniformRing),
 		.offset = 0,
 		.range = sizeof(self->boardUniform)
 	};
 
 	VkDescriptorBufferInfo piecesBufferDescriptorInfo = {
-		.buffer = self->piecesUniformBuffers[0],
+		.buffer = uniformRingGetBuffer(self->uniformRing),
+		.offset = 0,
+		.range = sizeof(self->piecesUniforms)
+	};
+
+	VkDescriptorBufferInfo tilesBufferDescriptorInfo = {
+		.buffer = uniformRingGetBuffer(self->uniformRing),
 		.offset = 0,
-		.range = sizeof(self->piecesUniforms[0])
+		.range = sizeof(self->tiles)
+	};
+
+	VkDescriptorBufferInfo boardStateDescriptorInfo = {
+		.buffer = self->boardStateBuffer.buffer,
+		.offset = self->boardStateBuffer.offset,
+		.range = self->boardStateBuffer.size
+	};
+
+	VkDescriptorBufferInfo piecesBoundsDescriptorInfo = {
+		.buffer = self->piecesBoundsBuffer.buffer,
+		.offset = self->piecesBoundsBuffer.offset,
+		.range = self->piecesBoundsBuffer.size
 	};
 
 	VkDescriptorImageInfo imageDescriptorInfo = {
@@ -488,7 +509,7 @@ static bool createDescriptors(ChessBoard self, char **error)
 	VkDescriptorSetLayoutBinding boardBufferBinding = {
 		.binding = 0,
 		.descriptorCount = 1,
-		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
 		.pImmutableSamplers = NULL
 	};
@@ -501,6 +522,30 @@ static bool createDescriptors(ChessBoard self, char **error)
 		.pImmutableSamplers = NULL
 	};
 
+	VkDescriptorSetLayoutBinding boardTilesBufferBinding = {
+		.binding = 2,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.pImmutableSamplers = NULL
+	};
+
+	VkDescriptorSetLayoutBinding boardStateBufferBinding = {
+		.binding = 3,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.pImmutableSamplers = NULL
+	};
+
+	VkDescriptorSetLayoutBinding piecesTilesBufferBinding = {
+		.binding = 1,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.pImmutableSamplers = NULL
+	};
+
 	VkDescriptorSetLayoutBinding piecesBufferBinding = {
 		.binding = 0,
 		.descriptorCount = 1,
@@ -509,22 +554,31 @@ static bool createDescriptors(ChessBoard self, char **error)
 		.pImmutableSamplers = NULL
 	};
 
-	void *boardDescriptorSetDescriptorInfos[] = {&boardBufferDescriptorInfo, &imageDescriptorInfo};
-	VkDescriptorSetLayoutBinding boardDescriptorSetBindings[] = {boardBufferBinding, imageBinding};
-	void *piecesDescriptorSetDescriptorInfos[] = {&piecesBufferDescriptorInfo};
+	VkDescriptorSetLayoutBinding piecesBoundsBufferBinding = {
+		.binding = 2,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.pImmutableSamplers = NULL
+	};
+
+	void *boardDescriptorSetDescriptorInfos[] = {&boardBufferDescriptorInfo, &imageDescriptorInfo, &tilesBufferDescriptorInfo, &boardStateDescriptorInfo};
+	VkDescriptorSetLayoutBinding boardDescriptorSetBindings[] = {boardBufferBinding, imageBinding, boardTilesBufferBinding, boardStateBufferBinding};
+	void *piecesDescriptorSetDescriptorInfos[] = {&piecesBufferDescriptorInfo, &tilesBufferDescriptorInfo, &piecesBoundsDescriptorInfo};
+	VkDescriptorSetLayoutBinding piecesDescriptorSetBindings[] = {piecesBufferBinding, piecesTilesBufferBinding, piecesBoundsBufferBinding};
 	CreateDescriptorSetInfo createDescriptorSetInfos[] = {
 		{
 			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT & VK_SHADER_STAGE_FRAGMENT_BIT,
 			.descriptorInfos = boardDescriptorSetDescriptorInfos,
-			.descriptorCount = 2,
+			.descriptorCount = 4,
 			.bindings = boardDescriptorSetBindings,
-			.bindingCount = 2
+			.bindingCount = 4
 		}, {
 			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
 			.descriptorInfos = piecesDescriptorSetDescriptorInfos,
-			.descriptorCount = 1,
-			.bindings = &piecesBufferBinding,
-			.bindingCount = 1
+			.descriptorCount = 3,
+			.bindings = piecesDescriptorSetBindings,
+			.bindingCount = 3
 		}
 	};
 	VkDescriptorSet descriptorSets[2];
@@ -532,102 +586,258 @@ static bool createDescriptors(ChessBoard self, char **error)
 	if (!createDescriptorSets(self->device, createDescriptorSetInfos, 2, &self->descriptorPool, descriptorSets, descriptorSetLayouts, error)) {
 		return false;
 	}
-	self->boardDescriptorSets[0] = descriptorSets[0];
-	self->piecesDescriptorSets[0] = descriptorSets[1];
-	self->boardDescriptorSetLayouts[0] = descriptorSetLayouts[0];
-	self->piecesDescriptorSetLayouts[0] = descriptorSetLayouts[1];
+	self->boardDescriptorSet = descriptorSets[0];
+	self->piecesDescriptorSet = descriptorSets[1];
+	self->boardDescriptorSetLayout = descriptorSetLayouts[0];
+	self->piecesDescriptorSetLayout = descriptorSetLayouts[1];
 
 	return true;
 }
 
-static bool createBoardVertexBuffer(ChessBoard self, char **error)
+static bool reserveUniforms(ChessBoard self, char **error)
 {
-	if (!createMutableBufferWithStaging(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &self->boardStagingVertexBufferMappedMemory, &self->boardStagingVertexBuffer, &self->boardStagingVertexBufferAllocation, &self->boardVertexBuffer, &self->boardVertexBufferAllocation, self->boardVertices, CHESS_VERTEX_COUNT + 32, sizeof(*self->boardVertices), error)) {
+	if (!uniformRingReserve(self->uniformRing, sizeof(self->boardUniform), &self->boardUniformOffset, error)) {
+		return false;
+	}
+
+	if (!uniformRingReserve(self->uniformRing, sizeof(self->piecesUniforms), &self->piecesUniformOffset, error)) {
+		return false;
+	}
+
+	if (!uniformRingReserve(self->uniformRing, sizeof(self->tiles), &self->tilesUniformOffset, error)) {
 		return false;
 	}
 
 	return true;
 }
 
-static bool createBoardUniformBuffer(ChessBoard self, char **error)
+/* A change is copied into each frame's region as that frame comes round, rather than into all of them at once */
+static void writeStaleUniforms(ChessBoard self, uint32_t frame)
 {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-		if (!createHostVisibleMutableBuffer(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &self->boardUniformBufferMappedMemories[i], &self->boardUniformBuffers[i], &self->boardUniformBufferAllocations[i], &self->boardUniform, 1, sizeof(self->boardUniform), error)) {
-			return false;
-		}
+	if (self->staleTransformFrames & 1 << frame) {
+		uniformRingWrite(self->uniformRing, frame, self->boardUniformOffset, &self->boardUniform, sizeof(self->boardUniform));
+		uniformRingWrite(self->uniformRing, frame, self->piecesUniformOffset, self->piecesUniforms, sizeof(self->piecesUniforms));
+		self->staleTransformFrames &= ~(1 << frame);
 	}
 
-	return true;
+	if (self->staleTilesFrames & 1 << frame) {
+		uniformRingWrite(self->uniformRing, frame, self->tilesUniformOffset, self->tiles, sizeof(self->tiles));
+		self->staleTilesFrames &= ~(1 << frame);
+	}
 }
 
-static bool createPiecesUniformBuffer(ChessBoard self, char **error)
+static bool createBoardStateBuffer(ChessBoard self, UploadBatch uploadBatch, char **error)
 {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-		if (!createHostVisibleMutableBuffer(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &self->piecesUniformBufferMappedMemories[i], &self->piecesUniformBuffers[i], &self->piecesUniformBufferAllocations[i], self->piecesUniforms, CHESS_SQUARE_COUNT, sizeof(self->piecesUniforms[0]), error)) {
-			return false;
-		}
+	if (!bufferArenaAllocateStatic(self->bufferArena, uploadBatch, &self->boardState, sizeof(self->boardState), &self->boardStateBuffer, error)) {
+		return false;
 	}
 
+	memset(self->boardStateChangedSquares, 0, sizeof(self->boardStateChangedSquares));
+	self->boardStateHeaderChanged = false;
+
 	return true;
 }
 
-static void updateBoardUniformBuffer(ChessBoard self)
+static bool createPiecesComputeBuffers(ChessBoard self, UploadBatch uploadBatch, char **error)
 {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-		updateHostVisibleMutableBuffer(self->device, self->boardUniformBufferMappedMemories[i], &self->boardUniform, 1, sizeof(self->boardUniform));
+	float blackDiffuse[] = {0.3f, 0.3f, 0.3f};
+	srgbToLinear(blackDiffuse);
+	float blackAmbient[] = {0.03f, 0.03f, 0.03f};
+	srgbToLinear(blackAmbient);
+	float whiteDiffuse[] = {0.9f, 0.9f, 0.9f};
+	srgbToLinear(whiteDiffuse);
+	float whiteAmbient[] = {0.09f, 0.09f, 0.09f};
+	srgbToLinear(whiteAmbient);
+
+	PieceDrawParameters parameters = {
+		.diffuseColors = {
+			{blackDiffuse[0], blackDiffuse[1], blackDiffuse[2], 0.0f},
+			{whiteDiffuse[0], whiteDiffuse[1], whiteDiffuse[2], 0.0f}
+		},
+		.ambientColors = {
+			{blackAmbient[0], blackAmbient[1], blackAmbient[2], 0.0f},
+			{whiteAmbient[0], whiteAmbient[1], whiteAmbient[2], 0.0f}
+		}
+	};
+	for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+		for (size_t j = 0; j < MESH_LOD_COUNT; ++j) {
+			uint32_t *mesh = parameters.meshes[i * MESH_LOD_COUNT + j];
+			mesh[0] = self->pieceLods[i][j].indexCount;
+			mesh[1] = self->pieceIndexOffsets[i] + self->pieceLods[i][j].indexOffset;
+			mesh[2] = self->pieceVertexOffsets[i] + self->pieceLods[i][j].vertexOffset;
+			mesh[3] = 0;
+		}
+	}
+
+	if (!bufferArenaAllocateStatic(self->bufferArena, uploadBatch, &parameters, sizeof(parameters), &self->piecesParametersBuffer, error)) {
+		return false;
+	}
+
+	if (!bufferArenaAllocate(self->bufferArena, sizeof(PieceInstance) * CHESS_BOARD_MAX_TILES * CHESS_SQUARE_COUNT * PIECE_MESH_COUNT, &self->piecesInstanceBuffer, error)) {
+		return false;
 	}
+
+	if (!bufferArenaAllocate(self->bufferArena, sizeof(VkDrawIndexedIndirectCommand) * PIECE_MESH_COUNT, &self->piecesIndirectBuffer, error)) {
+		return false;
+	}
+
+	return true;
 }
 
-static void updatePiecesUniformBuffer(ChessBoard self)
+static bool createPiecesComputeDescriptors(ChessBoard self, char **error)
 {
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-		updateHostVisibleMutableBuffer(self->device, self->piecesUniformBufferMappedMemories[i], self->piecesUniforms, CHESS_SQUARE_COUNT, sizeof(self->piecesUniforms[0]));
+	VkDescriptorBufferInfo boardStateDescriptorInfo = {
+		.buffer = self->boardStateBuffer.buffer,
+		.offset = self->boardStateBuffer.offset,
+		.range = self->boardStateBuffer.size
+	};
+
+	VkDescriptorBufferInfo parametersDescriptorInfo = {
+		.buffer = self->piecesParametersBuffer.buffer,
+		.offset = self->piecesParametersBuffer.offset,
+		.range = self->piecesParametersBuffer.size
+	};
+
+	VkDescriptorBufferInfo instanceDescriptorInfo = {
+		.buffer = self->piecesInstanceBuffer.buffer,
+		.offset = self->piecesInstanceBuffer.offset,
+		.range = self->piecesInstanceBuffer.size
+	};
+
+	VkDescriptorBufferInfo indirectDescriptorInfo = {
+		.buffer = self->piecesIndirectBuffer.buffer,
+		.offset = self->piecesIndirectBuffer.offset,
+		.range = self->piecesIndirectBuffer.size
+	};
+
+	VkDescriptorSetLayoutBinding bindings[] = {
+		{
+			.binding = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = NULL
+		}, {
+			.binding = 1,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = NULL
+		}, {
+			.binding = 2,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = NULL
+		}, {
+			.binding = 3,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = NULL
+		}
+	};
+
+	void *descriptorInfos[] = {&boardStateDescriptorInfo, &parametersDescriptorInfo, &instanceDescriptorInfo, &indirectDescriptorInfo};
+	CreateDescriptorSetInfo createDescriptorSetInfo = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.descriptorInfos = descriptorInfos,
+		.descriptorCount = 4,
+		.bindings = bindings,
+		.bindingCount = 4
+	};
+	if (!createDescriptorSets(self->device, &createDescriptorSetInfo, 1, &self->piecesComputeDescriptorPool, &self->piecesComputeDescriptorSet, &self->piecesComputeDescriptorSetLayout, error)) {
+		return false;
 	}
+
+	return true;
 }
 
-static bool createBoardIndexBuffer(ChessBoard self, char **error)
+static bool createPiecesComputePipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error)
 {
-	uint16_t indices[CHESS_INDEX_COUNT + 48];
-
-	for (size_t i = 0; i < CHESS_SQUARE_COUNT + 8; ++i) {
-		size_t verticesOffset = i * 4;
-		size_t indicesOffset = i * 6;
+#ifndef EMBED_SHADERS
+	char *pieceInstancesCompShaderPath;
+	asprintf(&pieceInstancesCompShaderPath, "%s/%s", self->resourcePath, "piece_instances.comp.spv");
+	char *pieceInstancesCompShaderBytes;
+	uint32_t pieceInstancesCompShaderSize = 0;
 
-		indices[indicesOffset] = verticesOffset + 0;
-		indices[indicesOffset + 1] = verticesOffset + 1;
-		indices[indicesOffset + 2] = verticesOffset + 2;
-		indices[indicesOffset + 3] = verticesOffset + 2;
-		indices[indicesOffset + 4] = verticesOffset + 3;
-		indices[indicesOffset + 5] = verticesOffset + 0;
+	if ((pieceInstancesCompShaderSize = readFileToString(pieceInstancesCompShaderPath, &pieceInstancesCompShaderBytes)) == -1) {
+		asprintf(error, "Failed to open piece instances compute shader for reading.\n");
+		return false;
 	}
+#endif /* EMBED_SHADERS */
 
-	if (!createStaticBuffer(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &self->boardIndexBuffer, &self->boardIndexBufferAllocation, indices, sizeof(indices[0]), CHESS_INDEX_COUNT + 48, error)) {
+	ComputePipelineCreateInfo pipelineCreateInfo = {
+		.device = self->device,
+		.pipelineCache = self->pipelineCache,
+		.computeShaderBytes = pieceInstancesCompShaderBytes,
+		.computeShaderSize = pieceInstancesCompShaderSize,
+		.descriptorSetLayouts = &self->piecesComputeDescriptorSetLayout,
+		.descriptorSetLayoutCount = 1,
+		.pushConstantRanges = NULL,
+		.pushConstantRangeCount = 0
+	};
+	bool pipelineCreateSuccess = pipelineBuilderAddComputePipeline(pipelineBuilder, pipelineCreateInfo, &self->piecesComputePipelineLayout, &self->piecesComputePipeline, error);
+#ifndef EMBED_SHADERS
+	free(pieceInstancesCompShaderBytes);
+#endif /* EMBED_SHADERS */
+	if (!pipelineCreateSuccess) {
 		return false;
 	}
 
 	return true;
 }
 
-static bool createPiecesPipeline(ChessBoard self, char **error)
+static bool createPiecesPipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error)
 {
-	VkVertexInputBindingDescription vertexBindingDescription = {
-		.binding = 0,
-		.stride = sizeof(MeshVertex),
-		.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+	VkVertexInputBindingDescription vertexBindingDescriptions[] = {
+		{
+			.binding = 0,
+			.stride = sizeof(MeshVertex),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		}, {
+			.binding = 1,
+			.stride = sizeof(PieceInstance),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+		}
 	};
 
 	VkVertexInputAttributeDescription vertexAttributeDescriptions[] = {
 		{
 			.binding = 0,
 			.location = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.format = VK_FORMAT_R16G16B16A16_UNORM,
 			.offset = offsetof(MeshVertex, pos),
 		},
 		{
 			.binding = 0,
 			.location = 1,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.format = VK_FORMAT_R16G16_SNORM,
 			.offset = offsetof(MeshVertex, normal),
+		},
+		{
+			.binding = 1,
+			.location = 2,
+			.format = VK_FORMAT_R32_UINT,
+			.offset = offsetof(PieceInstance, transformIndex),
+		},
+		{
+			.binding = 1,
+			.location = 3,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = offsetof(PieceInstance, diffuseColor),
+		},
+		{
+			.binding = 1,
+			.location = 4,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = offsetof(PieceInstance, ambientColor),
+		},
+		{
+			.binding = 1,
+			.location = 5,
+			.format = VK_FORMAT_R32_UINT,
+			.offset = offsetof(PieceInstance, meshIndex),
 		}
 	};
 
@@ -651,12 +861,6 @@ static bool createPiecesPipeline(ChessBoard self, char **error)
 	}
 #endif /* EMBED_SHADERS */
 
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-		.offset = 0,
-		.size = sizeof(ChessPiecePushConstants)
-	};
-
 	VkPipelineDepthStencilStateCreateInfo depthStencilState = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
 		.depthTestEnable = VK_TRUE,
@@ -672,24 +876,25 @@ static bool createPiecesPipeline(ChessBoard self, char **error)
 
 	PipelineCreateInfo pipelineCreateInfo = {
 		.device = self->device,
+		.pipelineCache = self->pipelineCache,
 		.renderPass = self->renderPass,
 		.subpassIndex = self->subpass,
 		.vertexShaderBytes = phongVertShaderBytes,
 		.vertexShaderSize = phongVertShaderSize,
 		.fragmentShaderBytes = phongFragShaderBytes,
 		.fragmentShaderSize = phongFragShaderSize,
-		.vertexBindingDescriptionCount = 1,
-		.vertexBindingDescriptions = &vertexBindingDescription,
+		.vertexBindingDescriptionCount = sizeof(vertexBindingDescriptions) / sizeof(*vertexBindingDescriptions),
+		.vertexBindingDescriptions = vertexBindingDescriptions,
 		.vertexAttributeDescriptionCount = sizeof(vertexAttributeDescriptions) / sizeof(*vertexAttributeDescriptions),
 		.VertexAttributeDescriptions = vertexAttributeDescriptions,
-		.descriptorSetLayouts = self->piecesDescriptorSetLayouts,
+		.descriptorSetLayouts = &self->piecesDescriptorSetLayout,
 		.descriptorSetLayoutCount = 1,
-		.pushConstantRangeCount = 1,
-		.pushConstantRanges = &pushConstantRange,
+		.pushConstantRangeCount = 0,
+		.pushConstantRanges = NULL,
 		.depthStencilState = depthStencilState,
 		.sampleCount = self->sampleCount
 	};
-	bool pipelineCreateSuccess = createPipeline(pipelineCreateInfo, &self->piecesPipelineLayout, &self->piecesPipeline, false, error);
+	bool pipelineCreateSuccess = pipelineBuilderAddPipeline(pipelineBuilder, pipelineCreateInfo, &self->piecesPipelineLayout, &self->piecesPipeline, false, error);
 #ifndef EMBED_SHADERS
 	free(phongFragShaderBytes);
 	free(phongVertShaderBytes);
@@ -701,38 +906,8 @@ static bool createPiecesPipeline(ChessBoard self, char **error)
 	return true;
 }
 
-static bool createBoardPipeline(ChessBoard self, char **error)
+static bool createBoardPipeline(ChessBoard self, PipelineBuilder pipelineBuilder, char **error)
 {
-	VkVertexInputBindingDescription vertexBindingDescription = {
-		.binding = 0,
-		.stride = sizeof(BoardVertex),
-		.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
-	};
-
-	VkVertexInputAttributeDescription vertexAttributeDescriptions[] = {
-		{
-			.binding = 0,
-			.location = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = offsetof(BoardVertex, pos),
-		}, {
-			.binding = 0,
-			.location = 1,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = offsetof(BoardVertex, color),
-		}, {
-			.binding = 0,
-			.location = 2,
-			.format = VK_FORMAT_R32G32_SFLOAT,
-			.offset = offsetof(BoardVertex, texCoord),
-		}, {
-			.binding = 0,
-			.location = 3,
-			.format = VK_FORMAT_R32G32_SFLOAT,
-			.offset = offsetof(BoardVertex, texCoord2),
-		}
-	};
-
 #ifndef EMBED_SHADERS
 	char *chessBoardVertShaderPath;
 	char *chessBoardFragShaderPath;
@@ -757,7 +932,8 @@ static bool createBoardPipeline(ChessBoard self, char **error)
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
 		.depthTestEnable = VK_TRUE,
 		.depthWriteEnable = VK_TRUE,
-		.depthCompareOp = VK_COMPARE_OP_LESS,
+		/* Arrows lie flat on the squares in 2D and are drawn after them */
+		.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL,
 		.depthBoundsTestEnable = VK_FALSE,
 		.minDepthBounds = 0.0f,
 		.maxDepthBounds = 1.0f,
@@ -768,24 +944,26 @@ static bool createBoardPipeline(ChessBoard self, char **error)
 
 	PipelineCreateInfo pipelineCreateInfo = {
 		.device = self->device,
+		.pipelineCache = self->pipelineCache,
 		.renderPass = self->renderPass,
 		.subpassIndex = self->subpass,
 		.vertexShaderBytes = chessBoardVertShaderBytes,
 		.vertexShaderSize = chessBoardVertShaderSize,
 		.fragmentShaderBytes = chessBoardFragShaderBytes,
 		.fragmentShaderSize = chessBoardFragShaderSize,
-		.vertexBindingDescriptionCount = 1,
-		.vertexBindingDescriptions = &vertexBindingDescription,
-		.vertexAttributeDescriptionCount = sizeof(vertexAttributeDescriptions) / sizeof(*vertexAttributeDescriptions),
-		.VertexAttributeDescriptions = vertexAttributeDescriptions,
-		.descriptorSetLayouts = self->boardDescriptorSetLayouts,
+		/* The vertex shader builds its quads from the board state */
+		.vertexBindingDescriptionCount = 0,
+		.vertexBindingDescriptions = NULL,
+		.vertexAttributeDescriptionCount = 0,
+		.VertexAttributeDescriptions = NULL,
+		.descriptorSetLayouts = &self->boardDescriptorSetLayout,
 		.descriptorSetLayoutCount = 1,
 		.pushConstantRangeCount = 0,
 		.pushConstantRanges = NULL,
 		.depthStencilState = depthStencilState,
 		.sampleCount = self->sampleCount
 	};
-	bool pipelineCreateSuccess = createPipeline(pipelineCreateInfo, &self->boardPipelineLayout, &self->boardPipeline, false, error);
+	bool pipelineCreateSuccess = pipelineBuilderAddPipeline(pipelineBuilder, pipelineCreateInfo, &self->boardPipelineLayout, &self->boardPipeline, false, error);
 #ifndef EMBED_SHADERS
 	free(chessBoardFragShaderBytes);
 	free(chessBoardVertShaderBytes);
@@ -797,135 +975,226 @@ static bool createBoardPipeline(ChessBoard self, char **error)
 	return true;
 }
 
-static void updateBoardMesh(ChessBoard self)
+static void updateSquareState(ChessBoard self, size_t tile, ChessSquare square)
 {
-	float dark[] = {0.71f, 0.533f, 0.388f};
-	srgbToLinear(dark);
-	float light[] = {0.941f, 0.851f, 0.71f};
-	srgbToLinear(light);
-	float previousDark[] = {0.671f, 0.635f, 0.227f};
-	srgbToLinear(previousDark);
-	float previousLight[] = {0.808f, 0.824f, 0.42f};
-	srgbToLinear(previousLight);
-	float selectedDark[] = {0.749f, 0.475f, 0.271f};
-	srgbToLinear(selectedDark);
-	float selectedLight[] = {0.914f, 0.694f, 0.494f};
-	srgbToLinear(selectedLight);
-	float shadowDark[] = {0.41f, 0.233f, 0.088f};
-	srgbToLinear(shadowDark);
-	float shadowLight[] = {0.641f, 0.551f, 0.41f};
-	srgbToLinear(shadowLight);
+	LastMove lastMove = self->lastMoves[tile];
+	uint32_t state = self->boards[tile][square];
 
-	for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
-		float *spriteOrigin = self->enable3d ? pieceSpriteOriginMap[EMPTY] : pieceSpriteOriginMap[self->board[i]];
-		float *sprite2Origin = iconSpriteOriginMap[self->move[i]];
-		size_t verticesOffset = i * 4;
-		size_t offsetX = i % 8;
-		size_t offsetY = i / 8;
-		float squareWidth = VIEWPORT_WIDTH / 8.0f;
-		float squareHeight = squareWidth;
-		float squareOriginX = (offsetX * squareWidth) - (VIEWPORT_WIDTH / 2);
-		float squareOriginY = (offsetY * squareHeight) - (VIEWPORT_HEIGHT / 2);
-
-		float *thisLight = light;
-		float *thisDark = dark;
-		if (i == self->lastMove.from || i == self->lastMove.to) {
-			thisLight = previousLight;
-			thisDark = previousDark;
-		}
-		if (i == self->selected) {
-			thisLight = selectedLight;
-			thisDark = selectedDark;
+	if (tile == 0) {
+		state |= self->move[square] << 8;
+		if (square == self->selected) {
+			state |= SQUARE_SELECTED;
 		}
-		const float *color = (offsetY % 2) ?
-			((offsetX % 2) ? thisLight : thisDark) :
-			(offsetX % 2) ? thisDark : thisLight;
+	}
+	if (square == lastMove.from || square == lastMove.to) {
+		state |= SQUARE_LAST_MOVE;
+	}
 
-		self->boardVertices[verticesOffset] = (BoardVertex) {{squareOriginX, squareOriginY, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0], spriteOrigin[1]}, {sprite2Origin[0], sprite2Origin[1]}};
-		self->boardVertices[verticesOffset + 1] = (BoardVertex) {{squareOriginX, squareOriginY + squareHeight, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0], spriteOrigin[1] + 0.25f}, {sprite2Origin[0], sprite2Origin[1] + 0.25f}};
-		self->boardVertices[verticesOffset + 2] = (BoardVertex) {{squareOriginX + squareWidth, squareOriginY + squareHeight, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0] + 0.25f, spriteOrigin[1] + 0.25f}, {sprite2Origin[0] + 0.25f, sprite2Origin[1] + 0.25f}};
-		self->boardVertices[verticesOffset + 3] = (BoardVertex) {{squareOriginX + squareWidth, squareOriginY, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0] + 0.25f, spriteOrigin[1]}, {sprite2Origin[0] + 0.25f, sprite2Origin[1]}};
+	uint32_t *squareState = self->boardState.squares + tile * CHESS_SQUARE_COUNT + square;
+	if (*squareState != state) {
+		*squareState = state;
+		self->boardStateChangedSquares[tile] |= (uint64_t) 1 << square;
 	}
+}
 
-	if (self->enable3d) {
-		size_t sideOffset = CHESS_SQUARE_COUNT * 4;
-		for (size_t i = 0; i < 8; ++i) {
-			float *spriteOrigin = pieceSpriteOriginMap[EMPTY];
-			float *sprite2Origin = iconSpriteOriginMap[ILLEGAL];
-			size_t verticesOffset = sideOffset + i * 4;
-			float squareWidth = VIEWPORT_WIDTH / 8.0f;
-			float squareHeight = squareWidth / 2;
-			float squareOriginX = (i * squareWidth) - (VIEWPORT_WIDTH / 2);
-
-			const float *color = (i % 2) ? shadowLight : shadowDark;
-
-			self->boardVertices[verticesOffset] = (BoardVertex) {{squareOriginX, 1.0f, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0], spriteOrigin[1]}, {sprite2Origin[0], sprite2Origin[1]}};
-			self->boardVertices[verticesOffset + 1] = (BoardVertex) {{squareOriginX, 1.0f, squareHeight}, {color[0], color[1], color[2]}, {spriteOrigin[0], spriteOrigin[1] + 0.25f}, {sprite2Origin[0], sprite2Origin[1] + 0.25f}};
-			self->boardVertices[verticesOffset + 2] = (BoardVertex) {{squareOriginX + squareWidth, 1.0f, squareHeight}, {color[0], color[1], color[2]}, {spriteOrigin[0] + 0.25f, spriteOrigin[1] + 0.25f}, {sprite2Origin[0] + 0.25f, sprite2Origin[1] + 0.25f}};
-			self->boardVertices[verticesOffset + 3] = (BoardVertex) {{squareOriginX + squareWidth, 1.0f, 0}, {color[0], color[1], color[2]}, {spriteOrigin[0] + 0.25f, spriteOrigin[1]}, {sprite2Origin[0] + 0.25f, sprite2Origin[1]}};
-		}
+static void updateTileState(ChessBoard self, size_t tile)
+{
+	for (ChessSquare i = 0; i < CHESS_SQUARE_COUNT; ++i) {
+		updateSquareState(self, tile, i);
 	}
 }
 
-bool updateChessBoard(ChessBoard self, char **error)
+static void updateBoardStateHeader(ChessBoard self)
 {
-	if (!updateMutableBufferWithStaging(self->device, self->allocator, self->commandPool, self->queue, self->boardStagingVertexBufferMappedMemory, &self->boardStagingVertexBuffer, &self->boardVertexBuffer, self->boardVertices, CHESS_VERTEX_COUNT + (self->enable3d ? 32 : 0), sizeof(*self->boardVertices), error)) {
-		return false;
+	self->boardState.enable3d = self->enable3d;
+	self->boardState.arrowCount = self->arrowCount;
+	for (size_t i = 0; i < self->arrowCount; ++i) {
+		self->boardState.arrows[i] = self->arrows[i].from | self->arrows[i].to << 8;
 	}
 
-	return true;
+	self->boardStateHeaderChanged = true;
 }
 
-bool drawChessBoard(ChessBoard self, VkCommandBuffer commandBuffer, char **error)
+/*
+ * Picks the piece LOD from how many pixels across a piece's bounding sphere
+ * is on a centre square, so the triangle count follows the boards' pixel
+ * area rather than how many there are. Every tile is the same size, so one
+ * LOD serves all of them.
+ */
+static void updatePieceLod(ChessBoard self)
 {
-	VkDeviceSize offsets[] = {0};
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &self->boardVertexBuffer, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, self->boardIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->boardPipeline);
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->boardPipelineLayout, 0, 1, self->boardDescriptorSets, 0, NULL);
-	vkCmdDrawIndexed(commandBuffer, CHESS_INDEX_COUNT + 48, 1, 0, 0, 0);
+	TransformUniform *transform = self->piecesUniforms + CHESS_SQUARE_COUNT / 2;
+	float origin[mat4N] = {0.0f, 0.0f, 0.0f, 1.0f};
+	float radius[mat4N] = {self->pieceRadius, 0.0f, 0.0f, 0.0f};
+	float viewCenter[mat4N];
+	float viewRadius[mat4N];
+	mat4Vec4Multiply(transform->MV, origin, viewCenter);
+	mat4Vec4Multiply(transform->MV, radius, viewRadius);
+
+	float viewEdge[mat4N] = {viewCenter[0], viewCenter[1] + sqrtf(dot(viewRadius, viewRadius)), viewCenter[2], viewCenter[3]};
+	float clipCenter[mat4N];
+	float clipEdge[mat4N];
+	mat4Vec4Multiply(transform->P, viewCenter, clipCenter);
+	mat4Vec4Multiply(transform->P, viewEdge, clipEdge);
+	vec4ScalarDivide(clipCenter[3], clipCenter);
+	vec4ScalarDivide(clipEdge[3], clipEdge);
+
+	/* The tile's scale applies after projection, and clip space is 2 across the viewport */
+	float clipRadius = hypotf(clipEdge[0] - clipCenter[0], clipEdge[1] - clipCenter[1]) * self->tiles[0][1];
+	float pixels = clipRadius * fminf(self->viewportWidth, self->viewportHeight);
+
+	uint32_t lod = 0;
+	for (float threshold = PIECE_LOD_FULL_DETAIL_PIXELS; lod + 1 < MESH_LOD_COUNT && pixels < threshold; threshold /= 2) {
+		++lod;
+	}
 
-	if (self->enable3d) {
-		/* Draw Mesh */
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &self->piecesVertexBuffer, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, self->piecesIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->piecesPipeline);
-		for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
-			if (self->board[i] == EMPTY) {
+	if (self->boardState.pieceLod != lod) {
+		self->boardState.pieceLod = lod;
+		self->boardStateHeaderChanged = true;
+	}
+}
+
+/*
+ * Lay the tiles out in a centred grid of square cells, as close to square as
+ * the count allows, tile 0 at the top left. The offsets are applied after
+ * projection, so they're turned by the same pre-rotation as the boards.
+ */
+static void updateTiles(ChessBoard self)
+{
+	size_t columns = ceil(sqrt(self->tileCount));
+	size_t rows = (self->tileCount + columns - 1) / columns;
+	float cellSize = 2.0f / (columns > rows ? columns : rows);
+	float originX = -(columns * cellSize) / 2;
+	float originY = -(rows * cellSize) / 2;
+	float rotation = -getRotationRadians(self);
+
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		float offsetX = originX + ((i % columns) + 0.5f) * cellSize;
+		float offsetY = originY + ((i / columns) + 0.5f) * cellSize;
+		self->tiles[i][0] = cellSize / 2;
+		self->tiles[i][1] = cellSize / 2;
+		self->tiles[i][2] = offsetX * cosf(rotation) - offsetY * sinf(rotation);
+		self->tiles[i][3] = offsetX * sinf(rotation) + offsetY * cosf(rotation);
+	}
+
+	self->staleTilesFrames = EVERY_FRAME;
+}
+
+/*
+ * Queues each run of squares that changed since the last call as one upload,
+ * recorded into the next frame. Whatever doesn't fit in the upload ring
+ * stays marked and goes with a later call.
+ */
+bool updateChessBoard(ChessBoard self, char **error)
+{
+	if (self->boardStateHeaderChanged && uploadManagerUpload(self->uploadManager, self->boardStateBuffer.buffer, self->boardStateBuffer.offset, &self->boardState, offsetof(BoardState, squares))) {
+		self->boardStateHeaderChanged = false;
+	}
+
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		uint64_t changed = self->boardStateChangedSquares[i];
+		ChessSquare j = 0;
+		while (changed && j < CHESS_SQUARE_COUNT) {
+			if (!(changed & (uint64_t) 1 << j)) {
+				++j;
 				continue;
 			}
-
-			float diffuseColor[3];
-			float ambientColor[3];
-			if (self->board[i] >= BLACK_PAWN && self->board[i] <= BLACK_KING) {
-				diffuseColor[0] = 0.3f;
-				diffuseColor[1] = 0.3f;
-				diffuseColor[2] = 0.3f;
-				ambientColor[0] = 0.03f;
-				ambientColor[1] = 0.03f;
-				ambientColor[2] = 0.03f;
-			} else if (self->board[i] >= WHITE_PAWN && self->board[i] <= WHITE_KING) {
-				diffuseColor[0] = 0.9f;
-				diffuseColor[1] = 0.9f;
-				diffuseColor[2] = 0.9f;
-				ambientColor[0] = 0.09f;
-				ambientColor[1] = 0.09f;
-				ambientColor[2] = 0.09f;
+			ChessSquare first = j;
+			while (j < CHESS_SQUARE_COUNT && changed & (uint64_t) 1 << j) {
+				++j;
+			}
+			size_t index = i * CHESS_SQUARE_COUNT + first;
+			if (!uploadManagerUpload(self->uploadManager, self->boardStateBuffer.buffer, self->boardStateBuffer.offset + offsetof(BoardState, squares) + sizeof(uint32_t) * index, self->boardState.squares + index, sizeof(uint32_t) * (j - first))) {
+				continue;
+			}
+			for (ChessSquare k = first; k < j; ++k) {
+				self->boardStateChangedSquares[i] &= ~((uint64_t) 1 << k);
 			}
-			srgbToLinear(diffuseColor);
-			srgbToLinear(ambientColor);
+		}
+	}
+
+	return true;
+}
+
+/* Whether a frame still has to be drawn for the board to catch up with its last change */
+bool chessBoardHasPendingChanges(ChessBoard self)
+{
+	if (self->boardStateHeaderChanged || self->staleTransformFrames || self->staleTilesFrames) {
+		return true;
+	}
+
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		if (self->boardStateChangedSquares[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Must be recorded outside the render pass, before drawChessBoard. In 3D
+ * it runs every frame so the recorded commands don't depend on the board;
+ * in 2D no pieces are instanced, so it records nothing.
+ */
+void dispatchChessBoard(ChessBoard self, VkCommandBuffer commandBuffer)
+{
+	if (!self->enable3d) {
+		return;
+	}
+
+	/* The previous frame's draws must finish reading before they're overwritten */
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
 
-			ChessPiecePushConstants pushConstants = {
-				.diffuseColor = {diffuseColor[0], diffuseColor[1], diffuseColor[2], 0.0f},
-				.ambientColor = {ambientColor[0], ambientColor[1], ambientColor[2], 0.0f}
-			};
+	/* Every tile's workgroup counts its instances into the same draws */
+	vkCmdFillBuffer(commandBuffer, self->piecesIndirectBuffer.buffer, self->piecesIndirectBuffer.offset, self->piecesIndirectBuffer.size, 0);
+	VkMemoryBarrier fillBarrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, NULL, 0, NULL);
 
-			size_t meshIndex = pieceMeshIndexMap[self->board[i]];
-			uint32_t piecesUniformBufferOffset = sizeof(self->piecesUniforms[0]) * i;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, self->piecesComputePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, self->piecesComputePipelineLayout, 0, 1, &self->piecesComputeDescriptorSet, 0, NULL);
+	vkCmdDispatch(commandBuffer, self->tileCount, 1, 1);
 
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->piecesPipelineLayout, 0, 1, &self->piecesDescriptorSets[0], 1, &piecesUniformBufferOffset);
-			vkCmdPushConstants(commandBuffer, self->piecesPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
-			vkCmdDrawIndexed(commandBuffer, self->pieceVertexCounts[meshIndex], 1, self->pieceVertexOffsets[meshIndex], self->pieceVertexOffsets[meshIndex], 0);
+	VkMemoryBarrier memoryBarrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+}
+
+/* frame must be the one being recorded, after its fence has been waited on */
+bool drawChessBoard(ChessBoard self, VkCommandBuffer commandBuffer, uint32_t frame, char **error)
+{
+	writeStaleUniforms(self, frame);
+
+	/* In binding order: the transforms, then the tiles */
+	uint32_t boardDynamicOffsets[] = {
+		uniformRingGetDynamicOffset(self->uniformRing, frame, self->boardUniformOffset),
+		uniformRingGetDynamicOffset(self->uniformRing, frame, self->tilesUniformOffset)
+	};
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->boardPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->boardPipelineLayout, 0, 1, &self->boardDescriptorSet, 2, boardDynamicOffsets);
+	vkCmdDraw(commandBuffer, BOARD_QUAD_COUNT * 6, self->tileCount, 0, 0);
+
+	if (self->enable3d) {
+		/* Draw Mesh */
+		vkCmdBindIndexBuffer(commandBuffer, self->piecesIndexBuffer.buffer, self->piecesIndexBuffer.offset, VK_INDEX_TYPE_UINT16);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->piecesPipeline);
+		uint32_t piecesDynamicOffsets[] = {
+			uniformRingGetDynamicOffset(self->uniformRing, frame, self->piecesUniformOffset),
+			uniformRingGetDynamicOffset(self->uniformRing, frame, self->tilesUniformOffset)
+		};
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->piecesPipelineLayout, 0, 1, &self->piecesDescriptorSet, 2, piecesDynamicOffsets);
+		for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+			VkBuffer piecesVertexBuffers[] = {self->piecesVertexBuffer.buffer, self->piecesInstanceBuffer.buffer};
+			VkDeviceSize piecesOffsets[] = {self->piecesVertexBuffer.offset, self->piecesInstanceBuffer.offset + sizeof(PieceInstance) * CHESS_BOARD_MAX_TILES * CHESS_SQUARE_COUNT * i};
+			vkCmdBindVertexBuffers(commandBuffer, 0, 2, piecesVertexBuffers, piecesOffsets);
+			vkCmdDrawIndexedIndirect(commandBuffer, self->piecesIndirectBuffer.buffer, self->piecesIndirectBuffer.offset + sizeof(VkDrawIndexedIndirectCommand) * i, 1, sizeof(VkDrawIndexedIndirectCommand));
 		}
 	}
 
@@ -941,6 +1210,9 @@ static ChessSquare squareFromPointerPosition(ChessBoard self)
 	float planePoint[] = {0.0f, 0.0f, 0.0f};
 	float planeNormal[] = {0.0f, 0.0f, 1.0f};
 	screenPositionFromPointerPosition(self->pointerPosition, screen);
+	/* Only tile 0 is interactive */
+	screen[0] = (screen[0] - self->tiles[0][2]) / self->tiles[0][0];
+	screen[1] = (screen[1] - self->tiles[0][3]) / self->tiles[0][1];
 	castScreenToPlane(intersection, screen, planePoint, planeNormal, self->inverseViewProjection);
 	if (intersection[0] < -1.0f || intersection[0] > 1.0f || intersection[1] < -1.0f || intersection[1] > 1.0f) {
 		return CHESS_SQUARE_COUNT;
@@ -981,173 +1253,87 @@ void chessBoardHandleInputEvent(void *chessBoard, InputEvent *inputEvent)
 	}
 }
 
-static void readObjFromFile(void* ctx, const char* filename, const int is_mtl, const char* obj_filename, char** data, size_t* len)
+static bool loadPieceMeshes(ChessBoard self, AssetLoader assetLoader, UploadBatch uploadBatch, char **error)
 {
-	if ((*len = readFileToString(obj_filename, data)) == -1) {
-    		*data = NULL;
-    		*len = 0;
+	/* pieceMeshIndexMap depends on the order of the mesh assets */
+	CookedMesh meshes[PIECE_MESH_COUNT] = {};
+	bool success = true;
+
+	for (size_t i = 0; i < PIECE_MESH_COUNT && success; ++i) {
+		success = assetLoaderTakeMesh(assetLoader, ASSET_PAWN_MESH + i, meshes + i, error);
 	}
-}
 
-static void readEmbeddedObj(void* ctx, const char* filename, const int is_mtl, const char* obj_filename, char** data, size_t* len)
-{
-#ifdef EMBED_MESHES
-	if (!strcmp(obj_filename, "pawn")) {
-		*data = pawnMeshBytes;
-		*len = pawnMeshSize;
-	} else if (!strcmp(obj_filename, "knight")) {
-		*data = knightMeshBytes;
-		*len = knightMeshSize;
-	} else if (!strcmp(obj_filename, "bishop")) {
-		*data = bishopMeshBytes;
-		*len = bishopMeshSize;
-	} else if (!strcmp(obj_filename, "rook")) {
-		*data = rookMeshBytes;
-		*len = rookMeshSize;
-	} else if (!strcmp(obj_filename, "queen")) {
-		*data = queenMeshBytes;
-		*len = queenMeshSize;
-	} else if (!strcmp(obj_filename, "king")) {
-		*data = kingMeshBytes;
-		*len = kingMeshSize;
-	}
-#endif /* EMBED_MESHES */
+	if (success) {
+		success = uploadPieceMeshes(self, meshes, uploadBatch, error);
+	}
+
+	for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+		freeCookedMesh(meshes[i]);
+	}
+
+	return success;
 }
 
-static bool loadPieceMeshes(ChessBoard self, char **error)
+/* The cooked arrays are copied straight into one vertex and one index staging buffer */
+static bool uploadPieceMeshes(ChessBoard self, CookedMesh *meshes, UploadBatch uploadBatch, char **error)
 {
-	/* pieceMeshIndexMap depends on this order */
-	char *pieceNames[] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
-	tinyobj_attrib_t attrib[6];
-	tinyobj_shape_t *shapes[6];
-	size_t shapeCount[6];
-	tinyobj_material_t *materials[6];
-	size_t materialCount[6];
-
 	size_t totalVertexCount = 0;
-
-	for (size_t i = 0; i < 6; ++i) {
-#ifndef EMBED_MESHES
-		char *pieceMeshPath;
-		asprintf(&pieceMeshPath, "%s/%s.obj", self->resourcePath, pieceNames[i]);
-#endif /* EMBED_MESHES */
-
-		if (tinyobj_parse_obj(
-			attrib + i,
-			shapes + i,
-			shapeCount + i,
-			materials + i,
-			materialCount + i,
-#ifndef EMBED_MESHES
-			pieceMeshPath,
-			readObjFromFile,
-#else /* EMBED_MESHES */
-			pieceNames[i],
-			readEmbeddedObj,
-#endif /* EMBED_MESHES */
-			NULL,
-			TINYOBJ_FLAG_TRIANGULATE) != TINYOBJ_SUCCESS
-		) {
-#ifndef EMBED_MESHES
-			free(pieceMeshPath);
-#endif /* EMBED_MESHES */
-			asprintf(error, "Failed to load mesh.\n");
-			return false;
-		}
-
-#ifndef EMBED_MESHES
-		free(pieceMeshPath);
-#endif /* EMBED_MESHES */
-
-		self->pieceVertexCounts[i] = attrib[i].num_face_num_verts * 3;
-		self->pieceVertexOffsets[i] = i == 0 ? 0 : self->pieceVertexOffsets[i - 1] + self->pieceVertexCounts[i - 1];
-		totalVertexCount += self->pieceVertexCounts[i];
+	size_t totalIndexCount = 0;
+
+	self->pieceRadius = 0.0f;
+	for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+		self->pieceVertexOffsets[i] = totalVertexCount;
+		self->pieceIndexOffsets[i] = totalIndexCount;
+		memcpy(self->pieceLods[i], meshes[i].lods, sizeof(self->pieceLods[i]));
+		totalVertexCount += meshes[i].vertexCount;
+		totalIndexCount += meshes[i].indexCount;
+
+		float radius = sqrtf(meshes[i].scale[0] * meshes[i].scale[0] + meshes[i].scale[1] * meshes[i].scale[1] + meshes[i].scale[2] * meshes[i].scale[2]) / 2;
+		self->pieceRadius = fmaxf(self->pieceRadius, radius);
 	}
 
-	MeshVertex *vertices = malloc(sizeof(*vertices) * totalVertexCount);
-	uint16_t *indices = malloc(sizeof(*indices) * totalVertexCount);
-
-	for (size_t i = 0; i < 6; ++i) {
-		parseTinyobjIntoBuffers(attrib[i], self->pieceVertexOffsets[i], self->pieceVertexCounts[i], vertices, indices);
+	VkDeviceSize vertexBufferSize = sizeof(MeshVertex) * totalVertexCount;
+	VkDeviceSize indexBufferSize = sizeof(uint16_t) * totalIndexCount;
+	VkBuffer vertexStagingBuffer;
+	VkBuffer indexStagingBuffer;
+	void *vertexStagingMemory;
+	void *indexStagingMemory;
+	if (!uploadBatchAllocate(uploadBatch, vertexBufferSize, &vertexStagingBuffer, &vertexStagingMemory, error)) {
+		return false;
 	}
-
-	if (!createStaticBuffer(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &self->piecesVertexBuffer, &self->piecesVertexBufferAllocation, vertices, totalVertexCount, sizeof(*vertices), error)) {
-		free(vertices);
-		free(indices);
+	if (!uploadBatchAllocate(uploadBatch, indexBufferSize, &indexStagingBuffer, &indexStagingMemory, error)) {
 		return false;
 	}
 
-	free(vertices);
+	for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+		memcpy((MeshVertex *) vertexStagingMemory + self->pieceVertexOffsets[i], meshes[i].vertices, sizeof(MeshVertex) * meshes[i].vertexCount);
+		memcpy((uint16_t *) indexStagingMemory + self->pieceIndexOffsets[i], meshes[i].indices, sizeof(uint16_t) * meshes[i].indexCount);
+	}
 
-	if (!createStaticBuffer(self->device, self->allocator, self->commandPool, self->queue, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &self->piecesIndexBuffer, &self->piecesIndexBufferAllocation, indices, totalVertexCount, sizeof(*indices), error)) {
-		free(vertices);
-		free(indices);
+	if (!bufferArenaAllocate(self->bufferArena, vertexBufferSize, &self->piecesVertexBuffer, error)) {
 		return false;
 	}
+	uploadBatchCopyBuffer(uploadBatch, vertexStagingBuffer, self->piecesVertexBuffer.buffer, self->piecesVertexBuffer.offset, vertexBufferSize);
 
-	free(indices);
-
-	for (size_t i = 0; i < 6; ++i) {
-		tinyobj_attrib_free(attrib + i);
-		tinyobj_shapes_free(shapes[i], shapeCount[i]);
-		tinyobj_materials_free(materials[i], materialCount[i]);
+	if (!bufferArenaAllocate(self->bufferArena, indexBufferSize, &self->piecesIndexBuffer, error)) {
+		return false;
 	}
+	uploadBatchCopyBuffer(uploadBatch, indexStagingBuffer, self->piecesIndexBuffer.buffer, self->piecesIndexBuffer.offset, indexBufferSize);
 
-	return true;
-}
-
-static void parseTinyobjIntoBuffers(tinyobj_attrib_t attrib, size_t vertexOffset, size_t vertexCount, MeshVertex *vertices, uint16_t *indices)
-{
-	size_t faceOffset = 0;
-
-	for (size_t i = 0; i < attrib.num_face_num_verts; ++i) {
-		for (size_t f = 0; f < (size_t) attrib.face_num_verts[i] / 3; ++f) {
-			tinyobj_vertex_index_t idx0 = attrib.faces[faceOffset + 3 * f + 0];
-			tinyobj_vertex_index_t idx1 = attrib.faces[faceOffset + 3 * f + 1];
-			tinyobj_vertex_index_t idx2 = attrib.faces[faceOffset + 3 * f + 2];
-
-			float v[3][3];
-
-			for (size_t k = 0; k < 3; ++k) {
-				int f0 = idx0.v_idx;
-				int f1 = idx1.v_idx;
-				int f2 = idx2.v_idx;
-
-				v[0][k] = attrib.vertices[3 * (size_t) f0 + k];
-				v[1][k] = attrib.vertices[3 * (size_t) f1 + k];
-				v[2][k] = attrib.vertices[3 * (size_t) f2 + k];
-			}
-
-			float n[3][3];
-
-			if (attrib.num_normals > 0) {
-				int f0 = idx0.vn_idx;
-				int f1 = idx1.vn_idx;
-				int f2 = idx2.vn_idx;
-
-				if (f0 >= 0 && f1 >= 0 && f2 >= 0) {
- 					for (size_t k = 0; k < 3; ++k) {
-						n[0][k] = attrib.normals[3 * (size_t)f0 + k];
-						n[1][k] = attrib.normals[3 * (size_t)f1 + k];
-						n[2][k] = attrib.normals[3 * (size_t)f2 + k];
-					}
-				}
-			}
-
-			for (size_t j = 0; j < 3; ++j) {
-				vertices[vertexOffset + faceOffset + (f * 3) + j] = (MeshVertex) {
-					.pos = {v[j][0], v[j][1], v[j][2]},
-					.normal = {n[j][0], n[j][1], n[j][2]}
-				};
-			}
+	PieceMeshBounds bounds;
+	for (size_t i = 0; i < PIECE_MESH_COUNT; ++i) {
+		for (size_t k = 0; k < 3; ++k) {
+			bounds.scales[i][k] = meshes[i].scale[k];
+			bounds.biases[i][k] = meshes[i].bias[k];
 		}
-
-		faceOffset += (size_t) attrib.face_num_verts[i];
+		bounds.scales[i][3] = 0.0f;
+		bounds.biases[i][3] = 0.0f;
 	}
-
-	for (size_t i = 0; i < vertexCount; ++i) {
-		indices[vertexOffset + i] = i;
+	if (!bufferArenaAllocateStatic(self->bufferArena, uploadBatch, &bounds, sizeof(bounds), &self->piecesBoundsBuffer, error)) {
+		return false;
 	}
+
+	return true;
 }
 
 void destroyChessBoard(ChessBoard self)
@@ -1159,22 +1345,14 @@ void destroyChessBoard(ChessBoard self)
 	destroyPipelineLayout(self->device, self->boardPipelineLayout);
 	destroyPipeline(self->device, self->piecesPipeline);
 	destroyPipelineLayout(self->device, self->piecesPipelineLayout);
+	destroyPipeline(self->device, self->piecesComputePipeline);
+	destroyPipelineLayout(self->device, self->piecesComputePipelineLayout);
+	destroyDescriptorPool(self->device, self->piecesComputeDescriptorPool);
+	destroyDescriptorSetLayout(self->device, self->piecesComputeDescriptorSetLayout);
 	destroyDescriptorPool(self->device, self->descriptorPool);
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-		destroyDescriptorSetLayout(self->device, self->boardDescriptorSetLayouts[i]);
-		destroyDescriptorSetLayout(self->device, self->piecesDescriptorSetLayouts[i]);
-		vmaUnmapMemory(self->allocator, self->boardUniformBufferAllocations[i]);
-		destroyBuffer(self->allocator, self->boardUniformBuffers[i], self->boardUniformBufferAllocations[i]);
-		vmaUnmapMemory(self->allocator, self->piecesUniformBufferAllocations[i]);
-		destroyBuffer(self->allocator, self->piecesUniformBuffers[i], self->piecesUniformBufferAllocations[i]);
-	}
+	destroyDescriptorSetLayout(self->device, self->boardDescriptorSetLayout);
+	destroyDescriptorSetLayout(self->device, self->piecesDescriptorSetLayout);
 	destroySampler(self->device, self->sampler);
-	vmaUnmapMemory(self->allocator, self->boardStagingVertexBufferAllocation);
-	destroyBuffer(self->allocator, self->boardStagingVertexBuffer, self->boardStagingVertexBufferAllocation);
-	destroyBuffer(self->allocator, self->boardVertexBuffer, self->boardVertexBufferAllocation);
-	destroyBuffer(self->allocator, self->boardIndexBuffer, self->boardIndexBufferAllocation);
-	destroyBuffer(self->allocator, self->piecesVertexBuffer, self->piecesVertexBufferAllocation);
-	destroyBuffer(self->allocator, self->piecesIndexBuffer, self->piecesIndexBufferAllocation);
 	destroyImageView(self->device, self->textureImageView);
 
 	destroyImage(self->allocator, self->textureImage, self->textureImageAllocation);
@@ -1185,23 +1363,21 @@ void chessBoardSetOrientation(ChessBoard self, Orientation orientation)
 {
 	self->orientation = orientation;
 
+	updateTiles(self);
 	updateUniformBuffers(self);
-	updateBoardUniformBuffer(self);
-	updatePiecesUniformBuffer(self);
-	updateBoardMesh(self);
 }
 
 void basicSetBoard(ChessBoard self, Board8x8 board)
 {
 	for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
-		self->board[i] = board[i];
+		self->boards[0][i] = board[i];
 	}
 }
 
 void chessBoardSetBoard(ChessBoard self, Board8x8 board)
 {
 	basicSetBoard(self, board);
-	updateBoardMesh(self);
+	updateTileState(self, 0);
 }
 
 void basicSetMove(ChessBoard self, MoveBoard8x8 move)
@@ -1214,21 +1390,78 @@ void basicSetMove(ChessBoard self, MoveBoard8x8 move)
 void chessBoardSetMove(ChessBoard self, MoveBoard8x8 move)
 {
 	basicSetMove(self, move);
-	updateBoardMesh(self);
+	updateTileState(self, 0);
 }
 
 void chessBoardSetSelected(ChessBoard self, ChessSquare selected)
 {
+	ChessSquare previous = self->selected;
 	self->selected = selected;
 
-	updateBoardMesh(self);
+	if (previous < CHESS_SQUARE_COUNT) {
+		updateSquareState(self, 0, previous);
+	}
+	if (selected < CHESS_SQUARE_COUNT) {
+		updateSquareState(self, 0, selected);
+	}
 }
 
 void chessBoardSetLastMove(ChessBoard self, LastMove lastMove)
 {
-	self->lastMove = lastMove;
+	LastMove previous = self->lastMoves[0];
+	self->lastMoves[0] = lastMove;
+
+	ChessSquare squares[] = {previous.from, previous.to, lastMove.from, lastMove.to};
+	for (size_t i = 0; i < 4; ++i) {
+		if (squares[i] < CHESS_SQUARE_COUNT) {
+			updateSquareState(self, 0, squares[i]);
+		}
+	}
+}
+
+void chessBoardSetArrows(ChessBoard self, const BoardArrow *arrows, size_t arrowCount)
+{
+	self->arrowCount = arrowCount < CHESS_BOARD_MAX_ARROWS ? arrowCount : CHESS_BOARD_MAX_ARROWS;
+	for (size_t i = 0; i < self->arrowCount; ++i) {
+		self->arrows[i] = arrows[i];
+	}
 
-	updateBoardMesh(self);
+	updateBoardStateHeader(self);
+}
+
+size_t chessBoardGetTileCount(ChessBoard self)
+{
+	return self->tileCount;
+}
+
+void chessBoardSetTileCount(ChessBoard self, size_t tileCount)
+{
+	if (tileCount < 1) {
+		tileCount = 1;
+	} else if (tileCount > CHESS_BOARD_MAX_TILES) {
+		tileCount = CHESS_BOARD_MAX_TILES;
+	}
+	if (self->tileCount == tileCount) {
+		return;
+	}
+
+	self->tileCount = tileCount;
+
+	updateTiles(self);
+	updatePieceLod(self);
+}
+
+/* Tiles past the current count keep their board until they're shown */
+void chessBoardSetTileBoard(ChessBoard self, size_t tile, Board8x8 board, LastMove lastMove)
+{
+	if (tile >= CHESS_BOARD_MAX_TILES) {
+		return;
+	}
+
+	memcpy(self->boards[tile], board, sizeof(self->boards[tile]));
+	self->lastMoves[tile] = lastMove;
+
+	updateTileState(self, tile);
 }
 
 bool chessBoardGetEnable3d(ChessBoard self)
@@ -1245,9 +1478,8 @@ void chessBoardSetEnable3d(ChessBoard self, bool enable3d)
 	self->enable3d = enable3d;
 
 	updateUniformBuffers(self);
-	updateBoardUniformBuffer(self);
-	updatePiecesUniformBuffer(self);
-	updateBoardMesh(self);
+	updateBoardStateHeader(self);
+	updatePieceLod(self);
 }
 
 Projection chessBoardGetProjection(ChessBoard self)
@@ -1264,6 +1496,43 @@ void chessBoardSetProjection(ChessBoard self, Projection projection)
 	self->projection = projection;
 
 	updateUniformBuffers(self);
-	updateBoardUniformBuffer(self);
-	updatePiecesUniformBuffer(self);
+	updatePieceLod(self);
+}
+
+/*
+ * For a render pass with a different sample count. The device must be
+ * idle, and the new pipelines aren't ready until pipelineBuilder finishes.
+ */
+bool chessBoardRecreatePipelines(ChessBoard self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error)
+{
+	destroyPipeline(self->device, self->boardPipeline);
+	destroyPipelineLayout(self->device, self->boardPipelineLayout);
+	destroyPipeline(self->device, self->piecesPipeline);
+	destroyPipelineLayout(self->device, self->piecesPipelineLayout);
+
+	self->renderPass = renderPass;
+	self->sampleCount = sampleCount;
+
+	if (!createBoardPipeline(self, pipelineBuilder, error)) {
+		return false;
+	}
+
+	if (!createPiecesPipeline(self, pipelineBuilder, error)) {
+		return false;
+	}
+
+	return true;
+}
+
+/* In pixels, for choosing the piece LOD */
+void chessBoardSetViewportExtent(ChessBoard self, float width, float height)
+{
+	if (self->viewportWidth == width && self->viewportHeight == height) {
+		return;
+	}
+
+	self->viewportWidth = width;
+	self->viewportHeight = height;
+
+	updatePieceLod(self);
 }
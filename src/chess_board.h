@@ -10,27 +10,43 @@ typedef struct chess_board_t *ChessBoard;
 #include "input_event.h"
 #include "window.h"
 #include "buffer.h"
+#include "upload.h"
+#include "uniform_ring.h"
+#include "buffer_arena.h"
+#include "pipeline.h"
+#include "asset_loader.h"
 #include "vulkan_utils.h"
 #include "vk_mem_alloc.h"
 
+#define CHESS_BOARD_MAX_ARROWS 8
+#define CHESS_BOARD_MAX_TILES 64
+
 typedef enum projection_t {
 	ORTHOGRAPHIC,
 	PERSPECTIVE
 } Projection;
 
-bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderPass, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, Orientation orientation, bool enable3d, Projection projection, char **error);
-bool drawChessBoard(ChessBoard self, VkCommandBuffer commandBuffer, char **error);
+bool createChessBoard(ChessBoard *chessBoard, ChessEngine engine, VkDevice device, VmaAllocator allocator, AssetLoader assetLoader, UploadBatch uploadBatch, UploadManager uploadManager, UniformRing uniformRing, BufferArena bufferArena, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, Orientation orientation, bool enable3d, Projection projection, char **error);
+void dispatchChessBoard(ChessBoard self, VkCommandBuffer commandBuffer);
+bool drawChessBoard(ChessBoard self, VkCommandBuffer commandBuffer, uint32_t frame, char **error);
 void destroyChessBoard(ChessBoard self);
 bool updateChessBoard(ChessBoard self, char **error);
+bool chessBoardHasPendingChanges(ChessBoard self);
 void chessBoardHandleInputEvent(void *chessBoard, InputEvent *inputEvent);
 void chessBoardSetOrientation(ChessBoard self, Orientation orientation);
 void chessBoardSetBoard(ChessBoard self, Board8x8 board);
 void chessBoardSetMove(ChessBoard self, MoveBoard8x8 move);
 void chessBoardSetSelected(ChessBoard self, ChessSquare selected);
 void chessBoardSetLastMove(ChessBoard self, LastMove lastMove);
+void chessBoardSetArrows(ChessBoard self, const BoardArrow *arrows, size_t arrowCount);
+size_t chessBoardGetTileCount(ChessBoard self);
+void chessBoardSetTileCount(ChessBoard self, size_t tileCount);
+void chessBoardSetTileBoard(ChessBoard self, size_t tile, Board8x8 board, LastMove lastMove);
 bool chessBoardGetEnable3d(ChessBoard self);
 void chessBoardSetEnable3d(ChessBoard self, bool enable3d);
 Projection chessBoardGetProjection(ChessBoard self);
 void chessBoardSetProjection(ChessBoard self, Projection projection);
+void chessBoardSetViewportExtent(ChessBoard self, float width, float height);
+bool chessBoardRecreatePipelines(ChessBoard self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error);
 
 #endif /* MODELER_CHESS_BOARD_H */
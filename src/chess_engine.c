@@ -1,23 +1,50 @@
+#include <ctype.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "chess_engine.h"
 #include "utils.h"
 
 struct chess_engine_t {
-	Board8x8 board;
+	ChessPosition position;
 	ChessSquare lastSelected;
+	LastMove lastMove;
+	ChessPosition tilePositions[CHESS_BOARD_MAX_TILES]; /* Tile 0 is position */
+	LastMove tileLastMoves[CHESS_BOARD_MAX_TILES];
+	bool tileChanged[CHESS_BOARD_MAX_TILES];
 	ChessBoard *chessBoard;
+	ChessSearch search;
+	bool analysisEnabled;
+	size_t analysisLineCount;
+	bool hasAnalysis;
+	Analysis analysis;
 };
 
 void basicSetBoard(ChessEngine self, Board8x8 board);
+static void moveSelected(ChessEngine self, ChessSquare from, ChessSquare to);
+static void restartAnalysis(ChessEngine self);
+static bool parseSquare(const char *name, ChessSquare *square);
+static bool parseTile(char **line, size_t *tile);
+static bool applyUciMove(ChessPosition *position, LastMove *lastMove, const char *move);
 
 static inline bool hasLastSelected(ChessEngine self)
 {
 	return self->lastSelected < CHESS_SQUARE_COUNT;
 }
 
-void createChessEngine(ChessEngine *chessEngine, ChessBoard *chessBoard)
+static inline ChessPosition *tilePosition(ChessEngine self, size_t tile)
+{
+	return tile == 0 ? &self->position : self->tilePositions + tile;
+}
+
+static inline LastMove *tileLastMove(ChessEngine self, size_t tile)
+{
+	return tile == 0 ? &self->lastMove : self->tileLastMoves + tile;
+}
+
+bool createChessEngine(ChessEngine *chessEngine, ChessBoard *chessBoard, Queue *renderQueue, char **error)
 {
 	*chessEngine = malloc(sizeof(**chessEngine));
 
@@ -25,19 +52,36 @@ void createChessEngine(ChessEngine *chessEngine, ChessBoard *chessBoard)
 
 	self->chessBoard = chessBoard;
 
-	Board8x8 initialSetup = {
-		BLACK_ROOK, BLACK_KNIGHT, BLACK_BISHOP, BLACK_QUEEN, BLACK_KING, BLACK_BISHOP, BLACK_KNIGHT, BLACK_ROOK,
-		BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN,
-		EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
-		EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
-		EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
-		EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
-		WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN,
-		WHITE_ROOK, WHITE_KNIGHT, WHITE_BISHOP, WHITE_QUEEN, WHITE_KING, WHITE_BISHOP, WHITE_KNIGHT, WHITE_ROOK
-	};
-	basicSetBoard(self, initialSetup);
+	if (!createChessSearch(&self->search, renderQueue, error)) {
+		free(self);
+		return false;
+	}
+
+	chessPositionSetInitial(&self->position);
 
 	self->lastSelected = CHESS_SQUARE_COUNT;
+	self->lastMove = (LastMove) {
+		.from = CHESS_SQUARE_COUNT,
+		.to = CHESS_SQUARE_COUNT
+	};
+
+	for (size_t i = 0; i < CHESS_BOARD_MAX_TILES; ++i) {
+		chessPositionSetInitial(self->tilePositions + i);
+		self->tileLastMoves[i] = self->lastMove;
+		self->tileChanged[i] = false;
+	}
+
+	self->analysisEnabled = false;
+	self->analysisLineCount = 3;
+	self->hasAnalysis = false;
+
+	return true;
+}
+
+void destroyChessEngine(ChessEngine self)
+{
+	destroyChessSearch(self->search);
+	free(self);
 }
 
 void chessEngineSquareSelected(ChessEngine self, ChessSquare square)
@@ -48,20 +92,20 @@ void chessEngineSquareSelected(ChessEngine self, ChessSquare square)
 		self->lastSelected = CHESS_SQUARE_COUNT;
 		chessBoardSetSelected(*self->chessBoard, self->lastSelected);
 	} else if (hasLastSelected(self)) {
-		self->board[square] = self->board[self->lastSelected];
-		self->board[self->lastSelected] = EMPTY;
+		moveSelected(self, self->lastSelected, square);
 
-		LastMove lastMove = {
+		self->lastMove = (LastMove) {
 			.from = self->lastSelected,
 			.to = square
 		};
 
 		self->lastSelected = CHESS_SQUARE_COUNT;
 
-		chessBoardSetBoard(*self->chessBoard, self->board);
-		chessBoardSetLastMove(*self->chessBoard, lastMove);
+		chessBoardSetBoard(*self->chessBoard, self->position.board);
+		chessBoardSetLastMove(*self->chessBoard, self->lastMove);
 		chessBoardSetSelected(*self->chessBoard, self->lastSelected);
-	} else if (self->board[square] != EMPTY) {
+		restartAnalysis(self);
+	} else if (self->position.board[square] != EMPTY) {
 		self->lastSelected = square;
 		chessBoardSetSelected(*self->chessBoard, self->lastSelected);
 	}
@@ -74,9 +118,7 @@ void chessEngineSquareSelected(ChessEngine self, ChessSquare square)
 
 void basicSetBoard(ChessEngine self, Board8x8 board)
 {
-	for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
-		self->board[i] = board[i];
-	}
+	chessPositionFromBoard(&self->position, board, WHITE);
 }
 
 void chessEngineSetBoard(ChessEngine self, Board8x8 board)
@@ -85,7 +127,8 @@ void chessEngineSetBoard(ChessEngine self, Board8x8 board)
 
 	basicSetBoard(self, board);
 
-	chessBoardSetBoard(*self->chessBoard, self->board);
+	chessBoardSetBoard(*self->chessBoard, self->position.board);
+	restartAnalysis(self);
 
 	if (!updateChessBoard(*self->chessBoard, error)) {
 		asprintf(error, "Failed to update chess board.\n");
@@ -116,3 +159,293 @@ void chessEngineReset(ChessEngine self)
 	};
 	chessEngineSetBoard(self, initialSetup);
 }
+
+/*
+ * Apply lines received from the board stream to the engine's boards only; the
+ * chess board is left untouched until chessEnginePublishBoard, so any number
+ * of lines costs a single upload. A line may start with a tile number and a
+ * colon, e.g. "3:e2e4", to address one of the tiled boards; lines without one
+ * go to the interactive board, tile 0. A FEN line replaces the whole position,
+ * so only the last one in the batch for each tile and the moves following it
+ * are applied. Returns whether any line was applied.
+ */
+bool chessEngineApplyStreamLines(ChessEngine self, char **lines, size_t lineCount)
+{
+	bool applied = false;
+	size_t lastFen[CHESS_BOARD_MAX_TILES] = {0}; /* One past the line, 0 if none */
+
+	for (size_t i = 0; i < lineCount; ++i) {
+		char *line = lines[i];
+		size_t tile;
+		if (parseTile(&line, &tile) && strchr(line, '/')) {
+			lastFen[tile] = i + 1;
+		}
+	}
+
+	for (size_t i = 0; i < lineCount; ++i) {
+		char *line = lines[i];
+		size_t tile;
+		if (!parseTile(&line, &tile)) {
+			fprintf(stderr, "Ignoring line for unknown board: %s\n", lines[i]);
+			continue;
+		}
+		if (i + 1 < lastFen[tile]) {
+			continue;
+		}
+
+		ChessPosition *position = tilePosition(self, tile);
+		LastMove *lastMove = tileLastMove(self, tile);
+
+		if (strchr(line, '/')) {
+			ChessPosition fenPosition;
+			if (!chessPositionFromFen(&fenPosition, line)) {
+				fprintf(stderr, "Ignoring invalid FEN: %s\n", line);
+				continue;
+			}
+			*position = fenPosition;
+			*lastMove = (LastMove) {
+				.from = CHESS_SQUARE_COUNT,
+				.to = CHESS_SQUARE_COUNT
+			};
+			self->tileChanged[tile] = true;
+			applied = true;
+			continue;
+		}
+
+		for (char *move = line; *move; ) {
+			while (isspace((unsigned char) *move)) {
+				++move;
+			}
+			if (!*move) {
+				break;
+			}
+			if (applyUciMove(position, lastMove, move)) {
+				self->tileChanged[tile] = true;
+				applied = true;
+			} else {
+				fprintf(stderr, "Ignoring invalid move: %s\n", move);
+			}
+			while (*move && !isspace((unsigned char) *move)) {
+				++move;
+			}
+		}
+	}
+
+	return applied;
+}
+
+/* Addressing a tile past the current count brings the tiles up to it */
+bool chessEnginePublishBoard(ChessEngine self, char **error)
+{
+	if (self->tileChanged[0]) {
+		self->lastSelected = CHESS_SQUARE_COUNT;
+		chessBoardSetSelected(*self->chessBoard, self->lastSelected);
+		chessBoardSetLastMove(*self->chessBoard, self->lastMove);
+		chessBoardSetBoard(*self->chessBoard, self->position.board);
+		restartAnalysis(self);
+		self->tileChanged[0] = false;
+	}
+
+	size_t tileCount = chessBoardGetTileCount(*self->chessBoard);
+	for (size_t i = 1; i < CHESS_BOARD_MAX_TILES; ++i) {
+		if (!self->tileChanged[i]) {
+			continue;
+		}
+		chessBoardSetTileBoard(*self->chessBoard, i, self->tilePositions[i].board, self->tileLastMoves[i]);
+		if (i >= tileCount) {
+			tileCount = i + 1;
+		}
+		self->tileChanged[i] = false;
+	}
+	chessBoardSetTileCount(*self->chessBoard, tileCount);
+
+	return updateChessBoard(*self->chessBoard, error);
+}
+
+bool chessEngineGetAnalysisEnabled(ChessEngine self)
+{
+	return self->analysisEnabled;
+}
+
+bool chessEngineSetAnalysisEnabled(ChessEngine self, bool enabled, char **error)
+{
+	self->analysisEnabled = enabled;
+	restartAnalysis(self);
+
+	return updateChessBoard(*self->chessBoard, error);
+}
+
+size_t chessEngineGetAnalysisLineCount(ChessEngine self)
+{
+	return self->analysisLineCount;
+}
+
+/* The current arrows stay up until the first iteration with the new count */
+void chessEngineSetAnalysisLineCount(ChessEngine self, size_t lineCount)
+{
+	self->analysisLineCount = lineCount;
+	if (self->analysisEnabled) {
+		chessSearchStart(self->search, &self->position, self->analysisLineCount);
+	}
+}
+
+/* NULL until the first iteration on the current position completes */
+const Analysis *chessEngineGetAnalysis(ChessEngine self)
+{
+	return self->analysisEnabled && self->hasAnalysis ? &self->analysis : NULL;
+}
+
+/*
+ * Called once per frame: picks up the newest iteration the search has
+ * finished, if any, and shows its lines as arrows, best first.
+ */
+bool chessEngineUpdateAnalysis(ChessEngine self, char **error)
+{
+	if (!self->analysisEnabled || !chessSearchPollAnalysis(self->search, &self->analysis)) {
+		return true;
+	}
+	self->hasAnalysis = true;
+
+	BoardArrow arrows[CHESS_SEARCH_MAX_LINES];
+	for (size_t i = 0; i < self->analysis.lineCount; ++i) {
+		arrows[i] = (BoardArrow) {
+			.from = self->analysis.lines[i].moves[0].from,
+			.to = self->analysis.lines[i].moves[0].to
+		};
+	}
+	chessBoardSetArrows(*self->chessBoard, arrows, self->analysis.lineCount);
+
+	return updateChessBoard(*self->chessBoard, error);
+}
+
+/* A move the rules don't allow is kept anyway, handing the turn over */
+static void moveSelected(ChessEngine self, ChessSquare from, ChessSquare to)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	size_t moveCount = chessPositionGenerateLegalMoves(&self->position, moves);
+
+	for (size_t i = 0; i < moveCount; ++i) {
+		if (moves[i].from == from && moves[i].to == to && (!(moves[i].flags & MOVE_PROMOTION) || pieceType(moves[i].promotion) == QUEEN)) {
+			ChessUndo undo;
+			chessPositionMakeMove(&self->position, moves[i], &undo);
+			return;
+		}
+	}
+
+	Board8x8 board;
+	memcpy(board, self->position.board, sizeof(board));
+	ChessColor color = pieceColor(board[from]);
+	board[to] = board[from];
+	board[from] = EMPTY;
+	chessPositionFromBoard(&self->position, board, color == WHITE ? BLACK : WHITE);
+}
+
+/* Old arrows belong to the previous position, so they go straight away */
+static void restartAnalysis(ChessEngine self)
+{
+	self->hasAnalysis = false;
+	chessBoardSetArrows(*self->chessBoard, NULL, 0);
+
+	if (self->analysisEnabled) {
+		chessSearchStart(self->search, &self->position, self->analysisLineCount);
+	} else {
+		chessSearchStop(self->search);
+	}
+}
+
+static bool parseSquare(const char *name, ChessSquare *square)
+{
+	if (name[0] < 'a' || name[0] > 'h' || name[1] < '1' || name[1] > '8') {
+		return false;
+	}
+
+	*square = ('8' - name[1]) * 8 + (name[0] - 'a');
+	return true;
+}
+
+/* Strips an optional "N:" tile prefix; false if the tile is out of range */
+static bool parseTile(char **line, size_t *tile)
+{
+	char *end;
+	unsigned long number = strtoul(*line, &end, 10);
+	if (end == *line || *end != ':') {
+		*tile = 0;
+		return true;
+	}
+
+	if (number >= CHESS_BOARD_MAX_TILES) {
+		return false;
+	}
+
+	*tile = number;
+	*line = end + 1;
+	return true;
+}
+
+/*
+ * Apply a move in UCI long algebraic notation, e.g. e2e4, e1g1 or e7e8q. A
+ * move that isn't legal in the current position is still carried out on the
+ * board, as the stream may be showing an unfinished or edited game.
+ */
+static bool applyUciMove(ChessPosition *position, LastMove *lastMove, const char *move)
+{
+	ChessSquare from;
+	ChessSquare to;
+	if (!parseSquare(move, &from) || !parseSquare(move + 2, &to) || from == to) {
+		return false;
+	}
+
+	ChessMove legalMove;
+	if (chessPositionParseMove(position, move, &legalMove)) {
+		ChessUndo undo;
+		chessPositionMakeMove(position, legalMove, &undo);
+		*lastMove = (LastMove) {
+			.from = from,
+			.to = to
+		};
+		return true;
+	}
+
+	Board8x8 board;
+	memcpy(board, position->board, sizeof(board));
+
+	Piece piece = board[from];
+	if (piece == EMPTY) {
+		return false;
+	}
+	bool white = piece >= WHITE_PAWN;
+
+	char promotion = move[4];
+	if (promotion && !isspace((unsigned char) promotion)) {
+		const char *promotionLetters = "nbrq";
+		const char *letter = strchr(promotionLetters, promotion);
+		if (!letter || (piece != BLACK_PAWN && piece != WHITE_PAWN)) {
+			return false;
+		}
+		piece = (white ? WHITE_KNIGHT : BLACK_KNIGHT) + (letter - promotionLetters);
+	}
+
+	size_t fromFile = from % 8;
+	size_t toFile = to % 8;
+	if ((piece == BLACK_KING || piece == WHITE_KING) && from / 8 == to / 8 && (fromFile > toFile ? fromFile - toFile : toFile - fromFile) == 2) {
+		/* Castling: bring the rook across the king */
+		size_t rank = from - fromFile;
+		ChessSquare rookFrom = rank + (toFile > fromFile ? 7 : 0);
+		ChessSquare rookTo = rank + (toFile > fromFile ? 5 : 3);
+		board[rookTo] = board[rookFrom];
+		board[rookFrom] = EMPTY;
+	} else if ((piece == BLACK_PAWN || piece == WHITE_PAWN) && fromFile != toFile && board[to] == EMPTY) {
+		/* En passant: the captured pawn sits beside the moving one */
+		board[from - fromFile + toFile] = EMPTY;
+	}
+
+	board[to] = piece;
+	board[from] = EMPTY;
+	chessPositionFromBoard(position, board, white ? BLACK : WHITE);
+	*lastMove = (LastMove) {
+		.from = from,
+		.to = to
+	};
+
+	return true;
+}
@@ -1,14 +1,26 @@
 #ifndef MODELER_CHESS_ENGINE_H
 #define MODELER_CHESS_ENGINE_H
 
+#include <stdbool.h>
+
 typedef struct chess_engine_t *ChessEngine;
 
 #include "chess.h"
 #include "chess_board.h"
+#include "chess_search.h"
 
-void createChessEngine(ChessEngine *chessEngine, ChessBoard *chessBoard);
+bool createChessEngine(ChessEngine *chessEngine, ChessBoard *chessBoard, Queue *renderQueue, char **error);
+void destroyChessEngine(ChessEngine self);
 void chessEngineSquareSelected(ChessEngine self, ChessSquare square);
 void chessEngineSetBoard(ChessEngine self, Board8x8 board);
 void chessEngineReset(ChessEngine self);
+bool chessEngineApplyStreamLines(ChessEngine self, char **lines, size_t lineCount);
+bool chessEnginePublishBoard(ChessEngine self, char **error);
+bool chessEngineGetAnalysisEnabled(ChessEngine self);
+bool chessEngineSetAnalysisEnabled(ChessEngine self, bool enabled, char **error);
+size_t chessEngineGetAnalysisLineCount(ChessEngine self);
+void chessEngineSetAnalysisLineCount(ChessEngine self, size_t lineCount);
+const Analysis *chessEngineGetAnalysis(ChessEngine self);
+bool chessEngineUpdateAnalysis(ChessEngine self, char **error);
 
 #endif /* MODELER_CHESS_ENGINE_H */
@@ -0,0 +1,673 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chess_position.h"
+
+/*
+ * Squares are generated on a 10x12 mailbox so that stepping off the edge of
+ * the board lands on a sentinel instead of needing per-direction file checks.
+ * Square indices match Board8x8: 0 is a8, 63 is h1.
+ */
+static const int mailbox[120] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 0, 1, 2, 3, 4, 5, 6, 7, -1,
+	-1, 8, 9, 10, 11, 12, 13, 14, 15, -1,
+	-1, 16, 17, 18, 19, 20, 21, 22, 23, -1,
+	-1, 24, 25, 26, 27, 28, 29, 30, 31, -1,
+	-1, 32, 33, 34, 35, 36, 37, 38, 39, -1,
+	-1, 40, 41, 42, 43, 44, 45, 46, 47, -1,
+	-1, 48, 49, 50, 51, 52, 53, 54, 55, -1,
+	-1, 56, 57, 58, 59, 60, 61, 62, 63, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const int mailbox64[CHESS_SQUARE_COUNT] = {
+	21, 22, 23, 24, 25, 26, 27, 28,
+	31, 32, 33, 34, 35, 36, 37, 38,
+	41, 42, 43, 44, 45, 46, 47, 48,
+	51, 52, 53, 54, 55, 56, 57, 58,
+	61, 62, 63, 64, 65, 66, 67, 68,
+	71, 72, 73, 74, 75, 76, 77, 78,
+	81, 82, 83, 84, 85, 86, 87, 88,
+	91, 92, 93, 94, 95, 96, 97, 98
+};
+
+static const int knightOffsets[] = {-21, -19, -12, -8, 8, 12, 19, 21};
+static const int bishopOffsets[] = {-11, -9, 9, 11};
+static const int rookOffsets[] = {-10, -1, 1, 10};
+static const int kingOffsets[] = {-11, -10, -9, -1, 1, 9, 10, 11};
+
+/* Castling rights that survive a move touching each square */
+static const uint8_t castlingMask[CHESS_SQUARE_COUNT] = {
+	15 & ~BLACK_QUEENSIDE, 15, 15, 15, 15 & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE), 15, 15, 15 & ~BLACK_KINGSIDE,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15 & ~WHITE_QUEENSIDE, 15, 15, 15, 15 & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE), 15, 15, 15 & ~WHITE_KINGSIDE
+};
+
+static uint64_t pieceKeys[13][CHESS_SQUARE_COUNT];
+static uint64_t castlingKeys[16];
+static uint64_t enPassantKeys[8];
+static uint64_t sideKey;
+static pthread_once_t keysOnce = PTHREAD_ONCE_INIT;
+
+static void initializeKeys(void);
+static void finishPosition(ChessPosition *position);
+static size_t generatePawnMoves(const ChessPosition *position, ChessMove *moves);
+static size_t generateSteppingMoves(const ChessPosition *position, ChessPieceType type, const int *offsets, size_t offsetCount, ChessMove *moves);
+static size_t generateSlidingMoves(const ChessPosition *position, ChessPieceType type, const int *offsets, size_t offsetCount, ChessMove *moves);
+static size_t generateCastlingMoves(const ChessPosition *position, ChessMove *moves);
+static bool isAttackedBySlider(const ChessPosition *position, int mailboxSquare, const int *offsets, Piece slider, Piece queen);
+
+static inline size_t addMove(ChessMove *moves, size_t count, int from, int to, Piece promotion, uint8_t flags)
+{
+	moves[count] = (ChessMove) {
+		.from = from,
+		.to = to,
+		.promotion = promotion,
+		.flags = flags
+	};
+	return count + 1;
+}
+
+static inline size_t addPawnMove(ChessMove *moves, size_t count, ChessColor color, int from, int to, uint8_t flags)
+{
+	if (to < 8 || to >= 56) {
+		for (ChessPieceType type = QUEEN; type >= KNIGHT; --type) {
+			count = addMove(moves, count, from, to, makePiece(color, type), flags | MOVE_PROMOTION);
+		}
+		return count;
+	}
+	return addMove(moves, count, from, to, EMPTY, flags);
+}
+
+void chessPositionSetInitial(ChessPosition *position)
+{
+	chessPositionFromFen(position, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+}
+
+/* Trailing fields may be omitted, defaulting to "w - - 0 1" */
+bool chessPositionFromFen(ChessPosition *position, const char *fen)
+{
+	static const char pieceLetters[] = " pnbrqkPNBRQK";
+	size_t square = 0;
+	size_t file = 0;
+	ChessPosition result = {
+		.sideToMove = WHITE,
+		.castling = 0,
+		.enPassant = CHESS_NO_SQUARE,
+		.halfmoveClock = 0,
+		.fullmoveNumber = 1
+	};
+
+	while (isspace((unsigned char) *fen)) {
+		++fen;
+	}
+
+	for (; *fen && !isspace((unsigned char) *fen); ++fen) {
+		char c = *fen;
+		const char *letter;
+		if (c == '/') {
+			if (file != 8) {
+				return false;
+			}
+			file = 0;
+		} else if (c >= '1' && c <= '8') {
+			size_t emptyCount = c - '0';
+			if (file + emptyCount > 8) {
+				return false;
+			}
+			for (size_t i = 0; i < emptyCount; ++i) {
+				result.board[square++] = EMPTY;
+			}
+			file += emptyCount;
+		} else if (c != ' ' && (letter = strchr(pieceLetters, c))) {
+			if (file == 8 || square == CHESS_SQUARE_COUNT) {
+				return false;
+			}
+			result.board[square++] = (Piece) (letter - pieceLetters);
+			++file;
+		} else {
+			return false;
+		}
+	}
+	if (square != CHESS_SQUARE_COUNT || file != 8) {
+		return false;
+	}
+
+	while (isspace((unsigned char) *fen)) {
+		++fen;
+	}
+	if (*fen == 'b') {
+		result.sideToMove = BLACK;
+	} else if (*fen && *fen != 'w') {
+		return false;
+	}
+	if (*fen) {
+		++fen;
+	}
+
+	while (isspace((unsigned char) *fen)) {
+		++fen;
+	}
+	for (; *fen && !isspace((unsigned char) *fen); ++fen) {
+		switch (*fen) {
+		case 'K':
+			result.castling |= WHITE_KINGSIDE;
+			break;
+		case 'Q':
+			result.castling |= WHITE_QUEENSIDE;
+			break;
+		case 'k':
+			result.castling |= BLACK_KINGSIDE;
+			break;
+		case 'q':
+			result.castling |= BLACK_QUEENSIDE;
+			break;
+		case '-':
+			break;
+		default:
+			return false;
+		}
+	}
+
+	while (isspace((unsigned char) *fen)) {
+		++fen;
+	}
+	if (fen[0] >= 'a' && fen[0] <= 'h' && fen[1] >= '1' && fen[1] <= '8') {
+		result.enPassant = ('8' - fen[1]) * 8 + (fen[0] - 'a');
+		fen += 2;
+	} else if (*fen == '-') {
+		++fen;
+	} else if (*fen) {
+		return false;
+	}
+
+	char *end;
+	long halfmoveClock = strtol(fen, &end, 10);
+	if (end != fen) {
+		result.halfmoveClock = halfmoveClock;
+		fen = end;
+		long fullmoveNumber = strtol(fen, &end, 10);
+		if (end != fen && fullmoveNumber > 0) {
+			result.fullmoveNumber = fullmoveNumber;
+		}
+	}
+
+	*position = result;
+	finishPosition(position);
+
+	return true;
+}
+
+/* Castling rights are assumed wherever king and rook are still at home */
+void chessPositionFromBoard(ChessPosition *position, Board8x8 board, ChessColor sideToMove)
+{
+	*position = (ChessPosition) {
+		.sideToMove = sideToMove,
+		.castling = 0,
+		.enPassant = CHESS_NO_SQUARE,
+		.halfmoveClock = 0,
+		.fullmoveNumber = 1
+	};
+	memcpy(position->board, board, sizeof(position->board));
+
+	if (board[60] == WHITE_KING) {
+		position->castling |= (board[63] == WHITE_ROOK ? WHITE_KINGSIDE : 0) | (board[56] == WHITE_ROOK ? WHITE_QUEENSIDE : 0);
+	}
+	if (board[4] == BLACK_KING) {
+		position->castling |= (board[7] == BLACK_ROOK ? BLACK_KINGSIDE : 0) | (board[0] == BLACK_ROOK ? BLACK_QUEENSIDE : 0);
+	}
+
+	finishPosition(position);
+}
+
+size_t chessPositionGeneratePseudoLegalMoves(const ChessPosition *position, ChessMove *moves)
+{
+	size_t count = 0;
+	for (ChessPieceType type = PAWN; type < CHESS_PIECE_TYPE_COUNT; ++type) {
+		count += chessPositionGeneratePieceMoves(position, type, moves + count);
+	}
+	return count;
+}
+
+size_t chessPositionGeneratePieceMoves(const ChessPosition *position, ChessPieceType type, ChessMove *moves)
+{
+	switch (type) {
+	case PAWN:
+		return generatePawnMoves(position, moves);
+	case KNIGHT:
+		return generateSteppingMoves(position, KNIGHT, knightOffsets, 8, moves);
+	case BISHOP:
+		return generateSlidingMoves(position, BISHOP, bishopOffsets, 4, moves);
+	case ROOK:
+		return generateSlidingMoves(position, ROOK, rookOffsets, 4, moves);
+	case QUEEN:
+		return generateSlidingMoves(position, QUEEN, kingOffsets, 8, moves);
+	case KING: {
+		size_t count = generateSteppingMoves(position, KING, kingOffsets, 8, moves);
+		return count + generateCastlingMoves(position, moves + count);
+	}
+	default:
+		return 0;
+	}
+}
+
+size_t chessPositionGenerateLegalMoves(ChessPosition *position, ChessMove *moves)
+{
+	ChessColor color = position->sideToMove;
+	size_t pseudoLegalCount = chessPositionGeneratePseudoLegalMoves(position, moves);
+	size_t count = 0;
+
+	for (size_t i = 0; i < pseudoLegalCount; ++i) {
+		ChessUndo undo;
+		chessPositionMakeMove(position, moves[i], &undo);
+		if (!chessPositionIsInCheck(position, color)) {
+			moves[count++] = moves[i];
+		}
+		chessPositionUnmakeMove(position, moves[i], &undo);
+	}
+
+	return count;
+}
+
+void chessPositionMakeMove(ChessPosition *position, ChessMove move, ChessUndo *undo)
+{
+	Piece *board = position->board;
+	Piece piece = board[move.from];
+	ChessColor color = position->sideToMove;
+	int capturedSquare = move.flags & MOVE_EN_PASSANT ? move.to + (color == WHITE ? 8 : -8) : move.to;
+
+	*undo = (ChessUndo) {
+		.captured = board[capturedSquare],
+		.castling = position->castling,
+		.enPassant = position->enPassant,
+		.halfmoveClock = position->halfmoveClock,
+		.hash = position->hash
+	};
+
+	uint64_t hash = position->hash ^ pieceKeys[piece][move.from];
+	if (undo->captured != EMPTY) {
+		hash ^= pieceKeys[undo->captured][capturedSquare];
+		board[capturedSquare] = EMPTY;
+	}
+
+	Piece placed = move.flags & MOVE_PROMOTION ? (Piece) move.promotion : piece;
+	board[move.from] = EMPTY;
+	board[move.to] = placed;
+	hash ^= pieceKeys[placed][move.to];
+
+	if (move.flags & MOVE_CASTLE) {
+		int rookFrom = move.to > move.from ? move.from + 3 : move.from - 4;
+		int rookTo = move.to > move.from ? move.from + 1 : move.from - 1;
+		Piece rook = board[rookFrom];
+		board[rookTo] = rook;
+		board[rookFrom] = EMPTY;
+		hash ^= pieceKeys[rook][rookFrom] ^ pieceKeys[rook][rookTo];
+	}
+
+	if (pieceType(piece) == KING) {
+		position->kings[color] = move.to;
+	}
+
+	if (position->enPassant != CHESS_NO_SQUARE) {
+		hash ^= enPassantKeys[position->enPassant % 8];
+	}
+	if (move.flags & MOVE_DOUBLE_PUSH) {
+		position->enPassant = (move.from + move.to) / 2;
+		hash ^= enPassantKeys[position->enPassant % 8];
+	} else {
+		position->enPassant = CHESS_NO_SQUARE;
+	}
+
+	uint8_t castling = position->castling & castlingMask[move.from] & castlingMask[move.to];
+	hash ^= castlingKeys[position->castling] ^ castlingKeys[castling];
+	position->castling = castling;
+
+	if (pieceType(piece) == PAWN || undo->captured != EMPTY) {
+		position->halfmoveClock = 0;
+	} else {
+		++position->halfmoveClock;
+	}
+	if (color == BLACK) {
+		++position->fullmoveNumber;
+	}
+
+	position->sideToMove = !color;
+	position->hash = hash ^ sideKey;
+}
+
+void chessPositionUnmakeMove(ChessPosition *position, ChessMove move, const ChessUndo *undo)
+{
+	Piece *board = position->board;
+	ChessColor color = !position->sideToMove;
+	Piece piece = move.flags & MOVE_PROMOTION ? makePiece(color, PAWN) : board[move.to];
+
+	board[move.from] = piece;
+	board[move.to] = EMPTY;
+	if (move.flags & MOVE_EN_PASSANT) {
+		board[move.to + (color == WHITE ? 8 : -8)] = undo->captured;
+	} else {
+		board[move.to] = undo->captured;
+	}
+
+	if (move.flags & MOVE_CASTLE) {
+		int rookFrom = move.to > move.from ? move.from + 3 : move.from - 4;
+		int rookTo = move.to > move.from ? move.from + 1 : move.from - 1;
+		board[rookFrom] = board[rookTo];
+		board[rookTo] = EMPTY;
+	}
+
+	if (pieceType(piece) == KING) {
+		position->kings[color] = move.from;
+	}
+	if (color == BLACK) {
+		--position->fullmoveNumber;
+	}
+
+	position->sideToMove = color;
+	position->castling = undo->castling;
+	position->enPassant = undo->enPassant;
+	position->halfmoveClock = undo->halfmoveClock;
+	position->hash = undo->hash;
+}
+
+bool chessPositionIsSquareAttacked(const ChessPosition *position, ChessSquare square, ChessColor attacker)
+{
+	const Piece *board = position->board;
+	int mailboxSquare = mailbox64[square];
+	int target;
+
+	/* Pawns attack toward the opponent, so look for them one rank behind */
+	int pawnDirection = attacker == WHITE ? 10 : -10;
+	Piece pawn = makePiece(attacker, PAWN);
+	if (((target = mailbox[mailboxSquare + pawnDirection - 1]) != -1 && board[target] == pawn) ||
+		((target = mailbox[mailboxSquare + pawnDirection + 1]) != -1 && board[target] == pawn)) {
+		return true;
+	}
+
+	Piece knight = makePiece(attacker, KNIGHT);
+	for (size_t i = 0; i < 8; ++i) {
+		if ((target = mailbox[mailboxSquare + knightOffsets[i]]) != -1 && board[target] == knight) {
+			return true;
+		}
+	}
+
+	Piece king = makePiece(attacker, KING);
+	for (size_t i = 0; i < 8; ++i) {
+		if ((target = mailbox[mailboxSquare + kingOffsets[i]]) != -1 && board[target] == king) {
+			return true;
+		}
+	}
+
+	Piece queen = makePiece(attacker, QUEEN);
+	return isAttackedBySlider(position, mailboxSquare, bishopOffsets, makePiece(attacker, BISHOP), queen) ||
+		isAttackedBySlider(position, mailboxSquare, rookOffsets, makePiece(attacker, ROOK), queen);
+}
+
+bool chessPositionIsInCheck(const ChessPosition *position, ChessColor color)
+{
+	if (position->kings[color] == CHESS_NO_SQUARE) {
+		return false;
+	}
+	return chessPositionIsSquareAttacked(position, position->kings[color], !color);
+}
+
+uint64_t chessPositionComputeHash(const ChessPosition *position)
+{
+	pthread_once(&keysOnce, initializeKeys);
+
+	uint64_t hash = castlingKeys[position->castling];
+	for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
+		if (position->board[i] != EMPTY) {
+			hash ^= pieceKeys[position->board[i]][i];
+		}
+	}
+	if (position->enPassant != CHESS_NO_SQUARE) {
+		hash ^= enPassantKeys[position->enPassant % 8];
+	}
+	if (position->sideToMove == BLACK) {
+		hash ^= sideKey;
+	}
+
+	return hash;
+}
+
+uint64_t chessPositionPerft(ChessPosition *position, unsigned depth)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	size_t moveCount = chessPositionGenerateLegalMoves(position, moves);
+
+	if (depth <= 1) {
+		return depth == 0 ? 1 : moveCount;
+	}
+
+	uint64_t nodes = 0;
+	for (size_t i = 0; i < moveCount; ++i) {
+		ChessUndo undo;
+		chessPositionMakeMove(position, moves[i], &undo);
+		nodes += chessPositionPerft(position, depth - 1);
+		chessPositionUnmakeMove(position, moves[i], &undo);
+	}
+
+	return nodes;
+}
+
+/* Match a UCI long algebraic move (e.g. e2e4, e7e8q) against the legal moves */
+bool chessPositionParseMove(ChessPosition *position, const char *string, ChessMove *move)
+{
+	ChessMove moves[CHESS_MAX_MOVES];
+	size_t moveCount = chessPositionGenerateLegalMoves(position, moves);
+
+	for (size_t i = 0; i < moveCount; ++i) {
+		char moveString[6];
+		chessMoveToString(moves[i], moveString);
+		size_t length = strlen(moveString);
+		if (strncmp(moveString, string, length) == 0 && (string[length] == '\0' || isspace((unsigned char) string[length]))) {
+			*move = moves[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void chessMoveToString(ChessMove move, char string[6])
+{
+	static const char promotionLetters[] = "  nbrq";
+
+	string[0] = 'a' + move.from % 8;
+	string[1] = '8' - move.from / 8;
+	string[2] = 'a' + move.to % 8;
+	string[3] = '8' - move.to / 8;
+	if (move.flags & MOVE_PROMOTION) {
+		string[4] = promotionLetters[pieceType(move.promotion) + 1];
+		string[5] = '\0';
+	} else {
+		string[4] = '\0';
+	}
+}
+
+static void initializeKeys(void)
+{
+	/* splitmix64 with a fixed seed, so hashes are stable across runs */
+	uint64_t state = 0x6d6f64656c657221;
+	uint64_t *keys[] = {pieceKeys[0], castlingKeys, enPassantKeys, &sideKey};
+	size_t keyCounts[] = {13 * CHESS_SQUARE_COUNT, 16, 8, 1};
+
+	for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+		for (size_t j = 0; j < keyCounts[i]; ++j) {
+			uint64_t z = (state += 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			keys[i][j] = z ^ (z >> 31);
+		}
+	}
+
+	/* An empty square never contributes to the hash */
+	memset(pieceKeys[EMPTY], 0, sizeof(pieceKeys[EMPTY]));
+	castlingKeys[0] = 0;
+}
+
+static void finishPosition(ChessPosition *position)
+{
+	position->kings[WHITE] = position->kings[BLACK] = CHESS_NO_SQUARE;
+	for (size_t i = 0; i < CHESS_SQUARE_COUNT; ++i) {
+		if (position->board[i] == WHITE_KING) {
+			position->kings[WHITE] = i;
+		} else if (position->board[i] == BLACK_KING) {
+			position->kings[BLACK] = i;
+		}
+	}
+
+	position->hash = chessPositionComputeHash(position);
+}
+
+static size_t generatePawnMoves(const ChessPosition *position, ChessMove *moves)
+{
+	const Piece *board = position->board;
+	ChessColor color = position->sideToMove;
+	Piece pawn = makePiece(color, PAWN);
+	int forward = color == WHITE ? -10 : 10;
+	int startRow = color == WHITE ? 6 : 1;
+	size_t count = 0;
+
+	for (int from = 0; from < CHESS_SQUARE_COUNT; ++from) {
+		if (board[from] != pawn) {
+			continue;
+		}
+
+		int mailboxSquare = mailbox64[from];
+		int to = mailbox[mailboxSquare + forward];
+		if (to != -1 && board[to] == EMPTY) {
+			count = addPawnMove(moves, count, color, from, to, 0);
+			int doubleTo;
+			if (from / 8 == startRow && board[doubleTo = mailbox[mailboxSquare + 2 * forward]] == EMPTY) {
+				count = addMove(moves, count, from, doubleTo, EMPTY, MOVE_DOUBLE_PUSH);
+			}
+		}
+
+		for (int side = -1; side <= 1; side += 2) {
+			if ((to = mailbox[mailboxSquare + forward + side]) == -1) {
+				continue;
+			}
+			if (board[to] != EMPTY && pieceColor(board[to]) != color) {
+				count = addPawnMove(moves, count, color, from, to, MOVE_CAPTURE);
+			} else if (to == position->enPassant) {
+				count = addMove(moves, count, from, to, EMPTY, MOVE_CAPTURE | MOVE_EN_PASSANT);
+			}
+		}
+	}
+
+	return count;
+}
+
+static size_t generateSteppingMoves(const ChessPosition *position, ChessPieceType type, const int *offsets, size_t offsetCount, ChessMove *moves)
+{
+	const Piece *board = position->board;
+	ChessColor color = position->sideToMove;
+	Piece piece = makePiece(color, type);
+	size_t count = 0;
+
+	for (int from = 0; from < CHESS_SQUARE_COUNT; ++from) {
+		if (board[from] != piece) {
+			continue;
+		}
+
+		for (size_t i = 0; i < offsetCount; ++i) {
+			int to = mailbox[mailbox64[from] + offsets[i]];
+			if (to == -1) {
+				continue;
+			}
+			if (board[to] == EMPTY) {
+				count = addMove(moves, count, from, to, EMPTY, 0);
+			} else if (pieceColor(board[to]) != color) {
+				count = addMove(moves, count, from, to, EMPTY, MOVE_CAPTURE);
+			}
+		}
+	}
+
+	return count;
+}
+
+static size_t generateSlidingMoves(const ChessPosition *position, ChessPieceType type, const int *offsets, size_t offsetCount, ChessMove *moves)
+{
+	const Piece *board = position->board;
+	ChessColor color = position->sideToMove;
+	Piece piece = makePiece(color, type);
+	size_t count = 0;
+
+	for (int from = 0; from < CHESS_SQUARE_COUNT; ++from) {
+		if (board[from] != piece) {
+			continue;
+		}
+
+		for (size_t i = 0; i < offsetCount; ++i) {
+			for (int mailboxSquare = mailbox64[from] + offsets[i], to; (to = mailbox[mailboxSquare]) != -1; mailboxSquare += offsets[i]) {
+				if (board[to] == EMPTY) {
+					count = addMove(moves, count, from, to, EMPTY, 0);
+					continue;
+				}
+				if (pieceColor(board[to]) != color) {
+					count = addMove(moves, count, from, to, EMPTY, MOVE_CAPTURE);
+				}
+				break;
+			}
+		}
+	}
+
+	return count;
+}
+
+static size_t generateCastlingMoves(const ChessPosition *position, ChessMove *moves)
+{
+	const Piece *board = position->board;
+	ChessColor color = position->sideToMove;
+	uint8_t kingside = color == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+	uint8_t queenside = color == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+	int king = color == WHITE ? 60 : 4;
+	size_t count = 0;
+
+	if (!(position->castling & (kingside | queenside)) || board[king] != makePiece(color, KING) || chessPositionIsSquareAttacked(position, king, !color)) {
+		return 0;
+	}
+
+	/* The destination square is left to the legality check like any other king move */
+	if ((position->castling & kingside) && board[king + 1] == EMPTY && board[king + 2] == EMPTY && board[king + 3] == makePiece(color, ROOK) &&
+		!chessPositionIsSquareAttacked(position, king + 1, !color)) {
+		count = addMove(moves, count, king, king + 2, EMPTY, MOVE_CASTLE);
+	}
+	if ((position->castling & queenside) && board[king - 1] == EMPTY && board[king - 2] == EMPTY && board[king - 3] == EMPTY && board[king - 4] == makePiece(color, ROOK) &&
+		!chessPositionIsSquareAttacked(position, king - 1, !color)) {
+		count = addMove(moves, count, king, king - 2, EMPTY, MOVE_CASTLE);
+	}
+
+	return count;
+}
+
+static bool isAttackedBySlider(const ChessPosition *position, int mailboxSquare, const int *offsets, Piece slider, Piece queen)
+{
+	const Piece *board = position->board;
+
+	for (size_t i = 0; i < 4; ++i) {
+		for (int next = mailboxSquare + offsets[i], target; (target = mailbox[next]) != -1; next += offsets[i]) {
+			if (board[target] == EMPTY) {
+				continue;
+			}
+			if (board[target] == slider || board[target] == queen) {
+				return true;
+			}
+			break;
+		}
+	}
+
+	return false;
+}
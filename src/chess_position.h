@@ -0,0 +1,99 @@
+#ifndef MODELER_CHESS_POSITION_H
+#define MODELER_CHESS_POSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chess.h"
+
+#define CHESS_NO_SQUARE (CHESS_SQUARE_COUNT)
+#define CHESS_MAX_MOVES 256
+
+typedef enum chess_color_t {
+	WHITE,
+	BLACK
+} ChessColor;
+
+typedef enum chess_piece_type_t {
+	PAWN,
+	KNIGHT,
+	BISHOP,
+	ROOK,
+	QUEEN,
+	KING,
+	CHESS_PIECE_TYPE_COUNT
+} ChessPieceType;
+
+typedef enum castling_rights_t {
+	WHITE_KINGSIDE = 1 << 0,
+	WHITE_QUEENSIDE = 1 << 1,
+	BLACK_KINGSIDE = 1 << 2,
+	BLACK_QUEENSIDE = 1 << 3
+} CastlingRights;
+
+typedef enum chess_move_flags_t {
+	MOVE_CAPTURE = 1 << 0,
+	MOVE_DOUBLE_PUSH = 1 << 1,
+	MOVE_EN_PASSANT = 1 << 2,
+	MOVE_CASTLE = 1 << 3,
+	MOVE_PROMOTION = 1 << 4
+} ChessMoveFlags;
+
+typedef struct chess_move_t {
+	uint8_t from;
+	uint8_t to;
+	uint8_t promotion; /* Piece, EMPTY unless MOVE_PROMOTION */
+	uint8_t flags;
+} ChessMove;
+
+/* Everything make can't recompute when unmaking */
+typedef struct chess_undo_t {
+	Piece captured;
+	uint8_t castling;
+	uint8_t enPassant;
+	uint16_t halfmoveClock;
+	uint64_t hash;
+} ChessUndo;
+
+typedef struct chess_position_t {
+	Board8x8 board;
+	ChessColor sideToMove;
+	uint8_t castling;
+	uint8_t enPassant; /* Square a pawn can capture onto, or CHESS_NO_SQUARE */
+	uint16_t halfmoveClock;
+	uint16_t fullmoveNumber;
+	uint8_t kings[2];
+	uint64_t hash;
+} ChessPosition;
+
+static inline ChessColor pieceColor(Piece piece)
+{
+	return piece >= WHITE_PAWN ? WHITE : BLACK;
+}
+
+static inline ChessPieceType pieceType(Piece piece)
+{
+	return (piece - 1) % 6;
+}
+
+static inline Piece makePiece(ChessColor color, ChessPieceType type)
+{
+	return (color == WHITE ? WHITE_PAWN : BLACK_PAWN) + type;
+}
+
+void chessPositionSetInitial(ChessPosition *position);
+bool chessPositionFromFen(ChessPosition *position, const char *fen);
+void chessPositionFromBoard(ChessPosition *position, Board8x8 board, ChessColor sideToMove);
+size_t chessPositionGeneratePseudoLegalMoves(const ChessPosition *position, ChessMove *moves);
+size_t chessPositionGeneratePieceMoves(const ChessPosition *position, ChessPieceType type, ChessMove *moves);
+size_t chessPositionGenerateLegalMoves(ChessPosition *position, ChessMove *moves);
+void chessPositionMakeMove(ChessPosition *position, ChessMove move, ChessUndo *undo);
+void chessPositionUnmakeMove(ChessPosition *position, ChessMove move, const ChessUndo *undo);
+bool chessPositionIsSquareAttacked(const ChessPosition *position, ChessSquare square, ChessColor attacker);
+bool chessPositionIsInCheck(const ChessPosition *position, ChessColor color);
+uint64_t chessPositionComputeHash(const ChessPosition *position);
+uint64_t chessPositionPerft(ChessPosition *position, unsigned depth);
+bool chessPositionParseMove(ChessPosition *position, const char *string, ChessMove *move);
+void chessMoveToString(ChessMove move, char string[6]);
+
+#endif /* MODELER_CHESS_POSITION_H */
@@ -0,0 +1,553 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+#include "utils.h"
+
+#include "chess_search.h"
+
+#define MAX_PLY 64
+#define INFINITE_SCORE (CHESS_SEARCH_MATE_SCORE + 1)
+#define MATE_THRESHOLD (CHESS_SEARCH_MATE_SCORE - MAX_PLY)
+#define BEST_MOVE_TABLE_SIZE (1 << 16)
+#define STOP_CHECK_INTERVAL 1024
+
+typedef struct best_move_entry_t {
+	uint64_t hash;
+	ChessMove move;
+} BestMoveEntry;
+
+struct chess_search_t {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	/* Guarded by mutex */
+	ChessPosition pendingPosition;
+	size_t pendingLineCount;
+	uint64_t pendingGeneration;
+	bool hasPendingJob;
+	bool terminate;
+	/* Raised to abandon the running search as soon as possible */
+	atomic_bool stop;
+	Queue *results;
+	/* Woken whenever a result is enqueued, so an idle render thread draws it */
+	Queue *renderQueue;
+	/* Render thread only */
+	uint64_t generation;
+	/* Search thread only */
+	ChessPosition position;
+	uint64_t nodes;
+	bool aborted;
+	ChessMove excluded[CHESS_SEARCH_MAX_LINES];
+	size_t excludedCount;
+	ChessMove pv[MAX_PLY][MAX_PLY];
+	size_t pvLength[MAX_PLY];
+	BestMoveEntry *bestMoves;
+};
+
+static const int pieceValues[CHESS_PIECE_TYPE_COUNT] = {100, 320, 330, 500, 900, 0};
+
+/* From White's point of view, a8 first like Board8x8; Black mirrors the rank */
+static const int pieceSquareTables[CHESS_PIECE_TYPE_COUNT][CHESS_SQUARE_COUNT] = {
+	{
+		0, 0, 0, 0, 0, 0, 0, 0,
+		50, 50, 50, 50, 50, 50, 50, 50,
+		10, 10, 20, 30, 30, 20, 10, 10,
+		5, 5, 10, 25, 25, 10, 5, 5,
+		0, 0, 0, 20, 20, 0, 0, 0,
+		5, -5, -10, 0, 0, -10, -5, 5,
+		5, 10, 10, -20, -20, 10, 10, 5,
+		0, 0, 0, 0, 0, 0, 0, 0
+	},
+	{
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20, 0, 0, 0, 0, -20, -40,
+		-30, 0, 10, 15, 15, 10, 0, -30,
+		-30, 5, 15, 20, 20, 15, 5, -30,
+		-30, 0, 15, 20, 20, 15, 0, -30,
+		-30, 5, 10, 15, 15, 10, 5, -30,
+		-40, -20, 0, 5, 5, 0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50
+	},
+	{
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10, 0, 0, 0, 0, 0, 0, -10,
+		-10, 0, 5, 10, 10, 5, 0, -10,
+		-10, 5, 5, 10, 10, 5, 5, -10,
+		-10, 0, 10, 10, 10, 10, 0, -10,
+		-10, 10, 10, 10, 10, 10, 10, -10,
+		-10, 5, 0, 0, 0, 0, 5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20
+	},
+	{
+		0, 0, 0, 0, 0, 0, 0, 0,
+		5, 10, 10, 10, 10, 10, 10, 5,
+		-5, 0, 0, 0, 0, 0, 0, -5,
+		-5, 0, 0, 0, 0, 0, 0, -5,
+		-5, 0, 0, 0, 0, 0, 0, -5,
+		-5, 0, 0, 0, 0, 0, 0, -5,
+		-5, 0, 0, 0, 0, 0, 0, -5,
+		0, 0, 0, 5, 5, 0, 0, 0
+	},
+	{
+		-20, -10, -10, -5, -5, -10, -10, -20,
+		-10, 0, 0, 0, 0, 0, 0, -10,
+		-10, 0, 5, 5, 5, 5, 0, -10,
+		-5, 0, 5, 5, 5, 5, 0, -5,
+		0, 0, 5, 5, 5, 5, 0, -5,
+		-10, 5, 5, 5, 5, 5, 0, -10,
+		-10, 0, 5, 0, 0, 0, 0, -10,
+		-20, -10, -10, -5, -5, -10, -10, -20
+	},
+	{
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		20, 20, 0, 0, 0, 0, 20, 20,
+		20, 30, 10, 0, 0, 10, 30, 20
+	}
+};
+
+static void *searchThread(void *arg);
+static void searchPosition(ChessSearch self, uint64_t generation, size_t lineCount);
+static int search(ChessSearch self, unsigned depth, unsigned ply, int alpha, int beta);
+static int quiesce(ChessSearch self, unsigned ply, int alpha, int beta);
+static int evaluate(const ChessPosition *position);
+static void scoreMoves(ChessSearch self, const ChessMove *moves, int *scores, size_t moveCount);
+static void pickMove(ChessMove *moves, int *scores, size_t moveCount, size_t index);
+static void updatePv(ChessSearch self, unsigned ply, ChessMove move);
+
+static inline bool movesEqual(ChessMove a, ChessMove b)
+{
+	return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
+
+static inline bool shouldStop(ChessSearch self)
+{
+	if (self->nodes % STOP_CHECK_INTERVAL == 0 && atomic_load_explicit(&self->stop, memory_order_relaxed)) {
+		self->aborted = true;
+	}
+	return self->aborted;
+}
+
+bool createChessSearch(ChessSearch *chessSearch, Queue *renderQueue, char **error)
+{
+	*chessSearch = malloc(sizeof(**chessSearch));
+
+	ChessSearch self = *chessSearch;
+
+	pthread_mutex_init(&self->mutex, NULL);
+	pthread_cond_init(&self->condition, NULL);
+	self->hasPendingJob = false;
+	self->terminate = false;
+	atomic_init(&self->stop, false);
+	self->results = createQueue();
+	self->renderQueue = renderQueue;
+	self->generation = 0;
+	self->bestMoves = calloc(BEST_MOVE_TABLE_SIZE, sizeof(*self->bestMoves));
+
+	if (pthread_create(&self->thread, NULL, searchThread, (void *) self) != 0) {
+		asprintf(error, "Failed to start search thread");
+		free(self->bestMoves);
+		free(self->results->head);
+		free(self->results);
+		pthread_cond_destroy(&self->condition);
+		pthread_mutex_destroy(&self->mutex);
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Abandon whatever is being searched and start on position. Results of the
+ * previous search still in flight are recognized by their generation and
+ * dropped when polled.
+ */
+void chessSearchStart(ChessSearch self, const ChessPosition *position, size_t lineCount)
+{
+	pthread_mutex_lock(&self->mutex);
+	self->pendingPosition = *position;
+	self->pendingLineCount = lineCount < 1 ? 1 : lineCount > CHESS_SEARCH_MAX_LINES ? CHESS_SEARCH_MAX_LINES : lineCount;
+	self->pendingGeneration = ++self->generation;
+	self->hasPendingJob = true;
+	atomic_store(&self->stop, true);
+	pthread_cond_signal(&self->condition);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void chessSearchStop(ChessSearch self)
+{
+	pthread_mutex_lock(&self->mutex);
+	++self->generation;
+	self->hasPendingJob = false;
+	atomic_store(&self->stop, true);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+/*
+ * Never blocks: takes the newest completed iteration of the current search,
+ * if one has arrived since the last poll.
+ */
+bool chessSearchPollAnalysis(ChessSearch self, Analysis *analysis)
+{
+	Analysis *result;
+	bool updated = false;
+
+	while (dequeue(self->results, (void **) &result)) {
+		if (result->generation == self->generation) {
+			*analysis = *result;
+			updated = true;
+		}
+		free(result);
+	}
+
+	return updated;
+}
+
+void destroyChessSearch(ChessSearch self)
+{
+	pthread_mutex_lock(&self->mutex);
+	self->terminate = true;
+	atomic_store(&self->stop, true);
+	pthread_cond_signal(&self->condition);
+	pthread_mutex_unlock(&self->mutex);
+	pthread_join(self->thread, NULL);
+
+	Analysis *result;
+	while (dequeue(self->results, (void **) &result)) {
+		free(result);
+	}
+	free(self->results->head);
+	free(self->results);
+	free(self->bestMoves);
+	pthread_cond_destroy(&self->condition);
+	pthread_mutex_destroy(&self->mutex);
+	free(self);
+}
+
+/* Score from White's point of view followed by the line, e.g. "+0.35 e2e4 e7e5" */
+void analysisLineToString(const Analysis *analysis, size_t index, char *string, size_t size)
+{
+	const AnalysisLine *line = analysis->lines + index;
+	int score = analysis->sideToMove == WHITE ? line->score : -line->score;
+	int length;
+
+	if (abs(score) > MATE_THRESHOLD) {
+		length = snprintf(string, size, "#%s%d", score < 0 ? "-" : "", (CHESS_SEARCH_MATE_SCORE - abs(score) + 1) / 2);
+	} else {
+		length = snprintf(string, size, "%+.2f", score / 100.0);
+	}
+
+	for (size_t i = 0; i < line->moveCount && length >= 0 && (size_t) length < size; ++i) {
+		char move[6];
+		chessMoveToString(line->moves[i], move);
+		length += snprintf(string + length, size - length, " %s", move);
+	}
+}
+
+static void *searchThread(void *arg)
+{
+	ChessSearch self = (ChessSearch) arg;
+
+	for (;;) {
+		pthread_mutex_lock(&self->mutex);
+		while (!self->hasPendingJob && !self->terminate) {
+			pthread_cond_wait(&self->condition, &self->mutex);
+		}
+		if (self->terminate) {
+			pthread_mutex_unlock(&self->mutex);
+			return NULL;
+		}
+		self->position = self->pendingPosition;
+		size_t lineCount = self->pendingLineCount;
+		uint64_t generation = self->pendingGeneration;
+		self->hasPendingJob = false;
+		atomic_store(&self->stop, false);
+		pthread_mutex_unlock(&self->mutex);
+
+		searchPosition(self, generation, lineCount);
+	}
+}
+
+/*
+ * Iterative deepening. Each iteration finds the top lines one at a time, every
+ * root search excluding the first moves of the lines already found, and is
+ * published as a whole once all of them are done. An abandoned iteration is
+ * never published.
+ */
+static void searchPosition(ChessSearch self, uint64_t generation, size_t lineCount)
+{
+	ChessMove rootMoves[CHESS_MAX_MOVES];
+	size_t rootMoveCount = chessPositionGenerateLegalMoves(&self->position, rootMoves);
+
+	if (lineCount > rootMoveCount) {
+		lineCount = rootMoveCount;
+	}
+	if (lineCount == 0) {
+		return;
+	}
+
+	self->nodes = 0;
+	self->aborted = false;
+
+	for (unsigned depth = 1; depth <= CHESS_SEARCH_MAX_DEPTH; ++depth) {
+		Analysis *analysis = malloc(sizeof(*analysis));
+		*analysis = (Analysis) {
+			.generation = generation,
+			.depth = depth,
+			.sideToMove = self->position.sideToMove,
+			.lineCount = lineCount
+		};
+
+		bool allMates = true;
+		self->excludedCount = 0;
+		for (size_t i = 0; i < lineCount; ++i) {
+			int score = search(self, depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+			if (self->aborted) {
+				free(analysis);
+				return;
+			}
+
+			AnalysisLine *line = analysis->lines + i;
+			line->score = score;
+			line->moveCount = self->pvLength[0] < CHESS_SEARCH_MAX_PV_LENGTH ? self->pvLength[0] : CHESS_SEARCH_MAX_PV_LENGTH;
+			memcpy(line->moves, self->pv[0], sizeof(*line->moves) * line->moveCount);
+			self->excluded[self->excludedCount++] = self->pv[0][0];
+			allMates = allMates && abs(score) > MATE_THRESHOLD;
+		}
+
+		analysis->nodes = self->nodes;
+		enqueue(self->results, analysis);
+		wakeQueue(self->renderQueue);
+
+		/* Searching deeper can't improve on a forced mate in every line */
+		if (allMates) {
+			return;
+		}
+	}
+}
+
+static int search(ChessSearch self, unsigned depth, unsigned ply, int alpha, int beta)
+{
+	ChessPosition *position = &self->position;
+
+	self->pvLength[ply] = ply;
+
+	if (shouldStop(self)) {
+		return 0;
+	}
+	if (ply > 0 && position->halfmoveClock >= 100) {
+		return 0;
+	}
+	if (depth == 0 || ply >= MAX_PLY - 1) {
+		return quiesce(self, ply, alpha, beta);
+	}
+
+	++self->nodes;
+
+	ChessMove moves[CHESS_MAX_MOVES];
+	int scores[CHESS_MAX_MOVES];
+	size_t moveCount = chessPositionGeneratePseudoLegalMoves(position, moves);
+	scoreMoves(self, moves, scores, moveCount);
+
+	ChessColor color = position->sideToMove;
+	size_t legalCount = 0;
+	bool hasBestMove = false;
+	ChessMove bestMove;
+
+	for (size_t i = 0; i < moveCount; ++i) {
+		pickMove(moves, scores, moveCount, i);
+
+		if (ply == 0) {
+			bool excluded = false;
+			for (size_t j = 0; j < self->excludedCount; ++j) {
+				excluded = excluded || movesEqual(moves[i], self->excluded[j]);
+			}
+			if (excluded) {
+				continue;
+			}
+		}
+
+		ChessUndo undo;
+		chessPositionMakeMove(position, moves[i], &undo);
+		if (chessPositionIsInCheck(position, color)) {
+			chessPositionUnmakeMove(position, moves[i], &undo);
+			continue;
+		}
+		++legalCount;
+		int score = -search(self, depth - 1, ply + 1, -beta, -alpha);
+		chessPositionUnmakeMove(position, moves[i], &undo);
+
+		if (self->aborted) {
+			return 0;
+		}
+
+		if (score > alpha) {
+			alpha = score;
+			bestMove = moves[i];
+			hasBestMove = true;
+			updatePv(self, ply, moves[i]);
+			if (alpha >= beta) {
+				break;
+			}
+		}
+	}
+
+	if (legalCount == 0) {
+		return chessPositionIsInCheck(position, color) ? -CHESS_SEARCH_MATE_SCORE + (int) ply : 0;
+	}
+
+	/* Secondary root searches would overwrite the best line's move */
+	if (hasBestMove && (ply > 0 || self->excludedCount == 0)) {
+		self->bestMoves[position->hash % BEST_MOVE_TABLE_SIZE] = (BestMoveEntry) {
+			.hash = position->hash,
+			.move = bestMove
+		};
+	}
+
+	return alpha;
+}
+
+/* Resolve captures and promotions so the evaluation isn't taken mid-exchange */
+static int quiesce(ChessSearch self, unsigned ply, int alpha, int beta)
+{
+	ChessPosition *position = &self->position;
+
+	self->pvLength[ply] = ply;
+
+	if (shouldStop(self)) {
+		return 0;
+	}
+
+	++self->nodes;
+
+	int standPat = evaluate(position);
+	if (ply >= MAX_PLY - 1) {
+		return standPat;
+	}
+	if (standPat >= beta) {
+		return beta;
+	}
+	if (standPat > alpha) {
+		alpha = standPat;
+	}
+
+	ChessMove moves[CHESS_MAX_MOVES];
+	int scores[CHESS_MAX_MOVES];
+	size_t moveCount = chessPositionGeneratePseudoLegalMoves(position, moves);
+	scoreMoves(self, moves, scores, moveCount);
+
+	ChessColor color = position->sideToMove;
+	for (size_t i = 0; i < moveCount; ++i) {
+		pickMove(moves, scores, moveCount, i);
+		if (!(moves[i].flags & (MOVE_CAPTURE | MOVE_PROMOTION))) {
+			continue;
+		}
+
+		ChessUndo undo;
+		chessPositionMakeMove(position, moves[i], &undo);
+		if (chessPositionIsInCheck(position, color)) {
+			chessPositionUnmakeMove(position, moves[i], &undo);
+			continue;
+		}
+		int score = -quiesce(self, ply + 1, -beta, -alpha);
+		chessPositionUnmakeMove(position, moves[i], &undo);
+
+		if (self->aborted) {
+			return 0;
+		}
+
+		if (score > alpha) {
+			alpha = score;
+			updatePv(self, ply, moves[i]);
+			if (alpha >= beta) {
+				return beta;
+			}
+		}
+	}
+
+	return alpha;
+}
+
+/* Material and piece placement, from the side to move's point of view */
+static int evaluate(const ChessPosition *position)
+{
+	int score = 0;
+
+	for (ChessSquare square = 0; square < CHESS_SQUARE_COUNT; ++square) {
+		Piece piece = position->board[square];
+		if (piece == EMPTY) {
+			continue;
+		}
+		ChessPieceType type = pieceType(piece);
+		if (pieceColor(piece) == WHITE) {
+			score += pieceValues[type] + pieceSquareTables[type][square];
+		} else {
+			score -= pieceValues[type] + pieceSquareTables[type][square ^ 56];
+		}
+	}
+
+	return position->sideToMove == WHITE ? score : -score;
+}
+
+/* Best move from an earlier search first, then captures by MVV-LVA */
+static void scoreMoves(ChessSearch self, const ChessMove *moves, int *scores, size_t moveCount)
+{
+	const ChessPosition *position = &self->position;
+	const BestMoveEntry *entry = self->bestMoves + position->hash % BEST_MOVE_TABLE_SIZE;
+	bool hasBestMove = entry->hash == position->hash;
+
+	for (size_t i = 0; i < moveCount; ++i) {
+		ChessMove move = moves[i];
+		int score = 0;
+		if (hasBestMove && movesEqual(move, entry->move)) {
+			score = 1 << 20;
+		} else {
+			if (move.flags & MOVE_CAPTURE) {
+				ChessPieceType victim = move.flags & MOVE_EN_PASSANT ? PAWN : pieceType(position->board[move.to]);
+				score += 10000 + 10 * pieceValues[victim] - pieceValues[pieceType(position->board[move.from])];
+			}
+			if (move.flags & MOVE_PROMOTION) {
+				score += 10000 + pieceValues[pieceType(move.promotion)];
+			}
+		}
+		scores[i] = score;
+	}
+}
+
+/* Selection sort one step at a time, since most nodes cut off early */
+static void pickMove(ChessMove *moves, int *scores, size_t moveCount, size_t index)
+{
+	size_t best = index;
+	for (size_t i = index + 1; i < moveCount; ++i) {
+		if (scores[i] > scores[best]) {
+			best = i;
+		}
+	}
+
+	if (best != index) {
+		ChessMove move = moves[index];
+		int score = scores[index];
+		moves[index] = moves[best];
+		scores[index] = scores[best];
+		moves[best] = move;
+		scores[best] = score;
+	}
+}
+
+static void updatePv(ChessSearch self, unsigned ply, ChessMove move)
+{
+	self->pv[ply][ply] = move;
+	for (size_t i = ply + 1; i < self->pvLength[ply + 1]; ++i) {
+		self->pv[ply][i] = self->pv[ply + 1][i];
+	}
+	self->pvLength[ply] = self->pvLength[ply + 1];
+}
@@ -0,0 +1,40 @@
+#ifndef MODELER_CHESS_SEARCH_H
+#define MODELER_CHESS_SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chess_position.h"
+#include "queue.h"
+
+#define CHESS_SEARCH_MAX_LINES 5
+#define CHESS_SEARCH_MAX_PV_LENGTH 16
+#define CHESS_SEARCH_MAX_DEPTH 32
+#define CHESS_SEARCH_MATE_SCORE 30000
+
+typedef struct analysis_line_t {
+	int score; /* Centipawns for the side to move */
+	size_t moveCount;
+	ChessMove moves[CHESS_SEARCH_MAX_PV_LENGTH];
+} AnalysisLine;
+
+/* One completed iteration, lines ranked best first */
+typedef struct analysis_t {
+	uint64_t generation;
+	unsigned depth;
+	uint64_t nodes;
+	ChessColor sideToMove;
+	size_t lineCount;
+	AnalysisLine lines[CHESS_SEARCH_MAX_LINES];
+} Analysis;
+
+typedef struct chess_search_t *ChessSearch;
+
+bool createChessSearch(ChessSearch *chessSearch, Queue *renderQueue, char **error);
+void chessSearchStart(ChessSearch self, const ChessPosition *position, size_t lineCount);
+void chessSearchStop(ChessSearch self);
+bool chessSearchPollAnalysis(ChessSearch self, Analysis *analysis);
+void destroyChessSearch(ChessSearch self);
+void analysisLineToString(const Analysis *analysis, size_t index, char *string, size_t size);
+
+#endif /* MODELER_CHESS_SEARCH_H */
@@ -3,13 +3,13 @@
 
 #include "command_pool.h"
 
-bool createCommandPool(VkDevice device, QueueInfo queueInfo, VkCommandPool *commandPool, char **error)
+bool createCommandPool(VkDevice device, uint32_t queueFamilyIndex, VkCommandPool *commandPool, char **error)
 {
 	VkCommandPoolCreateInfo commandPoolCreateInfo = {
 		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 		.pNext = NULL,
 		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-		.queueFamilyIndex = queueInfo.graphicsQueueFamilyIndex
+		.queueFamilyIndex = queueFamilyIndex
 	};
 
 	VkResult result;
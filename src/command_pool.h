@@ -6,7 +6,7 @@
 
 #include "device.h"
 
-bool createCommandPool(VkDevice device, QueueInfo queueInfo, VkCommandPool *commandPool, char **error);
+bool createCommandPool(VkDevice device, uint32_t queueFamilyIndex, VkCommandPool *commandPool, char **error);
 
 void destroyCommandPool(VkDevice device, VkCommandPool commandPool);
 
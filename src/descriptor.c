@@ -80,6 +80,7 @@ bool createDescriptorSets(
 				break;
 			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
 				writeDescriptorSets[writeDescriptorSetOffset].pBufferInfo = ((VkDescriptorBufferInfo **) infos[i].descriptorInfos)[j];
 				break;
 			}
@@ -39,15 +39,27 @@ bool createDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
 	float presentationQueuePriority = 1.0f;
 	presentationQueueCreateInfo.pQueuePriorities = &presentationQueuePriority;
 
-	VkDeviceQueueCreateInfo queueCreateInfos[2] = {graphicsQueueCreateInfo, presentationQueueCreateInfo};
+	/* Uploads go to a transfer-only family when there is one so they can overlap graphics work */
+	if (!findDedicatedQueueFamilyWithFlags(characteristics.queueFamilies, characteristics.queueFamilyCount, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, &queueInfo->transferQueueFamilyIndex)) {
+		queueInfo->transferQueueFamilyIndex = queueInfo->graphicsQueueFamilyIndex;
+	}
+
+	VkDeviceQueueCreateInfo transferQueueCreateInfo = {};
+	transferQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	transferQueueCreateInfo.queueFamilyIndex = queueInfo->transferQueueFamilyIndex;
+	transferQueueCreateInfo.queueCount = 1;
+	float transferQueuePriority = 1.0f;
+	transferQueueCreateInfo.pQueuePriorities = &transferQueuePriority;
 
-	if (queueInfo->graphicsQueueFamilyIndex == queueInfo->presentationQueueFamilyIndex) {
-		createInfo.queueCreateInfoCount = 1;
-		createInfo.pQueueCreateInfos = &graphicsQueueCreateInfo;
-	} else {
-		createInfo.queueCreateInfoCount = 2;
-		createInfo.pQueueCreateInfos = queueCreateInfos;
+	VkDeviceQueueCreateInfo queueCreateInfos[3] = {graphicsQueueCreateInfo};
+	createInfo.queueCreateInfoCount = 1;
+	if (queueInfo->presentationQueueFamilyIndex != queueInfo->graphicsQueueFamilyIndex) {
+		queueCreateInfos[createInfo.queueCreateInfoCount++] = presentationQueueCreateInfo;
+	}
+	if (queueInfo->transferQueueFamilyIndex != queueInfo->graphicsQueueFamilyIndex) {
+		queueCreateInfos[createInfo.queueCreateInfoCount++] = transferQueueCreateInfo;
 	}
+	createInfo.pQueueCreateInfos = queueCreateInfos;
 
 	VkPhysicalDeviceFeatures deviceFeatures = {
 		.samplerAnisotropy = VK_TRUE
@@ -73,6 +85,7 @@ bool createDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
 
 	vkGetDeviceQueue(*device, queueInfo->graphicsQueueFamilyIndex, 0, &queueInfo->graphicsQueue);
 	vkGetDeviceQueue(*device, queueInfo->presentationQueueFamilyIndex, 0, &queueInfo->presentationQueue);
+	vkGetDeviceQueue(*device, queueInfo->transferQueueFamilyIndex, 0, &queueInfo->transferQueue);
 
 	return true;
 }
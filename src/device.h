@@ -9,8 +9,10 @@
 typedef struct queue_info_t {
 	VkQueue graphicsQueue;
 	VkQueue presentationQueue;
+	VkQueue transferQueue; /* The graphics queue when there's no dedicated transfer family */
 	uint32_t graphicsQueueFamilyIndex;
 	uint32_t presentationQueueFamilyIndex;
+	uint32_t transferQueueFamilyIndex;
 } QueueInfo;
 
 bool createDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
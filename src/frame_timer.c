@@ -0,0 +1,105 @@
+#include <stdlib.h>
+
+#include "frame_timer.h"
+
+#include "synchronization.h"
+#include "utils.h"
+#include "vulkan_utils.h"
+
+/*
+ * Times every frame on the GPU with a pair of timestamps. Each frame in
+ * flight has its own pair of queries, read back after that frame's fence
+ * wait, so reading never stalls.
+ */
+struct frame_timer_t {
+	VkDevice device;
+	float timestampPeriod;
+	VkQueryPool queryPool; /* VK_NULL_HANDLE without timestamp support */
+	bool frameTimed[MAX_FRAMES_IN_FLIGHT];
+};
+
+bool createFrameTimer(FrameTimer *frameTimer, VkDevice device, VkPhysicalDeviceProperties deviceProperties, char **error)
+{
+	*frameTimer = malloc(sizeof(**frameTimer));
+
+	FrameTimer self = *frameTimer;
+
+	self->device = device;
+	self->timestampPeriod = deviceProperties.limits.timestampPeriod;
+	self->queryPool = VK_NULL_HANDLE;
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+		self->frameTimed[i] = false;
+	}
+
+	/* Without timestamps no frame is ever read back */
+	if (deviceProperties.limits.timestampComputeAndGraphics) {
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = 2 * MAX_FRAMES_IN_FLIGHT
+		};
+
+		VkResult result;
+		if ((result = vkCreateQueryPool(device, &queryPoolCreateInfo, NULL, &self->queryPool)) != VK_SUCCESS) {
+			asprintf(error, "Failed to create query pool: %s", string_VkResult(result));
+			free(self);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Must be recorded outside any render pass, before the frame's first render
+ * pass. The submission waits for the swapchain image at
+ * COLOR_ATTACHMENT_OUTPUT, so the barrier chains onto that wait and holds
+ * the timestamp back until the image is acquired. Otherwise waiting on
+ * presentation, a whole refresh under FIFO, would count as GPU time.
+ */
+void frameTimerBegin(FrameTimer self, VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	if (self->queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkCmdResetQueryPool(commandBuffer, self->queryPool, 2 * frame, 2);
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, self->queryPool, 2 * frame);
+}
+
+/* Must be recorded outside any render pass, after everything else in the frame */
+void frameTimerEnd(FrameTimer self, VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	if (self->queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, self->queryPool, 2 * frame + 1);
+	self->frameTimed[frame] = true;
+}
+
+/* Call after frame's fence has been waited on; false if there's nothing new */
+bool frameTimerRead(FrameTimer self, uint32_t frame, double *nanoseconds)
+{
+	if (!self->frameTimed[frame]) {
+		return false;
+	}
+	self->frameTimed[frame] = false;
+
+	uint64_t timestamps[2];
+	if (vkGetQueryPoolResults(self->device, self->queryPool, 2 * frame, 2, sizeof(timestamps), timestamps, sizeof(*timestamps), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+		return false;
+	}
+	*nanoseconds = (timestamps[1] - timestamps[0]) * (double) self->timestampPeriod;
+
+	return true;
+}
+
+void destroyFrameTimer(FrameTimer self)
+{
+	if (self->queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(self->device, self->queryPool, NULL);
+	}
+	free(self);
+}
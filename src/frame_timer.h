@@ -0,0 +1,18 @@
+#ifndef MODELER_FRAME_TIMER_H
+#define MODELER_FRAME_TIMER_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+/* GPU time per frame the automatic quality settings aim to stay under */
+#define FRAME_BUDGET_NANOSECONDS 12000000
+
+typedef struct frame_timer_t *FrameTimer;
+
+bool createFrameTimer(FrameTimer *frameTimer, VkDevice device, VkPhysicalDeviceProperties deviceProperties, char **error);
+void frameTimerBegin(FrameTimer self, VkCommandBuffer commandBuffer, uint32_t frame);
+void frameTimerEnd(FrameTimer self, VkCommandBuffer commandBuffer, uint32_t frame);
+bool frameTimerRead(FrameTimer self, uint32_t frame, double *nanoseconds);
+void destroyFrameTimer(FrameTimer self);
+
+#endif /* MODELER_FRAME_TIMER_H */
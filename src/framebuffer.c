@@ -29,10 +29,15 @@ bool createFramebuffer(VkDevice device, SwapchainInfo swapchainInfo, VkImageView
 	return true;
 }
 
+void destroyFramebuffer(VkDevice device, VkFramebuffer framebuffer)
+{
+	vkDestroyFramebuffer(device, framebuffer, NULL);
+}
+
 void destroyFramebuffers(VkDevice device, VkFramebuffer *framebuffers, uint32_t count)
 {
 	for (uint32_t i = 0; i < count; ++i) {
-		vkDestroyFramebuffer(device, framebuffers[i], NULL);
+		destroyFramebuffer(device, framebuffers[i]);
 	}
 	free(framebuffers);
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 bool createFramebuffer(VkDevice device, SwapchainInfo swapchainInfo, VkImageView *attachments, uint32_t attachmentCount, VkRenderPass renderPass, VkFramebuffer *framebuffer, char **error);
 
+void destroyFramebuffer(VkDevice device, VkFramebuffer framebuffer);
+
 void destroyFramebuffers(VkDevice device, VkFramebuffer *framebuffers, uint32_t count);
 
 #endif /* MODELER_FRAMEBUFFER_H */
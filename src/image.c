@@ -1,7 +1,6 @@
 #include <stdlib.h>
 
 #include "image.h"
-#include "command_buffer.h"
 #include "utils.h"
 #include "vulkan_utils.h"
 
@@ -27,12 +26,18 @@ bool createImage(VkDevice device, VmaAllocator allocator, VkExtent2D extent, VkF
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
 	};
 
+	/* Attachments that never leave the render pass can live entirely in a tiler's on-chip memory */
 	VmaAllocationCreateInfo allocationCreateInfo = {
-		.usage = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		.usage = usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED : VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE
 	};
 
-	VkResult result;
-	if ((result = vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, image, allocation, NULL)) != VK_SUCCESS) {
+	VkResult result = vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, image, allocation, NULL);
+	if (result != VK_SUCCESS && allocationCreateInfo.usage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED) {
+		/* Most desktop GPUs have no lazily allocated memory type */
+		allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		result = vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, image, allocation, NULL);
+	}
+	if (result != VK_SUCCESS) {
 		asprintf(error, "Failed to create image: %s", string_VkResult(result));
 		return false;
 	}
@@ -40,13 +45,8 @@ bool createImage(VkDevice device, VmaAllocator allocator, VkExtent2D extent, VkF
 	return true;
 }
 
-bool transitionImageLayout(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, char **error)
+bool transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, char **error)
 {
-	VkCommandBuffer commandBuffer;
-	if (!beginSingleTimeCommands(device, commandPool, &commandBuffer, error)) {
-		return false;
-	}
-
 	VkImageMemoryBarrier barrier = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
 		.oldLayout = oldLayout,
@@ -90,59 +90,27 @@ bool transitionImageLayout(VkDevice device, VkCommandPool commandPool, VkQueue q
 		1, &barrier
 	);
 
-	if (!endSingleTimeCommands(device, commandPool, queue, commandBuffer, error)) {
-		return false;
-	}
-
 	return true;
 }
 
-bool copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, char **error)
+/* Each level is tightly packed at its offset in the buffer */
+void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const VkDeviceSize *levelOffsets)
 {
-	VkCommandBuffer commandBuffer;
-	if (!beginSingleTimeCommands(device, commandPool, &commandBuffer, error)) {
-		return false;
-	}
-
-	uint32_t level0Width = height;
-	uint32_t level0Height = height;
 	VkBufferImageCopy *regions = malloc(sizeof(*regions) * mipLevels);
 
-	regions[0] = (VkBufferImageCopy) {
-		.bufferOffset = 0,
-		.bufferRowLength = width,
-		.bufferImageHeight = height,
-		.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-		.imageSubresource.mipLevel = 0,
-		.imageSubresource.baseArrayLayer = 0,
-		.imageSubresource.layerCount = 1,
-		.imageOffset = {0, 0, 0},
-		.imageExtent = {
-			level0Width,
-			level0Height,
-			1
-		}
-	};
-
-	VkDeviceSize heightOffset = 0;
-	for (uint32_t i = 1; i < mipLevels; ++i) {
-		uint32_t extentWidth = level0Width >> i;
-		uint32_t extentHeight = level0Height >> i;
-		uint32_t bufferOffset = width * heightOffset + level0Width;
-		heightOffset += extentHeight;
-
+	for (uint32_t i = 0; i < mipLevels; ++i) {
 		regions[i] = (VkBufferImageCopy) {
-			.bufferOffset = bufferOffset * 4,
-			.bufferRowLength = width,
-			.bufferImageHeight = height,
+			.bufferOffset = levelOffsets[i],
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
 			.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
 			.imageSubresource.mipLevel = i,
 			.imageSubresource.baseArrayLayer = 0,
 			.imageSubresource.layerCount = 1,
 			.imageOffset = {0, 0, 0},
 			.imageExtent = {
-				extentWidth,
-				extentHeight,
+				width >> i,
+				height >> i,
 				1
 			}
 		};
@@ -158,12 +126,6 @@ bool copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue queue
 	);
 
 	free(regions);
-
-	if (!endSingleTimeCommands(device, commandPool, queue, commandBuffer, error)) {
-		return false;
-	}
-
-	return true;
 }
 
 void destroyImage(VmaAllocator allocator, VkImage image, VmaAllocation allocation)
@@ -6,8 +6,8 @@
 #include "vk_mem_alloc.h"
 
 bool createImage(VkDevice device, VmaAllocator allocator, VkExtent2D extent, VkFormat format, VkImageUsageFlagBits usage, uint32_t mipLevels, VkSampleCountFlagBits sampleCount, VkImage *image, VmaAllocation *allocation, char **error);
-bool transitionImageLayout(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, char **error);
-bool copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, char **error);
+bool transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, char **error);
+void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const VkDeviceSize *levelOffsets);
 void destroyImage(VmaAllocator allocator, VkImage image, VmaAllocation allocation);
 
 #endif /* MODELER_IMAGE_H */
@@ -63,3 +63,12 @@ NormalizedPointerPosition normalizePointerPosition(VkViewport viewport, PointerP
 		.y = (position.y - viewport.y) / (float) viewport.height,
 	};
 }
+
+void freeBoardUpdateBatch(BoardUpdateBatch *batch)
+{
+	for (size_t i = 0; i < batch->lineCount; ++i) {
+		free(batch->lines[i]);
+	}
+	free(batch->lines);
+	free(batch);
+}
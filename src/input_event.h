@@ -14,7 +14,8 @@ typedef enum input_event_type_t {
 	POINTER_LEAVE,
 	RESIZE,
 	TERMINATE,
-	INSET_CHANGE
+	INSET_CHANGE,
+	BOARD_UPDATE
 } InputEventType;
 
 typedef struct input_event_t {
@@ -32,11 +33,18 @@ typedef struct normalized_pointer_position_t {
 	float y;
 } NormalizedPointerPosition;
 
+/* FEN or UCI move lines received together, in arrival order */
+typedef struct board_update_batch_t {
+	char **lines;
+	size_t lineCount;
+} BoardUpdateBatch;
+
 void enqueueInputEvent(Queue *queue, InputEventType type, void *data);
 void enqueueInputEventWithPosition(Queue *queue, InputEventType type, int x, int y);
 void enqueueInputEventWithExtent(Queue *queue, InputEventType type, int width, int height);
 void enqueueInputEventWithWindowDimensions(Queue *queue, InputEventType type, WindowDimensions windowDimensions);
 bool isPointerOnViewport(VkViewport viewport, PointerPosition position);
 NormalizedPointerPosition normalizePointerPosition(VkViewport viewport, PointerPosition position);
+void freeBoardUpdateBatch(BoardUpdateBatch *batch);
 
 #endif /* MODELER_INPUT_EVENT_H */
\ No newline at end of file
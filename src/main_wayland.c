@@ -13,6 +13,7 @@
 
 #include "queue.h"
 #include "input_event.h"
+#include "board_stream.h"
 #include "modeler.h"
 #include "utils.h"
 
@@ -186,6 +187,26 @@ int main(int argc, char **argv)
 	};
 	epoll_ctl(epollFd, EPOLL_CTL_ADD, wlFd, &epollConfigurationEvent2);
 
+	/* The board stream is optional; run without it if the socket can't be set up */
+	BoardStream boardStream = NULL;
+	int boardStreamFd = -1;
+	char *boardStreamPath = getDefaultBoardStreamPath();
+	if (!boardStreamPath) {
+		fprintf(stderr, "Neither MODELER_SOCKET nor XDG_RUNTIME_DIR is set, board stream disabled\n");
+	} else if (!createBoardStream(&boardStream, boardStreamPath, &error)) {
+		fprintf(stderr, "%s\n", error);
+		free(error);
+		boardStream = NULL;
+	} else {
+		boardStreamFd = boardStreamGetFd(boardStream);
+		struct epoll_event epollConfigurationEvent3 = {
+			.events = EPOLLIN,
+			.data.fd = boardStreamFd
+		};
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, boardStreamFd, &epollConfigurationEvent3);
+	}
+	free(boardStreamPath);
+
 	struct epoll_event epollEventBuffer;
 	for (;;) {
 		if (epoll_wait(epollFd, &epollEventBuffer, 1, -1) == -1) {
@@ -211,9 +232,21 @@ int main(int argc, char **argv)
 				xdg_toplevel_unset_fullscreen(display.xdgToplevel);
 				break;
 			}
+		} else if (epollEventBuffer.data.fd == boardStreamFd) {
+			BoardUpdateBatch *batch;
+			if (!boardStreamDispatch(boardStream, &batch, &error)) {
+				fprintf(stderr, "%s\n", error);
+				free(error);
+			}
+			if (batch) {
+				enqueueInputEvent(&display.inputQueue, BOARD_UPDATE, batch);
+			}
 		}
 	}
 
+	if (boardStream) {
+		destroyBoardStream(boardStream);
+	}
 	close(epollFd);
 
 	destroyCursor(&display);
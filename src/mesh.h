@@ -0,0 +1,46 @@
+#ifndef MODELER_MESH_H
+#define MODELER_MESH_H
+
+#include <stdint.h>
+
+/*
+ * A cooked mesh is a MeshHeader followed by vertexCount MeshVertex and then
+ * indexCount uint16_t indices, all in native byte order, so each array can
+ * be copied into a staging buffer as is. mesh_cook writes them from OBJs.
+ *
+ * The arrays hold MESH_LOD_COUNT levels of detail back to back, from full
+ * detail down, each with about a quarter of the triangles of the one before.
+ */
+#define MESH_MAGIC 0x4853454d /* "MESH" */
+#define MESH_VERSION 4
+#define MESH_LOD_COUNT 4
+
+/*
+ * Read as R16G16B16A16_UNORM and R16G16_SNORM. The position is
+ * pos * scale + bias with the header's scale and bias, and the normal is
+ * octahedral-encoded.
+ */
+typedef struct mesh_vertex_t {
+	uint16_t pos[4]; /* w unused */
+	int16_t normal[2];
+} MeshVertex;
+
+/* A level's indices count from its own first vertex */
+typedef struct mesh_lod_t {
+	uint32_t vertexOffset;
+	uint32_t vertexCount;
+	uint32_t indexOffset;
+	uint32_t indexCount;
+} MeshLod;
+
+typedef struct mesh_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	float scale[3];
+	float bias[3];
+	MeshLod lods[MESH_LOD_COUNT];
+} MeshHeader;
+
+#endif /* MODELER_MESH_H */
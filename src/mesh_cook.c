@@ -0,0 +1,732 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mesh.h"
+#include "tinyobj_loader_c.h"
+
+/*
+ * Build-time tool that turns an OBJ into the cooked format described in
+ * mesh.h, so the app never parses OBJ text:
+ *
+ * 	mesh_cook input.obj output.mesh
+ *
+ * Faces are triangulated and expanded to one vertex per corner, then corners
+ * with the same position and normal are welded and both arrays are reordered
+ * for the GPU: triangles for the post-transform cache and then overdraw,
+ * vertices for fetch locality. Each further LOD is simplified from that by
+ * vertex clustering and reordered the same way. Last, positions are
+ * quantized within the mesh's bounds and normals are octahedral-encoded into
+ * a MeshVertex.
+ */
+
+/* Tom Forsyth's linear-speed vertex cache optimization constants */
+#define VERTEX_CACHE_SIZE 32
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+/* The FIFO used to find where overdraw clusters can start without costing cache misses */
+#define OVERDRAW_CACHE_SIZE 16
+
+/* Cells along the longest side of the bounds for LOD 1, halved for each further LOD */
+#define LOD_GRID_SIZE 32
+
+/* Full precision, while the mesh is being welded and reordered */
+typedef struct cook_vertex_t {
+	float pos[3];
+	float normal[3];
+} CookVertex;
+
+static void readObjFromFile(void *ctx, const char *filename, const int is_mtl, const char *obj_filename, char **data, size_t *len);
+static void expandFaces(tinyobj_attrib_t attrib, CookVertex *vertices, uint16_t *indices);
+static size_t weldVertices(CookVertex *vertices, size_t vertexCount, uint16_t *indices);
+static uint32_t hashVertex(const CookVertex *vertex);
+static void optimizeVertexCache(uint16_t *indices, size_t indexCount, size_t vertexCount);
+static float vertexScore(int cachePosition, uint32_t remainingTriangles);
+static void optimizeOverdraw(uint16_t *indices, size_t indexCount, const CookVertex *vertices);
+static int compareClusters(const void *a, const void *b);
+static size_t optimizeVertexFetch(CookVertex *vertices, size_t vertexCount, uint16_t *indices, size_t indexCount);
+static float averageCacheMissRatio(const uint16_t *indices, size_t indexCount);
+static void clusterVertices(const CookVertex *vertices, size_t vertexCount, const uint16_t *indices, size_t indexCount, const float min[3], const float max[3], size_t gridSize, CookVertex **lodVertices, size_t *lodVertexCount, uint16_t **lodIndices, size_t *lodIndexCount);
+static uint32_t insertCluster(uint32_t *keys, uint32_t *values, size_t tableSize, uint32_t key, size_t *count);
+static void findBounds(const CookVertex *vertices, size_t vertexCount, float min[3], float max[3]);
+static void quantizeVertices(const CookVertex *vertices, size_t vertexCount, MeshVertex *quantizedVertices, const MeshHeader *header);
+static void encodeOctahedral(const float normal[3], int16_t encoded[2]);
+
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s input.obj output.mesh\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	tinyobj_attrib_t attrib;
+	tinyobj_shape_t *shapes;
+	size_t shapeCount;
+	tinyobj_material_t *materials;
+	size_t materialCount;
+	if (tinyobj_parse_obj(&attrib, &shapes, &shapeCount, &materials, &materialCount, argv[1], readObjFromFile, NULL, TINYOBJ_FLAG_TRIANGULATE) != TINYOBJ_SUCCESS) {
+		fprintf(stderr, "Failed to load mesh %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	size_t cornerCount = attrib.num_face_num_verts * 3;
+	if (cornerCount > UINT16_MAX + 1) {
+		fprintf(stderr, "%s has too many vertices for 16-bit indices\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	CookVertex *vertices = malloc(sizeof(*vertices) * cornerCount);
+	uint16_t *indices = malloc(sizeof(*indices) * cornerCount);
+	expandFaces(attrib, vertices, indices);
+	size_t vertexCount = weldVertices(vertices, cornerCount, indices);
+
+	MeshHeader header = {
+		.magic = MESH_MAGIC,
+		.version = MESH_VERSION,
+		.vertexCount = 0,
+		.indexCount = 0
+	};
+	float min[3];
+	float max[3];
+	findBounds(vertices, vertexCount, min, max);
+	for (size_t k = 0; k < 3; ++k) {
+		header.scale[k] = max[k] > min[k] ? max[k] - min[k] : 1.0f;
+		header.bias[k] = min[k];
+	}
+
+	CookVertex *lodVertices[MESH_LOD_COUNT];
+	uint16_t *lodIndices[MESH_LOD_COUNT];
+	for (size_t i = 0; i < MESH_LOD_COUNT; ++i) {
+		size_t lodVertexCount = vertexCount;
+		size_t lodIndexCount = cornerCount;
+		if (i == 0) {
+			lodVertices[i] = vertices;
+			lodIndices[i] = indices;
+		} else {
+			clusterVertices(vertices, vertexCount, indices, cornerCount, min, max, LOD_GRID_SIZE >> (i - 1), &lodVertices[i], &lodVertexCount, &lodIndices[i], &lodIndexCount);
+		}
+
+		float unoptimizedMissRatio = averageCacheMissRatio(lodIndices[i], lodIndexCount);
+		optimizeVertexCache(lodIndices[i], lodIndexCount, lodVertexCount);
+		optimizeOverdraw(lodIndices[i], lodIndexCount, lodVertices[i]);
+		lodVertexCount = optimizeVertexFetch(lodVertices[i], lodVertexCount, lodIndices[i], lodIndexCount);
+		printf("%s LOD %zu: %zu triangles, %zu vertices, ACMR %.3f to %.3f\n", argv[2], i, lodIndexCount / 3, lodVertexCount, unoptimizedMissRatio, averageCacheMissRatio(lodIndices[i], lodIndexCount));
+
+		header.lods[i] = (MeshLod) {
+			.vertexOffset = header.vertexCount,
+			.vertexCount = lodVertexCount,
+			.indexOffset = header.indexCount,
+			.indexCount = lodIndexCount
+		};
+		header.vertexCount += lodVertexCount;
+		header.indexCount += lodIndexCount;
+	}
+
+	MeshVertex *quantizedVertices = malloc(sizeof(*quantizedVertices) * header.vertexCount);
+	for (size_t i = 0; i < MESH_LOD_COUNT; ++i) {
+		quantizeVertices(lodVertices[i], header.lods[i].vertexCount, quantizedVertices + header.lods[i].vertexOffset, &header);
+	}
+
+	FILE *fp;
+	if (!(fp = fopen(argv[2], "wb"))) {
+		fprintf(stderr, "Failed to open %s for writing\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	bool writeSuccess = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(quantizedVertices, sizeof(*quantizedVertices), header.vertexCount, fp) == header.vertexCount;
+	for (size_t i = 0; i < MESH_LOD_COUNT && writeSuccess; ++i) {
+		writeSuccess = fwrite(lodIndices[i], sizeof(*lodIndices[i]), header.lods[i].indexCount, fp) == header.lods[i].indexCount;
+	}
+	if (fclose(fp) != 0 || !writeSuccess) {
+		fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	free(quantizedVertices);
+	for (size_t i = 0; i < MESH_LOD_COUNT; ++i) {
+		free(lodVertices[i]);
+		free(lodIndices[i]);
+	}
+	tinyobj_attrib_free(&attrib);
+	tinyobj_shapes_free(shapes, shapeCount);
+	tinyobj_materials_free(materials, materialCount);
+
+	return EXIT_SUCCESS;
+}
+
+static void readObjFromFile(void *ctx, const char *filename, const int is_mtl, const char *obj_filename, char **data, size_t *len)
+{
+	*data = NULL;
+	*len = 0;
+
+	FILE *fp;
+	if (!(fp = fopen(filename, "rb"))) {
+		return;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	rewind(fp);
+	*data = malloc(size);
+	*len = fread(*data, 1, size, fp);
+
+	fclose(fp);
+}
+
+static void expandFaces(tinyobj_attrib_t attrib, CookVertex *vertices, uint16_t *indices)
+{
+	size_t faceOffset = 0;
+
+	for (size_t i = 0; i < attrib.num_face_num_verts; ++i) {
+		for (size_t f = 0; f < (size_t) attrib.face_num_verts[i] / 3; ++f) {
+			tinyobj_vertex_index_t idx0 = attrib.faces[faceOffset + 3 * f + 0];
+			tinyobj_vertex_index_t idx1 = attrib.faces[faceOffset + 3 * f + 1];
+			tinyobj_vertex_index_t idx2 = attrib.faces[faceOffset + 3 * f + 2];
+
+			float v[3][3];
+
+			for (size_t k = 0; k < 3; ++k) {
+				int f0 = idx0.v_idx;
+				int f1 = idx1.v_idx;
+				int f2 = idx2.v_idx;
+
+				v[0][k] = attrib.vertices[3 * (size_t) f0 + k];
+				v[1][k] = attrib.vertices[3 * (size_t) f1 + k];
+				v[2][k] = attrib.vertices[3 * (size_t) f2 + k];
+			}
+
+			float n[3][3] = {};
+
+			if (attrib.num_normals > 0) {
+				int f0 = idx0.vn_idx;
+				int f1 = idx1.vn_idx;
+				int f2 = idx2.vn_idx;
+
+				if (f0 >= 0 && f1 >= 0 && f2 >= 0) {
+					for (size_t k = 0; k < 3; ++k) {
+						n[0][k] = attrib.normals[3 * (size_t) f0 + k];
+						n[1][k] = attrib.normals[3 * (size_t) f1 + k];
+						n[2][k] = attrib.normals[3 * (size_t) f2 + k];
+					}
+				}
+			}
+
+			for (size_t j = 0; j < 3; ++j) {
+				vertices[faceOffset + (f * 3) + j] = (CookVertex) {
+					.pos = {v[j][0], v[j][1], v[j][2]},
+					.normal = {n[j][0], n[j][1], n[j][2]}
+				};
+			}
+		}
+
+		faceOffset += (size_t) attrib.face_num_verts[i];
+	}
+
+	for (size_t i = 0; i < faceOffset; ++i) {
+		indices[i] = i;
+	}
+}
+
+static uint32_t hashVertex(const CookVertex *vertex)
+{
+	const unsigned char *bytes = (const unsigned char *) vertex;
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < sizeof(*vertex); ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/* Compacts bitwise-identical vertices to the front of the array and rewrites the indices to match */
+static size_t weldVertices(CookVertex *vertices, size_t vertexCount, uint16_t *indices)
+{
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2) {
+		tableSize *= 2;
+	}
+	int32_t *table = malloc(sizeof(*table) * tableSize);
+	for (size_t i = 0; i < tableSize; ++i) {
+		table[i] = -1;
+	}
+
+	size_t uniqueCount = 0;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		CookVertex vertex = vertices[indices[i]];
+		size_t slot = hashVertex(&vertex) & (tableSize - 1);
+		while (table[slot] != -1 && memcmp(vertices + table[slot], &vertex, sizeof(vertex)) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == -1) {
+			table[slot] = uniqueCount;
+			vertices[uniqueCount++] = vertex;
+		}
+		indices[i] = table[slot];
+	}
+
+	free(table);
+
+	return uniqueCount;
+}
+
+static void optimizeVertexCache(uint16_t *indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+
+	/* Each vertex's triangles, of which the first remainingTriangles aren't emitted yet */
+	uint32_t *remainingTriangles = calloc(vertexCount, sizeof(*remainingTriangles));
+	uint32_t *adjacencyOffsets = malloc(sizeof(*adjacencyOffsets) * vertexCount);
+	uint32_t *adjacency = malloc(sizeof(*adjacency) * indexCount);
+	for (size_t i = 0; i < indexCount; ++i) {
+		++remainingTriangles[indices[i]];
+	}
+	for (size_t i = 0, offset = 0; i < vertexCount; ++i) {
+		adjacencyOffsets[i] = offset;
+		offset += remainingTriangles[i];
+		remainingTriangles[i] = 0;
+	}
+	for (size_t i = 0; i < indexCount; ++i) {
+		adjacency[adjacencyOffsets[indices[i]] + remainingTriangles[indices[i]]++] = i / 3;
+	}
+
+	int *cachePositions = malloc(sizeof(*cachePositions) * vertexCount);
+	float *vertexScores = malloc(sizeof(*vertexScores) * vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		cachePositions[i] = -1;
+		vertexScores[i] = vertexScore(-1, remainingTriangles[i]);
+	}
+
+	float *triangleScores = malloc(sizeof(*triangleScores) * triangleCount);
+	bool *emitted = calloc(triangleCount, sizeof(*emitted));
+	for (size_t i = 0; i < triangleCount; ++i) {
+		triangleScores[i] = vertexScores[indices[3 * i]] + vertexScores[indices[3 * i + 1]] + vertexScores[indices[3 * i + 2]];
+	}
+
+	uint16_t *output = malloc(sizeof(*output) * indexCount);
+	uint32_t cache[VERTEX_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+	long bestTriangle = -1;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		/* Nothing in the cache has triangles left, so start again from the best anywhere */
+		if (bestTriangle < 0) {
+			for (size_t i = 0; i < triangleCount; ++i) {
+				if (!emitted[i] && (bestTriangle < 0 || triangleScores[i] > triangleScores[bestTriangle])) {
+					bestTriangle = i;
+				}
+			}
+		}
+
+		const uint16_t *triangle = indices + 3 * bestTriangle;
+		memcpy(output + 3 * emittedCount, triangle, sizeof(*triangle) * 3);
+		emitted[bestTriangle] = true;
+
+		for (size_t j = 0; j < 3; ++j) {
+			uint32_t *triangles = adjacency + adjacencyOffsets[triangle[j]];
+			uint32_t *remaining = remainingTriangles + triangle[j];
+			for (size_t k = 0; k < *remaining; ++k) {
+				if (triangles[k] == bestTriangle) {
+					triangles[k] = triangles[--*remaining];
+					triangles[*remaining] = bestTriangle;
+					break;
+				}
+			}
+		}
+
+		/* The emitted vertices move to the front of the LRU cache, and whatever falls off the end leaves it */
+		uint32_t newCache[VERTEX_CACHE_SIZE + 6];
+		size_t newCacheCount = 0;
+		for (size_t j = 0; j < 3; ++j) {
+			newCache[newCacheCount++] = triangle[j];
+		}
+		for (size_t j = 0; j < cacheCount; ++j) {
+			if (cache[j] != triangle[0] && cache[j] != triangle[1] && cache[j] != triangle[2]) {
+				newCache[newCacheCount++] = cache[j];
+			}
+		}
+
+		bestTriangle = -1;
+		for (size_t j = 0; j < newCacheCount; ++j) {
+			uint32_t vertex = newCache[j];
+			cachePositions[vertex] = j < VERTEX_CACHE_SIZE ? (int) j : -1;
+			vertexScores[vertex] = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+		for (size_t j = 0; j < newCacheCount; ++j) {
+			uint32_t vertex = newCache[j];
+			const uint32_t *triangles = adjacency + adjacencyOffsets[vertex];
+			for (size_t k = 0; k < remainingTriangles[vertex]; ++k) {
+				const uint16_t *candidate = indices + 3 * triangles[k];
+				triangleScores[triangles[k]] = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+				if (bestTriangle < 0 || triangleScores[triangles[k]] > triangleScores[bestTriangle]) {
+					bestTriangle = triangles[k];
+				}
+			}
+		}
+
+		cacheCount = newCacheCount < VERTEX_CACHE_SIZE ? newCacheCount : VERTEX_CACHE_SIZE;
+		memcpy(cache, newCache, sizeof(*cache) * cacheCount);
+	}
+
+	memcpy(indices, output, sizeof(*indices) * indexCount);
+
+	free(output);
+	free(emitted);
+	free(triangleScores);
+	free(vertexScores);
+	free(cachePositions);
+	free(adjacency);
+	free(adjacencyOffsets);
+	free(remainingTriangles);
+}
+
+static float vertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+	if (remainingTriangles == 0) {
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			score = LAST_TRIANGLE_SCORE;
+		} else {
+			score = powf(1.0f - (float) (cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	return score + VALENCE_BOOST_SCALE * powf((float) remainingTriangles, -VALENCE_BOOST_POWER);
+}
+
+typedef struct cluster_t {
+	size_t start;
+	size_t triangleCount;
+	float center[3];
+	float normal[3];
+	float sortKey;
+} Cluster;
+
+/*
+ * Splits the cache-ordered triangles into clusters wherever a triangle
+ * misses on all three vertices, where the cache was cold anyway, then draws
+ * the clusters that face furthest out from the mesh's center first so they
+ * tend to occlude the rest
+ */
+static void optimizeOverdraw(uint16_t *indices, size_t indexCount, const CookVertex *vertices)
+{
+	size_t triangleCount = indexCount / 3;
+	Cluster *clusters = malloc(sizeof(*clusters) * triangleCount);
+	size_t clusterCount = 0;
+
+	uint16_t cache[OVERDRAW_CACHE_SIZE];
+	size_t cacheCount = 0;
+	size_t cacheHead = 0;
+	for (size_t i = 0; i < triangleCount; ++i) {
+		size_t misses = 0;
+		for (size_t j = 0; j < 3; ++j) {
+			uint16_t vertex = indices[3 * i + j];
+			bool hit = false;
+			for (size_t k = 0; k < cacheCount && !hit; ++k) {
+				hit = cache[k] == vertex;
+			}
+			if (!hit) {
+				++misses;
+				cache[cacheHead] = vertex;
+				cacheHead = (cacheHead + 1) % OVERDRAW_CACHE_SIZE;
+				if (cacheCount < OVERDRAW_CACHE_SIZE) {
+					++cacheCount;
+				}
+			}
+		}
+		if (i == 0 || misses == 3) {
+			clusters[clusterCount++] = (Cluster) {
+				.start = i
+			};
+		}
+		++clusters[clusterCount - 1].triangleCount;
+	}
+
+	float meshCenter[3] = {};
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; ++c) {
+		Cluster *cluster = clusters + c;
+		float area = 0.0f;
+		for (size_t i = cluster->start; i < cluster->start + cluster->triangleCount; ++i) {
+			const float *p0 = vertices[indices[3 * i]].pos;
+			const float *p1 = vertices[indices[3 * i + 1]].pos;
+			const float *p2 = vertices[indices[3 * i + 2]].pos;
+			float e0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+			float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+			float n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0]};
+			float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (size_t k = 0; k < 3; ++k) {
+				cluster->center[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+				cluster->normal[k] += n[k];
+			}
+			area += triangleArea;
+		}
+
+		float normalLength = sqrtf(cluster->normal[0] * cluster->normal[0] + cluster->normal[1] * cluster->normal[1] + cluster->normal[2] * cluster->normal[2]);
+		for (size_t k = 0; k < 3; ++k) {
+			meshCenter[k] += cluster->center[k];
+			if (area > 0.0f) {
+				cluster->center[k] /= area;
+			}
+			if (normalLength > 0.0f) {
+				cluster->normal[k] /= normalLength;
+			}
+		}
+		meshArea += area;
+	}
+	for (size_t k = 0; k < 3 && meshArea > 0.0f; ++k) {
+		meshCenter[k] /= meshArea;
+	}
+
+	for (size_t c = 0; c < clusterCount; ++c) {
+		Cluster *cluster = clusters + c;
+		cluster->sortKey = 0.0f;
+		for (size_t k = 0; k < 3; ++k) {
+			cluster->sortKey += (cluster->center[k] - meshCenter[k]) * cluster->normal[k];
+		}
+	}
+	qsort(clusters, clusterCount, sizeof(*clusters), compareClusters);
+
+	uint16_t *output = malloc(sizeof(*output) * indexCount);
+	for (size_t c = 0, offset = 0; c < clusterCount; ++c) {
+		memcpy(output + offset, indices + 3 * clusters[c].start, sizeof(*output) * 3 * clusters[c].triangleCount);
+		offset += 3 * clusters[c].triangleCount;
+	}
+	memcpy(indices, output, sizeof(*indices) * indexCount);
+
+	free(output);
+	free(clusters);
+}
+
+/* Outermost first, falling back to the cache order so the sort is stable */
+static int compareClusters(const void *a, const void *b)
+{
+	const Cluster *clusterA = a;
+	const Cluster *clusterB = b;
+
+	if (clusterA->sortKey != clusterB->sortKey) {
+		return clusterA->sortKey > clusterB->sortKey ? -1 : 1;
+	}
+
+	return clusterA->start < clusterB->start ? -1 : clusterA->start > clusterB->start;
+}
+
+/* Renumbers vertices in the order the indices first use them, dropping any that aren't, and returns how many are left */
+static size_t optimizeVertexFetch(CookVertex *vertices, size_t vertexCount, uint16_t *indices, size_t indexCount)
+{
+	int32_t *remap = malloc(sizeof(*remap) * vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		remap[i] = -1;
+	}
+
+	CookVertex *output = malloc(sizeof(*output) * vertexCount);
+	size_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		if (remap[indices[i]] == -1) {
+			remap[indices[i]] = nextVertex;
+			output[nextVertex++] = vertices[indices[i]];
+		}
+		indices[i] = remap[indices[i]];
+	}
+	memcpy(vertices, output, sizeof(*vertices) * nextVertex);
+
+	free(output);
+	free(remap);
+
+	return nextVertex;
+}
+
+/* Vertex shader invocations per triangle through a FIFO cache, for the cook log */
+static float averageCacheMissRatio(const uint16_t *indices, size_t indexCount)
+{
+	uint16_t cache[OVERDRAW_CACHE_SIZE];
+	size_t cacheCount = 0;
+	size_t cacheHead = 0;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < indexCount; ++i) {
+		bool hit = false;
+		for (size_t k = 0; k < cacheCount && !hit; ++k) {
+			hit = cache[k] == indices[i];
+		}
+		if (!hit) {
+			++misses;
+			cache[cacheHead] = indices[i];
+			cacheHead = (cacheHead + 1) % OVERDRAW_CACHE_SIZE;
+			if (cacheCount < OVERDRAW_CACHE_SIZE) {
+				++cacheCount;
+			}
+		}
+	}
+
+	return indexCount ? (float) misses / (indexCount / 3) : 0.0f;
+}
+
+/*
+ * Snaps every vertex to the average position of the vertices in its grid
+ * cell and drops the triangles that collapse. Vertices in a cell are only
+ * merged if their normals share a dominant axis, so hard edges survive, but
+ * they all take the cell's position so no cracks open between them.
+ */
+static void clusterVertices(const CookVertex *vertices, size_t vertexCount, const uint16_t *indices, size_t indexCount, const float min[3], const float max[3], size_t gridSize, CookVertex **lodVertices, size_t *lodVertexCount, uint16_t **lodIndices, size_t *lodIndexCount)
+{
+	float extent = fmaxf(fmaxf(max[0] - min[0], max[1] - min[1]), max[2] - min[2]);
+	float cellSize = extent > 0.0f ? extent / gridSize : 1.0f;
+
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2) {
+		tableSize *= 2;
+	}
+	uint32_t *cellKeys = malloc(sizeof(*cellKeys) * tableSize);
+	uint32_t *cellValues = malloc(sizeof(*cellValues) * tableSize);
+	uint32_t *clusterKeys = malloc(sizeof(*clusterKeys) * tableSize);
+	uint32_t *clusterValues = malloc(sizeof(*clusterValues) * tableSize);
+	memset(cellKeys, 0xff, sizeof(*cellKeys) * tableSize);
+	memset(clusterKeys, 0xff, sizeof(*clusterKeys) * tableSize);
+
+	uint32_t *vertexCells = malloc(sizeof(*vertexCells) * vertexCount);
+	uint32_t *vertexClusters = malloc(sizeof(*vertexClusters) * vertexCount);
+	uint32_t *clusterCells = malloc(sizeof(*clusterCells) * vertexCount);
+	float (*cellPositions)[3] = calloc(vertexCount, sizeof(*cellPositions));
+	uint32_t *cellVertexCounts = calloc(vertexCount, sizeof(*cellVertexCounts));
+	CookVertex *clusters = calloc(vertexCount, sizeof(*clusters));
+	size_t cellCount = 0;
+	size_t clusterCount = 0;
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const CookVertex *vertex = vertices + i;
+		uint32_t cellKey = 0;
+		for (size_t k = 3; k-- > 0;) {
+			size_t cell = (vertex->pos[k] - min[k]) / cellSize;
+			cellKey = cellKey * (gridSize + 1) + (cell < gridSize ? cell : gridSize);
+		}
+
+		size_t axis = 0;
+		for (size_t k = 1; k < 3; ++k) {
+			if (fabsf(vertex->normal[k]) > fabsf(vertex->normal[axis])) {
+				axis = k;
+			}
+		}
+		uint32_t normalBucket = axis * 2 + (vertex->normal[axis] < 0.0f);
+
+		vertexCells[i] = insertCluster(cellKeys, cellValues, tableSize, cellKey, &cellCount);
+		vertexClusters[i] = insertCluster(clusterKeys, clusterValues, tableSize, cellKey * 6 + normalBucket, &clusterCount);
+		clusterCells[vertexClusters[i]] = vertexCells[i];
+		++cellVertexCounts[vertexCells[i]];
+		for (size_t k = 0; k < 3; ++k) {
+			cellPositions[vertexCells[i]][k] += vertex->pos[k];
+			clusters[vertexClusters[i]].normal[k] += vertex->normal[k];
+		}
+	}
+
+	for (size_t i = 0; i < clusterCount; ++i) {
+		CookVertex *cluster = clusters + i;
+		float normalLength = sqrtf(cluster->normal[0] * cluster->normal[0] + cluster->normal[1] * cluster->normal[1] + cluster->normal[2] * cluster->normal[2]);
+		for (size_t k = 0; k < 3; ++k) {
+			cluster->pos[k] = cellPositions[clusterCells[i]][k] / cellVertexCounts[clusterCells[i]];
+			if (normalLength > 0.0f) {
+				cluster->normal[k] /= normalLength;
+			}
+		}
+	}
+
+	*lodIndices = malloc(sizeof(**lodIndices) * indexCount);
+	*lodIndexCount = 0;
+	for (size_t i = 0; i < indexCount; i += 3) {
+		uint32_t cell0 = vertexCells[indices[i]];
+		uint32_t cell1 = vertexCells[indices[i + 1]];
+		uint32_t cell2 = vertexCells[indices[i + 2]];
+		if (cell0 == cell1 || cell1 == cell2 || cell2 == cell0) {
+			continue;
+		}
+		for (size_t j = 0; j < 3; ++j) {
+			(*lodIndices)[(*lodIndexCount)++] = vertexClusters[indices[i + j]];
+		}
+	}
+	*lodVertices = clusters;
+	*lodVertexCount = clusterCount;
+
+	free(cellVertexCounts);
+	free(cellPositions);
+	free(clusterCells);
+	free(vertexClusters);
+	free(vertexCells);
+	free(clusterValues);
+	free(clusterKeys);
+	free(cellValues);
+	free(cellKeys);
+}
+
+/* Open addressing from a sparse key to the next dense index, for clusterVertices */
+static uint32_t insertCluster(uint32_t *keys, uint32_t *values, size_t tableSize, uint32_t key, size_t *count)
+{
+	size_t slot = (key * 2654435761u) & (tableSize - 1);
+	while (keys[slot] != UINT32_MAX && keys[slot] != key) {
+		slot = (slot + 1) & (tableSize - 1);
+	}
+	if (keys[slot] == UINT32_MAX) {
+		keys[slot] = key;
+		values[slot] = (*count)++;
+	}
+
+	return values[slot];
+}
+
+static void findBounds(const CookVertex *vertices, size_t vertexCount, float min[3], float max[3])
+{
+	for (size_t k = 0; k < 3; ++k) {
+		min[k] = vertexCount ? INFINITY : 0.0f;
+		max[k] = vertexCount ? -INFINITY : 0.0f;
+	}
+	for (size_t i = 0; i < vertexCount; ++i) {
+		for (size_t k = 0; k < 3; ++k) {
+			min[k] = fminf(min[k], vertices[i].pos[k]);
+			max[k] = fmaxf(max[k], vertices[i].pos[k]);
+		}
+	}
+}
+
+/* Positions become unorm16 fractions of the bounding box, which the header's scale and bias undo */
+static void quantizeVertices(const CookVertex *vertices, size_t vertexCount, MeshVertex *quantizedVertices, const MeshHeader *header)
+{
+	for (size_t i = 0; i < vertexCount; ++i) {
+		for (size_t k = 0; k < 3; ++k) {
+			float fraction = (vertices[i].pos[k] - header->bias[k]) / header->scale[k];
+			quantizedVertices[i].pos[k] = lroundf(fminf(fmaxf(fraction, 0.0f), 1.0f) * UINT16_MAX);
+		}
+		quantizedVertices[i].pos[3] = 0;
+		encodeOctahedral(vertices[i].normal, quantizedVertices[i].normal);
+	}
+}
+
+/* Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper */
+static void encodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+	float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+	if (length == 0.0f) {
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+
+	float u = normal[0] / length;
+	float v = normal[1] / length;
+	if (normal[2] < 0.0f) {
+		float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		float foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	encoded[0] = lroundf(fminf(fmaxf(u, -1.0f), 1.0f) * INT16_MAX);
+	encoded[1] = lroundf(fminf(fmaxf(v, -1.0f), 1.0f) * INT16_MAX);
+}
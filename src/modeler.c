@@ -25,6 +25,10 @@
 #include "synchronization.h"
 #include "allocator.h"
 #include "buffer.h"
+#include "upload.h"
+#include "uniform_ring.h"
+#include "buffer_arena.h"
+#include "asset_loader.h"
 #include "utils.h"
 #include "vulkan_utils.h"
 #include "chess_board.h"
@@ -32,6 +36,10 @@
 #include "titlebar.h"
 #include "renderloop.h"
 #include "window.h"
+#include "frame_timer.h"
+#include "msaa.h"
+#include "resolution.h"
+#include "upscale.h"
 
 #ifdef EMBED_SHADERS
 #include "../shader_window_border.vert.h"
@@ -48,10 +56,15 @@ struct swapchain_create_info_t {
 	QueueInfo queueInfo;
 	VkCommandPool commandPool;
 	VkRenderPass *renderPass;
+	VkRenderPass *sceneRenderPass;
 	SwapchainInfo *swapchainInfo;
 	VkImage *multisampleImage;
 	VkImageView *multisampleImageView;
 	VmaAllocation *multisampleImageAllocation;
+	VkImage *sceneImage;
+	VmaAllocation *sceneImageAllocation;
+	VkImageView *sceneImageView;
+	VkFramebuffer *sceneFramebuffer;
 	VkImage *offscreenImage;
 	uint32_t offscreenImageCount;
 	VkImageView *offscreenImageView;
@@ -67,15 +80,28 @@ struct swapchain_create_info_t {
 	VkFormat *depthImageFormat;
 	VkImageView *depthImageView;
 	SynchronizationInfo *synchronizationInfo;
+	VkSampleCountFlagBits sampleCount;
+	/* Rebuilt when the sample count changes */
+	VkPipelineCache pipelineCache;
+	const char *resourcePath;
+	ChessBoard chessBoard;
+	Titlebar titlebar;
+	Upscaler upscaler;
+	VkPipelineLayout *windowBorderPipelineLayout;
+	VkPipeline *windowBorderPipeline;
 };
 
-static void cleanupVulkan(VkInstance instance, VkDebugReportCallbackEXT debugCallback, VkSurfaceKHR surface, PhysicalDeviceCharacteristics *physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics *surfaceCharacteristics, VkDevice device, VmaAllocator allocator, VkSwapchainKHR swapchain, VkImage *offscreenImages, VmaAllocation *offscreenImageAllocations, size_t offscreenImageCount, VkImageView *offscreenImageViews, VkImageView *imageViews, uint32_t imageViewCount, VkRenderPass renderPass, VkPipelineLayout *pipelineLayouts, VkPipeline *pipelines, size_t pipelineCount, VkFramebuffer *framebuffers, uint32_t framebufferCount, VkCommandPool commandPool, VkCommandBuffer *commandBuffers, uint32_t commandBufferCount, VkDescriptorPool descriptorPool, VkDescriptorSet *imageDescriptorSets, VkDescriptorSetLayout *imageDescriptorSetLayouts, ChessBoard chessBoard, Titlebar titlebar, VkImage depthImage, VmaAllocation depthImageAllocation, VkImageView depthImageView, VkImage multisampleImage, VkImageView multisampleImageView, VmaAllocation multisampleImageAllocation, SwapchainCreateInfo swapchainCreateInfo, VkDescriptorPool imDescriptorPool);
+static void cleanupVulkan(VkInstance instance, VkDebugReportCallbackEXT debugCallback, VkSurfaceKHR surface, PhysicalDeviceCharacteristics *physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics *surfaceCharacteristics, VkDevice device, VmaAllocator allocator, VkSwapchainKHR swapchain, VkImage *offscreenImages, VmaAllocation *offscreenImageAllocations, size_t offscreenImageCount, VkImageView *offscreenImageViews, VkImageView *imageViews, uint32_t imageViewCount, VkRenderPass renderPass, VkPipelineCache pipelineCache, VkPipelineLayout *pipelineLayouts, VkPipeline *pipelines, size_t pipelineCount, VkFramebuffer *framebuffers, uint32_t framebufferCount, VkCommandPool commandPool, VkCommandBuffer *commandBuffers, uint32_t commandBufferCount, VkDescriptorPool descriptorPool, VkDescriptorSet *imageDescriptorSets, VkDescriptorSetLayout *imageDescriptorSetLayouts, UploadManager uploadManager, UniformRing uniformRing, BufferArena bufferArena, FrameTimer frameTimer, MsaaController msaaController, ResolutionController resolutionController, ChessBoard chessBoard, Titlebar titlebar, Upscaler upscaler, VkImage depthImage, VmaAllocation depthImageAllocation, VkImageView depthImageView, VkImage multisampleImage, VkImageView multisampleImageView, VmaAllocation multisampleImageAllocation, SwapchainCreateInfo swapchainCreateInfo, VkDescriptorPool imDescriptorPool);
 #ifdef ENABLE_IMGUI
-void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowDimensions *windowDimensions, PhysicalDeviceCharacteristics physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics surfaceCharacteristics, QueueInfo queueInfo, VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkDescriptorPool *descriptorPool, char **error);
+void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowDimensions *windowDimensions, VkSampleCountFlagBits sampleCount, PhysicalDeviceSurfaceCharacteristics surfaceCharacteristics, QueueInfo queueInfo, VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkPipelineCache pipelineCache, VkDescriptorPool *descriptorPool, char **error);
 static void imVkCheck(VkResult result);
 #endif /* ENABLE_IMGUI */
 static void destroyAppSwapchain(SwapchainCreateInfo swapchainCreateInfo);
+static bool recreatePipelines(SwapchainCreateInfo swapchainCreateInfo, char **error);
 bool createAppSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResized, char **error);
+#ifdef DRAW_WINDOW_BORDER
+static bool createWindowBorderPipeline(VkDevice device, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, const char *resourcePath, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error);
+#endif /* DRAW_WINDOW_BORDER */
 static bool createDepthBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator allocator, VkExtent2D extent, VkSampleCountFlagBits sampleCount, VkImage *image, VmaAllocation *imageAllocation, VkFormat *format, VkImageView *imageView, char **error);
 static void destroyDepthBuffer(VkDevice device, VmaAllocator allocator, VkImage image, VmaAllocation imageAllocation, VkImageView imageView);
 
@@ -91,11 +117,18 @@ void *threadProc(void *arg)
 	void *platformWindow = threadArgs->platformWindow;
 	Queue *inputQueue = threadArgs->inputQueue;
 	const char *resourcePath = threadArgs->resourcePath;
+	const char *cachePath = threadArgs->cachePath;
 	const char **instanceExtensions = threadArgs->instanceExtensions;
 	uint32_t instanceExtensionCount = threadArgs->instanceExtensionCount;
 	WindowDimensions windowDimensions = threadArgs->windowDimensions;
 	char **error = threadArgs->error;
 
+	/* Files are read on worker threads while the device comes up */
+	AssetLoader assetLoader;
+	if (!createAssetLoader(&assetLoader, resourcePath, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
 	VkInstance instance;
 	VkDebugReportCallbackEXT debugCallback;
 	if (!createInstance(instanceExtensions, instanceExtensionCount, &instance, &debugCallback, error)) {
@@ -125,6 +158,11 @@ void *threadProc(void *arg)
 	updateWindowDimensionsInsets(&windowDimensions, windowDimensions.insets);
 #endif /* ANDROID */
 
+	TextureEncoding textureEncoding;
+	if (!chooseTextureEncoding(physicalDevice, &textureEncoding, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
 	VkDevice device;
 	QueueInfo queueInfo = {};
 	if (!createDevice(physicalDevice, surface, physicalDeviceCharacteristics, &device, &queueInfo, error)) {
@@ -136,8 +174,15 @@ void *threadProc(void *arg)
 		sendThreadFailureSignal(platformWindow);
 	}
 
+	char *pipelineCachePath;
+	asprintf(&pipelineCachePath, "%s/%s", cachePath, PIPELINE_CACHE_FILE_NAME);
+	VkPipelineCache pipelineCache;
+	if (!createPipelineCache(device, physicalDeviceCharacteristics.deviceProperties, pipelineCachePath, &pipelineCache, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
 	VkCommandPool commandPool;
-	if (!createCommandPool(device, queueInfo, &commandPool, error)) {
+	if (!createCommandPool(device, queueInfo.graphicsQueueFamilyIndex, &commandPool, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
 
@@ -146,6 +191,37 @@ void *threadProc(void *arg)
 		sendThreadFailureSignal(platformWindow);
 	}
 
+	UploadManager uploadManager;
+	if (!createUploadManager(&uploadManager, device, allocator, UPLOAD_MANAGER_DEFAULT_SIZE, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	UniformRing uniformRing;
+	if (!createUniformRing(&uniformRing, device, allocator, physicalDeviceCharacteristics.deviceProperties.limits.minUniformBufferOffsetAlignment, UNIFORM_RING_DEFAULT_FRAME_SIZE, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	BufferArena bufferArena;
+	if (!createBufferArena(&bufferArena, device, allocator, &physicalDeviceCharacteristics.deviceProperties.limits, BUFFER_ARENA_DEFAULT_BLOCK_SIZE, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	FrameTimer frameTimer;
+	if (!createFrameTimer(&frameTimer, device, physicalDeviceCharacteristics.deviceProperties, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	MsaaController msaaController;
+	if (!createMsaaController(&msaaController, physicalDeviceCharacteristics.deviceProperties, MSAA_MODE_AUTO, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	ResolutionController resolutionController;
+	if (!createResolutionController(&resolutionController, true, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+	VkSampleCountFlagBits sampleCount = msaaControllerGetSampleCount(msaaController);
+
 	SwapchainInfo swapchainInfo = {};
 	VkImageView *imageViews;
 	VkDescriptorPool descriptorPool;
@@ -158,6 +234,11 @@ void *threadProc(void *arg)
 #endif /* DRAW_WINDOW_BORDER */
 	VkRenderPass renderPass;
 	VkFramebuffer *framebuffers;
+	VkRenderPass sceneRenderPass;
+	VkFramebuffer sceneFramebuffer;
+	VkImage sceneImage;
+	VmaAllocation sceneImageAllocation;
+	VkImageView sceneImageView;
 	VkImage multisampleImage;
 	VkImageView multisampleImageView;
 	VmaAllocation multisampleImageAllocation;
@@ -176,6 +257,7 @@ void *threadProc(void *arg)
 		.surfaceCharacteristics = &surfaceCharacteristics,
 		.queueInfo = queueInfo,
 		.renderPass = &renderPass,
+		.sceneRenderPass = &sceneRenderPass,
 		.swapchainInfo = &swapchainInfo,
 		.imageViews = &imageViews,
 		.framebuffers = &framebuffers,
@@ -188,7 +270,14 @@ void *threadProc(void *arg)
 		.multisampleImage = &multisampleImage,
 		.multisampleImageView = &multisampleImageView,
 		.multisampleImageAllocation = &multisampleImageAllocation,
+		.sceneImage = &sceneImage,
+		.sceneImageAllocation = &sceneImageAllocation,
+		.sceneImageView = &sceneImageView,
+		.sceneFramebuffer = &sceneFramebuffer,
 		.synchronizationInfo = &synchronizationInfo,
+		.sampleCount = sampleCount,
+		.pipelineCache = pipelineCache,
+		.resourcePath = resourcePath,
 #ifdef DRAW_WINDOW_BORDER
 		.descriptorPool = &descriptorPool,
 		.imageDescriptorSetLayouts = &imageDescriptorSetLayout,
@@ -211,9 +300,22 @@ void *threadProc(void *arg)
 
 	ChessBoard chessBoard;
 	ChessEngine chessEngine;
-	createChessEngine(&chessEngine, &chessBoard);
+	if (!createChessEngine(&chessEngine, &chessBoard, inputQueue, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	/* Startup pipelines compile on worker threads while the rest of setup continues */
+	PipelineBuilder pipelineBuilder;
+	if (!createPipelineBuilder(&pipelineBuilder, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
 
-	if (!createChessBoard(&chessBoard, chessEngine, device, allocator, commandPool, queueInfo.graphicsQueue, renderPass, 0, getMaxSampleCount(physicalDeviceCharacteristics.deviceProperties), resourcePath, negateRotation(windowDimensions.orientation), false, PERSPECTIVE, error)) {
+	UploadBatch uploadBatch;
+	if (!beginUploadBatch(&uploadBatch, device, allocator, commandPool, queueInfo, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
+	if (!createChessBoard(&chessBoard, chessEngine, device, allocator, assetLoader, uploadBatch, uploadManager, uniformRing, bufferArena, sceneRenderPass, pipelineCache, pipelineBuilder, 0, sampleCount, resourcePath, negateRotation(windowDimensions.orientation), false, PERSPECTIVE, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
 
@@ -225,81 +327,35 @@ void *threadProc(void *arg)
 	int titlebarSubpass = 1;
 #endif /* ENABLE_IMGUI */
 	Titlebar titlebar;
-	if (!createTitlebar(&titlebar, device, allocator, commandPool, queueInfo.graphicsQueue, renderPass, titlebarSubpass, getMaxSampleCount(physicalDeviceCharacteristics.deviceProperties), resourcePath, aspectRatio, &sendCloseSignal, platformWindow, &sendMaximizeSignal, platformWindow, &sendMinimizeSignal, platformWindow, error)) {
+	if (!createTitlebar(&titlebar, device, allocator, assetLoader, textureEncoding, uploadBatch, renderPass, pipelineCache, pipelineBuilder, titlebarSubpass, sampleCount, resourcePath, aspectRatio, &sendCloseSignal, platformWindow, &sendMaximizeSignal, platformWindow, &sendMinimizeSignal, platformWindow, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
 
-#ifndef EMBED_SHADERS
-#ifdef DRAW_WINDOW_BORDER
-	char *windowBorderVertShaderPath;
-	char *windowBorderFragShaderPath;
-	asprintf(&windowBorderVertShaderPath, "%s/%s", resourcePath, "window_border.vert.spv");
-	asprintf(&windowBorderFragShaderPath, "%s/%s", resourcePath, "window_border.frag.spv");
-	char *windowBorderVertShaderBytes;
-	char *windowBorderFragShaderBytes;
-	uint32_t windowBorderVertShaderSize = 0;
-	uint32_t windowBorderFragShaderSize = 0;
+	Upscaler upscaler;
+	if (!createUpscaler(&upscaler, device, renderPass, pipelineCache, pipelineBuilder, 0, sampleCount, resourcePath, sceneImageView, swapchainInfo.extent, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+	swapchainCreateInfo.chessBoard = chessBoard;
+	swapchainCreateInfo.titlebar = titlebar;
+	swapchainCreateInfo.upscaler = upscaler;
 
-	if ((windowBorderVertShaderSize = readFileToString(windowBorderVertShaderPath, &windowBorderVertShaderBytes)) == -1) {
-		asprintf(error, "Failed to open window border vertex shader for reading.\n");
+	if (!endUploadBatch(uploadBatch, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
-	if ((windowBorderFragShaderSize = readFileToString(windowBorderFragShaderPath, &windowBorderFragShaderBytes)) == -1) {
-		asprintf(error, "Failed to open window border fragment shader for reading.\n");
+
+	char *fontBytes = NULL;
+	size_t fontSize = 0;
+#ifdef ENABLE_IMGUI
+	if (!assetLoaderTakeFile(assetLoader, ASSET_ROBOTO_FONT, &fontBytes, &fontSize, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
-#endif /* DRAW_WINDOW_BORDER */
-#endif /* EMBED_SHADERS */
+#endif /* ENABLE_IMGUI */
+	destroyAssetLoader(assetLoader);
 
 #ifdef DRAW_WINDOW_BORDER
 	VkPipelineLayout pipelineLayoutWindowDecoration;
 	VkPipeline pipelineWindowDecoration;
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-		.offset = 0,
-		.size = sizeof(PushConstants)
-	};
-	VkPipelineDepthStencilStateCreateInfo depthStencilState = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-		.depthTestEnable = VK_FALSE,
-		.depthWriteEnable = VK_FALSE,
-		.depthCompareOp = VK_COMPARE_OP_NEVER,
-		.depthBoundsTestEnable = VK_FALSE,
-		.minDepthBounds = 0.0f,
-		.maxDepthBounds = 1.0f,
-		.stencilTestEnable = VK_FALSE,
-		.front = {},
-		.back = {}
-	};
-	PipelineCreateInfo pipelineCreateInfoWindowDecoration = {
-		.device = device,
-		.renderPass = renderPass,
-#ifdef ENABLE_IMGUI
-		.subpassIndex = 2,
-#else
-		.subpassIndex = 1,
-#endif /* ENABLE_IMGUI */
-		.vertexShaderBytes = windowBorderVertShaderBytes,
-		.vertexShaderSize = windowBorderVertShaderSize,
-		.fragmentShaderBytes = windowBorderFragShaderBytes,
-		.fragmentShaderSize = windowBorderFragShaderSize,
-		.vertexBindingDescriptionCount = 0,
-		.vertexBindingDescriptions = NULL,
-		.vertexAttributeDescriptionCount = 0,
-		.VertexAttributeDescriptions = NULL,
-		.descriptorSetLayouts = &imageDescriptorSetLayout,
-		.descriptorSetLayoutCount = 1,
-		.pushConstantRangeCount = 1,
-		.pushConstantRanges = &pushConstantRange,
-		.depthStencilState = depthStencilState,
-		.sampleCount = VK_SAMPLE_COUNT_1_BIT
-	};
-	bool pipelineCreateSuccessWindowDecoration = createPipeline(pipelineCreateInfoWindowDecoration, &pipelineLayoutWindowDecoration, &pipelineWindowDecoration, false, error);
-#ifndef EMBED_SHADERS
-	free(windowBorderFragShaderBytes);
-	free(windowBorderVertShaderBytes);
-#endif /* EMBED_SHADERS */
-	if (!pipelineCreateSuccessWindowDecoration) {
+	if (!createWindowBorderPipeline(device, pipelineCache, pipelineBuilder, renderPass, imageDescriptorSetLayout, resourcePath, &pipelineLayoutWindowDecoration, &pipelineWindowDecoration, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
 #endif /* DRAW_WINDOW_BORDER */
@@ -307,14 +363,20 @@ void *threadProc(void *arg)
 	VkDescriptorPool imDescriptorPool;
 #ifdef ENABLE_IMGUI
 	ImGui_ImplVulkan_InitInfo imVulkanInitInfo;
-	initializeImgui(platformWindow, &swapchainInfo, &windowDimensions, physicalDeviceCharacteristics, surfaceCharacteristics, queueInfo, instance, physicalDevice, device, renderPass, &imDescriptorPool, error);
+	initializeImgui(platformWindow, &swapchainInfo, &windowDimensions, sampleCount, surfaceCharacteristics, queueInfo, instance, physicalDevice, device, renderPass, pipelineCache, &imDescriptorPool, error);
 #endif /* ENABLE_IMGUI */
 
+	if (!finishPipelineBuilder(pipelineBuilder, error)) {
+		sendThreadFailureSignal(platformWindow);
+	}
+
 #if DRAW_WINDOW_BORDER
 	VkPipeline pipelines[] = {pipelineWindowDecoration};
 	VkPipelineLayout pipelineLayouts[] = {pipelineLayoutWindowDecoration};
 	size_t pipelineCount = 1;
 	VkDescriptorSet *drawDescriptorSets = &imageDescriptorSet;
+	swapchainCreateInfo.windowBorderPipelineLayout = pipelineLayouts;
+	swapchainCreateInfo.windowBorderPipeline = pipelines;
 #else
 	VkPipeline pipelines[] = {};
 	VkPipelineLayout pipelineLayouts[] = {};
@@ -322,10 +384,20 @@ void *threadProc(void *arg)
 	VkDescriptorSet *drawDescriptorSets = NULL;
 #endif /* DRAW_WINDOW_BORDER */
 
-	if (!draw(device, platformWindow, &windowDimensions, drawDescriptorSets, &renderPass, pipelines, pipelineLayouts, &framebuffers, commandBuffers, &synchronizationInfo, &swapchainInfo, queueInfo.graphicsQueue, queueInfo.presentationQueue, queueInfo.graphicsQueueFamilyIndex, resourcePath, inputQueue, &swapchainCreateInfo, chessBoard, chessEngine, titlebar, error)) {
+	if (!draw(device, platformWindow, &windowDimensions, drawDescriptorSets, &renderPass, pipelines, pipelineLayouts, &framebuffers, &sceneRenderPass, &sceneFramebuffer, commandBuffers, &synchronizationInfo, &swapchainInfo, queueInfo.graphicsQueue, queueInfo.presentationQueue, queueInfo.graphicsQueueFamilyIndex, fontBytes, fontSize, inputQueue, &swapchainCreateInfo, uploadManager, frameTimer, msaaController, resolutionController, chessBoard, chessEngine, titlebar, upscaler, error)) {
 		sendThreadFailureSignal(platformWindow);
 	}
 
+	free(fontBytes);
+
+	/* Losing the cache only costs the next launch some compile time */
+	char *pipelineCacheError;
+	if (!makeDirectories(cachePath, &pipelineCacheError) || !savePipelineCache(device, pipelineCache, pipelineCachePath, &pipelineCacheError)) {
+		fprintf(stderr, "%s\n", pipelineCacheError);
+		free(pipelineCacheError);
+	}
+	free(pipelineCachePath);
+
 #ifdef DRAW_WINDOW_BORDER
 	size_t offscreenImageCount = 1;
 	VkImage offscreenImages[] = {offscreenImage};
@@ -338,7 +410,8 @@ void *threadProc(void *arg)
 	VkImageView *offscreenImageViews = NULL;
 #endif /* DRAW_WINDOW_BORDER */
 
-	cleanupVulkan(instance, debugCallback, surface, &physicalDeviceCharacteristics, &surfaceCharacteristics, device, allocator, swapchainInfo.swapchain, offscreenImages, offscreenImageAllocations, offscreenImageCount, offscreenImageViews, imageViews, swapchainInfo.imageCount, renderPass, pipelineLayouts, pipelines, pipelineCount, framebuffers, swapchainInfo.imageCount, commandPool, commandBuffers, MAX_FRAMES_IN_FLIGHT, descriptorPool, &imageDescriptorSet, &imageDescriptorSetLayout, chessBoard, titlebar, depthImage, depthImageAllocation, depthImageView, multisampleImage, multisampleImageView, multisampleImageAllocation, &swapchainCreateInfo, imDescriptorPool);
+	destroyChessEngine(chessEngine);
+	cleanupVulkan(instance, debugCallback, surface, &physicalDeviceCharacteristics, &surfaceCharacteristics, device, allocator, swapchainInfo.swapchain, offscreenImages, offscreenImageAllocations, offscreenImageCount, offscreenImageViews, imageViews, swapchainInfo.imageCount, renderPass, pipelineCache, pipelineLayouts, pipelines, pipelineCount, framebuffers, swapchainInfo.imageCount, commandPool, commandBuffers, MAX_FRAMES_IN_FLIGHT, descriptorPool, &imageDescriptorSet, &imageDescriptorSetLayout, uploadManager, uniformRing, bufferArena, frameTimer, msaaController, resolutionController, chessBoard, titlebar, upscaler, depthImage, depthImageAllocation, depthImageView, multisampleImage, multisampleImageView, multisampleImageAllocation, &swapchainCreateInfo, imDescriptorPool);
 
 	return NULL;
 }
@@ -351,7 +424,7 @@ static void imVkCheck(VkResult result)
 	}
 }
 
-void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowDimensions *windowDimensions, PhysicalDeviceCharacteristics physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics surfaceCharacteristics, QueueInfo queueInfo, VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkDescriptorPool *descriptorPool, char **error)
+void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowDimensions *windowDimensions, VkSampleCountFlagBits sampleCount, PhysicalDeviceSurfaceCharacteristics surfaceCharacteristics, QueueInfo queueInfo, VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkPipelineCache pipelineCache, VkDescriptorPool *descriptorPool, char **error)
 {
 	VkDescriptorPoolSize pool_sizes[] = {
 		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1}
@@ -381,7 +454,7 @@ void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowD
 		.Device = device,
 		.QueueFamily = queueInfo.graphicsQueueFamilyIndex,
 		.Queue = queueInfo.graphicsQueue,
-		.PipelineCache = VK_NULL_HANDLE,
+		.PipelineCache = pipelineCache,
 		.DescriptorPool = *descriptorPool,
 		.MinImageCount = surfaceCharacteristics.capabilities.minImageCount,
 		.ImageCount = swapchainInfo->imageCount,
@@ -389,14 +462,14 @@ void initializeImgui(void *platformWindow, SwapchainInfo *swapchainInfo, WindowD
 		.CheckVkResultFn = imVkCheck,
 		.PipelineInfoMain.RenderPass = renderPass,
 		.PipelineInfoMain.Subpass = 1,
-		.PipelineInfoMain.MSAASamples = getMaxSampleCount(physicalDeviceCharacteristics.deviceProperties),
+		.PipelineInfoMain.MSAASamples = sampleCount,
 		.WindowDimensions = windowDimensions
 	};
 	cImGui_ImplVulkan_Init(&imVulkanInitInfo);
 }
 #endif /* ENABLE_IMGUI */
 
-bool recreateSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResized, char **error)
+bool recreateSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResized, VkSampleCountFlagBits sampleCount, char **error)
 {
 	vkDeviceWaitIdle(swapchainCreateInfo->device);
 
@@ -406,16 +479,81 @@ bool recreateSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResiz
 		return false;
 	}
 
-	createAppSwapchain(swapchainCreateInfo, windowResized, error);
+	bool sampleCountChanged = sampleCount != swapchainCreateInfo->sampleCount;
+	swapchainCreateInfo->sampleCount = sampleCount;
+
+	if (!createAppSwapchain(swapchainCreateInfo, windowResized, error)) {
+		return false;
+	}
+
+	if (!upscalerSetScene(swapchainCreateInfo->upscaler, *swapchainCreateInfo->sceneImageView, swapchainCreateInfo->swapchainInfo->extent, error)) {
+		return false;
+	}
+
+	if (sampleCountChanged && !recreatePipelines(swapchainCreateInfo, error)) {
+		return false;
+	}
 
 	return true;
 }
 
+/* Every pipeline has to match the render pass's sample count */
+static bool recreatePipelines(SwapchainCreateInfo swapchainCreateInfo, char **error)
+{
+	VkRenderPass renderPass = *swapchainCreateInfo->renderPass;
+	VkSampleCountFlagBits sampleCount = swapchainCreateInfo->sampleCount;
+
+	PipelineBuilder pipelineBuilder;
+	if (!createPipelineBuilder(&pipelineBuilder, error)) {
+		return false;
+	}
+
+	bool recreated = chessBoardRecreatePipelines(swapchainCreateInfo->chessBoard, pipelineBuilder, *swapchainCreateInfo->sceneRenderPass, sampleCount, error)
+		&& upscalerRecreatePipeline(swapchainCreateInfo->upscaler, pipelineBuilder, renderPass, sampleCount, error)
+		&& titlebarRecreatePipeline(swapchainCreateInfo->titlebar, pipelineBuilder, renderPass, sampleCount, error);
+
+#ifdef DRAW_WINDOW_BORDER
+	if (recreated) {
+		destroyPipeline(swapchainCreateInfo->device, *swapchainCreateInfo->windowBorderPipeline);
+		destroyPipelineLayout(swapchainCreateInfo->device, *swapchainCreateInfo->windowBorderPipelineLayout);
+		recreated = createWindowBorderPipeline(swapchainCreateInfo->device, swapchainCreateInfo->pipelineCache, pipelineBuilder, renderPass, *swapchainCreateInfo->imageDescriptorSetLayouts, swapchainCreateInfo->resourcePath, swapchainCreateInfo->windowBorderPipelineLayout, swapchainCreateInfo->windowBorderPipeline, error);
+	}
+#endif /* DRAW_WINDOW_BORDER */
+
+#ifdef ENABLE_IMGUI
+	if (recreated) {
+		ImGui_ImplVulkan_PipelineInfo imPipelineInfo = {
+			.RenderPass = renderPass,
+			.Subpass = 1,
+			.MSAASamples = sampleCount
+		};
+		cImGui_ImplVulkan_CreateMainPipeline(&imPipelineInfo);
+	}
+#endif /* ENABLE_IMGUI */
+
+	/* Jobs already queued point into live objects, so the builder is finished even after a failure */
+	char *finishError;
+	if (!finishPipelineBuilder(pipelineBuilder, &finishError)) {
+		if (recreated) {
+			*error = finishError;
+		} else {
+			free(finishError);
+		}
+		return false;
+	}
+
+	return recreated;
+}
+
 void destroyAppSwapchain(SwapchainCreateInfo swapchainCreateInfo)
 {
 	destroySynchronization(swapchainCreateInfo->device, swapchainCreateInfo->swapchainInfo->imageCount, swapchainCreateInfo->synchronizationInfo);
 	destroyFramebuffers(swapchainCreateInfo->device, *swapchainCreateInfo->framebuffers, swapchainCreateInfo->swapchainInfo->imageCount);
 	destroyRenderPass(swapchainCreateInfo->device, *swapchainCreateInfo->renderPass);
+	destroyFramebuffer(swapchainCreateInfo->device, *swapchainCreateInfo->sceneFramebuffer);
+	destroyRenderPass(swapchainCreateInfo->device, *swapchainCreateInfo->sceneRenderPass);
+	destroyImageView(swapchainCreateInfo->device, *swapchainCreateInfo->sceneImageView);
+	destroyImage(swapchainCreateInfo->allocator, *swapchainCreateInfo->sceneImage, *swapchainCreateInfo->sceneImageAllocation);
 #ifdef DRAW_WINDOW_BORDER
 	for (size_t i = 0; i < swapchainCreateInfo->offscreenImageCount; ++i) {
 		destroyDescriptorSetLayout(swapchainCreateInfo->device, (swapchainCreateInfo->imageDescriptorSetLayouts)[i]);
@@ -490,20 +628,51 @@ bool createAppSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResi
 	}
 #endif /* DRAW_WINDOW_BORDER */
 
-	VkSampleCountFlagBits sampleCount = getMaxSampleCount(swapchainCreateInfo->physicalDeviceCharacteristics.deviceProperties);
-	if (!createImage(swapchainCreateInfo->device, swapchainCreateInfo->allocator, swapchainCreateInfo->swapchainInfo->extent, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 1, sampleCount, swapchainCreateInfo->multisampleImage, swapchainCreateInfo->multisampleImageAllocation, error)) {
+	/* At one sample the render pass draws straight into the resolve target */
+	VkSampleCountFlagBits sampleCount = swapchainCreateInfo->sampleCount;
+	bool resolve = sampleCount != VK_SAMPLE_COUNT_1_BIT;
+	*swapchainCreateInfo->multisampleImage = VK_NULL_HANDLE;
+	*swapchainCreateInfo->multisampleImageAllocation = VK_NULL_HANDLE;
+	*swapchainCreateInfo->multisampleImageView = VK_NULL_HANDLE;
+	if (resolve) {
+		if (!createImage(swapchainCreateInfo->device, swapchainCreateInfo->allocator, swapchainCreateInfo->swapchainInfo->extent, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 1, sampleCount, swapchainCreateInfo->multisampleImage, swapchainCreateInfo->multisampleImageAllocation, error)) {
+			return false;
+		}
+
+		if (!createImageView(swapchainCreateInfo->device, *swapchainCreateInfo->multisampleImage, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, swapchainCreateInfo->multisampleImageView, error)) {
+			return false;
+		}
+	}
+
+	if (!createDepthBuffer(swapchainCreateInfo->physicalDevice, swapchainCreateInfo->device, swapchainCreateInfo->allocator, swapchainCreateInfo->swapchainInfo->extent, sampleCount, swapchainCreateInfo->depthImage, swapchainCreateInfo->depthImageAllocation, swapchainCreateInfo->depthImageFormat, swapchainCreateInfo->depthImageView, error)) {
 		return false;
 	}
 
-	if (!createImageView(swapchainCreateInfo->device, *swapchainCreateInfo->multisampleImage, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, swapchainCreateInfo->multisampleImageView, error)) {
+	if (!createRenderPass(swapchainCreateInfo->device, *swapchainCreateInfo->swapchainInfo, *swapchainCreateInfo->depthImageFormat, sampleCount, swapchainCreateInfo->renderPass, error)) {
 		return false;
 	}
 
-	if (!createDepthBuffer(swapchainCreateInfo->physicalDevice, swapchainCreateInfo->device, swapchainCreateInfo->allocator, swapchainCreateInfo->swapchainInfo->extent, sampleCount, swapchainCreateInfo->depthImage, swapchainCreateInfo->depthImageAllocation, swapchainCreateInfo->depthImageFormat, swapchainCreateInfo->depthImageView, error)) {
+	if (!createSceneRenderPass(swapchainCreateInfo->device, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, *swapchainCreateInfo->depthImageFormat, sampleCount, swapchainCreateInfo->sceneRenderPass, error)) {
 		return false;
 	}
 
-	if (!createRenderPass(swapchainCreateInfo->device, *swapchainCreateInfo->swapchainInfo, *swapchainCreateInfo->depthImageFormat, sampleCount, swapchainCreateInfo->renderPass, error)) {
+	/* Swapchain sized, so the render scale can change without recreating it */
+	if (!createImage(swapchainCreateInfo->device, swapchainCreateInfo->allocator, swapchainCreateInfo->swapchainInfo->extent, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 1, VK_SAMPLE_COUNT_1_BIT, swapchainCreateInfo->sceneImage, swapchainCreateInfo->sceneImageAllocation, error)) {
+		return false;
+	}
+
+	if (!createImageView(swapchainCreateInfo->device, *swapchainCreateInfo->sceneImage, swapchainCreateInfo->swapchainInfo->surfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1, swapchainCreateInfo->sceneImageView, error)) {
+		return false;
+	}
+
+	VkImageView sceneAttachments[] = {*swapchainCreateInfo->multisampleImageView, *swapchainCreateInfo->depthImageView, *swapchainCreateInfo->sceneImageView};
+	uint32_t sceneAttachmentCount = sizeof(sceneAttachments) / sizeof(sceneAttachments[0]);
+	if (!resolve) {
+		sceneAttachments[0] = *swapchainCreateInfo->sceneImageView;
+		sceneAttachmentCount = 2;
+	}
+
+	if (!createFramebuffer(swapchainCreateInfo->device, *swapchainCreateInfo->swapchainInfo, sceneAttachments, sceneAttachmentCount, *swapchainCreateInfo->sceneRenderPass, swapchainCreateInfo->sceneFramebuffer, error)) {
 		return false;
 	}
 
@@ -512,9 +681,18 @@ bool createAppSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResi
 #ifdef DRAW_WINDOW_BORDER
 		VkImageView attachments[] = {*swapchainCreateInfo->multisampleImageView, *swapchainCreateInfo->depthImageView, *swapchainCreateInfo->offscreenImageView, (*swapchainCreateInfo->imageViews)[i]};
 		uint32_t attachmentCount = 4;
+		if (!resolve) {
+			attachments[0] = *swapchainCreateInfo->offscreenImageView;
+			attachments[2] = (*swapchainCreateInfo->imageViews)[i];
+			attachmentCount = 3;
+		}
 #else
 		VkImageView attachments[] = {*swapchainCreateInfo->multisampleImageView, *swapchainCreateInfo->depthImageView, (*swapchainCreateInfo->imageViews)[i]};
 		uint32_t attachmentCount = sizeof(attachments) / sizeof(attachments[0]);
+		if (!resolve) {
+			attachments[0] = (*swapchainCreateInfo->imageViews)[i];
+			attachmentCount = 2;
+		}
 #endif /* DRAW_WINDOW_BORDER */
 
 		if (!createFramebuffer(swapchainCreateInfo->device, *swapchainCreateInfo->swapchainInfo, attachments, attachmentCount, *swapchainCreateInfo->renderPass, *swapchainCreateInfo->framebuffers + i, error)) {
@@ -529,6 +707,83 @@ bool createAppSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResi
 	return true;
 }
 
+#ifdef DRAW_WINDOW_BORDER
+static bool createWindowBorderPipeline(VkDevice device, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, const char *resourcePath, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error)
+{
+#ifndef EMBED_SHADERS
+	char *windowBorderVertShaderPath;
+	char *windowBorderFragShaderPath;
+	asprintf(&windowBorderVertShaderPath, "%s/%s", resourcePath, "window_border.vert.spv");
+	asprintf(&windowBorderFragShaderPath, "%s/%s", resourcePath, "window_border.frag.spv");
+	char *windowBorderVertShaderBytes;
+	char *windowBorderFragShaderBytes;
+	uint32_t windowBorderVertShaderSize = 0;
+	uint32_t windowBorderFragShaderSize = 0;
+
+	if ((windowBorderVertShaderSize = readFileToString(windowBorderVertShaderPath, &windowBorderVertShaderBytes)) == -1) {
+		asprintf(error, "Failed to open window border vertex shader for reading.\n");
+		return false;
+	}
+	if ((windowBorderFragShaderSize = readFileToString(windowBorderFragShaderPath, &windowBorderFragShaderBytes)) == -1) {
+		asprintf(error, "Failed to open window border fragment shader for reading.\n");
+		return false;
+	}
+#endif /* EMBED_SHADERS */
+
+	VkPushConstantRange pushConstantRange = {
+		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		.offset = 0,
+		.size = sizeof(PushConstants)
+	};
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.depthTestEnable = VK_FALSE,
+		.depthWriteEnable = VK_FALSE,
+		.depthCompareOp = VK_COMPARE_OP_NEVER,
+		.depthBoundsTestEnable = VK_FALSE,
+		.minDepthBounds = 0.0f,
+		.maxDepthBounds = 1.0f,
+		.stencilTestEnable = VK_FALSE,
+		.front = {},
+		.back = {}
+	};
+	PipelineCreateInfo pipelineCreateInfoWindowDecoration = {
+		.device = device,
+		.pipelineCache = pipelineCache,
+		.renderPass = renderPass,
+#ifdef ENABLE_IMGUI
+		.subpassIndex = 2,
+#else
+		.subpassIndex = 1,
+#endif /* ENABLE_IMGUI */
+		.vertexShaderBytes = windowBorderVertShaderBytes,
+		.vertexShaderSize = windowBorderVertShaderSize,
+		.fragmentShaderBytes = windowBorderFragShaderBytes,
+		.fragmentShaderSize = windowBorderFragShaderSize,
+		.vertexBindingDescriptionCount = 0,
+		.vertexBindingDescriptions = NULL,
+		.vertexAttributeDescriptionCount = 0,
+		.VertexAttributeDescriptions = NULL,
+		.descriptorSetLayouts = &descriptorSetLayout,
+		.descriptorSetLayoutCount = 1,
+		.pushConstantRangeCount = 1,
+		.pushConstantRanges = &pushConstantRange,
+		.depthStencilState = depthStencilState,
+		.sampleCount = VK_SAMPLE_COUNT_1_BIT
+	};
+	bool pipelineCreateSuccessWindowDecoration = pipelineBuilderAddPipeline(pipelineBuilder, pipelineCreateInfoWindowDecoration, pipelineLayout, pipeline, false, error);
+#ifndef EMBED_SHADERS
+	free(windowBorderFragShaderBytes);
+	free(windowBorderVertShaderBytes);
+#endif /* EMBED_SHADERS */
+	if (!pipelineCreateSuccessWindowDecoration) {
+		return false;
+	}
+
+	return true;
+}
+#endif /* DRAW_WINDOW_BORDER */
+
 static bool createDepthBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator allocator, VkExtent2D extent, VkSampleCountFlagBits sampleCount, VkImage *image, VmaAllocation *imageAllocation, VkFormat *format, VkImageView *imageView, char **error)
 {
 	VkFormat formats[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT};
@@ -544,7 +799,7 @@ static bool createDepthBuffer(VkPhysicalDevice physicalDevice, VkDevice device,
 		return false;
 	}
 
-	if (!createImage(device, allocator, extent, *format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 1, sampleCount, image, imageAllocation, error)) {
+	if (!createImage(device, allocator, extent, *format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 1, sampleCount, image, imageAllocation, error)) {
 		return false;
 	}
 
@@ -561,7 +816,7 @@ static void destroyDepthBuffer(VkDevice device, VmaAllocator allocator, VkImage
 	destroyImage(allocator, image, imageAllocation);
 }
 
-static void cleanupVulkan(VkInstance instance, VkDebugReportCallbackEXT debugCallback, VkSurfaceKHR surface, PhysicalDeviceCharacteristics *physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics *surfaceCharacteristics, VkDevice device, VmaAllocator allocator, VkSwapchainKHR swapchain, VkImage *offscreenImages, VmaAllocation *offscreenImageAllocations, size_t offscreenImageCount, VkImageView *offscreenImageViews, VkImageView *imageViews, uint32_t imageViewCount, VkRenderPass renderPass, VkPipelineLayout *pipelineLayouts, VkPipeline *pipelines, size_t pipelineCount, VkFramebuffer *framebuffers, uint32_t framebufferCount, VkCommandPool commandPool, VkCommandBuffer *commandBuffers, uint32_t commandBufferCount, VkDescriptorPool descriptorPool, VkDescriptorSet *imageDescriptorSets, VkDescriptorSetLayout *imageDescriptorSetLayouts, ChessBoard chessBoard, Titlebar titlebar, VkImage depthImage, VmaAllocation depthImageAllocation, VkImageView depthImageView, VkImage multisampleImage, VkImageView multisampleImageView, VmaAllocation multisampleImageAllocation, SwapchainCreateInfo swapchainCreateInfo, VkDescriptorPool imDescriptorPool)
+static void cleanupVulkan(VkInstance instance, VkDebugReportCallbackEXT debugCallback, VkSurfaceKHR surface, PhysicalDeviceCharacteristics *physicalDeviceCharacteristics, PhysicalDeviceSurfaceCharacteristics *surfaceCharacteristics, VkDevice device, VmaAllocator allocator, VkSwapchainKHR swapchain, VkImage *offscreenImages, VmaAllocation *offscreenImageAllocations, size_t offscreenImageCount, VkImageView *offscreenImageViews, VkImageView *imageViews, uint32_t imageViewCount, VkRenderPass renderPass, VkPipelineCache pipelineCache, VkPipelineLayout *pipelineLayouts, VkPipeline *pipelines, size_t pipelineCount, VkFramebuffer *framebuffers, uint32_t framebufferCount, VkCommandPool commandPool, VkCommandBuffer *commandBuffers, uint32_t commandBufferCount, VkDescriptorPool descriptorPool, VkDescriptorSet *imageDescriptorSets, VkDescriptorSetLayout *imageDescriptorSetLayouts, UploadManager uploadManager, UniformRing uniformRing, BufferArena bufferArena, FrameTimer frameTimer, MsaaController msaaController, ResolutionController resolutionController, ChessBoard chessBoard, Titlebar titlebar, Upscaler upscaler, VkImage depthImage, VmaAllocation depthImageAllocation, VkImageView depthImageView, VkImage multisampleImage, VkImageView multisampleImageView, VmaAllocation multisampleImageAllocation, SwapchainCreateInfo swapchainCreateInfo, VkDescriptorPool imDescriptorPool)
 {
 #ifdef ENABLE_IMGUI
 	cImGui_ImplVulkan_Shutdown();
@@ -569,12 +824,20 @@ static void cleanupVulkan(VkInstance instance, VkDebugReportCallbackEXT debugCal
 #endif /* ENABLE_IMGUI */
 	destroyChessBoard(chessBoard);
 	destroyTitlebar(titlebar);
+	destroyUpscaler(upscaler);
+	destroyBufferArena(bufferArena);
+	destroyUniformRing(uniformRing);
+	destroyUploadManager(uploadManager);
+	destroyFrameTimer(frameTimer);
+	destroyMsaaController(msaaController);
+	destroyResolutionController(resolutionController);
 	freeCommandBuffers(device, commandPool, commandBuffers, commandBufferCount);
 	destroyCommandPool(device, commandPool);
 	for (size_t i = 0; i < pipelineCount; ++i) {
 		destroyPipeline(device, pipelines[i]);
 		destroyPipelineLayout(device, pipelineLayouts[i]);
 	}
+	destroyPipelineCache(device, pipelineCache);
 	destroyAppSwapchain(swapchainCreateInfo);
 	destroySwapchain(device, swapchain);
 	freePhysicalDeviceCharacteristics(physicalDeviceCharacteristics);
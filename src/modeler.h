@@ -17,6 +17,7 @@ struct threadArguments {
 	void *platformWindow;
 	Queue *inputQueue;
 	char *resourcePath;
+	char *cachePath; /* Writable; holds the pipeline cache */
 	const char **instanceExtensions;
 	size_t instanceExtensionCount;
 	WindowDimensions windowDimensions;
@@ -24,7 +25,7 @@ struct threadArguments {
 };
 
 void *threadProc(void *arg);
-bool recreateSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResized, char **error);
+bool recreateSwapchain(SwapchainCreateInfo swapchainCreateInfo, bool windowResized, VkSampleCountFlagBits sampleCount, char **error);
 void sendCloseSignal(void *platformWindow);
 void sendMaximizeSignal(void *platformWindow);
 void sendMinimizeSignal(void *platformWindow);
@@ -21,6 +21,7 @@ pthread_t initVulkanAndroid(struct ANativeWindow *nativeWindow, struct ANativeAc
 	threadArgs->platformWindow = window;
 	threadArgs->inputQueue = inputQueue;
 	asprintf(&threadArgs->resourcePath, ".");
+	asprintf(&threadArgs->cachePath, "%s", nativeActivity->internalDataPath);
 	char *instanceExtensions[] = {
 		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
 		VK_KHR_SURFACE_EXTENSION_NAME,
@@ -59,6 +60,7 @@ pthread_t initVulkanAndroid(struct ANativeWindow *nativeWindow, struct ANativeAc
 
 	if (pthread_create(&thread, NULL, threadProc, (void *) threadArgs) != 0) {
 		free(threadArgs->resourcePath);
+		free(threadArgs->cachePath);
 		free(threadArgs);
 		asprintf(error, "Failed to start Vulkan thread");
 		return 0;
@@ -23,6 +23,17 @@ pthread_t initVulkanMetal(void *surfaceLayer, int width, int height, float scale
 	window->surfaceLayer = surfaceLayer;
 	threadArgs->platformWindow = window;
 	asprintf(&threadArgs->resourcePath, "%s", resourcePath);
+	/*
+	 * The bundle isn't writable. TMPDIR is the app's own container on iOS,
+	 * but is shared by every process of the user on macOS, so keep to a
+	 * subdirectory of our own.
+	 */
+	const char *temporaryPath = getenv("TMPDIR");
+	if (temporaryPath && *temporaryPath) {
+		asprintf(&threadArgs->cachePath, "%s/modeler", temporaryPath);
+	} else {
+		asprintf(&threadArgs->cachePath, ".");
+	}
 	threadArgs->inputQueue = inputQueue;
 	char *instanceExtensions[] = {
 		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
@@ -58,6 +69,7 @@ pthread_t initVulkanMetal(void *surfaceLayer, int width, int height, float scale
 
 	if (pthread_create(&thread, NULL, threadProc, (void *) threadArgs) != 0) {
 		free(threadArgs->resourcePath);
+		free(threadArgs->cachePath);
 		free(threadArgs);
 		asprintf(error, "Failed to start Vulkan thread");
 		return 0;
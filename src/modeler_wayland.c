@@ -26,6 +26,16 @@ pthread_t initVulkanWayland(struct wl_display *waylandDisplay, struct wl_surface
 	threadArgs->platformWindow = window;
 	threadArgs->inputQueue = inputQueue;
 	asprintf(&threadArgs->resourcePath, ".");
+	/* The cache directory is shared between applications, so keep to a subdirectory of our own */
+	const char *xdgCacheHome = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	if (xdgCacheHome && *xdgCacheHome) {
+		asprintf(&threadArgs->cachePath, "%s/modeler", xdgCacheHome);
+	} else if (home && *home) {
+		asprintf(&threadArgs->cachePath, "%s/.cache/modeler", home);
+	} else {
+		asprintf(&threadArgs->cachePath, ".");
+	}
 	char *instanceExtensions[] = {
 		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
 		VK_KHR_SURFACE_EXTENSION_NAME,
@@ -46,6 +56,7 @@ pthread_t initVulkanWayland(struct wl_display *waylandDisplay, struct wl_surface
 
 	if (pthread_create(&thread, NULL, threadProc, (void *) threadArgs) != 0) {
 		free(threadArgs->resourcePath);
+		free(threadArgs->cachePath);
 		free(threadArgs);
 		asprintf(error, "Failed to start Vulkan thread");
 		return 0;
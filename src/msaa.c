@@ -0,0 +1,104 @@
+#include <stdlib.h>
+
+#include "msaa.h"
+
+#include "frame_timer.h"
+#include "physical_device.h"
+
+/* The automatic mode raises the sample count when a frame takes less than this much of the budget */
+#define MSAA_HEADROOM_FRACTION 0.4
+
+/*
+ * Chooses the sample count for the colour and depth attachments. Once
+ * MSAA_FRAME_WINDOW frames have been timed at the current count, the
+ * automatic mode halves it if they averaged over budget or doubles it if
+ * there was enough headroom that twice the samples should still fit.
+ */
+struct msaa_controller_t {
+	VkPhysicalDeviceProperties deviceProperties;
+	MsaaMode mode;
+	VkSampleCountFlagBits sampleCount;
+	double elapsedNanoseconds;
+	uint32_t elapsedFrameCount;
+};
+
+static void resetTiming(MsaaController self);
+
+bool createMsaaController(MsaaController *msaaController, VkPhysicalDeviceProperties deviceProperties, MsaaMode mode, char **error)
+{
+	*msaaController = malloc(sizeof(**msaaController));
+
+	MsaaController self = *msaaController;
+
+	self->deviceProperties = deviceProperties;
+	msaaControllerSetMode(self, mode);
+
+	return true;
+}
+
+void msaaControllerSetMode(MsaaController self, MsaaMode mode)
+{
+	self->mode = mode;
+
+	switch (mode) {
+	case MSAA_MODE_1X:
+		self->sampleCount = VK_SAMPLE_COUNT_1_BIT;
+		break;
+	case MSAA_MODE_2X:
+		self->sampleCount = getSupportedSampleCount(self->deviceProperties, VK_SAMPLE_COUNT_2_BIT);
+		break;
+	case MSAA_MODE_4X: case MSAA_MODE_AUTO:
+		self->sampleCount = getSupportedSampleCount(self->deviceProperties, VK_SAMPLE_COUNT_4_BIT);
+		break;
+	case MSAA_MODE_MAX:
+		self->sampleCount = getMaxSampleCount(self->deviceProperties);
+		break;
+	}
+
+	resetTiming(self);
+}
+
+MsaaMode msaaControllerGetMode(MsaaController self)
+{
+	return self->mode;
+}
+
+VkSampleCountFlagBits msaaControllerGetSampleCount(MsaaController self)
+{
+	return self->sampleCount;
+}
+
+static void resetTiming(MsaaController self)
+{
+	self->elapsedNanoseconds = 0.0;
+	self->elapsedFrameCount = 0;
+}
+
+/*
+ * With the GPU time of each frame as frameTimerRead returns it. allowFewer
+ * and allowMore say whether the count may go down or up this frame, so
+ * another setting can be given up before it.
+ */
+void msaaControllerUpdate(MsaaController self, double frameNanoseconds, bool allowFewer, bool allowMore)
+{
+	self->elapsedNanoseconds += frameNanoseconds;
+	++self->elapsedFrameCount;
+
+	if (self->mode != MSAA_MODE_AUTO || self->elapsedFrameCount < MSAA_FRAME_WINDOW) {
+		return;
+	}
+
+	double average = self->elapsedNanoseconds / self->elapsedFrameCount;
+	resetTiming(self);
+	if (average > FRAME_BUDGET_NANOSECONDS && allowFewer && self->sampleCount > VK_SAMPLE_COUNT_1_BIT) {
+		self->sampleCount = getSupportedSampleCount(self->deviceProperties, (VkSampleCountFlagBits) (self->sampleCount >> 1));
+	} else if (average < FRAME_BUDGET_NANOSECONDS * MSAA_HEADROOM_FRACTION && allowMore && self->sampleCount < getMaxSampleCount(self->deviceProperties)) {
+		/* Rounding down can't go below the current count, as it's supported */
+		self->sampleCount = getSupportedSampleCount(self->deviceProperties, (VkSampleCountFlagBits) (self->sampleCount << 1));
+	}
+}
+
+void destroyMsaaController(MsaaController self)
+{
+	free(self);
+}
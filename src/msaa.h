@@ -0,0 +1,27 @@
+#ifndef MODELER_MSAA_H
+#define MODELER_MSAA_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+/* Frames averaged before the automatic mode reconsiders the sample count */
+#define MSAA_FRAME_WINDOW 60
+
+typedef enum msaa_mode_t {
+	MSAA_MODE_1X,
+	MSAA_MODE_2X,
+	MSAA_MODE_4X,
+	MSAA_MODE_MAX,
+	MSAA_MODE_AUTO
+} MsaaMode;
+
+typedef struct msaa_controller_t *MsaaController;
+
+bool createMsaaController(MsaaController *msaaController, VkPhysicalDeviceProperties deviceProperties, MsaaMode mode, char **error);
+void msaaControllerSetMode(MsaaController self, MsaaMode mode);
+MsaaMode msaaControllerGetMode(MsaaController self);
+VkSampleCountFlagBits msaaControllerGetSampleCount(MsaaController self);
+void msaaControllerUpdate(MsaaController self, double frameNanoseconds, bool allowFewer, bool allowMore);
+void destroyMsaaController(MsaaController self);
+
+#endif /* MODELER_MSAA_H */
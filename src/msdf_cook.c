@@ -0,0 +1,1286 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "texture_write.h"
+
+/*
+ * Build-time tool that turns the piece sprites in an SVG into a distance
+ * field atlas in the cooked format described in texture.h:
+ *
+ * 	msdf_cook input.svg size levels output.ktx2
+ *
+ * As with the PNG atlas, the sprites are the height-by-height square on the
+ * left of the SVG. RGB is a multi-channel signed distance field of
+ * everything drawn there, which keeps corners sharp, and A is a plain signed
+ * distance field of the parts painted black. Every level is computed from
+ * the outlines rather than filtered from the one above.
+ *
+ * Only what pieces.svg uses is understood: groups, paths and circles, the
+ * fill, stroke, fill-rule and stroke-linecap styles, and matrix, scale and
+ * translate transforms. Stroke joins are always round.
+ */
+
+/* Fraction of the atlas either side of an edge that the fields span; chess_board.frag has the same */
+#define DISTANCE_RANGE (1.0 / 64.0)
+
+/* Longest chord, in SVG units, that curves are flattened to */
+#define FLATTEN_STEP 1.0
+
+/* Outline joins sharper than this many radians from straight get a color change */
+#define CORNER_ANGLE 0.14
+
+/* Interpolated fields are checked for clashes at this many points across and down each texel */
+#define CLASH_SAMPLES 3
+
+/* Fraction of a texel from an edge within which the interpolated field is allowed to be wrong */
+#define CLASH_TOLERANCE 0.25
+
+/* Contours enclosing less than this many square SVG units are taken to be lines */
+#define MIN_FILL_AREA 1.0
+
+#define MAX_GROUP_DEPTH 16
+
+typedef enum paint_t {
+	PAINT_NONE,
+	PAINT_BLACK,
+	PAINT_WHITE,
+	PAINT_OTHER
+} Paint;
+
+typedef struct style_t {
+	Paint fill;
+	bool evenOdd;
+	Paint stroke;
+	double strokeWidth;
+	bool buttCap;
+} Style;
+
+typedef struct point_t {
+	double x;
+	double y;
+} Point;
+
+/* A flattened subpath; segment i runs from point i to the next, with the closing segment last */
+typedef struct contour_t {
+	Point *points;
+	bool *corners;
+	size_t pointCount;
+	size_t pointCapacity;
+	bool closed;
+	uint8_t *colors; /* Channel mask per segment */
+	bool *edgeStarts; /* Whether the color changes at each point */
+	double sign; /* 1 if the fill is to the left of each segment, otherwise -1 */
+	bool filled; /* Lines that enclose nothing are only ever stroked */
+} Contour;
+
+typedef struct shape_t {
+	Contour *contours;
+	size_t contourCount;
+	Paint fill;
+	bool evenOdd;
+	Paint stroke;
+	double strokeWidth;
+	bool buttCap;
+	double min[2];
+	double max[2];
+} Shape;
+
+typedef struct path_builder_t {
+	double transform[6];
+	Shape *shape;
+	Point current;
+	Point start;
+	Point control; /* Last control point, for the smooth curve commands */
+	Point lastTangent;
+	Point firstTangent;
+	bool hasTangent;
+} PathBuilder;
+
+/* What one texel's fields come to, before they're normalized */
+typedef struct texel_t {
+	double coverage[3];
+	double trueCoverage;
+	double ink;
+} Texel;
+
+static char *readSvg(const char *path);
+static bool parseSvg(const char *svg, Shape **shapes, size_t *shapeCount);
+static const char *parseAttribute(const char *cursor, char *name, size_t nameSize, const char **value, size_t *valueLength);
+static void parseStyle(const char *value, size_t length, Style *style);
+static Paint parsePaint(const char *value, size_t length);
+static void parseTransform(const char *value, size_t length, double transform[6]);
+static void multiplyTransforms(const double a[6], const double b[6], double result[6]);
+static Point transformPoint(const double transform[6], Point point);
+static Point transformVector(const double transform[6], Point vector);
+static double transformScale(const double transform[6]);
+static void parsePathData(PathBuilder *builder, const char *data, size_t length);
+static void addCircle(PathBuilder *builder, double cx, double cy, double r);
+static void beginContour(PathBuilder *builder, Point point);
+static void closeContour(PathBuilder *builder);
+static void lineTo(PathBuilder *builder, Point point);
+static void cubicTo(PathBuilder *builder, Point control1, Point control2, Point point);
+static void arcTo(PathBuilder *builder, double rx, double ry, double rotation, bool largeArc, bool sweep, Point point);
+static void beginSegment(PathBuilder *builder, Point tangent);
+static void appendPoint(Contour *contour, Point point);
+static void finishShape(Shape *shape);
+static void colorEdges(Contour *contour);
+static bool isInside(const Shape *shape, Point point);
+static void evaluateTexel(const Shape *shapes, size_t shapeCount, Point point, double range, Texel *texel);
+static void evaluateShape(const Shape *shape, Point point, double range, double coverage[3], double *trueCoverage, double *stroke);
+static void correctTexels(Texel *texels, uint32_t size, const Shape *shapes, size_t shapeCount, double spacing, double range);
+static double median(double a, double b, double c);
+static double cross(Point a, Point b);
+static double dot(Point a, Point b);
+static Point subtract(Point a, Point b);
+static double length(Point a);
+static uint8_t normalizeDistance(double distance, double range);
+
+int main(int argc, char **argv)
+{
+	if (argc != 5) {
+		fprintf(stderr, "usage: %s input.svg size levels output.ktx2\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t size = strtoul(argv[2], NULL, 10);
+	uint32_t levelCount = strtoul(argv[3], NULL, 10);
+	if (levelCount < 1 || levelCount > TEXTURE_MAX_LEVELS || (size >> (levelCount - 1)) < 1 || size % (1 << (levelCount - 1)) != 0) {
+		fprintf(stderr, "%u levels don't fit a %u texel atlas\n", levelCount, size);
+		return EXIT_FAILURE;
+	}
+
+	char *svg;
+	if (!(svg = readSvg(argv[1]))) {
+		fprintf(stderr, "Failed to read %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	Shape *shapes;
+	size_t shapeCount;
+	double height;
+	const char *heightAttribute = strstr(svg, "height=\"");
+	if (!heightAttribute || (height = strtod(heightAttribute + strlen("height=\""), NULL)) <= 0.0 || !parseSvg(svg, &shapes, &shapeCount)) {
+		fprintf(stderr, "Failed to parse %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	free(svg);
+
+	/* Drop what lies right of the sprites, like the pre-rendered mips */
+	size_t spriteCount = 0;
+	for (size_t i = 0; i < shapeCount; ++i) {
+		if (shapes[i].min[0] < height - 0.5) {
+			shapes[spriteCount++] = shapes[i];
+		}
+	}
+
+	double range = DISTANCE_RANGE * height;
+	uint8_t *levels[TEXTURE_MAX_LEVELS];
+	size_t levelSizes[TEXTURE_MAX_LEVELS];
+	for (uint32_t level = 0; level < levelCount; ++level) {
+		uint32_t levelSize = size >> level;
+		double spacing = height / levelSize;
+		Texel *texels = malloc(sizeof(*texels) * levelSize * levelSize);
+		for (uint32_t y = 0; y < levelSize; ++y) {
+			for (uint32_t x = 0; x < levelSize; ++x) {
+				Point point = {(x + 0.5) * spacing, (y + 0.5) * spacing};
+				evaluateTexel(shapes, spriteCount, point, range, texels + (size_t) y * levelSize + x);
+			}
+		}
+		correctTexels(texels, levelSize, shapes, spriteCount, spacing, range);
+
+		levelSizes[level] = (size_t) levelSize * levelSize * TEXTURE_MSDF_TEXEL_SIZE;
+		levels[level] = malloc(levelSizes[level]);
+		for (size_t i = 0; i < (size_t) levelSize * levelSize; ++i) {
+			for (size_t c = 0; c < 3; ++c) {
+				levels[level][i * 4 + c] = normalizeDistance(texels[i].coverage[c], range);
+			}
+			levels[level][i * 4 + 3] = normalizeDistance(texels[i].ink, range);
+		}
+		free(texels);
+	}
+
+	bool written = writeTexture(argv[4], TEXTURE_ENCODING_MSDF, size, size, levelCount, levels, levelSizes);
+	for (uint32_t level = 0; level < levelCount; ++level) {
+		free(levels[level]);
+	}
+	if (!written) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static char *readSvg(const char *path)
+{
+	FILE *fp;
+	if (!(fp = fopen(path, "rb"))) {
+		return NULL;
+	}
+
+	char *svg = NULL;
+	size_t size = 0;
+	size_t capacity = 0;
+	size_t read;
+	do {
+		if (capacity - size < 4096) {
+			capacity = capacity ? capacity * 2 : 65536;
+			svg = realloc(svg, capacity);
+		}
+		read = fread(svg + size, 1, capacity - size - 1, fp);
+		size += read;
+	} while (read > 0);
+	bool failed = ferror(fp);
+	fclose(fp);
+	if (failed) {
+		free(svg);
+		return NULL;
+	}
+	svg[size] = '\0';
+
+	return svg;
+}
+
+/* Shapes come out in paint order, each path or circle with its group's style and transform applied */
+static bool parseSvg(const char *svg, Shape **shapes, size_t *shapeCount)
+{
+	Style styles[MAX_GROUP_DEPTH + 1] = {
+		{
+			.fill = PAINT_BLACK,
+			.evenOdd = false,
+			.stroke = PAINT_NONE,
+			.strokeWidth = 1.0,
+			.buttCap = true
+		}
+	};
+	double transforms[MAX_GROUP_DEPTH + 1][6] = {
+		{1.0, 0.0, 0.0, 1.0, 0.0, 0.0}
+	};
+	size_t depth = 0;
+	size_t shapeCapacity = 0;
+	*shapes = NULL;
+	*shapeCount = 0;
+
+	for (const char *cursor = strchr(svg, '<'); cursor; cursor = strchr(cursor, '<')) {
+		++cursor;
+		if (strncmp(cursor, "!--", 3) == 0) {
+			const char *end = strstr(cursor, "-->");
+			if (!end) {
+				return false;
+			}
+			cursor = end + 3;
+			continue;
+		}
+		if (*cursor == '/') {
+			if (strncmp(cursor, "/g>", 3) == 0) {
+				if (depth == 0) {
+					return false;
+				}
+				--depth;
+			}
+			continue;
+		}
+
+		size_t nameLength = strcspn(cursor, " \t\r\n/>");
+		bool isGroup = nameLength == 1 && strncmp(cursor, "g", 1) == 0;
+		bool isPath = nameLength == 4 && strncmp(cursor, "path", 4) == 0;
+		bool isCircle = nameLength == 6 && strncmp(cursor, "circle", 6) == 0;
+		cursor += nameLength;
+		if (!isGroup && !isPath && !isCircle) {
+			continue;
+		}
+
+		Style style = styles[depth];
+		double transform[6];
+		memcpy(transform, transforms[depth], sizeof(transform));
+		const char *pathData = NULL;
+		size_t pathDataLength = 0;
+		double circle[3] = {};
+
+		char name[32];
+		const char *value;
+		size_t valueLength;
+		while ((cursor = parseAttribute(cursor, name, sizeof(name), &value, &valueLength))) {
+			if (strcmp(name, "style") == 0) {
+				parseStyle(value, valueLength, &style);
+			} else if (strcmp(name, "transform") == 0) {
+				double local[6];
+				parseTransform(value, valueLength, local);
+				double parent[6];
+				memcpy(parent, transform, sizeof(parent));
+				multiplyTransforms(parent, local, transform);
+			} else if (strcmp(name, "d") == 0) {
+				pathData = value;
+				pathDataLength = valueLength;
+			} else if (strcmp(name, "cx") == 0) {
+				circle[0] = strtod(value, NULL);
+			} else if (strcmp(name, "cy") == 0) {
+				circle[1] = strtod(value, NULL);
+			} else if (strcmp(name, "r") == 0) {
+				circle[2] = strtod(value, NULL);
+			}
+		}
+		if (!(cursor = strchr(value ? value : svg, '>'))) {
+			return false;
+		}
+		bool selfClosing = cursor[-1] == '/';
+
+		if (isGroup) {
+			if (!selfClosing) {
+				if (depth == MAX_GROUP_DEPTH) {
+					return false;
+				}
+				++depth;
+				styles[depth] = style;
+				memcpy(transforms[depth], transform, sizeof(transform));
+			}
+			continue;
+		}
+
+		if (style.fill == PAINT_NONE && style.stroke == PAINT_NONE) {
+			continue;
+		}
+		if (*shapeCount == shapeCapacity) {
+			shapeCapacity = shapeCapacity ? shapeCapacity * 2 : 64;
+			*shapes = realloc(*shapes, sizeof(**shapes) * shapeCapacity);
+		}
+		Shape *shape = *shapes + (*shapeCount)++;
+		*shape = (Shape) {
+			.contours = NULL,
+			.contourCount = 0,
+			.fill = style.fill,
+			.evenOdd = style.evenOdd,
+			.stroke = style.stroke,
+			.strokeWidth = style.strokeWidth * transformScale(transform),
+			.buttCap = style.buttCap
+		};
+
+		PathBuilder builder = {
+			.shape = shape,
+			.hasTangent = false
+		};
+		memcpy(builder.transform, transform, sizeof(transform));
+		if (isPath && pathData) {
+			parsePathData(&builder, pathData, pathDataLength);
+		} else if (isCircle) {
+			addCircle(&builder, circle[0], circle[1], circle[2]);
+		}
+		finishShape(shape);
+	}
+
+	return depth == 0;
+}
+
+/* Returns NULL at the end of the tag, leaving value pointing into it */
+static const char *parseAttribute(const char *cursor, char *name, size_t nameSize, const char **value, size_t *valueLength)
+{
+	cursor += strspn(cursor, " \t\r\n");
+	if (*cursor == '>' || *cursor == '/' || *cursor == '\0') {
+		*value = cursor;
+		return NULL;
+	}
+
+	size_t nameLength = strcspn(cursor, "= \t\r\n>");
+	snprintf(name, nameSize, "%.*s", (int) nameLength, cursor);
+	cursor += nameLength;
+	cursor += strspn(cursor, " \t\r\n");
+	if (*cursor != '=') {
+		*value = cursor;
+		*valueLength = 0;
+		return cursor;
+	}
+	++cursor;
+	cursor += strspn(cursor, " \t\r\n");
+
+	char quote = *cursor;
+	if (quote != '"' && quote != '\'') {
+		*value = cursor;
+		return NULL;
+	}
+	*value = cursor + 1;
+	const char *end = strchr(*value, quote);
+	if (!end) {
+		return NULL;
+	}
+	*valueLength = end - *value;
+
+	return end + 1;
+}
+
+static void parseStyle(const char *value, size_t length, Style *style)
+{
+	const char *end = value + length;
+	while (value < end) {
+		const char *declarationEnd = memchr(value, ';', end - value);
+		if (!declarationEnd) {
+			declarationEnd = end;
+		}
+		const char *colon = memchr(value, ':', declarationEnd - value);
+		if (colon) {
+			size_t nameLength = colon - value;
+			const char *property = colon + 1;
+			size_t propertyLength = declarationEnd - property;
+			if (nameLength == 4 && strncmp(value, "fill", 4) == 0) {
+				style->fill = parsePaint(property, propertyLength);
+			} else if (nameLength == 6 && strncmp(value, "stroke", 6) == 0) {
+				style->stroke = parsePaint(property, propertyLength);
+			} else if (nameLength == 9 && strncmp(value, "fill-rule", 9) == 0) {
+				style->evenOdd = propertyLength == 7 && strncmp(property, "evenodd", 7) == 0;
+			} else if (nameLength == 12 && strncmp(value, "stroke-width", 12) == 0) {
+				style->strokeWidth = strtod(property, NULL);
+			} else if (nameLength == 14 && strncmp(value, "stroke-linecap", 14) == 0) {
+				style->buttCap = propertyLength == 4 && strncmp(property, "butt", 4) == 0;
+			}
+		}
+		value = declarationEnd + 1;
+	}
+}
+
+/* Black and white are told apart for the ink field; other colors are the shader's to choose */
+static Paint parsePaint(const char *value, size_t length)
+{
+	if (length == 4 && strncmp(value, "none", 4) == 0) {
+		return PAINT_NONE;
+	}
+	if ((length == 7 && strncmp(value, "#000000", 7) == 0) || (length == 4 && strncmp(value, "#000", 4) == 0)) {
+		return PAINT_BLACK;
+	}
+	if ((length == 7 && strncmp(value, "#ffffff", 7) == 0) || (length == 4 && strncmp(value, "#fff", 4) == 0)) {
+		return PAINT_WHITE;
+	}
+
+	return PAINT_OTHER;
+}
+
+/* SVG's a, b, c, d, e, f order: x' = a x + c y + e, y' = b x + d y + f */
+static void parseTransform(const char *value, size_t length, double transform[6])
+{
+	double identity[6] = {1.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+	memcpy(transform, identity, sizeof(identity));
+
+	const char *end = value + length;
+	while (value < end) {
+		const char *open = memchr(value, '(', end - value);
+		if (!open) {
+			break;
+		}
+		const char *name = value + strspn(value, " \t\r\n,");
+		size_t nameLength = open - name;
+
+		double arguments[6] = {};
+		size_t argumentCount = 0;
+		const char *cursor = open + 1;
+		while (argumentCount < 6) {
+			cursor += strspn(cursor, " \t\r\n,");
+			char *argumentEnd;
+			double argument = strtod(cursor, &argumentEnd);
+			if (argumentEnd == cursor) {
+				break;
+			}
+			arguments[argumentCount++] = argument;
+			cursor = argumentEnd;
+		}
+
+		double local[6];
+		memcpy(local, identity, sizeof(identity));
+		if (nameLength == 6 && strncmp(name, "matrix", 6) == 0 && argumentCount == 6) {
+			memcpy(local, arguments, sizeof(local));
+		} else if (nameLength == 5 && strncmp(name, "scale", 5) == 0 && argumentCount >= 1) {
+			local[0] = arguments[0];
+			local[3] = argumentCount > 1 ? arguments[1] : arguments[0];
+		} else if (nameLength == 9 && strncmp(name, "translate", 9) == 0 && argumentCount >= 1) {
+			local[4] = arguments[0];
+			local[5] = arguments[1];
+		}
+
+		double outer[6];
+		memcpy(outer, transform, sizeof(outer));
+		multiplyTransforms(outer, local, transform);
+
+		const char *close = memchr(open, ')', end - open);
+		if (!close) {
+			break;
+		}
+		value = close + 1;
+	}
+}
+
+/* a applied after b */
+static void multiplyTransforms(const double a[6], const double b[6], double result[6])
+{
+	result[0] = a[0] * b[0] + a[2] * b[1];
+	result[1] = a[1] * b[0] + a[3] * b[1];
+	result[2] = a[0] * b[2] + a[2] * b[3];
+	result[3] = a[1] * b[2] + a[3] * b[3];
+	result[4] = a[0] * b[4] + a[2] * b[5] + a[4];
+	result[5] = a[1] * b[4] + a[3] * b[5] + a[5];
+}
+
+static Point transformPoint(const double transform[6], Point point)
+{
+	return (Point) {
+		transform[0] * point.x + transform[2] * point.y + transform[4],
+		transform[1] * point.x + transform[3] * point.y + transform[5]
+	};
+}
+
+static Point transformVector(const double transform[6], Point vector)
+{
+	return (Point) {
+		transform[0] * vector.x + transform[2] * vector.y,
+		transform[1] * vector.x + transform[3] * vector.y
+	};
+}
+
+/* Strokes are scaled by the geometric mean, which is exact for the uniform scales pieces.svg uses */
+static double transformScale(const double transform[6])
+{
+	return sqrt(fabs(transform[0] * transform[3] - transform[1] * transform[2]));
+}
+
+static void parsePathData(PathBuilder *builder, const char *data, size_t length)
+{
+	const char *end = data + length;
+	const char *cursor = data;
+	char command = 0;
+	char previousCommand = 0;
+
+	while (cursor < end) {
+		cursor += strspn(cursor, " \t\r\n,");
+		if (cursor >= end) {
+			break;
+		}
+		if (strchr("MmLlHhVvCcSsQqTtAaZz", *cursor)) {
+			command = *cursor++;
+		} else if (command == 'M') {
+			/* Coordinates after a move are implicit lines */
+			command = 'L';
+		} else if (command == 'm') {
+			command = 'l';
+		} else if (!command) {
+			return;
+		}
+
+		bool relative = command >= 'a';
+		Point origin = relative ? builder->current : (Point) {0.0, 0.0};
+		double arguments[7];
+		size_t argumentCount;
+		switch (command) {
+		case 'Z':
+		case 'z':
+			argumentCount = 0;
+			break;
+		case 'H':
+		case 'h':
+		case 'V':
+		case 'v':
+			argumentCount = 1;
+			break;
+		case 'M':
+		case 'm':
+		case 'L':
+		case 'l':
+		case 'T':
+		case 't':
+			argumentCount = 2;
+			break;
+		case 'S':
+		case 's':
+		case 'Q':
+		case 'q':
+			argumentCount = 4;
+			break;
+		case 'C':
+		case 'c':
+			argumentCount = 6;
+			break;
+		default:
+			argumentCount = 7;
+			break;
+		}
+		for (size_t i = 0; i < argumentCount; ++i) {
+			cursor += strspn(cursor, " \t\r\n,");
+			char *argumentEnd;
+			arguments[i] = strtod(cursor, &argumentEnd);
+			if (argumentEnd == cursor) {
+				return;
+			}
+			cursor = argumentEnd;
+		}
+
+		Point control = builder->current;
+		switch (command) {
+		case 'M':
+		case 'm':
+			beginContour(builder, (Point) {origin.x + arguments[0], origin.y + arguments[1]});
+			break;
+		case 'L':
+		case 'l':
+			lineTo(builder, (Point) {origin.x + arguments[0], origin.y + arguments[1]});
+			break;
+		case 'H':
+		case 'h':
+			lineTo(builder, (Point) {origin.x + arguments[0], builder->current.y});
+			break;
+		case 'V':
+		case 'v':
+			lineTo(builder, (Point) {builder->current.x, origin.y + arguments[0]});
+			break;
+		case 'C':
+		case 'c':
+			control = (Point) {origin.x + arguments[2], origin.y + arguments[3]};
+			cubicTo(builder, (Point) {origin.x + arguments[0], origin.y + arguments[1]}, control, (Point) {origin.x + arguments[4], origin.y + arguments[5]});
+			break;
+		case 'S':
+		case 's': {
+			Point reflected = builder->current;
+			if (strchr("CcSs", previousCommand)) {
+				reflected = (Point) {2.0 * builder->current.x - builder->control.x, 2.0 * builder->current.y - builder->control.y};
+			}
+			control = (Point) {origin.x + arguments[0], origin.y + arguments[1]};
+			cubicTo(builder, reflected, control, (Point) {origin.x + arguments[2], origin.y + arguments[3]});
+			break;
+		}
+		case 'Q':
+		case 'q':
+		case 'T':
+		case 't': {
+			Point quadratic;
+			Point point;
+			if (command == 'Q' || command == 'q') {
+				quadratic = (Point) {origin.x + arguments[0], origin.y + arguments[1]};
+				point = (Point) {origin.x + arguments[2], origin.y + arguments[3]};
+			} else {
+				quadratic = builder->current;
+				if (strchr("QqTt", previousCommand)) {
+					quadratic = (Point) {2.0 * builder->current.x - builder->control.x, 2.0 * builder->current.y - builder->control.y};
+				}
+				point = (Point) {origin.x + arguments[0], origin.y + arguments[1]};
+			}
+			Point start = builder->current;
+			control = quadratic;
+			cubicTo(builder,
+				(Point) {start.x + 2.0 / 3.0 * (quadratic.x - start.x), start.y + 2.0 / 3.0 * (quadratic.y - start.y)},
+				(Point) {point.x + 2.0 / 3.0 * (quadratic.x - point.x), point.y + 2.0 / 3.0 * (quadratic.y - point.y)},
+				point);
+			break;
+		}
+		case 'A':
+		case 'a':
+			arcTo(builder, arguments[0], arguments[1], arguments[2], arguments[3] != 0.0, arguments[4] != 0.0, (Point) {origin.x + arguments[5], origin.y + arguments[6]});
+			break;
+		default:
+			closeContour(builder);
+			break;
+		}
+		builder->control = control;
+		previousCommand = command;
+	}
+}
+
+static void addCircle(PathBuilder *builder, double cx, double cy, double r)
+{
+	beginContour(builder, (Point) {cx + r, cy});
+	arcTo(builder, r, r, 0.0, false, true, (Point) {cx - r, cy});
+	arcTo(builder, r, r, 0.0, false, true, (Point) {cx + r, cy});
+	closeContour(builder);
+}
+
+static void beginContour(PathBuilder *builder, Point point)
+{
+	Shape *shape = builder->shape;
+	shape->contours = realloc(shape->contours, sizeof(*shape->contours) * (shape->contourCount + 1));
+	shape->contours[shape->contourCount++] = (Contour) {
+		.points = NULL,
+		.corners = NULL,
+		.pointCount = 0,
+		.pointCapacity = 0,
+		.closed = false,
+		.colors = NULL,
+		.edgeStarts = NULL,
+		.sign = 1.0,
+		.filled = false
+	};
+
+	builder->current = point;
+	builder->start = point;
+	builder->hasTangent = false;
+	appendPoint(shape->contours + shape->contourCount - 1, transformPoint(builder->transform, point));
+}
+
+/* A closing line if it's needed, then a corner check where the contour meets itself */
+static void closeContour(PathBuilder *builder)
+{
+	Shape *shape = builder->shape;
+	if (shape->contourCount == 0) {
+		return;
+	}
+	Contour *contour = shape->contours + shape->contourCount - 1;
+	if (contour->closed) {
+		return;
+	}
+
+	lineTo(builder, builder->start);
+	if (contour->pointCount > 1) {
+		Point first = contour->points[0];
+		Point last = contour->points[contour->pointCount - 1];
+		if (fabs(first.x - last.x) < 1e-9 && fabs(first.y - last.y) < 1e-9) {
+			--contour->pointCount;
+		}
+	}
+	contour->closed = true;
+
+	if (builder->hasTangent) {
+		Point a = builder->lastTangent;
+		Point b = builder->firstTangent;
+		double lengths = length(a) * length(b);
+		contour->corners[0] = lengths > 0.0 && (dot(a, b) <= 0.0 || fabs(cross(a, b)) / lengths > sin(CORNER_ANGLE));
+	}
+	builder->current = builder->start;
+}
+
+static void lineTo(PathBuilder *builder, Point point)
+{
+	if (point.x == builder->current.x && point.y == builder->current.y) {
+		return;
+	}
+
+	Point start = transformPoint(builder->transform, builder->current);
+	Point end = transformPoint(builder->transform, point);
+	beginSegment(builder, subtract(end, start));
+	appendPoint(builder->shape->contours + builder->shape->contourCount - 1, end);
+	builder->lastTangent = subtract(end, start);
+	builder->current = point;
+}
+
+static void cubicTo(PathBuilder *builder, Point control1, Point control2, Point point)
+{
+	Point p[4] = {
+		transformPoint(builder->transform, builder->current),
+		transformPoint(builder->transform, control1),
+		transformPoint(builder->transform, control2),
+		transformPoint(builder->transform, point)
+	};
+	double polygonLength = length(subtract(p[1], p[0])) + length(subtract(p[2], p[1])) + length(subtract(p[3], p[2]));
+	if (polygonLength == 0.0) {
+		return;
+	}
+
+	/* End tangents fall back to the next control point when one coincides with its end */
+	Point startTangent = subtract(p[1], p[0]);
+	if (length(startTangent) == 0.0) {
+		startTangent = subtract(p[2], p[0]);
+	}
+	Point endTangent = subtract(p[3], p[2]);
+	if (length(endTangent) == 0.0) {
+		endTangent = subtract(p[3], p[1]);
+	}
+
+	beginSegment(builder, startTangent);
+	Contour *contour = builder->shape->contours + builder->shape->contourCount - 1;
+	size_t steps = (size_t) ceil(polygonLength / FLATTEN_STEP);
+	for (size_t i = 1; i <= steps; ++i) {
+		double t = (double) i / steps;
+		double s = 1.0 - t;
+		appendPoint(contour, (Point) {
+			s * s * s * p[0].x + 3.0 * s * s * t * p[1].x + 3.0 * s * t * t * p[2].x + t * t * t * p[3].x,
+			s * s * s * p[0].y + 3.0 * s * s * t * p[1].y + 3.0 * s * t * t * p[2].y + t * t * t * p[3].y
+		});
+	}
+	builder->lastTangent = endTangent;
+	builder->current = point;
+}
+
+/* Converted to center form as in the SVG implementation notes, then flattened in local space */
+static void arcTo(PathBuilder *builder, double rx, double ry, double rotation, bool largeArc, bool sweep, Point point)
+{
+	Point start = builder->current;
+	rx = fabs(rx);
+	ry = fabs(ry);
+	if (rx == 0.0 || ry == 0.0) {
+		lineTo(builder, point);
+		return;
+	}
+	if (point.x == start.x && point.y == start.y) {
+		return;
+	}
+
+	double phi = rotation * M_PI / 180.0;
+	double cosPhi = cos(phi);
+	double sinPhi = sin(phi);
+	double dx = (start.x - point.x) / 2.0;
+	double dy = (start.y - point.y) / 2.0;
+	double x1 = cosPhi * dx + sinPhi * dy;
+	double y1 = -sinPhi * dx + cosPhi * dy;
+
+	double lambda = x1 * x1 / (rx * rx) + y1 * y1 / (ry * ry);
+	if (lambda > 1.0) {
+		rx *= sqrt(lambda);
+		ry *= sqrt(lambda);
+	}
+	double numerator = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+	double denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+	double coefficient = sqrt(fmax(0.0, numerator / denominator)) * (largeArc == sweep ? -1.0 : 1.0);
+	double cx1 = coefficient * rx * y1 / ry;
+	double cy1 = -coefficient * ry * x1 / rx;
+	double cx = cosPhi * cx1 - sinPhi * cy1 + (start.x + point.x) / 2.0;
+	double cy = sinPhi * cx1 + cosPhi * cy1 + (start.y + point.y) / 2.0;
+
+	double theta1 = atan2((y1 - cy1) / ry, (x1 - cx1) / rx);
+	double theta2 = atan2((-y1 - cy1) / ry, (-x1 - cx1) / rx);
+	double delta = theta2 - theta1;
+	if (sweep && delta < 0.0) {
+		delta += 2.0 * M_PI;
+	} else if (!sweep && delta > 0.0) {
+		delta -= 2.0 * M_PI;
+	}
+
+	double direction = delta < 0.0 ? -1.0 : 1.0;
+	Point startTangent = {
+		direction * (-rx * cosPhi * sin(theta1) - ry * sinPhi * cos(theta1)),
+		direction * (-rx * sinPhi * sin(theta1) + ry * cosPhi * cos(theta1))
+	};
+	Point endTangent = {
+		direction * (-rx * cosPhi * sin(theta1 + delta) - ry * sinPhi * cos(theta1 + delta)),
+		direction * (-rx * sinPhi * sin(theta1 + delta) + ry * cosPhi * cos(theta1 + delta))
+	};
+
+	beginSegment(builder, transformVector(builder->transform, startTangent));
+	Contour *contour = builder->shape->contours + builder->shape->contourCount - 1;
+	size_t steps = (size_t) ceil(fabs(delta) * fmax(rx, ry) * transformScale(builder->transform) / FLATTEN_STEP);
+	steps = steps < 4 ? 4 : steps;
+	for (size_t i = 1; i <= steps; ++i) {
+		double theta = theta1 + delta * i / steps;
+		Point arcPoint = i == steps ? point : (Point) {
+			cx + rx * cosPhi * cos(theta) - ry * sinPhi * sin(theta),
+			cy + rx * sinPhi * cos(theta) + ry * cosPhi * sin(theta)
+		};
+		appendPoint(contour, transformPoint(builder->transform, arcPoint));
+	}
+	builder->lastTangent = transformVector(builder->transform, endTangent);
+	builder->current = point;
+}
+
+/* Marks a corner where the previous segment's end tangent turns sharply into this one */
+static void beginSegment(PathBuilder *builder, Point tangent)
+{
+	Shape *shape = builder->shape;
+	if (shape->contourCount == 0 || shape->contours[shape->contourCount - 1].closed) {
+		beginContour(builder, builder->current);
+	}
+	Contour *contour = shape->contours + shape->contourCount - 1;
+
+	if (!builder->hasTangent) {
+		builder->firstTangent = tangent;
+		builder->hasTangent = true;
+		return;
+	}
+
+	Point a = builder->lastTangent;
+	double lengths = length(a) * length(tangent);
+	contour->corners[contour->pointCount - 1] = lengths > 0.0 && (dot(a, tangent) <= 0.0 || fabs(cross(a, tangent)) / lengths > sin(CORNER_ANGLE));
+}
+
+static void appendPoint(Contour *contour, Point point)
+{
+	if (contour->pointCount == contour->pointCapacity) {
+		contour->pointCapacity = contour->pointCapacity ? contour->pointCapacity * 2 : 16;
+		contour->points = realloc(contour->points, sizeof(*contour->points) * contour->pointCapacity);
+		contour->corners = realloc(contour->corners, sizeof(*contour->corners) * contour->pointCapacity);
+	}
+	contour->points[contour->pointCount] = point;
+	contour->corners[contour->pointCount] = false;
+	++contour->pointCount;
+}
+
+/* Colors the edges, works out which side each contour fills and finds the bounds */
+static void finishShape(Shape *shape)
+{
+	size_t contourCount = 0;
+	for (size_t i = 0; i < shape->contourCount; ++i) {
+		if (shape->contours[i].pointCount > 1) {
+			shape->contours[contourCount++] = shape->contours[i];
+		} else {
+			free(shape->contours[i].points);
+			free(shape->contours[i].corners);
+		}
+	}
+	shape->contourCount = contourCount;
+
+	double margin = shape->stroke != PAINT_NONE ? shape->strokeWidth / 2.0 : 0.0;
+	shape->min[0] = shape->min[1] = INFINITY;
+	shape->max[0] = shape->max[1] = -INFINITY;
+	for (size_t i = 0; i < shape->contourCount; ++i) {
+		Contour *contour = shape->contours + i;
+		colorEdges(contour);
+		for (size_t j = 0; j < contour->pointCount; ++j) {
+			shape->min[0] = fmin(shape->min[0], contour->points[j].x - margin);
+			shape->min[1] = fmin(shape->min[1], contour->points[j].y - margin);
+			shape->max[0] = fmax(shape->max[0], contour->points[j].x + margin);
+			shape->max[1] = fmax(shape->max[1], contour->points[j].y + margin);
+		}
+	}
+
+	/* Probe just left of each contour's longest segment to see if that's the filled side */
+	for (size_t i = 0; i < shape->contourCount; ++i) {
+		Contour *contour = shape->contours + i;
+		size_t longest = 0;
+		double longestLength = 0.0;
+		double area = 0.0;
+		for (size_t j = 0; j < contour->pointCount; ++j) {
+			Point a = contour->points[j];
+			Point b = contour->points[(j + 1) % contour->pointCount];
+			double segmentLength = length(subtract(b, a));
+			if (segmentLength > longestLength) {
+				longest = j;
+				longestLength = segmentLength;
+			}
+			area += cross(a, b) / 2.0;
+		}
+		contour->filled = shape->fill != PAINT_NONE && fabs(area) > MIN_FILL_AREA;
+		if (!contour->filled) {
+			continue;
+		}
+		Point a = contour->points[longest];
+		Point b = contour->points[(longest + 1) % contour->pointCount];
+		Point direction = subtract(b, a);
+		/* Left being the side with a positive cross product */
+		Point probe = {
+			(a.x + b.x) / 2.0 - direction.y / longestLength * 1e-3,
+			(a.y + b.y) / 2.0 + direction.x / longestLength * 1e-3
+		};
+		contour->sign = isInside(shape, probe) ? 1.0 : -1.0;
+	}
+}
+
+/*
+ * Two channels per edge, switching at every corner so the edges either side
+ * of one only share a channel, as in Chlumsky's msdfgen. A contour with no
+ * corners is all channels, and one with a single corner is split in three.
+ */
+static void colorEdges(Contour *contour)
+{
+	const uint8_t cyan = 0x6, magenta = 0x5, yellow = 0x3, white = 0x7;
+	size_t segmentCount = contour->pointCount;
+	contour->colors = malloc(sizeof(*contour->colors) * segmentCount);
+	contour->edgeStarts = calloc(segmentCount, sizeof(*contour->edgeStarts));
+
+	size_t cornerCount = 0;
+	size_t firstCorner = 0;
+	for (size_t i = 0; i < segmentCount; ++i) {
+		if (contour->corners[i]) {
+			if (cornerCount == 0) {
+				firstCorner = i;
+			}
+			++cornerCount;
+		}
+	}
+
+	if (cornerCount == 0) {
+		memset(contour->colors, white, segmentCount);
+		return;
+	}
+
+	if (cornerCount == 1) {
+		const uint8_t thirds[3] = {magenta, white, yellow};
+		for (size_t i = 0; i < segmentCount; ++i) {
+			size_t third = i * 3 / segmentCount;
+			contour->colors[(firstCorner + i) % segmentCount] = thirds[third];
+			if (i == 0 || third != (i - 1) * 3 / segmentCount) {
+				contour->edgeStarts[(firstCorner + i) % segmentCount] = true;
+			}
+		}
+		return;
+	}
+
+	const uint8_t cycle[3] = {cyan, magenta, yellow};
+	size_t edge = 0;
+	for (size_t i = 0; i < segmentCount; ++i) {
+		size_t segment = (firstCorner + i) % segmentCount;
+		if (i > 0 && contour->corners[segment]) {
+			++edge;
+		}
+		contour->colors[segment] = cycle[edge % 3];
+		contour->edgeStarts[segment] = contour->corners[segment];
+	}
+
+	/* The last edge meets the first too, so it can't share its color */
+	if (edge % 3 == 0) {
+		for (size_t i = segmentCount; i-- > 0;) {
+			size_t segment = (firstCorner + i) % segmentCount;
+			contour->colors[segment] = yellow;
+			if (contour->corners[segment]) {
+				break;
+			}
+		}
+	}
+}
+
+static bool isInside(const Shape *shape, Point point)
+{
+	int winding = 0;
+	for (size_t i = 0; i < shape->contourCount; ++i) {
+		const Contour *contour = shape->contours + i;
+		for (size_t j = 0; j < contour->pointCount; ++j) {
+			Point a = contour->points[j];
+			Point b = contour->points[(j + 1) % contour->pointCount];
+			if ((a.y <= point.y) != (b.y <= point.y)) {
+				double x = a.x + (point.y - a.y) / (b.y - a.y) * (b.x - a.x);
+				if (x > point.x) {
+					winding += b.y > a.y ? 1 : -1;
+				}
+			}
+		}
+	}
+
+	return shape->evenOdd ? winding % 2 != 0 : winding != 0;
+}
+
+/*
+ * Shapes are combined in paint order: anything painted adds to the coverage,
+ * and adds to or cuts from the ink depending on whether it's black. The
+ * coverage takes all three channels from whichever shape's median is
+ * largest, since mixing channels from different outlines would join up
+ * edges that don't meet.
+ */
+static void evaluateTexel(const Shape *shapes, size_t shapeCount, Point point, double range, Texel *texel)
+{
+	*texel = (Texel) {
+		.coverage = {-range, -range, -range},
+		.trueCoverage = -range,
+		.ink = -range
+	};
+
+	for (size_t i = 0; i < shapeCount; ++i) {
+		const Shape *shape = shapes + i;
+		if (point.x < shape->min[0] - range || point.x > shape->max[0] + range || point.y < shape->min[1] - range || point.y > shape->max[1] + range) {
+			continue;
+		}
+
+		double coverage[3];
+		double trueCoverage;
+		double stroke;
+		evaluateShape(shape, point, range, coverage, &trueCoverage, &stroke);
+
+		if (shape->fill != PAINT_NONE) {
+			if (median(coverage[0], coverage[1], coverage[2]) > median(texel->coverage[0], texel->coverage[1], texel->coverage[2])) {
+				memcpy(texel->coverage, coverage, sizeof(coverage));
+			}
+			texel->trueCoverage = fmax(texel->trueCoverage, trueCoverage);
+			texel->ink = shape->fill == PAINT_BLACK ? fmax(texel->ink, trueCoverage) : fmin(texel->ink, -trueCoverage);
+		}
+		if (shape->stroke != PAINT_NONE) {
+			if (stroke > median(texel->coverage[0], texel->coverage[1], texel->coverage[2])) {
+				for (size_t c = 0; c < 3; ++c) {
+					texel->coverage[c] = stroke;
+				}
+			}
+			texel->trueCoverage = fmax(texel->trueCoverage, stroke);
+			texel->ink = shape->stroke == PAINT_BLACK ? fmax(texel->ink, stroke) : fmin(texel->ink, -stroke);
+		}
+	}
+}
+
+/*
+ * One pass over the segments for the fill's distance per channel, its true
+ * signed distance and the stroke's. A channel's distance comes from its
+ * nearest edge, extended past the edge's ends, which is what keeps the
+ * corners sharp once the shader takes the median.
+ */
+static void evaluateShape(const Shape *shape, Point point, double range, double coverage[3], double *trueCoverage, double *stroke)
+{
+	double nearest = INFINITY;
+	double strokeNearest = INFINITY;
+	double channelNearest[3] = {INFINITY, INFINITY, INFINITY};
+	double channelOrthogonality[3] = {};
+	double channelDistance[3] = {};
+	double capDistance = -INFINITY;
+	double capPerpendicular = 0.0;
+
+	for (size_t i = 0; i < shape->contourCount; ++i) {
+		const Contour *contour = shape->contours + i;
+		for (size_t j = 0; j < contour->pointCount; ++j) {
+			Point a = contour->points[j];
+			Point b = contour->points[(j + 1) % contour->pointCount];
+			Point ab = subtract(b, a);
+			double abLength = length(ab);
+			if (abLength == 0.0) {
+				continue;
+			}
+			Point direction = {ab.x / abLength, ab.y / abLength};
+			Point ap = subtract(point, a);
+			double t = fmin(fmax(dot(ap, direction) / abLength, 0.0), 1.0);
+			Point offset = {ap.x - ab.x * t, ap.y - ab.y * t};
+			double distance = length(offset);
+			double side = cross(direction, offset) < 0.0 ? -1.0 : 1.0;
+			double orthogonality = distance > 0.0 ? fabs(cross(direction, offset)) / distance : 1.0;
+
+			bool closing = j == contour->pointCount - 1;
+			if (!closing || contour->closed) {
+				if (distance < strokeNearest) {
+					strokeNearest = distance;
+					capDistance = -INFINITY;
+					/* Butt caps end square at the ends of open subpaths */
+					if (shape->buttCap && !contour->closed) {
+						if (j == 0 && t == 0.0) {
+							capDistance = -dot(ap, direction);
+							capPerpendicular = fabs(cross(direction, ap));
+						} else if (j == contour->pointCount - 2 && t == 1.0) {
+							capDistance = dot(subtract(point, b), direction);
+							capPerpendicular = fabs(cross(direction, subtract(point, b)));
+						}
+					}
+				}
+			}
+
+			if (!contour->filled) {
+				continue;
+			}
+			nearest = fmin(nearest, distance);
+			for (size_t c = 0; c < 3; ++c) {
+				if (!(contour->colors[j] & (1 << c))) {
+					continue;
+				}
+				if (distance > channelNearest[c] + 1e-9 || (distance > channelNearest[c] - 1e-9 && orthogonality <= channelOrthogonality[c])) {
+					continue;
+				}
+				channelNearest[c] = distance;
+				channelOrthogonality[c] = orthogonality;
+
+				double signedDistance = side * distance;
+				size_t next = (j + 1) % contour->pointCount;
+				bool startsEdge = contour->edgeStarts[j];
+				bool endsEdge = contour->edgeStarts[next];
+				if ((t == 0.0 && startsEdge) || (t == 1.0 && endsEdge)) {
+					double pseudoDistance = cross(direction, t == 0.0 ? ap : subtract(point, b));
+					if (fabs(pseudoDistance) <= distance) {
+						signedDistance = pseudoDistance;
+					}
+				}
+				channelDistance[c] = contour->sign * signedDistance;
+			}
+		}
+	}
+
+	*trueCoverage = isInside(shape, point) ? nearest : -nearest;
+	*trueCoverage = fmin(fmax(*trueCoverage, -range), range);
+	for (size_t c = 0; c < 3; ++c) {
+		double distance = channelNearest[c] == INFINITY ? *trueCoverage : channelDistance[c];
+		coverage[c] = fmin(fmax(distance, -range), range);
+	}
+
+	double halfWidth = shape->strokeWidth / 2.0;
+	*stroke = strokeNearest == INFINITY ? -range : halfWidth - strokeNearest;
+	if (capDistance > -INFINITY) {
+		*stroke = fmin(halfWidth - capPerpendicular, -capDistance);
+	}
+	*stroke = fmin(fmax(*stroke, -range), range);
+}
+
+/*
+ * Where the channels differ, their median can cross zero somewhere the
+ * shapes don't have an edge, which shows up as specks or notches. Those are
+ * looked for by interpolating each square of four texels the way the sampler
+ * would and checking against the shapes themselves, and the texels around
+ * one get the true distance in every channel.
+ */
+static void correctTexels(Texel *texels, uint32_t size, const Shape *shapes, size_t shapeCount, double spacing, double range)
+{
+	bool *clashes = calloc((size_t) size * size, sizeof(*clashes));
+
+	for (uint32_t y = 0; y < size; ++y) {
+		for (uint32_t x = 0; x < size; ++x) {
+			size_t i = (size_t) y * size + x;
+			double distance = median(texels[i].coverage[0], texels[i].coverage[1], texels[i].coverage[2]);
+			if ((distance > 0.0) != (texels[i].trueCoverage > 0.0)) {
+				clashes[i] = true;
+			}
+		}
+	}
+
+	for (uint32_t y = 0; y + 1 < size; ++y) {
+		for (uint32_t x = 0; x + 1 < size; ++x) {
+			size_t corners[4] = {(size_t) y * size + x, (size_t) y * size + x + 1, (size_t) (y + 1) * size + x, (size_t) (y + 1) * size + x + 1};
+			double spread = 0.0;
+			for (size_t k = 0; k < 4; ++k) {
+				const double *coverage = texels[corners[k]].coverage;
+				spread = fmax(spread, fmax(coverage[0], fmax(coverage[1], coverage[2])) - fmin(coverage[0], fmin(coverage[1], coverage[2])));
+			}
+			if (spread < CLASH_TOLERANCE * spacing) {
+				continue;
+			}
+
+			bool clash = false;
+			for (size_t sample = 0; sample < CLASH_SAMPLES * CLASH_SAMPLES && !clash; ++sample) {
+				double u = (sample % CLASH_SAMPLES + 1.0) / (CLASH_SAMPLES + 1.0);
+				double v = (sample / CLASH_SAMPLES + 1.0) / (CLASH_SAMPLES + 1.0);
+				double weights[4] = {(1.0 - u) * (1.0 - v), u * (1.0 - v), (1.0 - u) * v, u * v};
+				double coverage[3] = {};
+				for (size_t k = 0; k < 4; ++k) {
+					for (size_t c = 0; c < 3; ++c) {
+						coverage[c] += weights[k] * texels[corners[k]].coverage[c];
+					}
+				}
+				double distance = median(coverage[0], coverage[1], coverage[2]);
+				if (fabs(distance) < CLASH_TOLERANCE * spacing) {
+					continue;
+				}
+
+				Texel exact;
+				Point point = {(x + 0.5 + u) * spacing, (y + 0.5 + v) * spacing};
+				evaluateTexel(shapes, shapeCount, point, range, &exact);
+				clash = (distance > 0.0) != (exact.trueCoverage > 0.0) && fabs(exact.trueCoverage) > CLASH_TOLERANCE * spacing;
+			}
+			if (clash) {
+				for (size_t k = 0; k < 4; ++k) {
+					clashes[corners[k]] = true;
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < (size_t) size * size; ++i) {
+		if (clashes[i]) {
+			for (size_t c = 0; c < 3; ++c) {
+				texels[i].coverage[c] = texels[i].trueCoverage;
+			}
+		}
+	}
+
+	free(clashes);
+}
+
+static double median(double a, double b, double c)
+{
+	return fmax(fmin(a, b), fmin(fmax(a, b), c));
+}
+
+static double cross(Point a, Point b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+static double dot(Point a, Point b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+static Point subtract(Point a, Point b)
+{
+	return (Point) {a.x - b.x, a.y - b.y};
+}
+
+static double length(Point a)
+{
+	return sqrt(a.x * a.x + a.y * a.y);
+}
+
+/* Half way is the edge, and range either side reaches 0 or 255 */
+static uint8_t normalizeDistance(double distance, double range)
+{
+	double normalized = 0.5 + distance / (2.0 * range);
+
+	return (uint8_t) lround(fmin(fmax(normalized, 0.0), 1.0) * 255.0);
+}
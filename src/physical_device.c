@@ -78,6 +78,19 @@ bool findQueueFamilyWithFlags(VkQueueFamilyProperties *queueFamilies, uint32_t q
 	return false;
 }
 
+/* Finds a family with all of queueFlags and none of excludedFlags, e.g. a DMA-only transfer family */
+bool findDedicatedQueueFamilyWithFlags(VkQueueFamilyProperties *queueFamilies, uint32_t queueFamilyCount, VkQueueFlags queueFlags, VkQueueFlags excludedFlags, uint32_t *queueFamilyIndex)
+{
+	for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+		if ((queueFamilies[i].queueFlags & queueFlags) == queueFlags && !(queueFamilies[i].queueFlags & excludedFlags)) {
+			*queueFamilyIndex = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 SuitabilityResult findQueueFamilyWithSurfaceSupport(uint32_t queueFamilyCount, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *queueFamilyIndex, char **error)
 {
 	for (uint32_t i = 0; i < queueFamilyCount; ++i) {
@@ -188,6 +201,18 @@ VkSampleCountFlagBits getMaxSampleCount(VkPhysicalDeviceProperties physicalDevic
 	}
 }
 
+/* The highest sample count both colour and depth support that's no higher than limit */
+VkSampleCountFlagBits getSupportedSampleCount(VkPhysicalDeviceProperties physicalDeviceProperties, VkSampleCountFlagBits limit)
+{
+	VkSampleCountFlags counts = physicalDeviceProperties.limits.framebufferColorSampleCounts & physicalDeviceProperties.limits.framebufferDepthSampleCounts;
+	VkSampleCountFlagBits sampleCount = limit;
+	while (sampleCount > VK_SAMPLE_COUNT_1_BIT && !(counts & sampleCount)) {
+		sampleCount = (VkSampleCountFlagBits) (sampleCount >> 1);
+	}
+
+	return sampleCount;
+}
+
 VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, VkFormat *formats, size_t formatCount, VkImageTiling tiling, VkFormatFeatureFlags features)
 {
 	for (size_t i = 0; i < formatCount; ++i) {
@@ -210,6 +235,32 @@ VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, VkFormat *formats,
 			return formats[i];
 		}
 	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+/*
+ * Desktop GPUs sample BC7 and mobile ones ETC2, so one of the cooked images
+ * will do. Distance fields are uncompressed and don't need choosing.
+ */
+bool chooseTextureEncoding(VkPhysicalDevice physicalDevice, TextureEncoding *encoding, char **error)
+{
+	VkFormat formats[] = {
+		[TEXTURE_ENCODING_BC7] = TEXTURE_FORMAT_BC7_SRGB_BLOCK,
+		[TEXTURE_ENCODING_ETC2] = TEXTURE_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+	};
+	uint32_t formatCount = sizeof(formats) / sizeof(*formats);
+
+	VkFormat format = findSupportedFormat(physicalDevice, formats, formatCount, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+	for (TextureEncoding i = 0; i < formatCount; ++i) {
+		if (format == formats[i]) {
+			*encoding = i;
+			return true;
+		}
+	}
+
+	asprintf(error, "Device can't sample BC7 or ETC2 textures");
+	return false;
 }
 
 void freePhysicalDeviceCharacteristics(PhysicalDeviceCharacteristics *characteristics)
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <vulkan/vulkan.h>
 
+#include "texture.h"
+
 typedef enum suitability_result_t {
 	SUITABILITY_ERROR = -1,
 	SUITABILITY_UNSUITABLE = 0,
@@ -28,13 +30,17 @@ typedef struct physical_device_surface_characteristics_t {
 } PhysicalDeviceSurfaceCharacteristics;
 
 bool findQueueFamilyWithFlags(VkQueueFamilyProperties *queueFamilies, uint32_t queueFamilyCount, VkQueueFlags queueFlags, uint32_t *queueFamilyIndex);
+
+bool findDedicatedQueueFamilyWithFlags(VkQueueFamilyProperties *queueFamilies, uint32_t queueFamilyCount, VkQueueFlags queueFlags, VkQueueFlags excludedFlags, uint32_t *queueFamilyIndex);
 VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, VkFormat *formats, size_t formatCount, VkImageTiling tiling, VkFormatFeatureFlags features);
 SuitabilityResult findQueueFamilyWithSurfaceSupport(uint32_t queueFamilyCount, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *queueFamilyIndex, char **error);
 bool choosePhysicalDevice(VkInstance instance, VkSurfaceKHR surface,
 	VkPhysicalDevice *physicalDevice, PhysicalDeviceCharacteristics *characteristics,
 	PhysicalDeviceSurfaceCharacteristics *surfaceCharacteristics, char **error);
 bool getPhysicalDeviceSurfaceCharacteristics(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, PhysicalDeviceSurfaceCharacteristics *characteristics, char **error);
+bool chooseTextureEncoding(VkPhysicalDevice physicalDevice, TextureEncoding *encoding, char **error);
 VkSampleCountFlagBits getMaxSampleCount(VkPhysicalDeviceProperties physicalDeviceProperties);
+VkSampleCountFlagBits getSupportedSampleCount(VkPhysicalDeviceProperties physicalDeviceProperties, VkSampleCountFlagBits limit);
 void freePhysicalDeviceCharacteristics(PhysicalDeviceCharacteristics *characteristics);
 void freePhysicalDeviceSurfaceCharacteristics(PhysicalDeviceSurfaceCharacteristics *characteristics);
 
@@ -1,4 +1,7 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "swapchain.h"
 #include "utils.h"
@@ -6,7 +9,51 @@
 
 #include "pipeline.h"
 
+typedef struct pipeline_job_t {
+	bool compute;
+	PipelineCreateInfo pipelineCreateInfo;
+	ComputePipelineCreateInfo computePipelineCreateInfo;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline *pipeline;
+	bool blend;
+	char *error;
+	struct pipeline_job_t *next;
+} PipelineJob;
+
+/*
+ * Workers take jobs in the order they were added and move them to
+ * finishedJobs, where their copies and errors wait for finishPipelineBuilder
+ */
+struct pipeline_builder_t {
+	pthread_t workers[PIPELINE_BUILDER_WORKER_COUNT];
+	size_t workerCount;
+	pthread_mutex_t mutex;
+	pthread_cond_t jobAvailable;
+	PipelineJob *pendingJobs;
+	PipelineJob *lastPendingJob;
+	PipelineJob *finishedJobs;
+	bool finishing;
+};
+
+static bool buildPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout pipelineLayout, VkPipeline *pipeline, bool blend, char **error);
+static bool buildComputePipeline(ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout pipelineLayout, VkPipeline *pipeline, char **error);
+static bool createPipelineLayout(VkDevice device, VkDescriptorSetLayout *descriptorSetLayouts, uint32_t descriptorSetLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount, VkPipelineLayout *pipelineLayout, char **error);
+static void pushPipelineJob(PipelineBuilder self, PipelineJob *job);
+static void *pipelineBuilderWorker(void *arg);
+static void freePipelineJob(PipelineJob *job);
+static void *copyBytes(const void *bytes, size_t size);
+static bool isPipelineCacheDataCompatible(VkPhysicalDeviceProperties deviceProperties, const char *data, long size);
+
 bool createPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, bool blend, char **error)
+{
+	if (!createPipelineLayout(pipelineCreateInfo.device, pipelineCreateInfo.descriptorSetLayouts, pipelineCreateInfo.descriptorSetLayoutCount, pipelineCreateInfo.pushConstantRanges, pipelineCreateInfo.pushConstantRangeCount, pipelineLayout, error)) {
+		return false;
+	}
+
+	return buildPipeline(pipelineCreateInfo, *pipelineLayout, pipeline, blend, error);
+}
+
+static bool buildPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout pipelineLayout, VkPipeline *pipeline, bool blend, char **error)
 {
 	VkResult result;
 
@@ -151,21 +198,6 @@ bool createPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pip
 		colorBlendStateCreateInfo.blendConstants[i] = 0.0f;
 	}
 
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-		.pNext = NULL,
-		.flags = 0,
-		.setLayoutCount = pipelineCreateInfo.descriptorSetLayoutCount,
-		.pSetLayouts = pipelineCreateInfo.descriptorSetLayouts,
-		.pushConstantRangeCount = pipelineCreateInfo.pushConstantRangeCount,
-		.pPushConstantRanges = pipelineCreateInfo.pushConstantRanges
-	};
-
-	if ((result = vkCreatePipelineLayout(pipelineCreateInfo.device, &pipelineLayoutCreateInfo, NULL, pipelineLayout)) != VK_SUCCESS) {
-		asprintf(error, "Failed to create pipeline layout: %s", string_VkResult(result));
-		return false;
-	}
-
 	VkDynamicState dynamicStates[] = {
 		VK_DYNAMIC_STATE_VIEWPORT,
 		VK_DYNAMIC_STATE_SCISSOR
@@ -193,14 +225,14 @@ bool createPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pip
 		.pDepthStencilState = &pipelineCreateInfo.depthStencilState,
 		.pColorBlendState = &colorBlendStateCreateInfo,
 		.pDynamicState = &pipelineDynamicStateCreateInfo,
-		.layout = *pipelineLayout,
+		.layout = pipelineLayout,
 		.renderPass = pipelineCreateInfo.renderPass,
 		.subpass = pipelineCreateInfo.subpassIndex,
 		.basePipelineHandle = VK_NULL_HANDLE,
 		.basePipelineIndex = -1
 	};
 
-	if ((result = vkCreateGraphicsPipelines(pipelineCreateInfo.device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, NULL, pipeline)) != VK_SUCCESS) {
+	if ((result = vkCreateGraphicsPipelines(pipelineCreateInfo.device, pipelineCreateInfo.pipelineCache, 1, &graphicsPipelineCreateInfo, NULL, pipeline)) != VK_SUCCESS) {
 		asprintf(error, "Failed to create pipeline: %s", string_VkResult(result));
 		return false;
 	}
@@ -211,6 +243,383 @@ bool createPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pip
 	return true;
 }
 
+bool createComputePipeline(ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error)
+{
+	if (!createPipelineLayout(pipelineCreateInfo.device, pipelineCreateInfo.descriptorSetLayouts, pipelineCreateInfo.descriptorSetLayoutCount, pipelineCreateInfo.pushConstantRanges, pipelineCreateInfo.pushConstantRangeCount, pipelineLayout, error)) {
+		return false;
+	}
+
+	return buildComputePipeline(pipelineCreateInfo, *pipelineLayout, pipeline, error);
+}
+
+static bool buildComputePipeline(ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout pipelineLayout, VkPipeline *pipeline, char **error)
+{
+	VkResult result;
+
+	VkShaderModuleCreateInfo computeShaderModuleCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.codeSize = pipelineCreateInfo.computeShaderSize,
+		.pCode = (const uint32_t *) pipelineCreateInfo.computeShaderBytes
+	};
+
+	VkShaderModule computeShaderModule;
+	vkCreateShaderModule(pipelineCreateInfo.device, &computeShaderModuleCreateInfo, NULL, &computeShaderModule);
+
+	VkPipelineShaderStageCreateInfo computeShaderStageCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+		.module = computeShaderModule,
+		.pName = "main",
+		.pSpecializationInfo = NULL
+	};
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.stage = computeShaderStageCreateInfo,
+		.layout = pipelineLayout,
+		.basePipelineHandle = VK_NULL_HANDLE,
+		.basePipelineIndex = -1
+	};
+
+	if ((result = vkCreateComputePipelines(pipelineCreateInfo.device, pipelineCreateInfo.pipelineCache, 1, &computePipelineCreateInfo, NULL, pipeline)) != VK_SUCCESS) {
+		asprintf(error, "Failed to create compute pipeline: %s", string_VkResult(result));
+		return false;
+	}
+
+	vkDestroyShaderModule(pipelineCreateInfo.device, computeShaderModule, NULL);
+
+	return true;
+}
+
+static bool createPipelineLayout(VkDevice device, VkDescriptorSetLayout *descriptorSetLayouts, uint32_t descriptorSetLayoutCount, VkPushConstantRange *pushConstantRanges, uint32_t pushConstantRangeCount, VkPipelineLayout *pipelineLayout, char **error)
+{
+	VkResult result;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.setLayoutCount = descriptorSetLayoutCount,
+		.pSetLayouts = descriptorSetLayouts,
+		.pushConstantRangeCount = pushConstantRangeCount,
+		.pPushConstantRanges = pushConstantRanges
+	};
+
+	if ((result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, NULL, pipelineLayout)) != VK_SUCCESS) {
+		asprintf(error, "Failed to create pipeline layout: %s", string_VkResult(result));
+		return false;
+	}
+
+	return true;
+}
+
+bool createPipelineBuilder(PipelineBuilder *pipelineBuilder, char **error)
+{
+	*pipelineBuilder = malloc(sizeof(**pipelineBuilder));
+
+	PipelineBuilder self = *pipelineBuilder;
+
+	self->pendingJobs = NULL;
+	self->lastPendingJob = NULL;
+	self->finishedJobs = NULL;
+	self->finishing = false;
+	pthread_mutex_init(&self->mutex, NULL);
+	pthread_cond_init(&self->jobAvailable, NULL);
+
+	for (self->workerCount = 0; self->workerCount < PIPELINE_BUILDER_WORKER_COUNT; ++self->workerCount) {
+		if (pthread_create(&self->workers[self->workerCount], NULL, pipelineBuilderWorker, (void *) self) != 0) {
+			break;
+		}
+	}
+	if (self->workerCount == 0) {
+		asprintf(error, "Failed to start pipeline compilation threads");
+		pthread_cond_destroy(&self->jobAvailable);
+		pthread_mutex_destroy(&self->mutex);
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * The layout is created straight away; the pipeline handle is only written
+ * once finishPipelineBuilder returns. Shader code and vertex input state are
+ * copied, so the caller can free them as soon as this returns.
+ */
+bool pipelineBuilderAddPipeline(PipelineBuilder self, PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, bool blend, char **error)
+{
+	if (!createPipelineLayout(pipelineCreateInfo.device, pipelineCreateInfo.descriptorSetLayouts, pipelineCreateInfo.descriptorSetLayoutCount, pipelineCreateInfo.pushConstantRanges, pipelineCreateInfo.pushConstantRangeCount, pipelineLayout, error)) {
+		return false;
+	}
+
+	PipelineJob *job = malloc(sizeof(*job));
+	*job = (PipelineJob) {
+		.compute = false,
+		.pipelineCreateInfo = pipelineCreateInfo,
+		.pipelineLayout = *pipelineLayout,
+		.pipeline = pipeline,
+		.blend = blend,
+		.error = NULL,
+		.next = NULL
+	};
+	job->pipelineCreateInfo.vertexShaderBytes = copyBytes(pipelineCreateInfo.vertexShaderBytes, pipelineCreateInfo.vertexShaderSize);
+	job->pipelineCreateInfo.fragmentShaderBytes = copyBytes(pipelineCreateInfo.fragmentShaderBytes, pipelineCreateInfo.fragmentShaderSize);
+	job->pipelineCreateInfo.vertexBindingDescriptions = copyBytes(pipelineCreateInfo.vertexBindingDescriptions, sizeof(*pipelineCreateInfo.vertexBindingDescriptions) * pipelineCreateInfo.vertexBindingDescriptionCount);
+	job->pipelineCreateInfo.VertexAttributeDescriptions = copyBytes(pipelineCreateInfo.VertexAttributeDescriptions, sizeof(*pipelineCreateInfo.VertexAttributeDescriptions) * pipelineCreateInfo.vertexAttributeDescriptionCount);
+	job->pipelineCreateInfo.descriptorSetLayouts = NULL;
+	job->pipelineCreateInfo.pushConstantRanges = NULL;
+
+	pushPipelineJob(self, job);
+
+	return true;
+}
+
+bool pipelineBuilderAddComputePipeline(PipelineBuilder self, ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error)
+{
+	if (!createPipelineLayout(pipelineCreateInfo.device, pipelineCreateInfo.descriptorSetLayouts, pipelineCreateInfo.descriptorSetLayoutCount, pipelineCreateInfo.pushConstantRanges, pipelineCreateInfo.pushConstantRangeCount, pipelineLayout, error)) {
+		return false;
+	}
+
+	PipelineJob *job = malloc(sizeof(*job));
+	*job = (PipelineJob) {
+		.compute = true,
+		.computePipelineCreateInfo = pipelineCreateInfo,
+		.pipelineLayout = *pipelineLayout,
+		.pipeline = pipeline,
+		.error = NULL,
+		.next = NULL
+	};
+	job->computePipelineCreateInfo.computeShaderBytes = copyBytes(pipelineCreateInfo.computeShaderBytes, pipelineCreateInfo.computeShaderSize);
+	job->computePipelineCreateInfo.descriptorSetLayouts = NULL;
+	job->computePipelineCreateInfo.pushConstantRanges = NULL;
+
+	pushPipelineJob(self, job);
+
+	return true;
+}
+
+/* Waits for every pipeline added and frees the builder; reports the first failure */
+bool finishPipelineBuilder(PipelineBuilder self, char **error)
+{
+	pthread_mutex_lock(&self->mutex);
+	self->finishing = true;
+	pthread_cond_broadcast(&self->jobAvailable);
+	pthread_mutex_unlock(&self->mutex);
+
+	for (size_t i = 0; i < self->workerCount; ++i) {
+		pthread_join(self->workers[i], NULL);
+	}
+
+	bool success = true;
+	PipelineJob *job = self->finishedJobs;
+	while (job) {
+		PipelineJob *next = job->next;
+		if (job->error) {
+			if (success) {
+				*error = job->error;
+				success = false;
+			} else {
+				free(job->error);
+			}
+		}
+		freePipelineJob(job);
+		job = next;
+	}
+
+	pthread_cond_destroy(&self->jobAvailable);
+	pthread_mutex_destroy(&self->mutex);
+	free(self);
+
+	return success;
+}
+
+static void pushPipelineJob(PipelineBuilder self, PipelineJob *job)
+{
+	pthread_mutex_lock(&self->mutex);
+	if (self->lastPendingJob) {
+		self->lastPendingJob->next = job;
+	} else {
+		self->pendingJobs = job;
+	}
+	self->lastPendingJob = job;
+	pthread_cond_signal(&self->jobAvailable);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+/* Pipeline creation is free-threaded, and the shared cache synchronizes itself */
+static void *pipelineBuilderWorker(void *arg)
+{
+	PipelineBuilder self = (PipelineBuilder) arg;
+
+	pthread_mutex_lock(&self->mutex);
+	for (;;) {
+		while (!self->pendingJobs && !self->finishing) {
+			pthread_cond_wait(&self->jobAvailable, &self->mutex);
+		}
+		if (!self->pendingJobs) {
+			break;
+		}
+
+		PipelineJob *job = self->pendingJobs;
+		self->pendingJobs = job->next;
+		if (!self->pendingJobs) {
+			self->lastPendingJob = NULL;
+		}
+		pthread_mutex_unlock(&self->mutex);
+
+		if (job->compute) {
+			buildComputePipeline(job->computePipelineCreateInfo, job->pipelineLayout, job->pipeline, &job->error);
+		} else {
+			buildPipeline(job->pipelineCreateInfo, job->pipelineLayout, job->pipeline, job->blend, &job->error);
+		}
+
+		pthread_mutex_lock(&self->mutex);
+		job->next = self->finishedJobs;
+		self->finishedJobs = job;
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return NULL;
+}
+
+static void freePipelineJob(PipelineJob *job)
+{
+	if (job->compute) {
+		free((char *) job->computePipelineCreateInfo.computeShaderBytes);
+	} else {
+		free((char *) job->pipelineCreateInfo.vertexShaderBytes);
+		free((char *) job->pipelineCreateInfo.fragmentShaderBytes);
+		free(job->pipelineCreateInfo.vertexBindingDescriptions);
+		free(job->pipelineCreateInfo.VertexAttributeDescriptions);
+	}
+	free(job);
+}
+
+static void *copyBytes(const void *bytes, size_t size)
+{
+	if (!bytes || size == 0) {
+		return NULL;
+	}
+
+	void *copy = malloc(size);
+	memcpy(copy, bytes, size);
+
+	return copy;
+}
+
+/*
+ * Seeds the cache from the file at path if its header was written by this
+ * exact device and driver; anything else (a missing file, another GPU, an
+ * updated driver) starts an empty cache
+ */
+bool createPipelineCache(VkDevice device, VkPhysicalDeviceProperties deviceProperties, const char *path, VkPipelineCache *pipelineCache, char **error)
+{
+	char *data = NULL;
+	long size = readFileToString(path, &data);
+	if (size < 0) {
+		data = NULL;
+		size = 0;
+	}
+
+	if (data && !isPipelineCacheDataCompatible(deviceProperties, data, size)) {
+		free(data);
+		data = NULL;
+		size = 0;
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.initialDataSize = size,
+		.pInitialData = data
+	};
+
+	VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, NULL, pipelineCache);
+	free(data);
+	if (result != VK_SUCCESS) {
+		asprintf(error, "Failed to create pipeline cache: %s", string_VkResult(result));
+		return false;
+	}
+
+	return true;
+}
+
+bool savePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path, char **error)
+{
+	VkResult result;
+
+	size_t size;
+	if ((result = vkGetPipelineCacheData(device, pipelineCache, &size, NULL)) != VK_SUCCESS) {
+		asprintf(error, "Failed to get pipeline cache size: %s", string_VkResult(result));
+		return false;
+	}
+
+	char *data = malloc(size);
+	if ((result = vkGetPipelineCacheData(device, pipelineCache, &size, data)) != VK_SUCCESS) {
+		asprintf(error, "Failed to get pipeline cache data: %s", string_VkResult(result));
+		free(data);
+		return false;
+	}
+
+	FILE *fp = fopen(path, "wb");
+	if (fp == NULL) {
+		asprintf(error, "Failed to open pipeline cache for writing.\n");
+		free(data);
+		return false;
+	}
+	size_t written = fwrite(data, 1, size, fp);
+	fclose(fp);
+	free(data);
+
+	if (written != size) {
+		asprintf(error, "Failed to write pipeline cache.\n");
+		remove(path);
+		return false;
+	}
+
+	return true;
+}
+
+void destroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache)
+{
+	vkDestroyPipelineCache(device, pipelineCache, NULL);
+}
+
+/* The header is VkPipelineCacheHeaderVersionOne, stored little-endian */
+static bool isPipelineCacheDataCompatible(VkPhysicalDeviceProperties deviceProperties, const char *data, long size)
+{
+	const unsigned char *bytes = (const unsigned char *) data;
+	uint32_t fields[4];
+
+	if (size < 16 + VK_UUID_SIZE) {
+		return false;
+	}
+
+	for (size_t i = 0; i < 4; ++i) {
+		fields[i] = bytes[i * 4] | bytes[i * 4 + 1] << 8 | bytes[i * 4 + 2] << 16 | (uint32_t) bytes[i * 4 + 3] << 24;
+	}
+
+	uint32_t headerSize = fields[0];
+	uint32_t headerVersion = fields[1];
+	uint32_t vendorID = fields[2];
+	uint32_t deviceID = fields[3];
+
+	return headerSize >= 16 + VK_UUID_SIZE
+		&& headerSize <= size
+		&& headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& vendorID == deviceProperties.vendorID
+		&& deviceID == deviceProperties.deviceID
+		&& memcmp(bytes + 16, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
 void destroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout)
 {
 	vkDestroyPipelineLayout(device, pipelineLayout, NULL);
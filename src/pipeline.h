@@ -4,6 +4,11 @@
 #include <stdbool.h>
 #include <vulkan/vulkan.h>
 
+#define PIPELINE_CACHE_FILE_NAME "pipeline_cache.bin"
+#define PIPELINE_BUILDER_WORKER_COUNT 4
+
+typedef struct pipeline_builder_t *PipelineBuilder;
+
 typedef struct push_constants_t {
 	float extent[2];
 	float offset[2];
@@ -12,6 +17,7 @@ typedef struct push_constants_t {
 
 typedef struct pipeline_create_info_t {
 	VkDevice device;
+	VkPipelineCache pipelineCache;
 	VkRenderPass renderPass;
 	uint32_t subpassIndex;
 	const char *vertexShaderBytes;
@@ -30,8 +36,35 @@ typedef struct pipeline_create_info_t {
 	VkSampleCountFlagBits sampleCount;
 } PipelineCreateInfo;
 
+typedef struct compute_pipeline_create_info_t {
+	VkDevice device;
+	VkPipelineCache pipelineCache;
+	const char *computeShaderBytes;
+	long computeShaderSize;
+	VkDescriptorSetLayout *descriptorSetLayouts;
+	uint32_t descriptorSetLayoutCount;
+	VkPushConstantRange *pushConstantRanges;
+	uint32_t pushConstantRangeCount;
+} ComputePipelineCreateInfo;
+
 bool createPipeline(PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, bool blend, char **error);
 
+bool createComputePipeline(ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error);
+
+bool createPipelineBuilder(PipelineBuilder *pipelineBuilder, char **error);
+
+bool pipelineBuilderAddPipeline(PipelineBuilder self, PipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, bool blend, char **error);
+
+bool pipelineBuilderAddComputePipeline(PipelineBuilder self, ComputePipelineCreateInfo pipelineCreateInfo, VkPipelineLayout *pipelineLayout, VkPipeline *pipeline, char **error);
+
+bool finishPipelineBuilder(PipelineBuilder self, char **error);
+
+bool createPipelineCache(VkDevice device, VkPhysicalDeviceProperties deviceProperties, const char *path, VkPipelineCache *pipelineCache, char **error);
+
+bool savePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path, char **error);
+
+void destroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache);
+
 void destroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout);
 
 void destroyPipeline(VkDevice device, VkPipeline pipeline);
@@ -29,6 +29,7 @@ void initializeQueue(Queue *queue)
 	};
 	pthread_mutex_init(&queue->headLock, NULL);
 	pthread_mutex_init(&queue->tailLock, NULL);
+	pthread_cond_init(&queue->nonEmpty, NULL);
 }
   
 /*
@@ -51,6 +52,7 @@ void enqueue(Queue *queue, void *value)
 	pthread_mutex_lock(&queue->tailLock);
 	queue->tail->next = node;
 	queue->tail = node;
+	pthread_cond_signal(&queue->nonEmpty);
 	pthread_mutex_unlock(&queue->tailLock);
 }
   
@@ -86,4 +88,28 @@ bool dequeue(Queue *queue, void **value)
 	free(node);
 
 	return true;
+}
+
+/*
+ * Blocks until the queue isn't empty or wakeQueue has been called since the
+ * last wait. Only the consumer may call this: Head is only swung by the
+ * consumer, and Head->next is only linked under T_lock, which is held here.
+ */
+void waitForQueue(Queue *queue)
+{
+	pthread_mutex_lock(&queue->tailLock);
+	while (!queue->head->next && !queue->woken) {
+		pthread_cond_wait(&queue->nonEmpty, &queue->tailLock);
+	}
+	queue->woken = false;
+	pthread_mutex_unlock(&queue->tailLock);
+}
+
+/* Wakes the consumer without enqueueing anything */
+void wakeQueue(Queue *queue)
+{
+	pthread_mutex_lock(&queue->tailLock);
+	queue->woken = true;
+	pthread_cond_signal(&queue->nonEmpty);
+	pthread_mutex_unlock(&queue->tailLock);
 }
\ No newline at end of file
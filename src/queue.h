@@ -22,17 +22,24 @@ typedef struct node {
  * 	H_lock: lock type,
  * 	T_lock: lock type
  * }
+ *
+ * nonEmpty is signalled under T_lock whenever a node is linked or the
+ * consumer is woken, so a single consumer can sleep until there's work.
  */
 typedef struct queue {
 	Node *head;
 	Node *tail;
 	pthread_mutex_t headLock;
 	pthread_mutex_t tailLock;
+	pthread_cond_t nonEmpty;
+	bool woken;
 } Queue;
 
 Queue *createQueue(void);
 void initializeQueue(Queue *queue);
 void enqueue(Queue *queue, void *value);
 bool dequeue(Queue *queue, void **value);
+void waitForQueue(Queue *queue);
+void wakeQueue(Queue *queue);
 
 #endif /* MODELER_QUEUE_H */
\ No newline at end of file
@@ -5,14 +5,25 @@
 
  #include "render_pass.h"
 
+/*
+ * Attachments are the multisampled colour image, depth, the resolve target
+ * (the swapchain image, or the offscreen image with DRAW_WINDOW_BORDER) and
+ * then the swapchain image for the window decoration. Without multisampling
+ * there's nothing to resolve, so the subpasses draw straight into the
+ * resolve target, which takes the multisampled image's place at the front.
+ * The first subpass upscales the board from the scene render pass.
+ */
 bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat depthImageFormat, VkSampleCountFlagBits sampleCount, VkRenderPass *renderPass, char **error)
 {
+	bool resolve = sampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+	/* Only the resolved image is kept, so the multisampled one can be transient */
 	VkAttachmentDescription attachmentDescription = {
 		.flags = 0,
 		.format = swapchainInfo.surfaceFormat.format,
 		.samples = sampleCount,
 		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
 		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
@@ -46,7 +57,12 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.format = swapchainInfo.surfaceFormat.format,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+#if DRAW_WINDOW_BORDER
+		/* The offscreen image is only read by the window decoration subpass */
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+#else /* DRAW_WINDOW_BORDER */
 		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+#endif /* DRAW_WINDOW_BORDER */
 		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
@@ -62,6 +78,11 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	};
 
+	if (!resolve) {
+		attachmentDescription = resolveAttachmentDescription;
+		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	}
+
 	VkSubpassDescription subpassDescription = {
 		.flags = 0,
 		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -69,18 +90,19 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.pInputAttachments = NULL,
 		.colorAttachmentCount = 1,
 		.pColorAttachments = &attachmentReference,
-		.pResolveAttachments = &resolveAttachmentReference,
+		.pResolveAttachments = resolve ? &resolveAttachmentReference : NULL,
 		.pDepthStencilAttachment = &depthAttachmentReference,
 		.preserveAttachmentCount = 0,
 		.pPreserveAttachments = NULL
 	};
 
+	/* The scene pass earlier in the frame wrote the shared multisampled color and depth images */
 	VkSubpassDependency subpassDependency = {
 		.srcSubpass = VK_SUBPASS_EXTERNAL,
 		.dstSubpass = 0,
-		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-		.srcAccessMask = 0,
+		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 		.dependencyFlags = 0
 	};
@@ -93,7 +115,7 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.pInputAttachments = NULL,
 		.colorAttachmentCount = 1,
 		.pColorAttachments = &attachmentReference,
-		.pResolveAttachments = &resolveAttachmentReference,
+		.pResolveAttachments = resolve ? &resolveAttachmentReference : NULL,
 		.pDepthStencilAttachment = &depthAttachmentReference,
 		.preserveAttachmentCount = 0,
 		.pPreserveAttachments = NULL
@@ -117,7 +139,7 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.pInputAttachments = NULL,
 		.colorAttachmentCount = 1,
 		.pColorAttachments = &attachmentReference,
-		.pResolveAttachments = &resolveAttachmentReference,
+		.pResolveAttachments = resolve ? &resolveAttachmentReference : NULL,
 		.pDepthStencilAttachment = &depthAttachmentReference,
 		.preserveAttachmentCount = 0,
 		.pPreserveAttachments = NULL
@@ -152,12 +174,12 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 	};
 
 	VkAttachmentReference windowDecorationAttachmentInputReference = {
-		.attachment = 2,
+		.attachment = resolve ? 2 : 0,
 		.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 	};
 
 	VkAttachmentReference windowDecorationAttachmentReference = {
-		.attachment = 3,
+		.attachment = resolve ? 3 : 2,
 		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	};
 
@@ -190,6 +212,9 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 	};
 
 	VkAttachmentDescription attachmentDescriptions[] = {attachmentDescription, depthAttachmentDescription, resolveAttachmentDescription, windowDecorationAttachmentDescription};
+	if (!resolve) {
+		attachmentDescriptions[2] = windowDecorationAttachmentDescription;
+	}
 #if ENABLE_IMGUI
 	VkSubpassDescription subpassDescriptions[] = {subpassDescription, imSubpassDescription, titlebarSubpassDescription, windowDecorationSubpassDescription};
 	VkSubpassDependency subpassDependencies[] = {subpassDependency, imSubpassDependency, titlebarSubpassDependency, windowDecorationSubpassDependency};
@@ -212,7 +237,7 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
 		.pNext = NULL,
 		.flags = 0,
-		.attachmentCount = sizeof(attachmentDescriptions) / sizeof(attachmentDescriptions[0]),
+		.attachmentCount = sizeof(attachmentDescriptions) / sizeof(attachmentDescriptions[0]) - (resolve ? 0 : 1),
 		.pAttachments = attachmentDescriptions,
 		.subpassCount = sizeof(subpassDescriptions) / sizeof(subpassDescriptions[0]),
 		.dependencyCount = sizeof(subpassDependencies) / sizeof(subpassDependencies[0]),
@@ -229,6 +254,133 @@ bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat dep
 	return true;
 }
 
+/*
+ * Draws the board into the scene image, which the main render pass then
+ * samples, so the board can be drawn at a lower resolution than the rest.
+ * The multisampled colour and depth images are shared with the main render
+ * pass, which clears them again; attachments are ordered the same way.
+ */
+bool createSceneRenderPass(VkDevice device, VkFormat format, VkFormat depthImageFormat, VkSampleCountFlagBits sampleCount, VkRenderPass *renderPass, char **error)
+{
+	bool resolve = sampleCount != VK_SAMPLE_COUNT_1_BIT;
+
+	VkAttachmentDescription attachmentDescription = {
+		.flags = 0,
+		.format = format,
+		.samples = sampleCount,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+	};
+
+	VkAttachmentReference attachmentReference = {
+		.attachment = 0,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+	};
+
+	VkAttachmentDescription depthAttachmentDescription = {
+		.flags = 0,
+		.format = depthImageFormat,
+		.samples = sampleCount,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+	};
+
+	VkAttachmentReference depthAttachmentReference = {
+		.attachment = 1,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+	};
+
+	VkAttachmentDescription sceneAttachmentDescription = {
+		.flags = 0,
+		.format = format,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	};
+
+	VkAttachmentReference sceneAttachmentReference = {
+		.attachment = 2,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+	};
+
+	if (!resolve) {
+		attachmentDescription = sceneAttachmentDescription;
+		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	}
+
+	VkSubpassDescription subpassDescription = {
+		.flags = 0,
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.inputAttachmentCount = 0,
+		.pInputAttachments = NULL,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &attachmentReference,
+		.pResolveAttachments = resolve ? &sceneAttachmentReference : NULL,
+		.pDepthStencilAttachment = &depthAttachmentReference,
+		.preserveAttachmentCount = 0,
+		.pPreserveAttachments = NULL
+	};
+
+	/*
+	 * The previous frame's upscale may still be reading the scene image, and
+	 * its main pass wrote the shared multisampled color and depth images
+	 */
+	VkSubpassDependency subpassDependency = {
+		.srcSubpass = VK_SUBPASS_EXTERNAL,
+		.dstSubpass = 0,
+		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		.dependencyFlags = 0
+	};
+
+	VkSubpassDependency upscaleDependency = {
+		.srcSubpass = 0,
+		.dstSubpass = VK_SUBPASS_EXTERNAL,
+		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+		.dependencyFlags = 0
+	};
+
+	VkAttachmentDescription attachmentDescriptions[] = {attachmentDescription, depthAttachmentDescription, sceneAttachmentDescription};
+	VkSubpassDependency subpassDependencies[] = {subpassDependency, upscaleDependency};
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.attachmentCount = sizeof(attachmentDescriptions) / sizeof(attachmentDescriptions[0]) - (resolve ? 0 : 1),
+		.pAttachments = attachmentDescriptions,
+		.subpassCount = 1,
+		.dependencyCount = sizeof(subpassDependencies) / sizeof(subpassDependencies[0]),
+		.pSubpasses = &subpassDescription,
+		.pDependencies = subpassDependencies
+	};
+
+	VkResult result;
+	if ((result = vkCreateRenderPass(device, &renderPassCreateInfo, NULL, renderPass)) != VK_SUCCESS) {
+		asprintf(error, "Failed to create scene render pass: %s", string_VkResult(result));
+		return false;
+	}
+
+	return true;
+}
+
 void destroyRenderPass(VkDevice device, VkRenderPass renderPass) {
 	vkDestroyRenderPass(device, renderPass, NULL);
 }
@@ -8,6 +8,8 @@
 
 bool createRenderPass(VkDevice device, SwapchainInfo swapchainInfo, VkFormat depthImageFormat, VkSampleCountFlagBits sampleCount, VkRenderPass *renderPass, char **error);
 
+bool createSceneRenderPass(VkDevice device, VkFormat format, VkFormat depthImageFormat, VkSampleCountFlagBits sampleCount, VkRenderPass *renderPass, char **error);
+
 void destroyRenderPass(VkDevice device, VkRenderPass renderPass);
 
 #endif /* MODELER_RENDER_PASS_H */
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -16,9 +17,8 @@
 #include "imgui/imgui_impl_modeler.h"
 #endif /* ENABLE_IMGUI */
 
-#ifdef EMBED_FONTS
-#include "../font_roboto.h"
-#endif /* EMBED_FONTS */
+/* Frames drawn after the last change before rendering on demand sleeps, so every frame in flight and imgui catch up */
+#define ON_DEMAND_IDLE_FRAMES (MAX_FRAMES_IN_FLIGHT + 1)
 
 typedef struct component_t {
 	void *object;
@@ -36,13 +36,14 @@ typedef struct font_t {
 static inline Orientation negateRotation(Orientation orientation);
 static void sendInputToComponent(Component *components, size_t componentCount, InputEvent *inputEvent, PointerPosition pointerPosition);
 static void updateViewports(WindowDimensions *windowDimensions, VkViewport *chessBoardViewport, VkViewport *titlebarViewport);
+static void scaleViewport(VkViewport viewport, float scale, VkViewport *scaledViewport, VkRect2D *scaledScissor);
 #ifdef ENABLE_IMGUI
 static void pushFont(Font **fonts, size_t *fontCount, ImFont *font, float scale);
 static ImFont *findFontWithScale(Font *fonts, size_t fontCount, float scale);
-static bool rescaleImGui(Font **fonts, size_t *fontCount, ImFont **currentFont, float scale, const char *resourcePath, char **error);
+static bool rescaleImGui(Font **fonts, size_t *fontCount, ImFont **currentFont, float scale, const char *fontBytes, size_t fontSize, char **error);
 #endif /* ENABLE_IMGUI */
 
-bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensions, VkDescriptorSet *descriptorSets, VkRenderPass *renderPass, VkPipeline *pipelines, VkPipelineLayout *pipelineLayouts, VkFramebuffer **framebuffers, VkCommandBuffer *commandBuffers, SynchronizationInfo *synchronizationInfo, SwapchainInfo *swapchainInfo, VkQueue graphicsQueue, VkQueue presentationQueue, uint32_t graphicsQueueFamilyIndex, const char *resourcePath, Queue *inputQueue, SwapchainCreateInfo swapchainCreateInfo, ChessBoard chessBoard, ChessEngine chessEngine, Titlebar titlebar, char **error)
+bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensions, VkDescriptorSet *descriptorSets, VkRenderPass *renderPass, VkPipeline *pipelines, VkPipelineLayout *pipelineLayouts, VkFramebuffer **framebuffers, VkRenderPass *sceneRenderPass, VkFramebuffer *sceneFramebuffer, VkCommandBuffer *commandBuffers, SynchronizationInfo *synchronizationInfo, SwapchainInfo *swapchainInfo, VkQueue graphicsQueue, VkQueue presentationQueue, uint32_t graphicsQueueFamilyIndex, const char *fontBytes, size_t fontSize, Queue *inputQueue, SwapchainCreateInfo swapchainCreateInfo, UploadManager uploadManager, FrameTimer frameTimer, MsaaController msaaController, ResolutionController resolutionController, ChessBoard chessBoard, ChessEngine chessEngine, Titlebar titlebar, Upscaler upscaler, char **error)
 {
 #ifdef ENABLE_IMGUI
 	Font *fonts = NULL;
@@ -69,9 +70,24 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 	bool windowResized = false;
 	bool swapchainOutOfDate = false;
 	bool insetsChanged = false;
+	bool boardUpdated = false;
+	bool enableAnalysis = chessEngineGetAnalysisEnabled(chessEngine);
+	int analysisLineCount = chessEngineGetAnalysisLineCount(chessEngine);
+	int boardCount = chessBoardGetTileCount(chessBoard);
+	int msaaMode = msaaControllerGetMode(msaaController);
+	VkSampleCountFlagBits sampleCount = msaaControllerGetSampleCount(msaaController);
+	bool automaticResolution = resolutionControllerGetAutomatic(resolutionController);
+	float resolutionScale = resolutionControllerGetScale(resolutionController);
+#ifdef ON_DEMAND_RENDERING
+	bool onDemand = true;
+#else
+	bool onDemand = false;
+#endif /* ON_DEMAND_RENDERING */
+	unsigned int idleFrames = 0;
+	VkClearValue sceneClearValues[] = {clearValue, stencilClearValue};
 
 #ifdef ENABLE_IMGUI
-	if (!rescaleImGui(&fonts, &fontCount, &currentFont, windowDimensions->scale, resourcePath, error)) {
+	if (!rescaleImGui(&fonts, &fontCount, &currentFont, windowDimensions->scale, fontBytes, fontSize, error)) {
 		return false;
 	}
 #endif /* ENABLE_IMGUI */
@@ -91,6 +107,7 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 		}
 	};
 	updateViewports(windowDimensions, &chessBoardViewport, &titlebarViewport);
+	chessBoardSetViewportExtent(chessBoard, chessBoardViewport.width, chessBoardViewport.height);
 
 	for (uint32_t currentFrame = 0; true; currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT) {
 		VkResult result;
@@ -112,8 +129,15 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 			};
 		}
 
+		/* Sleep until an input event or a search result, rather than redrawing a board that hasn't changed */
+		if (onDemand && idleFrames >= ON_DEMAND_IDLE_FRAMES && !swapchainOutOfDate && !chessBoardHasPendingChanges(chessBoard)) {
+			waitForQueue(inputQueue);
+			idleFrames = 0;
+		}
+
 		InputEvent *inputEvent;
 		while (dequeue(inputQueue, (void **) &inputEvent)) {
+			idleFrames = 0;
 			InputEventType type = inputEvent->type;
 			void *data = inputEvent->data;
 			ResizeInfo *resizeInfo;
@@ -156,7 +180,7 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 				resizeInfo = (ResizeInfo *) data;
 #ifdef ENABLE_IMGUI
 				if (resizeInfo->windowDimensions.scale != windowDimensions->scale) {
-					if (!rescaleImGui(&fonts, &fontCount, &currentFont, resizeInfo->windowDimensions.scale, resourcePath, error)) {
+					if (!rescaleImGui(&fonts, &fontCount, &currentFont, resizeInfo->windowDimensions.scale, fontBytes, fontSize, error)) {
 						return false;
 					}
 				}
@@ -176,14 +200,40 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 				windowDimensions->insets = insets;
 				updateWindowDimensionsInsets(windowDimensions, insets);
 				break;
+			case BOARD_UPDATE:
+				if (chessEngineApplyStreamLines(chessEngine, ((BoardUpdateBatch *) data)->lines, ((BoardUpdateBatch *) data)->lineCount)) {
+					boardUpdated = true;
+				}
+				freeBoardUpdateBatch(data);
+				free(inputEvent);
+				break;
 			case TERMINATE:
 				free(inputEvent);
 				goto cancelMainLoop;
 			}
 		}
+		if (idleFrames < ON_DEMAND_IDLE_FRAMES) {
+			++idleFrames;
+		}
 
-		if (windowResized || swapchainOutOfDate) {
-			if (!recreateSwapchain(swapchainCreateInfo, windowResized, error)) {
+		/* However many stream batches arrived, upload the board once per frame */
+		if (boardUpdated) {
+			if (!chessEnginePublishBoard(chessEngine, error)) {
+				return false;
+			}
+			boardUpdated = false;
+		}
+
+		if (!chessEngineUpdateAnalysis(chessEngine, error)) {
+			return false;
+		}
+
+		/* The automatic mode may have moved it since the last frame */
+		bool sampleCountChanged = msaaControllerGetSampleCount(msaaController) != sampleCount;
+		sampleCount = msaaControllerGetSampleCount(msaaController);
+
+		if (windowResized || swapchainOutOfDate || sampleCountChanged) {
+			if (!recreateSwapchain(swapchainCreateInfo, windowResized, sampleCount, error)) {
 				return false;
 			}
 		}
@@ -195,6 +245,7 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 			updateWindowDimensionsInsets(windowDimensions, insets);
 
 			updateViewports(windowDimensions, &chessBoardViewport, &titlebarViewport);
+			chessBoardSetViewportExtent(chessBoard, chessBoardViewport.width, chessBoardViewport.height);
 
 			float aspectRatio = (float) windowDimensions->surfaceArea.width / windowDimensions->titlebarHeight;
 			titlebarSetAspectRatio(titlebar, aspectRatio);
@@ -210,6 +261,18 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 			asprintf(error, "Failed to wait for fences: %s", string_VkResult(result));
 			return false;
 		}
+		uploadManagerBeginFrame(uploadManager, currentFrame);
+		double frameNanoseconds;
+		if (frameTimerRead(frameTimer, currentFrame, &frameNanoseconds)) {
+			/* Resolution gives way before MSAA does */
+			msaaControllerUpdate(msaaController, frameNanoseconds, resolutionControllerAllowsFewerSamples(resolutionController), resolutionControllerAllowsMoreSamples(resolutionController));
+			resolutionControllerUpdate(resolutionController, frameNanoseconds);
+		}
+
+		/* Retries anything the upload ring had no room for */
+		if (!updateChessBoard(chessBoard, error)) {
+			return false;
+		}
 
 		uint32_t imageIndex = 0;
 		result = vkAcquireNextImageKHR(device, swapchainInfo->swapchain, UINT64_MAX, synchronizationInfo->imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -244,6 +307,39 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 
 		vkResetCommandBuffer(commandBuffers[currentFrame], 0);
 		vkBeginCommandBuffer(commandBuffers[currentFrame], &commandBufferBeginInfos[currentFrame]);
+		uploadManagerRecord(uploadManager, commandBuffers[currentFrame], currentFrame);
+		dispatchChessBoard(chessBoard, commandBuffers[currentFrame]);
+		/* Only what follows the swapchain image's acquisition is timed */
+		frameTimerBegin(frameTimer, commandBuffers[currentFrame], currentFrame);
+
+		/* The board is drawn at a fraction of its size, for the first subpass to upscale */
+		float renderScale = resolutionControllerGetScale(resolutionController);
+		VkViewport sceneViewport;
+		VkRect2D sceneScissor;
+		scaleViewport(chessBoardViewport, renderScale, &sceneViewport, &sceneScissor);
+		VkRenderPassBeginInfo sceneRenderPassBeginInfo = {
+			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+			.pNext = NULL,
+			.renderPass = *sceneRenderPass,
+			.framebuffer = *sceneFramebuffer,
+			.renderArea = {
+				.offset = {},
+				.extent = {
+					.width = ceilf(swapchainInfo->extent.width * renderScale),
+					.height = ceilf(swapchainInfo->extent.height * renderScale)
+				}
+			},
+			.clearValueCount = sizeof(sceneClearValues) / sizeof(sceneClearValues[0]),
+			.pClearValues = sceneClearValues
+		};
+		vkCmdBeginRenderPass(commandBuffers[currentFrame], &sceneRenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdSetViewport(commandBuffers[currentFrame], 0, 1, &sceneViewport);
+		vkCmdSetScissor(commandBuffers[currentFrame], 0, 1, &sceneScissor);
+		if (!drawChessBoard(chessBoard, commandBuffers[currentFrame], currentFrame, error)) {
+			return false;
+		}
+		vkCmdEndRenderPass(commandBuffers[currentFrame]);
+
 		vkCmdBeginRenderPass(commandBuffers[currentFrame], &renderPassBeginInfos[currentFrame], VK_SUBPASS_CONTENTS_INLINE);
 
 		/* First subpass */
@@ -260,9 +356,7 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 		};
 		vkCmdSetViewport(commandBuffers[currentFrame], 0, 1, &chessBoardViewport);
 		vkCmdSetScissor(commandBuffers[currentFrame], 0, 1, &scissor);
-		if (!drawChessBoard(chessBoard, commandBuffers[currentFrame], error)) {
-			return false;
-		}
+		drawUpscaler(upscaler, commandBuffers[currentFrame], chessBoardViewport, renderScale);
 
 #ifdef ENABLE_IMGUI
 		vkCmdNextSubpass(commandBuffers[currentFrame], VK_SUBPASS_CONTENTS_INLINE);
@@ -376,6 +470,47 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 			}
 		}
 		ImGui_EndDisabled();
+		if (ImGui_Combo("MSAA", &msaaMode, "1x\0" "2x\0" "4x\0" "Max\0" "Auto\0")) {
+			msaaControllerSetMode(msaaController, msaaMode);
+		}
+		ImGui_Text("%ux MSAA", (unsigned int) sampleCount);
+		if (ImGui_Checkbox("Auto resolution", &automaticResolution)) {
+			resolutionControllerSetAutomatic(resolutionController, automaticResolution);
+		}
+		ImGui_BeginDisabled(automaticResolution);
+		resolutionScale = resolutionControllerGetScale(resolutionController);
+		if (ImGui_SliderFloat("Resolution", &resolutionScale, RESOLUTION_MIN_SCALE, 1.0f)) {
+			resolutionControllerSetScale(resolutionController, resolutionScale);
+		}
+		ImGui_EndDisabled();
+		ImGui_Checkbox("On demand", &onDemand);
+		/* The stream can add boards too */
+		boardCount = chessBoardGetTileCount(chessBoard);
+		if (ImGui_SliderInt("Boards", &boardCount, 1, CHESS_BOARD_MAX_TILES)) {
+			chessBoardSetTileCount(chessBoard, boardCount);
+			if (!updateChessBoard(chessBoard, error)) {
+				return false;
+			}
+		}
+		if (ImGui_Checkbox("Analysis", &enableAnalysis)) {
+			if (!chessEngineSetAnalysisEnabled(chessEngine, enableAnalysis, error)) {
+				return false;
+			}
+		}
+		ImGui_BeginDisabled(!enableAnalysis);
+		if (ImGui_SliderInt("Lines", &analysisLineCount, 1, CHESS_SEARCH_MAX_LINES)) {
+			chessEngineSetAnalysisLineCount(chessEngine, analysisLineCount);
+		}
+		ImGui_EndDisabled();
+		const Analysis *analysis = chessEngineGetAnalysis(chessEngine);
+		if (analysis) {
+			ImGui_Text("depth %u, %llu nodes", analysis->depth, (unsigned long long) analysis->nodes);
+			for (size_t i = 0; i < analysis->lineCount; ++i) {
+				char line[128];
+				analysisLineToString(analysis, i, line, sizeof(line));
+				ImGui_TextWrapped("%zu. %s", i + 1, line);
+			}
+		}
 		ImGui_End();
 		ImGui_PopStyleVar();
 		ImGui_PopStyleVar();
@@ -439,6 +574,7 @@ bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensi
 #endif /* DRAW_WINDOW_BORDER */
 
 		vkCmdEndRenderPass(commandBuffers[currentFrame]);
+		frameTimerEnd(frameTimer, commandBuffers[currentFrame], currentFrame);
 		vkEndCommandBuffer(commandBuffers[currentFrame]);
 
 		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -559,6 +695,32 @@ static void updateViewports(WindowDimensions *windowDimensions, VkViewport *ches
 	}
 }
 
+/* Scissor rounded outwards to whole pixels */
+static void scaleViewport(VkViewport viewport, float scale, VkViewport *scaledViewport, VkRect2D *scaledScissor)
+{
+	*scaledViewport = (VkViewport) {
+		.x = viewport.x * scale,
+		.y = viewport.y * scale,
+		.width = viewport.width * scale,
+		.height = viewport.height * scale,
+		.minDepth = viewport.minDepth,
+		.maxDepth = viewport.maxDepth
+	};
+
+	int32_t left = floorf(scaledViewport->x);
+	int32_t top = floorf(scaledViewport->y);
+	*scaledScissor = (VkRect2D) {
+		.offset = {
+			.x = left,
+			.y = top
+		},
+		.extent = {
+			.width = ceilf(scaledViewport->x + scaledViewport->width) - left,
+			.height = ceilf(scaledViewport->y + scaledViewport->height) - top
+		}
+	};
+}
+
 #ifdef ENABLE_IMGUI
 static void pushFont(Font **fonts, size_t *fontCount, ImFont *font, float scale)
 {
@@ -580,21 +742,14 @@ static ImFont *findFontWithScale(Font *fonts, size_t fontCount, float scale)
 	return NULL;
 }
 
-static bool rescaleImGui(Font **fonts, size_t *fontCount, ImFont **currentFont, float scale, const char *resourcePath, char **error)
+/* The font was read once at startup; the atlas takes ownership of a copy per scale */
+static bool rescaleImGui(Font **fonts, size_t *fontCount, ImFont **currentFont, float scale, const char *fontBytes, size_t fontSize, char **error)
 {
 	if (!(*currentFont = findFontWithScale(*fonts, *fontCount, scale))) {
 		ImGuiIO *io = ImGui_GetIO();
-#ifndef EMBED_FONTS
-		char *robotoFontPath;
-		int robotoFontSize;
-		char *robotoFontBytes;
-		asprintf(&robotoFontPath, "%s/%s", resourcePath, "roboto.ttf");
-		if ((robotoFontSize = readFileToString(robotoFontPath, &robotoFontBytes)) == -1) {
-			asprintf(error, "Failed to load font file.\n");
-			return false;
-		}
-#endif /* EMBED_FONTS */
-		ImFont *font = ImFontAtlas_AddFontFromMemoryTTF(io->Fonts, robotoFontBytes, robotoFontSize, 16 * scale, NULL, NULL);
+		char *robotoFontBytes = malloc(fontSize);
+		memcpy(robotoFontBytes, fontBytes, fontSize);
+		ImFont *font = ImFontAtlas_AddFontFromMemoryTTF(io->Fonts, robotoFontBytes, fontSize, 16 * scale, NULL, NULL);
 		pushFont(fonts, fontCount, font, scale);
 		ImFontAtlas_Build(io->Fonts);
 		*currentFont = font;
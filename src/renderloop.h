@@ -11,9 +11,14 @@
 #include "synchronization.h"
 #include "queue.h"
 #include "input_event.h"
+#include "upload.h"
+#include "frame_timer.h"
+#include "msaa.h"
+#include "resolution.h"
+#include "upscale.h"
 #include "chess_board.h"
 #include "titlebar.h"
 
-bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensions, VkDescriptorSet *descriptorSets, VkRenderPass *renderPass, VkPipeline *pipelines, VkPipelineLayout *pipelineLayouts, VkFramebuffer **framebuffers, VkCommandBuffer *commandBuffers, SynchronizationInfo *synchronizationInfo, SwapchainInfo *swapchainInfo, VkQueue graphicsQueue, VkQueue presentationQueue, uint32_t graphicsQueueFamilyIndex, const char *resourcePath, Queue *inputQueue, SwapchainCreateInfo swapchainCreateInfo, ChessBoard chessBoard, ChessEngine chessEngine, Titlebar titlebar, char **error);
+bool draw(VkDevice device, void *platformWindow, WindowDimensions *windowDimensions, VkDescriptorSet *descriptorSets, VkRenderPass *renderPass, VkPipeline *pipelines, VkPipelineLayout *pipelineLayouts, VkFramebuffer **framebuffers, VkRenderPass *sceneRenderPass, VkFramebuffer *sceneFramebuffer, VkCommandBuffer *commandBuffers, SynchronizationInfo *synchronizationInfo, SwapchainInfo *swapchainInfo, VkQueue graphicsQueue, VkQueue presentationQueue, uint32_t graphicsQueueFamilyIndex, const char *fontBytes, size_t fontSize, Queue *inputQueue, SwapchainCreateInfo swapchainCreateInfo, UploadManager uploadManager, FrameTimer frameTimer, MsaaController msaaController, ResolutionController resolutionController, ChessBoard chessBoard, ChessEngine chessEngine, Titlebar titlebar, Upscaler upscaler, char **error);
 
 #endif /* MODELER_RENDERLOOP_H */
@@ -0,0 +1,115 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "resolution.h"
+
+#include "frame_timer.h"
+
+/* The automatic mode aims for frames to take this much of the budget */
+#define RESOLUTION_TARGET_FRACTION 0.8
+/* Most the scale moves in one step, so a single slow window can't halve it */
+#define RESOLUTION_MAX_STEP 0.1f
+/* Smaller changes aren't worth the shimmer */
+#define RESOLUTION_MIN_STEP 0.02f
+
+/*
+ * Chooses the fraction of the window's size the board is drawn at before
+ * it's upscaled. Fill rate goes with the number of pixels, so once
+ * RESOLUTION_FRAME_WINDOW frames have been timed the automatic mode scales
+ * both dimensions by the square root of how far the average was from the
+ * target. The target sits under the budget the MSAA controller works to,
+ * and while the scale is automatic MSAA is only allowed to drop samples
+ * once it has bottomed out, and to add them once the board is back at
+ * full resolution, so resolution is always given up first.
+ */
+struct resolution_controller_t {
+	bool automatic;
+	float scale;
+	double elapsedNanoseconds;
+	uint32_t elapsedFrameCount;
+};
+
+static float clampScale(float scale);
+
+bool createResolutionController(ResolutionController *resolutionController, bool automatic, char **error)
+{
+	*resolutionController = malloc(sizeof(**resolutionController));
+
+	ResolutionController self = *resolutionController;
+
+	self->automatic = automatic;
+	self->scale = 1.0f;
+	self->elapsedNanoseconds = 0.0;
+	self->elapsedFrameCount = 0;
+
+	return true;
+}
+
+void resolutionControllerSetAutomatic(ResolutionController self, bool automatic)
+{
+	self->automatic = automatic;
+	self->elapsedNanoseconds = 0.0;
+	self->elapsedFrameCount = 0;
+}
+
+bool resolutionControllerGetAutomatic(ResolutionController self)
+{
+	return self->automatic;
+}
+
+void resolutionControllerSetScale(ResolutionController self, float scale)
+{
+	self->scale = clampScale(scale);
+}
+
+float resolutionControllerGetScale(ResolutionController self)
+{
+	return self->scale;
+}
+
+static float clampScale(float scale)
+{
+	return fminf(fmaxf(scale, RESOLUTION_MIN_SCALE), 1.0f);
+}
+
+/* With the GPU time of each frame as frameTimerRead returns it */
+void resolutionControllerUpdate(ResolutionController self, double frameNanoseconds)
+{
+	if (!self->automatic) {
+		return;
+	}
+
+	self->elapsedNanoseconds += frameNanoseconds;
+	if (++self->elapsedFrameCount < RESOLUTION_FRAME_WINDOW) {
+		return;
+	}
+
+	double average = self->elapsedNanoseconds / self->elapsedFrameCount;
+	self->elapsedNanoseconds = 0.0;
+	self->elapsedFrameCount = 0;
+	if (average <= 0.0) {
+		return;
+	}
+
+	float step = self->scale * sqrtf((float) (FRAME_BUDGET_NANOSECONDS * RESOLUTION_TARGET_FRACTION / average)) - self->scale;
+	step = fminf(fmaxf(step, -RESOLUTION_MAX_STEP), RESOLUTION_MAX_STEP);
+	float scale = clampScale(self->scale + step);
+	if (fabsf(scale - self->scale) >= RESOLUTION_MIN_STEP || scale == 1.0f || scale == RESOLUTION_MIN_SCALE) {
+		self->scale = scale;
+	}
+}
+
+bool resolutionControllerAllowsFewerSamples(ResolutionController self)
+{
+	return !self->automatic || self->scale == RESOLUTION_MIN_SCALE;
+}
+
+bool resolutionControllerAllowsMoreSamples(ResolutionController self)
+{
+	return !self->automatic || self->scale == 1.0f;
+}
+
+void destroyResolutionController(ResolutionController self)
+{
+	free(self);
+}
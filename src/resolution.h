@@ -0,0 +1,23 @@
+#ifndef MODELER_RESOLUTION_H
+#define MODELER_RESOLUTION_H
+
+#include <stdbool.h>
+
+/* The board is never drawn at less than this fraction of the window's size */
+#define RESOLUTION_MIN_SCALE 0.5f
+/* Frames averaged before the automatic mode reconsiders the scale */
+#define RESOLUTION_FRAME_WINDOW 20
+
+typedef struct resolution_controller_t *ResolutionController;
+
+bool createResolutionController(ResolutionController *resolutionController, bool automatic, char **error);
+void resolutionControllerSetAutomatic(ResolutionController self, bool automatic);
+bool resolutionControllerGetAutomatic(ResolutionController self);
+void resolutionControllerSetScale(ResolutionController self, float scale);
+float resolutionControllerGetScale(ResolutionController self);
+void resolutionControllerUpdate(ResolutionController self, double frameNanoseconds);
+bool resolutionControllerAllowsFewerSamples(ResolutionController self);
+bool resolutionControllerAllowsMoreSamples(ResolutionController self);
+void destroyResolutionController(ResolutionController self);
+
+#endif /* MODELER_RESOLUTION_H */
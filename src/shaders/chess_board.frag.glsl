@@ -1,5 +1,8 @@
 #version 450
 
+/* Fraction of the atlas either side of an edge that the distance fields span; msdf_cook has the same */
+#define DISTANCE_RANGE (1.0 / 64.0)
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 layout(location = 2) in vec2 fragTexCoord2;
@@ -7,10 +10,36 @@ layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) out vec4 outColor;
 
+/* The move markers' #00804b at 75% opacity, as drawn in pieces.svg */
+const vec3 markerColor = vec3(0.0, 0.216, 0.068);
+const float markerOpacity = 0.75;
+
+float median(float r, float g, float b) {
+	return max(min(r, g), min(max(r, g), b));
+}
+
+/* How many screen pixels the distance range covers, so edges stay about a pixel wide at any size */
+float screenPxRange(vec2 texCoord) {
+	vec2 pixelsPerAtlas = 1.0 / max(fwidth(texCoord), vec2(1e-6));
+	return max(DISTANCE_RANGE * (pixelsPerAtlas.x + pixelsPerAtlas.y), 1.0);
+}
+
+float coverage(float distance, float pxRange) {
+	return clamp(pxRange * (distance - 0.5) + 0.5, 0.0, 1.0);
+}
+
+/*
+ * RGB is where anything is drawn, with sharp corners, and A is where it's
+ * drawn black; everything else in a piece is white
+ */
 void main() {
-	vec4 background = vec4(fragColor, 1.0);
-	vec4 texture1 = texture(texSampler, fragTexCoord);
-	vec4 texture2 = texture(texSampler, fragTexCoord2);
-	vec4 firstTextureApplied = mix(background, vec4(texture1.rgb, 1.0), texture1.a);
-	outColor = mix(firstTextureApplied, vec4(texture2.rgb, 1.0), texture2.a);
+	vec4 piece = texture(texSampler, fragTexCoord);
+	float piecePxRange = screenPxRange(fragTexCoord);
+	float pieceCoverage = coverage(median(piece.r, piece.g, piece.b), piecePxRange);
+	float ink = coverage(piece.a, piecePxRange);
+	vec3 color = mix(fragColor, vec3(1.0 - ink), pieceCoverage);
+
+	vec4 marker = texture(texSampler, fragTexCoord2);
+	float markerCoverage = coverage(median(marker.r, marker.g, marker.b), screenPxRange(fragTexCoord2));
+	outColor = vec4(mix(color, markerColor, markerCoverage * markerOpacity), 1.0);
 }
@@ -1,9 +1,20 @@
 #version 450
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec2 inTexCoord2;
+/*
+ * There is no vertex buffer: each quad is built from gl_VertexIndex, six
+ * vertices to a quad, with the instance as the tile. A tile is its 64
+ * squares, the 8 board sides shown in 3D, then a shaft and a head quad per
+ * arrow. Quads that aren't shown collapse to a point.
+ */
+
+#define SIDE_OFFSET 64
+#define ARROW_OFFSET 72
+#define MAX_ARROWS 8
+#define SQUARE_WIDTH 0.25
+
+/* Square state: piece in bits 0-7, move marker in bits 8-15, then flags */
+#define SQUARE_LAST_MOVE (1u << 16)
+#define SQUARE_SELECTED (1u << 17)
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
@@ -15,13 +26,148 @@ layout (binding = 0) uniform _transform_uniform {
 	mat4 normalMatrix;
 } TransformUniform;
 
+/* Per tile clip-space scale (xy) and offset (zw) */
+layout (binding = 2) uniform _tiles_uniform {
+	vec4 tiles[64];
+} TilesUniform;
+
+layout (std430, binding = 3) readonly buffer _board_state {
+	uint enable3d;
+	uint arrowCount;
+	uint pieceLod;
+	uint arrows[MAX_ARROWS]; /* from | to << 8, tile 0 only */
+	uint squares[]; /* 64 per tile */
+} BoardState;
+
 mat4 MV = TransformUniform.MV;
 mat4 P = TransformUniform.P;
 mat4 normalMatrix = TransformUniform.normalMatrix;
 
+const uint quadCorners[6] = uint[](0, 1, 2, 2, 3, 0);
+
+/* Indexed by Piece; EMPTY is a transparent cell */
+const vec2 pieceSpriteOrigins[13] = vec2[](
+	vec2(0.75, 0.75),
+	vec2(0.25, 0.75),
+	vec2(0.75, 0.5),
+	vec2(0.5, 0.5),
+	vec2(0.0, 0.75),
+	vec2(0.25, 0.5),
+	vec2(0.0, 0.5),
+	vec2(0.25, 0.25),
+	vec2(0.75, 0.0),
+	vec2(0.5, 0.0),
+	vec2(0.0, 0.25),
+	vec2(0.25, 0.0),
+	vec2(0.0, 0.0)
+);
+
+/* Indexed by Move */
+const vec2 iconSpriteOrigins[3] = vec2[](
+	vec2(0.75, 0.75),
+	vec2(0.5, 0.25),
+	vec2(0.75, 0.25)
+);
+
+/* Plain, last move, selected; sRGB */
+const vec3 darkColors[3] = vec3[](
+	vec3(0.71, 0.533, 0.388),
+	vec3(0.671, 0.635, 0.227),
+	vec3(0.749, 0.475, 0.271)
+);
+const vec3 lightColors[3] = vec3[](
+	vec3(0.941, 0.851, 0.71),
+	vec3(0.808, 0.824, 0.42),
+	vec3(0.914, 0.694, 0.494)
+);
+const vec3 shadowDark = vec3(0.41, 0.233, 0.088);
+const vec3 shadowLight = vec3(0.641, 0.551, 0.41);
+
+/* Earlier arrows are the higher ranked ones and get the stronger colors */
+const vec3 arrowColors[MAX_ARROWS] = vec3[](
+	vec3(0.157, 0.537, 0.271),
+	vec3(0.192, 0.455, 0.686),
+	vec3(0.569, 0.388, 0.678),
+	vec3(0.776, 0.545, 0.208),
+	vec3(0.6, 0.6, 0.6),
+	vec3(0.6, 0.6, 0.6),
+	vec3(0.6, 0.6, 0.6),
+	vec3(0.6, 0.6, 0.6)
+);
+
+vec3 srgbToLinear(vec3 color) {
+	return pow(color, vec3(2.2));
+}
+
+vec2 squareCenter(uint square) {
+	return (vec2(square % 8, square / 8) + 0.5) * SQUARE_WIDTH - 1.0;
+}
+
 void main() {
-	gl_Position = P * MV * vec4(inPosition, 1.0);
-	fragColor = inColor;
-	fragTexCoord = inTexCoord;
-	fragTexCoord2 = inTexCoord2;
+	uint quad = uint(gl_VertexIndex) / 6;
+	uint corner = quadCorners[uint(gl_VertexIndex) % 6];
+	vec2 cornerOffset = vec2(corner >= 2 ? 1.0 : 0.0, (corner == 1 || corner == 2) ? 1.0 : 0.0);
+	uint tile = uint(gl_InstanceIndex);
+	bool enable3d = BoardState.enable3d != 0;
+
+	vec3 position = vec3(0.0);
+	vec3 color = vec3(0.0);
+	vec2 texCoord = pieceSpriteOrigins[0] + cornerOffset * 0.25;
+	vec2 texCoord2 = iconSpriteOrigins[0] + cornerOffset * 0.25;
+	bool visible = true;
+
+	if (quad < SIDE_OFFSET) {
+		uint state = BoardState.squares[tile * 64 + quad];
+		uvec2 square = uvec2(quad % 8, quad / 8);
+		uint highlight = (state & SQUARE_SELECTED) != 0 ? 2 : (state & SQUARE_LAST_MOVE) != 0 ? 1 : 0;
+		uint piece = enable3d ? 0 : state & 0xff;
+
+		position = vec3((vec2(square) + cornerOffset) * SQUARE_WIDTH - 1.0, 0.0);
+		color = srgbToLinear((square.x + square.y) % 2 == 0 ? lightColors[highlight] : darkColors[highlight]);
+		texCoord = pieceSpriteOrigins[piece] + cornerOffset * 0.25;
+		texCoord2 = iconSpriteOrigins[(state >> 8) & 0xff] + cornerOffset * 0.25;
+	} else if (quad < ARROW_OFFSET) {
+		uint side = quad - SIDE_OFFSET;
+
+		visible = enable3d;
+		position = vec3((side + cornerOffset.x) * SQUARE_WIDTH - 1.0, 1.0, cornerOffset.y * SQUARE_WIDTH / 2);
+		color = srgbToLinear(side % 2 == 1 ? shadowLight : shadowDark);
+	} else {
+		uint arrow = (quad - ARROW_OFFSET) / 2;
+		bool head = (quad - ARROW_OFFSET) % 2 == 1;
+
+		visible = tile == 0 && arrow < BoardState.arrowCount;
+		if (visible) {
+			vec2 start = squareCenter(BoardState.arrows[arrow] & 0xff);
+			vec2 tip = squareCenter((BoardState.arrows[arrow] >> 8) & 0xff);
+			vec2 direction = normalize(tip - start);
+			vec2 normal = vec2(-direction.y, direction.x);
+			vec2 base = tip - direction * SQUARE_WIDTH * 0.4;
+			/* Same winding as the squares; the head's tip is two coincident corners */
+			float side = (corner == 0 || corner == 1) ? 1.0 : -1.0;
+			vec2 point;
+			if (head) {
+				point = (corner == 1 || corner == 2) ? tip : base + normal * side * SQUARE_WIDTH * 0.25;
+			} else {
+				point = ((corner == 0 || corner == 3) ? start : base) + normal * side * SQUARE_WIDTH * 0.1;
+			}
+
+			/* Lifted off the board in 3D so the squares can't win the depth test */
+			position = vec3(point, enable3d ? -0.005 : 0.0);
+			color = srgbToLinear(arrowColors[arrow]);
+			texCoord = pieceSpriteOrigins[0] + 0.125;
+			texCoord2 = iconSpriteOrigins[0] + 0.125;
+		}
+	}
+
+	if (!visible) {
+		position = vec3(0.0);
+	}
+
+	vec4 tileTransform = TilesUniform.tiles[tile];
+	gl_Position = P * MV * vec4(position, 1.0);
+	gl_Position.xy = gl_Position.xy * tileTransform.xy + tileTransform.zw * gl_Position.w;
+	fragColor = color;
+	fragTexCoord = texCoord;
+	fragTexCoord2 = texCoord2;
 }
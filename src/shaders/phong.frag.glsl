@@ -2,15 +2,11 @@
 
 layout(location = 0) in vec3 fragPosition;
 layout(location = 1) in vec3 fragNormal;
+layout(location = 2) flat in vec3 fragDiffuseColor;
+layout(location = 3) flat in vec3 fragAmbientColor;
 
 layout(location = 0) out vec4 outColor;
 
-layout (push_constant) uniform _push_constants {
-	vec4 diffuseColor;
-	vec4 ambientColor;
-} PushConstants;
-
-
 const float Ka = 1.0;
 const float Kd = 1.0;
 const float Ks = 1.0;
@@ -18,8 +14,8 @@ const float shininessVal = 5.0;
 const vec3 specularColor = vec3(1.0, 1.0, 1.0);
 const vec3 lightPos = vec3(10.0, -5.0, -10.0);
 
-vec3 diffuseColor = vec3(PushConstants.diffuseColor);
-vec3 ambientColor = vec3(PushConstants.ambientColor);
+vec3 diffuseColor = fragDiffuseColor;
+vec3 ambientColor = fragAmbientColor;
 
 void main() {
 	vec3 N = normalize(fragNormal);
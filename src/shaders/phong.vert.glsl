@@ -1,24 +1,58 @@
 #version 450
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
+/* Quantized within the mesh's bounds, and octahedral-encoded */
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in uint inTransformIndex;
+layout(location = 3) in vec3 inDiffuseColor;
+layout(location = 4) in vec3 inAmbientColor;
+layout(location = 5) in uint inMeshIndex;
 
 layout(location = 0) out vec3 fragPosition;
 layout(location = 1) out vec3 fragNormal;
+layout(location = 2) flat out vec3 fragDiffuseColor;
+layout(location = 3) flat out vec3 fragAmbientColor;
 
-layout (binding = 0) uniform _transform_uniform {
+struct Transform {
 	mat4 MV;
 	mat4 P;
 	mat4 normalMatrix;
+};
+
+/* One transform per square, shared by every tile */
+layout (binding = 0) uniform _transform_uniform {
+	Transform transforms[64];
 } TransformUniform;
 
-mat4 MV = TransformUniform.MV;
-mat4 P = TransformUniform.P;
-mat4 normalMatrix = TransformUniform.normalMatrix;
+/* Per tile clip-space scale (xy) and offset (zw) */
+layout (binding = 1) uniform _tiles_uniform {
+	vec4 tiles[64];
+} TilesUniform;
+
+/* Per mesh dequantization, position = inPosition * scale + bias */
+layout (binding = 2) uniform _mesh_bounds_uniform {
+	vec4 scales[6];
+	vec4 biases[6];
+} MeshBoundsUniform;
+
+vec3 decodeOctahedral(vec2 encoded) {
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0);
+	normal.x += normal.x >= 0.0 ? -fold : fold;
+	normal.y += normal.y >= 0.0 ? -fold : fold;
+	return normalize(normal);
+}
 
 void main() {
-	vec4 vertPos4 = MV * vec4(inPosition, 1.0);
+	/* tile * 64 + square */
+	Transform transform = TransformUniform.transforms[inTransformIndex % 64];
+	vec4 tile = TilesUniform.tiles[inTransformIndex / 64];
+	vec3 position = inPosition.xyz * MeshBoundsUniform.scales[inMeshIndex].xyz + MeshBoundsUniform.biases[inMeshIndex].xyz;
+	vec4 vertPos4 = transform.MV * vec4(position, 1.0);
 	fragPosition = vec3(vertPos4) / vertPos4.w;
-	fragNormal = vec3(normalMatrix * vec4(inNormal, 0.0));
-	gl_Position = P * vertPos4;
+	fragNormal = vec3(transform.normalMatrix * vec4(decodeOctahedral(inNormal), 0.0));
+	fragDiffuseColor = inDiffuseColor;
+	fragAmbientColor = inAmbientColor;
+	gl_Position = transform.P * vertPos4;
+	gl_Position.xy = gl_Position.xy * tile.xy + tile.zw * gl_Position.w;
 }
@@ -0,0 +1,82 @@
+#version 450
+
+/*
+ * One workgroup per tile and one invocation per square. Each occupied square
+ * appends an instance to its mesh's fixed range of slots, then the first six
+ * invocations of the first tile write the constant parts of that mesh's
+ * indirect draw, so the frame records the same six draws regardless of what
+ * is on the boards. The instance counts are cleared before the dispatch.
+ * Each draw uses the LOD the CPU chose for the current board size.
+ */
+
+#define MAX_TILES 64
+#define LOD_COUNT 4
+
+layout(local_size_x = 64) in;
+
+struct PieceInstance {
+	uint transformIndex;
+	uint meshIndex;
+	float diffuseColor[3];
+	float ambientColor[3];
+};
+
+struct DrawIndexedIndirectCommand {
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+/* Shared with the board's vertex shader; the piece is the low byte of a square */
+layout(std430, binding = 0) readonly buffer _board_state {
+	uint enable3d;
+	uint arrowCount;
+	uint pieceLod;
+	uint arrows[8];
+	uint squares[]; /* 64 per tile */
+} BoardState;
+
+layout(std140, binding = 1) uniform _piece_draw_parameters {
+	uvec4 meshes[6 * LOD_COUNT]; /* indexCount, firstIndex, vertexOffset; mesh * LOD_COUNT + LOD */
+	vec4 diffuseColors[2]; /* Black, white */
+	vec4 ambientColors[2];
+} PieceDrawParameters;
+
+layout(std430, binding = 2) writeonly buffer _piece_instances {
+	PieceInstance instances[];
+} PieceInstances;
+
+layout(std430, binding = 3) buffer _piece_draws {
+	DrawIndexedIndirectCommand draws[6];
+} PieceDraws;
+
+void main() {
+	uint tile = gl_WorkGroupID.x;
+	uint square = gl_LocalInvocationID.x;
+
+	uint piece = BoardState.squares[tile * 64 + square] & 0xff;
+	if (piece != 0) {
+		uint meshIndex = (piece - 1) % 6;
+		uint color = piece > 6 ? 1 : 0;
+		uint slot = atomicAdd(PieceDraws.draws[meshIndex].instanceCount, 1);
+		PieceInstance instance;
+		instance.transformIndex = tile * 64 + square;
+		instance.meshIndex = meshIndex;
+		for (int i = 0; i < 3; ++i) {
+			instance.diffuseColor[i] = PieceDrawParameters.diffuseColors[color][i];
+			instance.ambientColor[i] = PieceDrawParameters.ambientColors[color][i];
+		}
+		PieceInstances.instances[meshIndex * MAX_TILES * 64 + slot] = instance;
+	}
+
+	if (tile == 0 && square < 6) {
+		uvec4 mesh = PieceDrawParameters.meshes[square * LOD_COUNT + BoardState.pieceLod];
+		PieceDraws.draws[square].indexCount = mesh.x;
+		PieceDraws.draws[square].firstIndex = mesh.y;
+		PieceDraws.draws[square].vertexOffset = int(mesh.z);
+		/* Each mesh's instance range is bound at an offset instead, as a nonzero firstInstance needs drawIndirectFirstInstance */
+		PieceDraws.draws[square].firstInstance = 0;
+	}
+}
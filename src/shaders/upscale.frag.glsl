@@ -0,0 +1,17 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+layout(location = 0) out vec4 outColor;
+
+layout (push_constant) uniform _push_constants {
+	vec2 scale;
+	vec2 minimum;
+	vec2 maximum;
+} PushConstants;
+
+void main()
+{
+	vec2 uv = clamp(gl_FragCoord.xy * PushConstants.scale, PushConstants.minimum, PushConstants.maximum);
+	outColor = texture(scene, uv);
+}
@@ -0,0 +1,59 @@
+#ifndef MODELER_TEXTURE_H
+#define MODELER_TEXTURE_H
+
+#include <stdint.h>
+
+/*
+ * A cooked texture is a KTX2 file with every mip level pre-built and no
+ * supercompression. Images are block-compressed, in 4x4 texel blocks of 16
+ * bytes: texture_cook writes one per encoding from each PNG, and the app
+ * loads whichever the device can sample. Distance fields don't survive
+ * block compression, so msdf_cook writes them as plain 4-byte texels.
+ */
+#define TEXTURE_MAX_LEVELS 16
+#define TEXTURE_BLOCK_DIMENSION 4
+#define TEXTURE_BLOCK_SIZE 16
+#define TEXTURE_MSDF_TEXEL_SIZE 4
+
+/* VkFormat values, so the cooking tools don't need the Vulkan headers */
+#define TEXTURE_FORMAT_R8G8B8A8_UNORM 37
+#define TEXTURE_FORMAT_BC7_SRGB_BLOCK 146
+#define TEXTURE_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK 152
+
+typedef enum texture_encoding_t {
+	TEXTURE_ENCODING_BC7,
+	TEXTURE_ENCODING_ETC2,
+	TEXTURE_ENCODING_MSDF,
+	TEXTURE_ENCODING_COUNT
+} TextureEncoding;
+
+#define KTX2_IDENTIFIER "\xabKTX 20\xbb\r\n\x1a\n"
+#define KTX2_IDENTIFIER_SIZE 12
+
+typedef struct ktx2_header_t {
+	uint8_t identifier[KTX2_IDENTIFIER_SIZE];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+} Ktx2Header;
+
+/* One per level, following the header, level 0 first */
+typedef struct ktx2_level_t {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+} Ktx2Level;
+
+#endif /* MODELER_TEXTURE_H */
@@ -0,0 +1,560 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lodepng.h"
+#include "texture_write.h"
+
+/*
+ * Build-time tool that turns a PNG mip atlas into the cooked format described
+ * in texture.h, so the app never decodes PNGs or converts texels:
+ *
+ * 	texture_cook input.png levels bc7|etc2 output.ktx2
+ *
+ * The atlas is laid out the way the textures always have been: level 0 is
+ * the height-by-height square on the left, and each further level is stacked
+ * below the one before it in the column to its right.
+ */
+
+typedef struct level_t {
+	uint32_t width;
+	uint32_t height;
+	uint8_t *blocks;
+	size_t size;
+} Level;
+
+static const int bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static const int etc1Modifiers[8][2] = {
+	{2, 8},
+	{5, 17},
+	{9, 29},
+	{13, 42},
+	{18, 60},
+	{24, 80},
+	{33, 106},
+	{47, 183}
+};
+
+static const int eacModifiers[16][8] = {
+	{-3, -6, -9, -15, 2, 5, 8, 14},
+	{-3, -7, -10, -13, 2, 6, 9, 12},
+	{-2, -5, -8, -13, 1, 4, 7, 12},
+	{-2, -4, -6, -13, 1, 3, 5, 12},
+	{-3, -6, -8, -12, 2, 5, 7, 11},
+	{-3, -7, -9, -11, 2, 6, 8, 10},
+	{-4, -7, -8, -11, 3, 6, 7, 10},
+	{-3, -5, -8, -11, 2, 4, 7, 10},
+	{-2, -6, -8, -10, 1, 5, 7, 9},
+	{-2, -5, -8, -10, 1, 4, 7, 9},
+	{-2, -4, -8, -10, 1, 3, 7, 9},
+	{-2, -5, -7, -10, 1, 4, 6, 9},
+	{-3, -4, -7, -10, 2, 3, 6, 9},
+	{-1, -2, -3, -10, 0, 1, 2, 9},
+	{-4, -6, -8, -9, 3, 5, 7, 8},
+	{-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+static void encodeLevel(const uint8_t *atlas, uint32_t atlasWidth, uint32_t x, uint32_t y, TextureEncoding encoding, Level *level);
+static void encodeBc7Block(const uint8_t pixels[16][4], uint8_t block[TEXTURE_BLOCK_SIZE]);
+static float fitBc7Endpoints(const uint8_t pixels[16][4], const float endpoints[2][4], uint8_t quantized[2][4], uint8_t pBits[2], uint8_t indices[16]);
+static void writeBits(uint8_t *block, size_t *offset, uint32_t value, size_t count);
+static void encodeEtc2Block(const uint8_t pixels[16][4], uint8_t block[TEXTURE_BLOCK_SIZE]);
+static uint64_t encodeEtc1Color(const uint8_t pixels[16][4]);
+static float fitEtc1Subblock(const uint8_t pixels[16][4], const bool inSubblock[16], const int base[3], uint32_t *table, uint32_t indices[16]);
+static uint64_t encodeEacAlpha(const uint8_t pixels[16][4]);
+static int clampInt(int value, int min, int max);
+
+int main(int argc, char **argv)
+{
+	if (argc != 5) {
+		fprintf(stderr, "usage: %s input.png levels bc7|etc2 output.ktx2\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t levelCount = strtoul(argv[2], NULL, 10);
+	TextureEncoding encoding;
+	if (strcmp(argv[3], "bc7") == 0) {
+		encoding = TEXTURE_ENCODING_BC7;
+	} else if (strcmp(argv[3], "etc2") == 0) {
+		encoding = TEXTURE_ENCODING_ETC2;
+	} else {
+		fprintf(stderr, "Unknown encoding %s\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+
+	unsigned char *atlas;
+	unsigned atlasWidth;
+	unsigned atlasHeight;
+	unsigned lodepngResult = lodepng_decode32_file(&atlas, &atlasWidth, &atlasHeight, argv[1]);
+	if (lodepngResult) {
+		fprintf(stderr, "Failed to decode %s: %s\n", argv[1], lodepng_error_text(lodepngResult));
+		return EXIT_FAILURE;
+	}
+
+	uint32_t size = atlasHeight;
+	if (levelCount < 1 || levelCount > TEXTURE_MAX_LEVELS || (size >> (levelCount - 1)) < TEXTURE_BLOCK_DIMENSION
+		|| size % (TEXTURE_BLOCK_DIMENSION << (levelCount - 1)) != 0
+		|| atlasWidth < (levelCount > 1 ? size + size / 2 : size)
+	) {
+		fprintf(stderr, "%s doesn't hold %u levels of whole blocks\n", argv[1], levelCount);
+		return EXIT_FAILURE;
+	}
+
+	Level levels[TEXTURE_MAX_LEVELS];
+	for (uint32_t i = 0, y = 0; i < levelCount; ++i) {
+		levels[i].width = size >> i;
+		levels[i].height = size >> i;
+		encodeLevel(atlas, atlasWidth, i == 0 ? 0 : size, y, encoding, levels + i);
+		if (i > 0) {
+			y += levels[i].height;
+		}
+	}
+	free(atlas);
+
+	uint8_t *blocks[TEXTURE_MAX_LEVELS];
+	size_t sizes[TEXTURE_MAX_LEVELS];
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		blocks[i] = levels[i].blocks;
+		sizes[i] = levels[i].size;
+	}
+	bool written = writeTexture(argv[4], encoding, size, size, levelCount, blocks, sizes);
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		free(levels[i].blocks);
+	}
+	if (!written) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void encodeLevel(const uint8_t *atlas, uint32_t atlasWidth, uint32_t x, uint32_t y, TextureEncoding encoding, Level *level)
+{
+	uint32_t blocksWide = level->width / TEXTURE_BLOCK_DIMENSION;
+	uint32_t blocksHigh = level->height / TEXTURE_BLOCK_DIMENSION;
+	level->size = (size_t) blocksWide * blocksHigh * TEXTURE_BLOCK_SIZE;
+	level->blocks = malloc(level->size);
+
+	for (uint32_t by = 0; by < blocksHigh; ++by) {
+		for (uint32_t bx = 0; bx < blocksWide; ++bx) {
+			/* Row-major, as BC7 numbers its texels */
+			uint8_t pixels[16][4];
+			for (uint32_t py = 0; py < TEXTURE_BLOCK_DIMENSION; ++py) {
+				for (uint32_t px = 0; px < TEXTURE_BLOCK_DIMENSION; ++px) {
+					size_t atlasOffset = ((size_t) (y + by * TEXTURE_BLOCK_DIMENSION + py) * atlasWidth + x + bx * TEXTURE_BLOCK_DIMENSION + px) * 4;
+					memcpy(pixels[py * TEXTURE_BLOCK_DIMENSION + px], atlas + atlasOffset, 4);
+				}
+			}
+
+			uint8_t *block = level->blocks + ((size_t) by * blocksWide + bx) * TEXTURE_BLOCK_SIZE;
+			if (encoding == TEXTURE_ENCODING_BC7) {
+				encodeBc7Block(pixels, block);
+			} else {
+				encodeEtc2Block(pixels, block);
+			}
+		}
+	}
+}
+
+/*
+ * Mode 6 only: one RGBA line with 7-bit endpoints plus a p-bit each and
+ * 4-bit indices. The line starts along the block's principal axis and is
+ * refit once by least squares to the indices that chose.
+ */
+static void encodeBc7Block(const uint8_t sourcePixels[16][4], uint8_t block[TEXTURE_BLOCK_SIZE])
+{
+	/*
+	 * Transparent texels' colors don't matter, so give them the block's
+	 * average visible color rather than let them bend the line
+	 */
+	uint8_t pixels[16][4];
+	float visibleColor[3] = {};
+	float visibleWeight = 0.0f;
+	for (size_t p = 0; p < 16; ++p) {
+		for (size_t c = 0; c < 3; ++c) {
+			visibleColor[c] += sourcePixels[p][c] * sourcePixels[p][3];
+		}
+		visibleWeight += sourcePixels[p][3];
+	}
+	for (size_t p = 0; p < 16; ++p) {
+		memcpy(pixels[p], sourcePixels[p], 4);
+		if (sourcePixels[p][3] == 0 && visibleWeight > 0.0f) {
+			for (size_t c = 0; c < 3; ++c) {
+				pixels[p][c] = lroundf(visibleColor[c] / visibleWeight);
+			}
+		}
+	}
+
+	float mean[4] = {};
+	for (size_t p = 0; p < 16; ++p) {
+		for (size_t c = 0; c < 4; ++c) {
+			mean[c] += pixels[p][c] / 16.0f;
+		}
+	}
+
+	float covariance[4][4] = {};
+	for (size_t p = 0; p < 16; ++p) {
+		for (size_t i = 0; i < 4; ++i) {
+			for (size_t j = 0; j < 4; ++j) {
+				covariance[i][j] += (pixels[p][i] - mean[i]) * (pixels[p][j] - mean[j]);
+			}
+		}
+	}
+
+	float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+	for (size_t iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = {};
+		for (size_t i = 0; i < 4; ++i) {
+			for (size_t j = 0; j < 4; ++j) {
+				next[i] += covariance[i][j] * axis[j];
+			}
+		}
+		float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length == 0.0f) {
+			break;
+		}
+		for (size_t i = 0; i < 4; ++i) {
+			axis[i] = next[i] / length;
+		}
+	}
+
+	float minProjection = INFINITY;
+	float maxProjection = -INFINITY;
+	for (size_t p = 0; p < 16; ++p) {
+		float projection = 0.0f;
+		for (size_t c = 0; c < 4; ++c) {
+			projection += (pixels[p][c] - mean[c]) * axis[c];
+		}
+		minProjection = fminf(minProjection, projection);
+		maxProjection = fmaxf(maxProjection, projection);
+	}
+
+	float endpoints[2][4];
+	for (size_t c = 0; c < 4; ++c) {
+		endpoints[0][c] = mean[c] + axis[c] * minProjection;
+		endpoints[1][c] = mean[c] + axis[c] * maxProjection;
+	}
+
+	uint8_t quantized[2][4];
+	uint8_t pBits[2];
+	uint8_t indices[16];
+	float error = fitBc7Endpoints(pixels, endpoints, quantized, pBits, indices);
+
+	float a = 0.0f;
+	float b = 0.0f;
+	float d = 0.0f;
+	float targets[2][4] = {};
+	for (size_t p = 0; p < 16; ++p) {
+		float weight = bc7Weights[indices[p]] / 64.0f;
+		a += (1.0f - weight) * (1.0f - weight);
+		b += (1.0f - weight) * weight;
+		d += weight * weight;
+		for (size_t c = 0; c < 4; ++c) {
+			targets[0][c] += (1.0f - weight) * pixels[p][c];
+			targets[1][c] += weight * pixels[p][c];
+		}
+	}
+	float determinant = a * d - b * b;
+	if (fabsf(determinant) > 1e-6f) {
+		float refitEndpoints[2][4];
+		for (size_t c = 0; c < 4; ++c) {
+			refitEndpoints[0][c] = (d * targets[0][c] - b * targets[1][c]) / determinant;
+			refitEndpoints[1][c] = (a * targets[1][c] - b * targets[0][c]) / determinant;
+		}
+
+		uint8_t refitQuantized[2][4];
+		uint8_t refitPBits[2];
+		uint8_t refitIndices[16];
+		if (fitBc7Endpoints(pixels, refitEndpoints, refitQuantized, refitPBits, refitIndices) < error) {
+			memcpy(quantized, refitQuantized, sizeof(quantized));
+			memcpy(pBits, refitPBits, sizeof(pBits));
+			memcpy(indices, refitIndices, sizeof(indices));
+		}
+	}
+
+	/* The first index's top bit is implied zero, so swap the endpoints if it's set */
+	if (indices[0] & 8) {
+		for (size_t c = 0; c < 4; ++c) {
+			uint8_t swap = quantized[0][c];
+			quantized[0][c] = quantized[1][c];
+			quantized[1][c] = swap;
+		}
+		uint8_t swap = pBits[0];
+		pBits[0] = pBits[1];
+		pBits[1] = swap;
+		for (size_t p = 0; p < 16; ++p) {
+			indices[p] = 15 - indices[p];
+		}
+	}
+
+	memset(block, 0, TEXTURE_BLOCK_SIZE);
+	size_t offset = 0;
+	writeBits(block, &offset, 1 << 6, 7);
+	for (size_t c = 0; c < 4; ++c) {
+		writeBits(block, &offset, quantized[0][c], 7);
+		writeBits(block, &offset, quantized[1][c], 7);
+	}
+	writeBits(block, &offset, pBits[0], 1);
+	writeBits(block, &offset, pBits[1], 1);
+	for (size_t p = 0; p < 16; ++p) {
+		writeBits(block, &offset, indices[p], p == 0 ? 3 : 4);
+	}
+}
+
+/* Tries each pair of p-bits and returns the squared error of the best */
+static float fitBc7Endpoints(const uint8_t pixels[16][4], const float endpoints[2][4], uint8_t quantized[2][4], uint8_t pBits[2], uint8_t indices[16])
+{
+	float bestError = INFINITY;
+
+	for (uint8_t pBit0 = 0; pBit0 < 2; ++pBit0) {
+		for (uint8_t pBit1 = 0; pBit1 < 2; ++pBit1) {
+			uint8_t candidatePBits[2] = {pBit0, pBit1};
+			uint8_t candidateQuantized[2][4];
+			int expanded[2][4];
+			for (size_t e = 0; e < 2; ++e) {
+				for (size_t c = 0; c < 4; ++c) {
+					candidateQuantized[e][c] = clampInt(lroundf((endpoints[e][c] - candidatePBits[e]) / 2.0f), 0, 127);
+					expanded[e][c] = candidateQuantized[e][c] << 1 | candidatePBits[e];
+				}
+			}
+
+			int palette[16][4];
+			for (size_t i = 0; i < 16; ++i) {
+				for (size_t c = 0; c < 4; ++c) {
+					palette[i][c] = ((64 - bc7Weights[i]) * expanded[0][c] + bc7Weights[i] * expanded[1][c] + 32) >> 6;
+				}
+			}
+
+			float error = 0.0f;
+			uint8_t candidateIndices[16];
+			for (size_t p = 0; p < 16; ++p) {
+				int bestPixelError = -1;
+				for (size_t i = 0; i < 16; ++i) {
+					int pixelError = 0;
+					for (size_t c = 0; c < 4; ++c) {
+						int difference = palette[i][c] - pixels[p][c];
+						pixelError += difference * difference;
+					}
+					if (bestPixelError < 0 || pixelError < bestPixelError) {
+						bestPixelError = pixelError;
+						candidateIndices[p] = i;
+					}
+				}
+				error += bestPixelError;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				memcpy(quantized, candidateQuantized, sizeof(candidateQuantized));
+				memcpy(pBits, candidatePBits, sizeof(candidatePBits));
+				memcpy(indices, candidateIndices, sizeof(candidateIndices));
+			}
+		}
+	}
+
+	return bestError;
+}
+
+/* Least significant bit first, as BC7 is laid out */
+static void writeBits(uint8_t *block, size_t *offset, uint32_t value, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, ++*offset) {
+		if (value >> i & 1) {
+			block[*offset / 8] |= 1 << (*offset % 8);
+		}
+	}
+}
+
+/* An EAC alpha block then an ETC1-compatible color block, each big-endian */
+static void encodeEtc2Block(const uint8_t pixels[16][4], uint8_t block[TEXTURE_BLOCK_SIZE])
+{
+	uint64_t alpha = encodeEacAlpha(pixels);
+	uint64_t color = encodeEtc1Color(pixels);
+
+	for (size_t i = 0; i < 8; ++i) {
+		block[i] = alpha >> (56 - 8 * i);
+		block[8 + i] = color >> (56 - 8 * i);
+	}
+}
+
+/*
+ * Individual or differential mode, whichever the two halves' average colors
+ * fit, trying both the side-by-side and the stacked split. The other ETC2
+ * modes aren't used, so the differential colors are never allowed to
+ * overflow into them.
+ */
+static uint64_t encodeEtc1Color(const uint8_t pixels[16][4])
+{
+	uint64_t bestBlock = 0;
+	float bestError = INFINITY;
+
+	for (uint32_t flip = 0; flip < 2; ++flip) {
+		bool inSubblock[2][16];
+		float averages[2][3] = {};
+		float weights[2] = {};
+		for (size_t p = 0; p < 16; ++p) {
+			size_t x = p % 4;
+			size_t y = p / 4;
+			size_t subblock = flip ? y >= 2 : x >= 2;
+			inSubblock[subblock][p] = true;
+			inSubblock[!subblock][p] = false;
+
+			/* Transparent texels don't matter, unless the whole half is transparent */
+			float weight = pixels[p][3] / 255.0f + 1.0f / 256.0f;
+			for (size_t c = 0; c < 3; ++c) {
+				averages[subblock][c] += pixels[p][c] * weight;
+			}
+			weights[subblock] += weight;
+		}
+
+		int bases5[2][3];
+		bool differential = true;
+		for (size_t s = 0; s < 2; ++s) {
+			for (size_t c = 0; c < 3; ++c) {
+				averages[s][c] /= weights[s];
+				bases5[s][c] = clampInt(lroundf(averages[s][c] * 31.0f / 255.0f), 0, 31);
+			}
+		}
+		for (size_t c = 0; c < 3; ++c) {
+			int difference = bases5[1][c] - bases5[0][c];
+			differential = differential && difference >= -4 && difference <= 3;
+		}
+
+		int bases[2][3];
+		for (size_t s = 0; s < 2; ++s) {
+			for (size_t c = 0; c < 3; ++c) {
+				if (differential) {
+					bases[s][c] = bases5[s][c] << 3 | bases5[s][c] >> 2;
+				} else {
+					int base4 = clampInt(lroundf(averages[s][c] * 15.0f / 255.0f), 0, 15);
+					bases[s][c] = base4 << 4 | base4;
+				}
+			}
+		}
+
+		uint32_t tables[2];
+		uint32_t indices[2][16];
+		float error = fitEtc1Subblock(pixels, inSubblock[0], bases[0], tables, indices[0])
+			+ fitEtc1Subblock(pixels, inSubblock[1], bases[1], tables + 1, indices[1]);
+		if (error >= bestError) {
+			continue;
+		}
+		bestError = error;
+
+		uint64_t block = 0;
+		for (size_t c = 0; c < 3; ++c) {
+			if (differential) {
+				uint64_t difference = (bases5[1][c] - bases5[0][c]) & 0x7;
+				block |= ((uint64_t) bases5[0][c] << 3 | difference) << (56 - 8 * c);
+			} else {
+				uint64_t base0 = bases[0][c] & 0xf;
+				uint64_t base1 = bases[1][c] & 0xf;
+				block |= (base0 << 4 | base1) << (56 - 8 * c);
+			}
+		}
+		block |= (uint64_t) tables[0] << 37 | (uint64_t) tables[1] << 34 | (uint64_t) differential << 33 | (uint64_t) flip << 32;
+
+		/* Texels are numbered down each column, each index split into a high and a low bit plane */
+		for (size_t p = 0; p < 16; ++p) {
+			size_t column = p % 4 * 4 + p / 4;
+			uint32_t index = indices[inSubblock[1][p]][p];
+			block |= (uint64_t) (index >> 1) << (16 + column) | (uint64_t) (index & 1) << column;
+		}
+		bestBlock = block;
+	}
+
+	return bestBlock;
+}
+
+static float fitEtc1Subblock(const uint8_t pixels[16][4], const bool inSubblock[16], const int base[3], uint32_t *table, uint32_t indices[16])
+{
+	float bestError = INFINITY;
+
+	for (uint32_t t = 0; t < 8; ++t) {
+		/* Index 0 and 1 add the small and large modifiers, 2 and 3 subtract them */
+		int modifiers[4] = {etc1Modifiers[t][0], etc1Modifiers[t][1], -etc1Modifiers[t][0], -etc1Modifiers[t][1]};
+		float error = 0.0f;
+		uint32_t candidateIndices[16];
+		for (size_t p = 0; p < 16; ++p) {
+			if (!inSubblock[p]) {
+				continue;
+			}
+			int bestPixelError = -1;
+			for (uint32_t i = 0; i < 4; ++i) {
+				int pixelError = 0;
+				for (size_t c = 0; c < 3; ++c) {
+					int difference = clampInt(base[c] + modifiers[i], 0, 255) - pixels[p][c];
+					pixelError += difference * difference;
+				}
+				if (bestPixelError < 0 || pixelError < bestPixelError) {
+					bestPixelError = pixelError;
+					candidateIndices[p] = i;
+				}
+			}
+			error += bestPixelError * (pixels[p][3] / 255.0f + 1.0f / 256.0f);
+		}
+
+		if (error < bestError) {
+			bestError = error;
+			*table = t;
+			for (size_t p = 0; p < 16; ++p) {
+				if (inSubblock[p]) {
+					indices[p] = candidateIndices[p];
+				}
+			}
+		}
+	}
+
+	return bestError;
+}
+
+/* Searches every table with the few multipliers that could span the block's alpha range */
+static uint64_t encodeEacAlpha(const uint8_t pixels[16][4])
+{
+	int minAlpha = 255;
+	int maxAlpha = 0;
+	for (size_t p = 0; p < 16; ++p) {
+		minAlpha = pixels[p][3] < minAlpha ? pixels[p][3] : minAlpha;
+		maxAlpha = pixels[p][3] > maxAlpha ? pixels[p][3] : maxAlpha;
+	}
+
+	uint64_t bestBlock = 0;
+	int bestError = -1;
+	for (uint32_t t = 0; t < 16; ++t) {
+		int tableMin = eacModifiers[t][3];
+		int tableMax = eacModifiers[t][7];
+		int estimate = (maxAlpha - minAlpha + (tableMax - tableMin) / 2) / (tableMax - tableMin);
+		for (int multiplier = clampInt(estimate - 1, 1, 15); multiplier <= clampInt(estimate + 1, 1, 15); ++multiplier) {
+			int base = clampInt((minAlpha + maxAlpha) / 2 - (tableMin + tableMax) * multiplier / 2, 0, 255);
+			int error = 0;
+			uint64_t block = (uint64_t) base << 56 | (uint64_t) multiplier << 52 | (uint64_t) t << 48;
+			for (size_t p = 0; p < 16; ++p) {
+				int bestPixelError = -1;
+				uint32_t bestIndex = 0;
+				for (uint32_t i = 0; i < 8; ++i) {
+					int difference = clampInt(base + eacModifiers[t][i] * multiplier, 0, 255) - pixels[p][3];
+					if (bestPixelError < 0 || difference * difference < bestPixelError) {
+						bestPixelError = difference * difference;
+						bestIndex = i;
+					}
+				}
+				error += bestPixelError;
+				block |= (uint64_t) bestIndex << (45 - 3 * (p % 4 * 4 + p / 4));
+			}
+			if (bestError < 0 || error < bestError) {
+				bestError = error;
+				bestBlock = block;
+			}
+		}
+	}
+
+	return bestBlock;
+}
+
+static int clampInt(int value, int min, int max)
+{
+	return value < min ? min : value > max ? max : value;
+}
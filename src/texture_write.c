@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "texture_write.h"
+
+/*
+ * Shared by the build-time texture tools, so every cooked texture is laid out
+ * the same way: header, level index and DFD, then the levels smallest first,
+ * each on a 16-byte boundary.
+ */
+
+/* Khronos Data Format descriptor values */
+#define KHR_DF_MODEL_RGBSDA 1
+#define KHR_DF_MODEL_BC7 134
+#define KHR_DF_MODEL_ETC2 161
+#define KHR_DF_PRIMARIES_BT709 1
+#define KHR_DF_TRANSFER_LINEAR 1
+#define KHR_DF_TRANSFER_SRGB 2
+#define KHR_DF_CHANNEL_RGBSDA_ALPHA 15
+#define KHR_DF_CHANNEL_BC7_COLOR 0
+#define KHR_DF_CHANNEL_ETC2_COLOR 2
+#define KHR_DF_CHANNEL_ETC2_ALPHA 15
+
+#define MAX_DFD_SAMPLES 4
+
+static size_t writeDataFormatDescriptor(TextureEncoding encoding, uint32_t *dfd);
+static void writeSample(uint32_t *sample, uint32_t channel, uint32_t bitOffset, uint32_t bitLength, uint32_t upper);
+
+bool writeTexture(const char *path, TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t levelCount, uint8_t *const *levels, const size_t *levelSizes)
+{
+	uint32_t formats[TEXTURE_ENCODING_COUNT] = {
+		[TEXTURE_ENCODING_BC7] = TEXTURE_FORMAT_BC7_SRGB_BLOCK,
+		[TEXTURE_ENCODING_ETC2] = TEXTURE_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,
+		[TEXTURE_ENCODING_MSDF] = TEXTURE_FORMAT_R8G8B8A8_UNORM
+	};
+
+	uint32_t dfd[1 + 6 + 4 * MAX_DFD_SAMPLES];
+	size_t dfdSize = writeDataFormatDescriptor(encoding, dfd);
+	Ktx2Header header = {
+		.vkFormat = formats[encoding],
+		.typeSize = 1,
+		.pixelWidth = width,
+		.pixelHeight = height,
+		.pixelDepth = 0,
+		.layerCount = 0,
+		.faceCount = 1,
+		.levelCount = levelCount,
+		.supercompressionScheme = 0,
+		.dfdByteOffset = sizeof(Ktx2Header) + sizeof(Ktx2Level) * levelCount,
+		.dfdByteLength = dfdSize,
+		.kvdByteOffset = 0,
+		.kvdByteLength = 0,
+		.sgdByteOffset = 0,
+		.sgdByteLength = 0
+	};
+	memcpy(header.identifier, KTX2_IDENTIFIER, KTX2_IDENTIFIER_SIZE);
+
+	Ktx2Level levelIndex[TEXTURE_MAX_LEVELS];
+	size_t fileSize = header.dfdByteOffset + header.dfdByteLength;
+	for (uint32_t i = levelCount; i-- > 0;) {
+		fileSize = (fileSize + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE * TEXTURE_BLOCK_SIZE;
+		levelIndex[i] = (Ktx2Level) {
+			.byteOffset = fileSize,
+			.byteLength = levelSizes[i],
+			.uncompressedByteLength = levelSizes[i]
+		};
+		fileSize += levelSizes[i];
+	}
+
+	uint8_t *file = calloc(fileSize, 1);
+	memcpy(file, &header, sizeof(header));
+	memcpy(file + sizeof(header), levelIndex, sizeof(*levelIndex) * levelCount);
+	memcpy(file + header.dfdByteOffset, dfd, dfdSize);
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		memcpy(file + levelIndex[i].byteOffset, levels[i], levelSizes[i]);
+	}
+
+	FILE *fp;
+	if (!(fp = fopen(path, "wb"))) {
+		fprintf(stderr, "Failed to open %s for writing\n", path);
+		free(file);
+		return false;
+	}
+	bool written = fwrite(file, fileSize, 1, fp) == 1;
+	if (fclose(fp) != 0 || !written) {
+		fprintf(stderr, "Failed to write %s\n", path);
+		free(file);
+		return false;
+	}
+	free(file);
+
+	return true;
+}
+
+/* A basic descriptor block for the encoding, preceded by its total size, returning the size in bytes */
+static size_t writeDataFormatDescriptor(TextureEncoding encoding, uint32_t *dfd)
+{
+	uint32_t sampleCount;
+	uint32_t model;
+	uint32_t transfer;
+	uint32_t blockDimension;
+	uint32_t blockSize;
+	uint32_t *samples = dfd + 7;
+	switch (encoding) {
+	case TEXTURE_ENCODING_BC7:
+		sampleCount = 1;
+		model = KHR_DF_MODEL_BC7;
+		transfer = KHR_DF_TRANSFER_SRGB;
+		blockDimension = TEXTURE_BLOCK_DIMENSION;
+		blockSize = TEXTURE_BLOCK_SIZE;
+		writeSample(samples, KHR_DF_CHANNEL_BC7_COLOR, 0, 128, UINT32_MAX);
+		break;
+	case TEXTURE_ENCODING_ETC2:
+		sampleCount = 2;
+		model = KHR_DF_MODEL_ETC2;
+		transfer = KHR_DF_TRANSFER_SRGB;
+		blockDimension = TEXTURE_BLOCK_DIMENSION;
+		blockSize = TEXTURE_BLOCK_SIZE;
+		writeSample(samples, KHR_DF_CHANNEL_ETC2_ALPHA, 0, 64, UINT32_MAX);
+		writeSample(samples + 4, KHR_DF_CHANNEL_ETC2_COLOR, 64, 64, UINT32_MAX);
+		break;
+	default:
+		sampleCount = 4;
+		model = KHR_DF_MODEL_RGBSDA;
+		transfer = KHR_DF_TRANSFER_LINEAR;
+		blockDimension = 1;
+		blockSize = TEXTURE_MSDF_TEXEL_SIZE;
+		for (uint32_t i = 0; i < 4; ++i) {
+			writeSample(samples + 4 * i, i == 3 ? KHR_DF_CHANNEL_RGBSDA_ALPHA : i, 8 * i, 8, 255);
+		}
+		break;
+	}
+
+	uint32_t descriptorBlockSize = 24 + 16 * sampleCount;
+	dfd[0] = 4 + descriptorBlockSize;
+	dfd[1] = 0;
+	dfd[2] = 2 | descriptorBlockSize << 16;
+	dfd[3] = model | KHR_DF_PRIMARIES_BT709 << 8 | transfer << 16;
+	dfd[4] = (blockDimension - 1) | (blockDimension - 1) << 8;
+	dfd[5] = blockSize;
+	dfd[6] = 0;
+
+	return dfd[0];
+}
+
+static void writeSample(uint32_t *sample, uint32_t channel, uint32_t bitOffset, uint32_t bitLength, uint32_t upper)
+{
+	sample[0] = bitOffset | (bitLength - 1) << 16 | channel << 24;
+	sample[1] = 0;
+	sample[2] = 0;
+	sample[3] = upper;
+}
@@ -0,0 +1,11 @@
+#ifndef MODELER_TEXTURE_WRITE_H
+#define MODELER_TEXTURE_WRITE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "texture.h"
+
+bool writeTexture(const char *path, TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t levelCount, uint8_t *const *levels, const size_t *levelSizes);
+
+#endif /* MODELER_TEXTURE_WRITE_H */
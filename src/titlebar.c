@@ -1,7 +1,5 @@
 #include <stdlib.h>
 
-#include "lodepng.h"
-
 #include "titlebar.h"
 #include "descriptor.h"
 #include "image.h"
@@ -17,10 +15,6 @@
 #include "../shader_titlebar.frag.h"
 #endif /* EMBED_SHADERS */
 
-#ifdef EMBED_TEXTURES
-#include "../texture_titlebar.h"
-#endif /* EMBED_TEXTURES */
-
 static const float VIEWPORT_WIDTH = 2.0f;
 static const float VIEWPORT_HEIGHT = 2.0f;
 
@@ -34,9 +28,8 @@ typedef struct titlebar_push_constants_t {
 struct titlebar_t {
 	VkDevice device;
 	VmaAllocator allocator;
-	VkCommandPool commandPool;
-	VkQueue queue;
 	VkRenderPass renderPass;
+	VkPipelineCache pipelineCache;
 	uint32_t subpass;
 	VkSampleCountFlagBits sampleCount;
 	const char *resourcePath;
@@ -66,14 +59,14 @@ struct titlebar_t {
 	void *minimizeArg;
 };
 
-static bool createTitlebarTexture(Titlebar self, char **error);
+static bool createTitlebarTexture(Titlebar self, AssetLoader assetLoader, TextureEncoding textureEncoding, UploadBatch uploadBatch, char **error);
 static bool createTitlebarTextureSampler(Titlebar self, char **error);
 static bool createTitlebarDescriptors(Titlebar self, char **error);
-static bool createTitlebarPipeline(Titlebar self, char **error);
+static bool createTitlebarPipeline(Titlebar self, PipelineBuilder pipelineBuilder, char **error);
 static void updateHovering(Titlebar self);
 static void updatePressed(Titlebar self);
 
-bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderPass, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, float aspectRatio, void (*close)(void *), void *closeArg, void (*maximize)(void *), void *maximizeArg, void (*minimize)(void *), void *minimizeArg, char **error)
+bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator, AssetLoader assetLoader, TextureEncoding textureEncoding, UploadBatch uploadBatch, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, float aspectRatio, void (*close)(void *), void *closeArg, void (*maximize)(void *), void *maximizeArg, void (*minimize)(void *), void *minimizeArg, char **error)
 {
 	*titlebar = malloc(sizeof(**titlebar));
 
@@ -81,9 +74,8 @@ bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator,
 
 	self->device = device;
 	self->allocator = allocator;
-	self->commandPool = commandPool;
-	self->queue = queue;
 	self->renderPass = renderPass;
+	self->pipelineCache = pipelineCache;
 	self->subpass = subpass;
 	self->sampleCount = sampleCount;
 	self->resourcePath = resourcePath;
@@ -98,7 +90,7 @@ bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator,
 	self->minimize = minimize;
 	self->minimizeArg = minimizeArg;
 
-	if (!createTitlebarTexture(self, error)) {
+	if (!createTitlebarTexture(self, assetLoader, textureEncoding, uploadBatch, error)) {
 		return false;
 	}
 
@@ -110,82 +102,43 @@ bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator,
 		return false;
 	}
 
-	if (!createTitlebarPipeline(self, error)) {
+	if (!createTitlebarPipeline(self, pipelineBuilder, error)) {
 		return false;
 	}
 
 	return true;
 }
 
-static bool createTitlebarTexture(Titlebar self, char **error)
+static bool createTitlebarTexture(Titlebar self, AssetLoader assetLoader, TextureEncoding textureEncoding, UploadBatch uploadBatch, char **error)
 {
-#ifndef EMBED_TEXTURES
-	char *texturePath;
-	asprintf(&texturePath, "%s/%s", self->resourcePath, "titlebar.png");
-	char *titlebarTextureBytes;
-	uint32_t titlebarTextureSize = 0;
-
-	if ((titlebarTextureSize = readFileToString(texturePath, &titlebarTextureBytes)) == -1) {
-		asprintf(error, "Failed to open texture for reading.\n");
-		return false;
-	}
-#endif /* EMBED_TEXTURES */
-
-	unsigned lodepngResult;
-	unsigned char *textureDecodedBytes;
-	unsigned textureDecodedWidth;
-	unsigned textureDecodedHeight;
-
-	if (lodepngResult = lodepng_decode32(&textureDecodedBytes, &textureDecodedWidth, &textureDecodedHeight, titlebarTextureBytes, titlebarTextureSize)) {
-		asprintf(error, "Failed to decode PNG: %s\n", lodepng_error_text(lodepngResult));
+	CookedTexture texture;
+	if (!assetLoaderTakeTexture(assetLoader, ASSET_TITLEBAR_TEXTURE, textureEncoding, &texture, error)) {
 		return false;
 	}
 
 	VkExtent2D textureExtent = {
-		.width = textureDecodedHeight,
-		.height = textureDecodedHeight
+		.width = texture.width,
+		.height = texture.height
 	};
-	unsigned textureDecodedSize = (textureDecodedWidth * textureDecodedHeight) * (32 / sizeof(textureDecodedBytes));
-
-#ifndef EMBED_TEXTURES
-	free(titlebarTextureBytes);
-#endif /* EMBED_TEXTURES */
+	VkFormat format = (VkFormat) texture.format;
 
 	VkBuffer stagingBuffer;
-	VmaAllocation stagingBufferAllocation;
-	if (!createBuffer(self->device, self->allocator, textureDecodedSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, 0, &stagingBuffer, &stagingBufferAllocation, error)) {
-		return false;
-	}
-
-	VkResult result;
-	void *data;
-	if ((result = vmaMapMemory(self->allocator, stagingBufferAllocation, &data)) != VK_SUCCESS) {
-		asprintf(error, "Failed to map memory: %s", string_VkResult(result));
+	VkDeviceSize levelOffsets[TEXTURE_MAX_LEVELS];
+	bool staged = uploadBatchStageLevels(uploadBatch, texture.levels, texture.levelSizes, texture.levelCount, &stagingBuffer, levelOffsets, error);
+	freeCookedTexture(texture);
+	if (!staged) {
 		return false;
 	}
-	memcpy(data, textureDecodedBytes, textureDecodedSize);
-	free(textureDecodedBytes);
-	vmaUnmapMemory(self->allocator, stagingBufferAllocation);
 
-	if (!createImage(self->device, self->allocator, textureExtent, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 1, VK_SAMPLE_COUNT_1_BIT, &self->textureImage, &self->textureImageAllocation, error)) {
+	if (!createImage(self->device, self->allocator, textureExtent, format, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 1, VK_SAMPLE_COUNT_1_BIT, &self->textureImage, &self->textureImageAllocation, error)) {
 		return false;
 	}
 
-	if (!transitionImageLayout(self->device, self->commandPool, self->queue, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, error)) {
+	if (!uploadBatchCopyImage(uploadBatch, stagingBuffer, self->textureImage, format, texture.width, texture.height, 1, levelOffsets, error)) {
 		return false;
 	}
 
-	if (!copyBufferToImage(self->device, self->commandPool, self->queue, stagingBuffer, self->textureImage, textureDecodedWidth, textureDecodedHeight, 1, error)) {
-		return false;
-	}
-
-	if (!transitionImageLayout(self->device, self->commandPool, self->queue, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, error)) {
-		return false;
-	}
-
-	destroyBuffer(self->allocator, stagingBuffer, stagingBufferAllocation);
-
-	if (!createImageView(self->device, self->textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1, &self->textureImageView, error)) {
+	if (!createImageView(self->device, self->textureImage, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, &self->textureImageView, error)) {
 		return false;
 	}
 
@@ -238,7 +191,7 @@ static bool createTitlebarDescriptors(Titlebar self, char **error)
 	return true;
 }
 
-static bool createTitlebarPipeline(Titlebar self, char **error)
+static bool createTitlebarPipeline(Titlebar self, PipelineBuilder pipelineBuilder, char **error)
 {
 #ifndef EMBED_SHADERS
 	char *titlebarVertShaderPath;
@@ -281,6 +234,7 @@ static bool createTitlebarPipeline(Titlebar self, char **error)
 
 	PipelineCreateInfo pipelineCreateInfo = {
 		.device = self->device,
+		.pipelineCache = self->pipelineCache,
 		.renderPass = self->renderPass,
 		.subpassIndex = self->subpass,
 		.vertexShaderBytes = titlebarVertShaderBytes,
@@ -298,7 +252,7 @@ static bool createTitlebarPipeline(Titlebar self, char **error)
 		.depthStencilState = depthStencilState,
 		.sampleCount = self->sampleCount
 	};
-	bool pipelineCreateSuccess = createPipeline(pipelineCreateInfo, &self->pipelineLayout, &self->pipeline, true, error);
+	bool pipelineCreateSuccess = pipelineBuilderAddPipeline(pipelineBuilder, pipelineCreateInfo, &self->pipelineLayout, &self->pipeline, true, error);
 #ifndef EMBED_SHADERS
 	free(titlebarFragShaderBytes);
 	free(titlebarVertShaderBytes);
@@ -431,3 +385,18 @@ void titlebarSetAspectRatio(Titlebar self, float aspectRatio)
 {
 	self->aspectRatio = aspectRatio;
 }
+
+/*
+ * For a render pass with a different sample count. The device must be
+ * idle, and the new pipeline isn't ready until pipelineBuilder finishes.
+ */
+bool titlebarRecreatePipeline(Titlebar self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error)
+{
+	destroyPipeline(self->device, self->pipeline);
+	destroyPipelineLayout(self->device, self->pipelineLayout);
+
+	self->renderPass = renderPass;
+	self->sampleCount = sampleCount;
+
+	return createTitlebarPipeline(self, pipelineBuilder, error);
+}
@@ -8,13 +8,16 @@ typedef struct titlebar_t *Titlebar;
 #include "input_event.h"
 #include "window.h"
 #include "buffer.h"
+#include "pipeline.h"
+#include "asset_loader.h"
 #include "vulkan_utils.h"
 #include "vk_mem_alloc.h"
 
-bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, VkQueue queue, VkRenderPass renderPass, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, float aspectRatio, void (*close)(void *), void *closeArg, void (*maximize)(void *), void *maximizeArg, void (*minimize)(void *), void *minimizeArg, char **error);
+bool createTitlebar(Titlebar *titlebar, VkDevice device, VmaAllocator allocator, AssetLoader assetLoader, TextureEncoding textureEncoding, UploadBatch uploadBatch, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, float aspectRatio, void (*close)(void *), void *closeArg, void (*maximize)(void *), void *maximizeArg, void (*minimize)(void *), void *minimizeArg, char **error);
 bool drawTitlebar(Titlebar self, VkCommandBuffer commandBuffer, char **error);
 void destroyTitlebar(Titlebar self);
 void titlebarHandleInputEvent(void *titlebar, InputEvent *inputEvent);
 void titlebarSetAspectRatio(Titlebar self, float aspectRatio);
+bool titlebarRecreatePipeline(Titlebar self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error);
 
 #endif /* MODELER_TITLEBAR_H */
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "uniform_ring.h"
+
+#include "buffer.h"
+#include "synchronization.h"
+#include "utils.h"
+#include "vulkan_utils.h"
+
+/*
+ * One persistently mapped buffer split into a region per frame in flight.
+ * Space is reserved once, bumped linearly through a region, and every
+ * region has the same layout, so a reservation is bound with a dynamic
+ * offset of its frame's region plus its own offset. A frame's region is
+ * only written once that frame's fence has been waited on, so the GPU never
+ * reads a uniform while it's being changed.
+ */
+struct uniform_ring_t {
+	VmaAllocator allocator;
+	VkBuffer buffer;
+	VmaAllocation allocation;
+	char *mappedMemory;
+	VkDeviceSize alignment; /* minUniformBufferOffsetAlignment */
+	VkDeviceSize frameSize;
+	VkDeviceSize head; /* Where the next reservation goes in every region */
+};
+
+bool createUniformRing(UniformRing *uniformRing, VkDevice device, VmaAllocator allocator, VkDeviceSize alignment, VkDeviceSize frameSize, char **error)
+{
+	VkResult result;
+
+	*uniformRing = malloc(sizeof(**uniformRing));
+
+	UniformRing self = *uniformRing;
+
+	self->allocator = allocator;
+	self->alignment = alignment > 0 ? alignment : 1;
+	self->frameSize = (frameSize + self->alignment - 1) / self->alignment * self->alignment;
+	self->head = 0;
+
+	if (!createBuffer(device, allocator, self->frameSize * MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &self->buffer, &self->allocation, error)) {
+		free(self);
+		return false;
+	}
+
+	if ((result = vmaMapMemory(allocator, self->allocation, (void **) &self->mappedMemory)) != VK_SUCCESS) {
+		asprintf(error, "Failed to map memory: %s", string_VkResult(result));
+		destroyBuffer(allocator, self->buffer, self->allocation);
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/* Reserves size bytes in every frame's region, at the same offset in each */
+bool uniformRingReserve(UniformRing self, VkDeviceSize size, VkDeviceSize *offset, char **error)
+{
+	VkDeviceSize start = (self->head + self->alignment - 1) / self->alignment * self->alignment;
+	if (start + size > self->frameSize) {
+		asprintf(error, "Uniform ring is full: %llu bytes won't fit after %llu of %llu", (unsigned long long) size, (unsigned long long) start, (unsigned long long) self->frameSize);
+		return false;
+	}
+
+	*offset = start;
+	self->head = start + size;
+
+	return true;
+}
+
+/* Only for the frame being recorded, whose previous submission has finished */
+void uniformRingWrite(UniformRing self, uint32_t frame, VkDeviceSize offset, const void *data, VkDeviceSize size)
+{
+	memcpy(self->mappedMemory + self->frameSize * frame + offset, data, size);
+}
+
+uint32_t uniformRingGetDynamicOffset(UniformRing self, uint32_t frame, VkDeviceSize offset)
+{
+	return self->frameSize * frame + offset;
+}
+
+VkBuffer uniformRingGetBuffer(UniformRing self)
+{
+	return self->buffer;
+}
+
+void destroyUniformRing(UniformRing self)
+{
+	vmaUnmapMemory(self->allocator, self->allocation);
+	destroyBuffer(self->allocator, self->buffer, self->allocation);
+	free(self);
+}
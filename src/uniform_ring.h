@@ -0,0 +1,19 @@
+#ifndef MODELER_UNIFORM_RING_H
+#define MODELER_UNIFORM_RING_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+#include "vk_mem_alloc.h"
+
+#define UNIFORM_RING_DEFAULT_FRAME_SIZE (32 * 1024)
+
+typedef struct uniform_ring_t *UniformRing;
+
+bool createUniformRing(UniformRing *uniformRing, VkDevice device, VmaAllocator allocator, VkDeviceSize alignment, VkDeviceSize frameSize, char **error);
+bool uniformRingReserve(UniformRing self, VkDeviceSize size, VkDeviceSize *offset, char **error);
+void uniformRingWrite(UniformRing self, uint32_t frame, VkDeviceSize offset, const void *data, VkDeviceSize size);
+uint32_t uniformRingGetDynamicOffset(UniformRing self, uint32_t frame, VkDeviceSize offset);
+VkBuffer uniformRingGetBuffer(UniformRing self);
+void destroyUniformRing(UniformRing self);
+
+#endif /* MODELER_UNIFORM_RING_H */
@@ -0,0 +1,485 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "upload.h"
+
+#include "buffer.h"
+#include "command_buffer.h"
+#include "command_pool.h"
+#include "image.h"
+#include "synchronization.h"
+#include "utils.h"
+#include "vulkan_utils.h"
+
+#define MAX_PENDING_UPLOADS 256
+
+/*
+ * Uploads are copied into a persistently mapped staging ring as soon as they
+ * are made, and the copies are recorded at the start of the next frame's
+ * command buffer, so nothing ever waits on the queue. Ring offsets only
+ * grow; the space a frame's copies read from is handed back once that
+ * frame's fence has been waited on.
+ */
+struct upload_manager_t {
+	VkDevice device;
+	VmaAllocator allocator;
+	VkBuffer stagingBuffer;
+	VmaAllocation stagingBufferAllocation;
+	char *stagingMappedMemory;
+	VkDeviceSize size;
+	VkDeviceSize head; /* Where the next upload goes */
+	VkDeviceSize tail; /* Oldest byte a frame in flight may still read */
+	VkDeviceSize frameHeads[MAX_FRAMES_IN_FLIGHT]; /* head as each frame was recorded */
+	VkBuffer pendingBuffers[MAX_PENDING_UPLOADS];
+	VkBufferCopy pendingRegions[MAX_PENDING_UPLOADS];
+	size_t pendingCount;
+};
+
+/*
+ * Startup uploads are all recorded into one command buffer and submitted
+ * together, so creating the board, the pieces and the titlebar costs a
+ * single round trip to the GPU. Each upload gets its own staging buffer,
+ * which is kept until the batch has finished executing.
+ *
+ * With a dedicated transfer family the copies run on the transfer queue.
+ * Every destination is then released to the graphics family, and a second,
+ * small command buffer on the graphics queue acquires it once a semaphore
+ * says the copies are done.
+ */
+struct upload_batch_t {
+	VkDevice device;
+	VmaAllocator allocator;
+	VkCommandPool commandPool;
+	VkCommandPool transferCommandPool; /* commandPool when the families are the same */
+	QueueInfo queueInfo;
+	VkCommandBuffer commandBuffer;
+	VkBuffer *stagingBuffers;
+	VmaAllocation *stagingBufferAllocations;
+	size_t stagingBufferCount;
+	VkBuffer *buffers;
+	VkDeviceSize *bufferOffsets;
+	VkDeviceSize *bufferSizes;
+	size_t bufferCount;
+	VkImage *images;
+	uint32_t *imageMipLevels;
+	size_t imageCount;
+};
+
+static void recordUploadBatchBarriers(UploadBatch self, VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+static bool submitUploadBatch(UploadBatch self, char **error);
+static void destroyUploadBatch(UploadBatch self);
+
+bool createUploadManager(UploadManager *uploadManager, VkDevice device, VmaAllocator allocator, VkDeviceSize size, char **error)
+{
+	VkResult result;
+
+	*uploadManager = malloc(sizeof(**uploadManager));
+
+	UploadManager self = *uploadManager;
+
+	self->device = device;
+	self->allocator = allocator;
+	self->size = size;
+	self->head = 0;
+	self->tail = 0;
+	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+		self->frameHeads[i] = 0;
+	}
+	self->pendingCount = 0;
+
+	if (!createBuffer(device, allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &self->stagingBuffer, &self->stagingBufferAllocation, error)) {
+		free(self);
+		return false;
+	}
+
+	if ((result = vmaMapMemory(allocator, self->stagingBufferAllocation, (void **) &self->stagingMappedMemory)) != VK_SUCCESS) {
+		asprintf(error, "Failed to map memory: %s", string_VkResult(result));
+		destroyBuffer(allocator, self->stagingBuffer, self->stagingBufferAllocation);
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Returns false without queueing anything if the ring or the pending list is
+ * full; the caller keeps its data and tries again on a later frame
+ */
+bool uploadManagerUpload(UploadManager self, VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size)
+{
+	if (size == 0) {
+		return true;
+	}
+
+	/* An upload never wraps; one that would starts over at the beginning */
+	VkDeviceSize start = self->head;
+	if (start % self->size + size > self->size) {
+		start += self->size - start % self->size;
+	}
+	if (start + size - self->tail > self->size || self->pendingCount == MAX_PENDING_UPLOADS) {
+		return false;
+	}
+
+	VkDeviceSize stagingOffset = start % self->size;
+	memcpy(self->stagingMappedMemory + stagingOffset, data, size);
+	self->head = start + size;
+
+	/* Consecutive writes to neighbouring bytes of one buffer become one copy */
+	if (self->pendingCount > 0) {
+		VkBufferCopy *previous = self->pendingRegions + self->pendingCount - 1;
+		if (self->pendingBuffers[self->pendingCount - 1] == buffer && previous->srcOffset + previous->size == stagingOffset && previous->dstOffset + previous->size == offset) {
+			previous->size += size;
+			return true;
+		}
+	}
+
+	self->pendingBuffers[self->pendingCount] = buffer;
+	self->pendingRegions[self->pendingCount] = (VkBufferCopy) {
+		.srcOffset = stagingOffset,
+		.dstOffset = offset,
+		.size = size
+	};
+	++self->pendingCount;
+
+	return true;
+}
+
+/* Call once the frame's fence has been waited on, before recording it */
+void uploadManagerBeginFrame(UploadManager self, uint32_t frame)
+{
+	if (self->frameHeads[frame] > self->tail) {
+		self->tail = self->frameHeads[frame];
+	}
+}
+
+/* Must be recorded outside a render pass, before anything that reads the uploads */
+void uploadManagerRecord(UploadManager self, VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	self->frameHeads[frame] = self->head;
+
+	if (self->pendingCount == 0) {
+		return;
+	}
+
+	/* Earlier frames must be done reading what's about to be overwritten */
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
+
+	for (size_t i = 0; i < self->pendingCount; ) {
+		size_t count = 1;
+		while (i + count < self->pendingCount && self->pendingBuffers[i + count] == self->pendingBuffers[i]) {
+			++count;
+		}
+		vkCmdCopyBuffer(commandBuffer, self->stagingBuffer, self->pendingBuffers[i], count, self->pendingRegions + i);
+		i += count;
+	}
+	self->pendingCount = 0;
+
+	VkMemoryBarrier memoryBarrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+}
+
+void destroyUploadManager(UploadManager self)
+{
+	vmaUnmapMemory(self->allocator, self->stagingBufferAllocation);
+	destroyBuffer(self->allocator, self->stagingBuffer, self->stagingBufferAllocation);
+	free(self);
+}
+
+bool beginUploadBatch(UploadBatch *uploadBatch, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, QueueInfo queueInfo, char **error)
+{
+	*uploadBatch = malloc(sizeof(**uploadBatch));
+
+	UploadBatch self = *uploadBatch;
+
+	self->device = device;
+	self->allocator = allocator;
+	self->commandPool = commandPool;
+	self->transferCommandPool = commandPool;
+	self->queueInfo = queueInfo;
+	self->stagingBuffers = NULL;
+	self->stagingBufferAllocations = NULL;
+	self->stagingBufferCount = 0;
+	self->buffers = NULL;
+	self->bufferOffsets = NULL;
+	self->bufferSizes = NULL;
+	self->bufferCount = 0;
+	self->images = NULL;
+	self->imageMipLevels = NULL;
+	self->imageCount = 0;
+
+	if (queueInfo.transferQueueFamilyIndex != queueInfo.graphicsQueueFamilyIndex) {
+		if (!createCommandPool(device, queueInfo.transferQueueFamilyIndex, &self->transferCommandPool, error)) {
+			free(self);
+			return false;
+		}
+	}
+
+	if (!beginSingleTimeCommands(device, self->transferCommandPool, &self->commandBuffer, error)) {
+		if (self->transferCommandPool != commandPool) {
+			destroyCommandPool(device, self->transferCommandPool);
+		}
+		free(self);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * For callers that assemble the data in place; the memory stays mapped
+ * until the batch ends
+ */
+bool uploadBatchAllocate(UploadBatch self, VkDeviceSize size, VkBuffer *stagingBuffer, void **mappedMemory, char **error)
+{
+	VkBuffer buffer;
+	VmaAllocation allocation;
+	if (!createBuffer(self->device, self->allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, 0, &buffer, &allocation, error)) {
+		return false;
+	}
+
+	VmaAllocationInfo allocationInfo;
+	vmaGetAllocationInfo(self->allocator, allocation, &allocationInfo);
+
+	++self->stagingBufferCount;
+	self->stagingBuffers = realloc(self->stagingBuffers, sizeof(*self->stagingBuffers) * self->stagingBufferCount);
+	self->stagingBufferAllocations = realloc(self->stagingBufferAllocations, sizeof(*self->stagingBufferAllocations) * self->stagingBufferCount);
+	self->stagingBuffers[self->stagingBufferCount - 1] = buffer;
+	self->stagingBufferAllocations[self->stagingBufferCount - 1] = allocation;
+
+	*stagingBuffer = buffer;
+	*mappedMemory = allocationInfo.pMappedData;
+
+	return true;
+}
+
+/* Copies data into a new staging buffer that lives until the batch ends */
+bool uploadBatchStage(UploadBatch self, const void *data, VkDeviceSize size, VkBuffer *stagingBuffer, char **error)
+{
+	void *mappedMemory;
+	if (!uploadBatchAllocate(self, size, stagingBuffer, &mappedMemory, error)) {
+		return false;
+	}
+	memcpy(mappedMemory, data, size);
+
+	return true;
+}
+
+/* Packs image levels one after another, each on a 16-byte boundary so any block or texel size can copy from it */
+bool uploadBatchStageLevels(UploadBatch self, const void *const *levels, const size_t *levelSizes, uint32_t levelCount, VkBuffer *stagingBuffer, VkDeviceSize *levelOffsets, char **error)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		levelOffsets[i] = (size + 15) & ~(VkDeviceSize) 15;
+		size = levelOffsets[i] + levelSizes[i];
+	}
+
+	void *mappedMemory;
+	if (!uploadBatchAllocate(self, size, stagingBuffer, &mappedMemory, error)) {
+		return false;
+	}
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		memcpy((char *) mappedMemory + levelOffsets[i], levels[i], levelSizes[i]);
+	}
+
+	return true;
+}
+
+/* Only the range written is handed over, as other ranges of the buffer may belong to other uploads */
+void uploadBatchCopyBuffer(UploadBatch self, VkBuffer stagingBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	copyBuffer(self->commandBuffer, stagingBuffer, buffer, offset, size);
+
+	++self->bufferCount;
+	self->buffers = realloc(self->buffers, sizeof(*self->buffers) * self->bufferCount);
+	self->bufferOffsets = realloc(self->bufferOffsets, sizeof(*self->bufferOffsets) * self->bufferCount);
+	self->bufferSizes = realloc(self->bufferSizes, sizeof(*self->bufferSizes) * self->bufferCount);
+	self->buffers[self->bufferCount - 1] = buffer;
+	self->bufferOffsets[self->bufferCount - 1] = offset;
+	self->bufferSizes[self->bufferCount - 1] = size;
+}
+
+/* The image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL once the batch ends */
+bool uploadBatchCopyImage(UploadBatch self, VkBuffer stagingBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, const VkDeviceSize *levelOffsets, char **error)
+{
+	if (!transitionImageLayout(self->commandBuffer, image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, error)) {
+		return false;
+	}
+
+	copyBufferToImage(self->commandBuffer, stagingBuffer, image, width, height, mipLevels, levelOffsets);
+
+	++self->imageCount;
+	self->images = realloc(self->images, sizeof(*self->images) * self->imageCount);
+	self->imageMipLevels = realloc(self->imageMipLevels, sizeof(*self->imageMipLevels) * self->imageCount);
+	self->images[self->imageCount - 1] = image;
+	self->imageMipLevels[self->imageCount - 1] = mipLevels;
+
+	return true;
+}
+
+/* Submits everything recorded, waits for it once and frees the batch */
+bool endUploadBatch(UploadBatch self, char **error)
+{
+	bool success = submitUploadBatch(self, error);
+
+	destroyUploadBatch(self);
+
+	return success;
+}
+
+static bool submitUploadBatch(UploadBatch self, char **error)
+{
+	VkResult result;
+
+	VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	VkAccessFlags readAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	if (self->transferCommandPool == self->commandPool) {
+		recordUploadBatchBarriers(self, self->commandBuffer, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, readStages, readAccess);
+
+		return endSingleTimeCommands(self->device, self->commandPool, self->queueInfo.graphicsQueue, self->commandBuffer, error);
+	}
+
+	/* Release on the transfer queue; the matching acquire below makes the writes visible */
+	recordUploadBatchBarriers(self, self->commandBuffer, self->queueInfo.transferQueueFamilyIndex, self->queueInfo.graphicsQueueFamilyIndex, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+
+	if ((result = vkEndCommandBuffer(self->commandBuffer)) != VK_SUCCESS) {
+		asprintf(error, "Failed to end command buffer: %s", string_VkResult(result));
+		return false;
+	}
+
+	VkCommandBuffer acquireCommandBuffer;
+	if (!beginSingleTimeCommands(self->device, self->commandPool, &acquireCommandBuffer, error)) {
+		return false;
+	}
+
+	recordUploadBatchBarriers(self, acquireCommandBuffer, self->queueInfo.transferQueueFamilyIndex, self->queueInfo.graphicsQueueFamilyIndex, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, readStages, readAccess);
+
+	if ((result = vkEndCommandBuffer(acquireCommandBuffer)) != VK_SUCCESS) {
+		asprintf(error, "Failed to end command buffer: %s", string_VkResult(result));
+		vkFreeCommandBuffers(self->device, self->commandPool, 1, &acquireCommandBuffer);
+		return false;
+	}
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+	};
+	VkSemaphore transferCompleteSemaphore;
+	if ((result = vkCreateSemaphore(self->device, &semaphoreCreateInfo, NULL, &transferCompleteSemaphore)) != VK_SUCCESS) {
+		asprintf(error, "Failed to create semaphore: %s", string_VkResult(result));
+		vkFreeCommandBuffers(self->device, self->commandPool, 1, &acquireCommandBuffer);
+		return false;
+	}
+
+	VkFenceCreateInfo fenceCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+	};
+	VkFence acquireCompleteFence;
+	if ((result = vkCreateFence(self->device, &fenceCreateInfo, NULL, &acquireCompleteFence)) != VK_SUCCESS) {
+		asprintf(error, "Failed to create fence: %s", string_VkResult(result));
+		vkDestroySemaphore(self->device, transferCompleteSemaphore, NULL);
+		vkFreeCommandBuffers(self->device, self->commandPool, 1, &acquireCommandBuffer);
+		return false;
+	}
+
+	bool success = false;
+
+	VkSubmitInfo transferSubmitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &self->commandBuffer,
+		.signalSemaphoreCount = 1,
+		.pSignalSemaphores = &transferCompleteSemaphore
+	};
+
+	VkSubmitInfo acquireSubmitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = &transferCompleteSemaphore,
+		.pWaitDstStageMask = &readStages,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &acquireCommandBuffer
+	};
+
+	if ((result = vkQueueSubmit(self->queueInfo.transferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE)) != VK_SUCCESS) {
+		asprintf(error, "Failed to submit queue: %s", string_VkResult(result));
+	} else if ((result = vkQueueSubmit(self->queueInfo.graphicsQueue, 1, &acquireSubmitInfo, acquireCompleteFence)) != VK_SUCCESS) {
+		asprintf(error, "Failed to submit queue: %s", string_VkResult(result));
+		vkQueueWaitIdle(self->queueInfo.transferQueue);
+	} else if ((result = vkWaitForFences(self->device, 1, &acquireCompleteFence, VK_TRUE, UINT64_MAX)) != VK_SUCCESS) {
+		asprintf(error, "Failed to wait for fence: %s", string_VkResult(result));
+	} else {
+		success = true;
+	}
+
+	vkDestroyFence(self->device, acquireCompleteFence, NULL);
+	vkDestroySemaphore(self->device, transferCompleteSemaphore, NULL);
+	vkFreeCommandBuffers(self->device, self->commandPool, 1, &acquireCommandBuffer);
+
+	return success;
+}
+
+/* Takes every buffer and image in the batch from the transfer writes to their first reads */
+static void recordUploadBatchBarriers(UploadBatch self, VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+{
+	VkBufferMemoryBarrier *bufferBarriers = malloc(sizeof(*bufferBarriers) * self->bufferCount);
+	for (size_t i = 0; i < self->bufferCount; ++i) {
+		bufferBarriers[i] = (VkBufferMemoryBarrier) {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = srcAccessMask,
+			.dstAccessMask = dstAccessMask,
+			.srcQueueFamilyIndex = srcQueueFamilyIndex,
+			.dstQueueFamilyIndex = dstQueueFamilyIndex,
+			.buffer = self->buffers[i],
+			.offset = self->bufferOffsets[i],
+			.size = self->bufferSizes[i]
+		};
+	}
+
+	VkImageMemoryBarrier *imageBarriers = malloc(sizeof(*imageBarriers) * self->imageCount);
+	for (size_t i = 0; i < self->imageCount; ++i) {
+		imageBarriers[i] = (VkImageMemoryBarrier) {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = srcAccessMask,
+			.dstAccessMask = dstAccessMask,
+			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.srcQueueFamilyIndex = srcQueueFamilyIndex,
+			.dstQueueFamilyIndex = dstQueueFamilyIndex,
+			.image = self->images[i],
+			.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.subresourceRange.baseMipLevel = 0,
+			.subresourceRange.levelCount = self->imageMipLevels[i],
+			.subresourceRange.baseArrayLayer = 0,
+			.subresourceRange.layerCount = 1
+		};
+	}
+
+	vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, NULL, self->bufferCount, bufferBarriers, self->imageCount, imageBarriers);
+
+	free(bufferBarriers);
+	free(imageBarriers);
+}
+
+static void destroyUploadBatch(UploadBatch self)
+{
+	for (size_t i = 0; i < self->stagingBufferCount; ++i) {
+		destroyBuffer(self->allocator, self->stagingBuffers[i], self->stagingBufferAllocations[i]);
+	}
+	if (self->transferCommandPool != self->commandPool) {
+		/* Also frees the transfer command buffer */
+		destroyCommandPool(self->device, self->transferCommandPool);
+	}
+	free(self->stagingBuffers);
+	free(self->stagingBufferAllocations);
+	free(self->buffers);
+	free(self->bufferOffsets);
+	free(self->bufferSizes);
+	free(self->images);
+	free(self->imageMipLevels);
+	free(self);
+}
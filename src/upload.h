@@ -0,0 +1,29 @@
+#ifndef MODELER_UPLOAD_H
+#define MODELER_UPLOAD_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+#include "vk_mem_alloc.h"
+
+#include "device.h"
+
+#define UPLOAD_MANAGER_DEFAULT_SIZE (256 * 1024)
+
+typedef struct upload_manager_t *UploadManager;
+typedef struct upload_batch_t *UploadBatch;
+
+bool createUploadManager(UploadManager *uploadManager, VkDevice device, VmaAllocator allocator, VkDeviceSize size, char **error);
+bool uploadManagerUpload(UploadManager self, VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size);
+void uploadManagerBeginFrame(UploadManager self, uint32_t frame);
+void uploadManagerRecord(UploadManager self, VkCommandBuffer commandBuffer, uint32_t frame);
+void destroyUploadManager(UploadManager self);
+
+bool beginUploadBatch(UploadBatch *uploadBatch, VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, QueueInfo queueInfo, char **error);
+bool uploadBatchAllocate(UploadBatch self, VkDeviceSize size, VkBuffer *stagingBuffer, void **mappedMemory, char **error);
+bool uploadBatchStage(UploadBatch self, const void *data, VkDeviceSize size, VkBuffer *stagingBuffer, char **error);
+bool uploadBatchStageLevels(UploadBatch self, const void *const *levels, const size_t *levelSizes, uint32_t levelCount, VkBuffer *stagingBuffer, VkDeviceSize *levelOffsets, char **error);
+void uploadBatchCopyBuffer(UploadBatch self, VkBuffer stagingBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+bool uploadBatchCopyImage(UploadBatch self, VkBuffer stagingBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, const VkDeviceSize *levelOffsets, char **error);
+bool endUploadBatch(UploadBatch self, char **error);
+
+#endif /* MODELER_UPLOAD_H */
@@ -0,0 +1,238 @@
+#include <stdlib.h>
+
+#include "upscale.h"
+#include "descriptor.h"
+#include "sampler.h"
+#include "utils.h"
+
+#ifdef EMBED_SHADERS
+#include "../shader_upscale.vert.h"
+#include "../shader_upscale.frag.h"
+#endif /* EMBED_SHADERS */
+
+typedef struct upscale_push_constants_t {
+	float scale[2]; /* From framebuffer coordinates to the scene's texture coordinates */
+	float minimum[2];
+	float maximum[2];
+} UpscalePushConstants;
+
+/*
+ * Stretches the board, drawn by the scene render pass into the top left
+ * of the scene image at a fraction of the window's size, over its
+ * viewport. The scene image is as big as the swapchain, so changing the
+ * fraction needs no new attachments, only a different render area.
+ */
+struct upscaler_t {
+	VkDevice device;
+	VkRenderPass renderPass;
+	VkPipelineCache pipelineCache;
+	uint32_t subpass;
+	VkSampleCountFlagBits sampleCount;
+	const char *resourcePath;
+	VkExtent2D sceneExtent;
+	VkSampler sampler;
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSet descriptorSet;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+};
+
+static bool createUpscalerPipeline(Upscaler self, PipelineBuilder pipelineBuilder, char **error);
+static void destroyUpscalerDescriptors(Upscaler self);
+
+bool createUpscaler(Upscaler *upscaler, VkDevice device, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, VkImageView sceneImageView, VkExtent2D sceneExtent, char **error)
+{
+	*upscaler = malloc(sizeof(**upscaler));
+
+	Upscaler self = *upscaler;
+
+	self->device = device;
+	self->renderPass = renderPass;
+	self->pipelineCache = pipelineCache;
+	self->subpass = subpass;
+	self->sampleCount = sampleCount;
+	self->resourcePath = resourcePath;
+	self->descriptorPool = VK_NULL_HANDLE;
+
+	if (!createSampler(self->device, 0, 1, &self->sampler, error)) {
+		return false;
+	}
+
+	if (!upscalerSetScene(self, sceneImageView, sceneExtent, error)) {
+		return false;
+	}
+
+	if (!createUpscalerPipeline(self, pipelineBuilder, error)) {
+		return false;
+	}
+
+	return true;
+}
+
+/* The scene image is replaced with the swapchain; the device must be idle */
+bool upscalerSetScene(Upscaler self, VkImageView sceneImageView, VkExtent2D sceneExtent, char **error)
+{
+	destroyUpscalerDescriptors(self);
+
+	self->sceneExtent = sceneExtent;
+
+	VkDescriptorImageInfo imageDescriptorInfo = {
+		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		.imageView = sceneImageView,
+		.sampler = self->sampler
+	};
+
+	VkDescriptorSetLayoutBinding imageBinding = {
+		.binding = 0,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		.pImmutableSamplers = NULL
+	};
+
+	void *descriptorSetDescriptorInfos[] = {&imageDescriptorInfo};
+	CreateDescriptorSetInfo createDescriptorSetInfo = {
+		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		.descriptorInfos = descriptorSetDescriptorInfos,
+		.descriptorCount = 1,
+		.bindings = &imageBinding,
+		.bindingCount = 1
+	};
+
+	if (!createDescriptorSets(self->device, &createDescriptorSetInfo, 1, &self->descriptorPool, &self->descriptorSet, &self->descriptorSetLayout, error)) {
+		return false;
+	}
+
+	return true;
+}
+
+static void destroyUpscalerDescriptors(Upscaler self)
+{
+	if (self->descriptorPool == VK_NULL_HANDLE) {
+		return;
+	}
+
+	destroyDescriptorPool(self->device, self->descriptorPool);
+	destroyDescriptorSetLayout(self->device, self->descriptorSetLayout);
+	self->descriptorPool = VK_NULL_HANDLE;
+}
+
+static bool createUpscalerPipeline(Upscaler self, PipelineBuilder pipelineBuilder, char **error)
+{
+#ifndef EMBED_SHADERS
+	char *upscaleVertShaderPath;
+	char *upscaleFragShaderPath;
+	asprintf(&upscaleVertShaderPath, "%s/%s", self->resourcePath, "upscale.vert.spv");
+	asprintf(&upscaleFragShaderPath, "%s/%s", self->resourcePath, "upscale.frag.spv");
+	char *upscaleVertShaderBytes;
+	char *upscaleFragShaderBytes;
+	uint32_t upscaleVertShaderSize = 0;
+	uint32_t upscaleFragShaderSize = 0;
+
+	if ((upscaleVertShaderSize = readFileToString(upscaleVertShaderPath, &upscaleVertShaderBytes)) == -1) {
+		asprintf(error, "Failed to open upscale vertex shader for reading.\n");
+		return false;
+	}
+	if ((upscaleFragShaderSize = readFileToString(upscaleFragShaderPath, &upscaleFragShaderBytes)) == -1) {
+		asprintf(error, "Failed to open upscale fragment shader for reading.\n");
+		return false;
+	}
+#endif /* EMBED_SHADERS */
+
+	VkPushConstantRange pushConstantRange = {
+		.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		.offset = 0,
+		.size = sizeof(UpscalePushConstants)
+	};
+
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.depthTestEnable = VK_FALSE,
+		.depthWriteEnable = VK_FALSE,
+		.depthCompareOp = VK_COMPARE_OP_NEVER,
+		.depthBoundsTestEnable = VK_FALSE,
+		.minDepthBounds = 0.0f,
+		.maxDepthBounds = 1.0f,
+		.stencilTestEnable = VK_FALSE,
+		.front = {},
+		.back = {}
+	};
+
+	PipelineCreateInfo pipelineCreateInfo = {
+		.device = self->device,
+		.pipelineCache = self->pipelineCache,
+		.renderPass = self->renderPass,
+		.subpassIndex = self->subpass,
+		.vertexShaderBytes = upscaleVertShaderBytes,
+		.vertexShaderSize = upscaleVertShaderSize,
+		.fragmentShaderBytes = upscaleFragShaderBytes,
+		.fragmentShaderSize = upscaleFragShaderSize,
+		.vertexBindingDescriptionCount = 0,
+		.vertexBindingDescriptions = NULL,
+		.vertexAttributeDescriptionCount = 0,
+		.VertexAttributeDescriptions = NULL,
+		.descriptorSetLayouts = &self->descriptorSetLayout,
+		.descriptorSetLayoutCount = 1,
+		.pushConstantRangeCount = 1,
+		.pushConstantRanges = &pushConstantRange,
+		.depthStencilState = depthStencilState,
+		.sampleCount = self->sampleCount
+	};
+	bool pipelineCreateSuccess = pipelineBuilderAddPipeline(pipelineBuilder, pipelineCreateInfo, &self->pipelineLayout, &self->pipeline, false, error);
+#ifndef EMBED_SHADERS
+	free(upscaleFragShaderBytes);
+	free(upscaleVertShaderBytes);
+#endif /* EMBED_SHADERS */
+	if (!pipelineCreateSuccess) {
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * For a render pass with a different sample count. The device must be
+ * idle, and the new pipeline isn't ready until pipelineBuilder finishes.
+ */
+bool upscalerRecreatePipeline(Upscaler self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error)
+{
+	destroyPipeline(self->device, self->pipeline);
+	destroyPipelineLayout(self->device, self->pipelineLayout);
+
+	self->renderPass = renderPass;
+	self->sampleCount = sampleCount;
+
+	return createUpscalerPipeline(self, pipelineBuilder, error);
+}
+
+/*
+ * Fills viewport, which the scene render pass drew at scale times its size
+ * and offset. Lookups are clamped to the centres of the texels that were
+ * drawn, so filtering never reaches outside the render area.
+ */
+void drawUpscaler(Upscaler self, VkCommandBuffer commandBuffer, VkViewport viewport, float scale)
+{
+	float width = self->sceneExtent.width;
+	float height = self->sceneExtent.height;
+
+	UpscalePushConstants pushConstants = {
+		.scale = {scale / width, scale / height},
+		.minimum = {(viewport.x * scale + 0.5f) / width, (viewport.y * scale + 0.5f) / height},
+		.maximum = {((viewport.x + viewport.width) * scale - 0.5f) / width, ((viewport.y + viewport.height) * scale - 0.5f) / height}
+	};
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->pipelineLayout, 0, 1, &self->descriptorSet, 0, NULL);
+	vkCmdPushConstants(commandBuffer, self->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
+
+void destroyUpscaler(Upscaler self)
+{
+	destroyPipeline(self->device, self->pipeline);
+	destroyPipelineLayout(self->device, self->pipelineLayout);
+	destroyUpscalerDescriptors(self);
+	destroySampler(self->device, self->sampler);
+	free(self);
+}
@@ -0,0 +1,17 @@
+#ifndef MODELER_UPSCALE_H
+#define MODELER_UPSCALE_H
+
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+typedef struct upscaler_t *Upscaler;
+
+#include "pipeline.h"
+
+bool createUpscaler(Upscaler *upscaler, VkDevice device, VkRenderPass renderPass, VkPipelineCache pipelineCache, PipelineBuilder pipelineBuilder, uint32_t subpass, VkSampleCountFlagBits sampleCount, const char *resourcePath, VkImageView sceneImageView, VkExtent2D sceneExtent, char **error);
+bool upscalerSetScene(Upscaler self, VkImageView sceneImageView, VkExtent2D sceneExtent, char **error);
+bool upscalerRecreatePipeline(Upscaler self, PipelineBuilder pipelineBuilder, VkRenderPass renderPass, VkSampleCountFlagBits sampleCount, char **error);
+void drawUpscaler(Upscaler self, VkCommandBuffer commandBuffer, VkViewport viewport, float scale);
+void destroyUpscaler(Upscaler self);
+
+#endif /* MODELER_UPSCALE_H */
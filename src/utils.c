@@ -1,9 +1,19 @@
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* _WIN32 */
+
 #include "utils.h"
 
 int asprintf(char **strp, const char *fmt, ...)
@@ -56,6 +66,95 @@ long readFileToString(const char *path, char **bytes)
 	return size;
 }
 
+/* Maps the whole file read-only; returns NULL on failure */
+void *mapFile(const char *path, size_t *size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping) {
+		return NULL;
+	}
+
+	void *bytes = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!bytes) {
+		return NULL;
+	}
+	*size = fileSize.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return NULL;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void *bytes = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (bytes == MAP_FAILED) {
+		return NULL;
+	}
+	*size = fileStat.st_size;
+#endif /* _WIN32 */
+
+	return bytes;
+}
+
+/* Creates path and any missing parents, like mkdir -p */
+bool makeDirectories(const char *path, char **error)
+{
+	char *partialPath = strdup(path);
+	for (char *c = partialPath + 1; ; ++c) {
+		if (*c != '/' && *c != '\0') {
+			continue;
+		}
+		char separator = *c;
+		*c = '\0';
+#ifdef _WIN32
+		bool created = CreateDirectoryA(partialPath, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+		bool created = mkdir(partialPath, 0700) == 0 || errno == EEXIST;
+#endif /* _WIN32 */
+		if (!created) {
+			asprintf(error, "Failed to create directory %s", partialPath);
+			free(partialPath);
+			return false;
+		}
+		if (separator == '\0') {
+			break;
+		}
+		*c = separator;
+	}
+	free(partialPath);
+
+	return true;
+}
+
+void unmapFile(void *bytes, size_t size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(bytes);
+#else
+	munmap(bytes, size);
+#endif /* _WIN32 */
+}
+
 void srgbToLinear(float vector[3])
 {
 	for (size_t i = 0; i < 3; ++i) {
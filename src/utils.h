@@ -8,6 +8,9 @@
 int asprintf(char **strp, const char *fmt, ...);
 int vasprintf(char **strp, const char *fmt, va_list ap);
 long readFileToString(const char *path, char **bytes);
+void *mapFile(const char *path, size_t *size);
+void unmapFile(void *bytes, size_t size);
+bool makeDirectories(const char *path, char **error);
 VkExtent2D getWindowExtent(void *platformWindow);
 float getWindowScale(void *platformWindow);
 void srgbToLinear(float vector[3]);